@@ -166,12 +166,13 @@ struct Index {
 			if (a < b) std::swap(a, b);
 			auto pair = std::make_pair(a, b);
 
-			if (!cache.count(pair)) {
+			auto it = cache.find(pair);
+			if (it == cache.end()) {
 				Lit nl = (static_cast<Writer*>(this))->emit_gate(a, b);
 				cache[pair] = nl;
 				return nl;
 			} else {
-				return cache.at(pair);
+				return it->second;
 			}
 		}
 	}
@@ -809,6 +810,121 @@ struct AigerWriter : Index<AigerWriter, unsigned int, 0, 1> {
 	}
 };
 
+// Writes the Tseitin encoding of the AIG directly as DIMACS. AIG literal
+// 2*n+neg maps to CNF literal (neg ? -1 : 1) * (n+1); CNF variable 1 is the
+// constant and is forced to false.
+struct CnfWriter : Index<CnfWriter, unsigned int, 0, 1> {
+	typedef unsigned int Lit;
+
+	const static constexpr Lit EMPTY_LIT = std::numeric_limits<Lit>::max();
+
+	static Lit negate(Lit lit) {
+		return lit ^ 1;
+	}
+
+	std::ostream *f;
+	Lit lit_counter;
+	int nclauses;
+
+	void put_lit(Lit lit)
+	{
+		char buf[16], *p = buf + sizeof(buf);
+		unsigned int x = (lit >> 1) + 1;
+		*--p = ' ';
+		do {
+			*--p = '0' + x % 10;
+			x /= 10;
+		} while (x);
+		if (lit & 1)
+			*--p = '-';
+		f->write(p, buf + sizeof(buf) - p);
+	}
+
+	void clause(std::initializer_list<Lit> clause_lits)
+	{
+		for (auto lit : clause_lits)
+			put_lit(lit);
+		f->write("0\n", 2);
+		nclauses++;
+	}
+
+	Lit emit_gate(Lit a, Lit b)
+	{
+		Lit out = lit_counter;
+		lit_counter += 2;
+
+		clause({negate(out), a});
+		clause({negate(out), b});
+		clause({out, negate(a), negate(b)});
+		return out;
+	}
+
+	void write_header()
+	{
+		// Padded to a fixed width so that it can be rewritten in place
+		char buf[64];
+		snprintf(buf, sizeof(buf) - 1, "p cnf %-10u %-10d\n", lit_counter / 2, nclauses);
+		f->write(buf, strlen(buf));
+	}
+
+	void write(std::ostream *f)
+	{
+		this->f = f;
+		lit_counter = 2;
+		nclauses = 0;
+
+		auto file_start = f->tellp();
+		write_header();
+		clause({1}); // forces the constant variable to false
+
+		std::vector<std::pair<SigBit, Lit>> inputs;
+		for (auto id : top->ports) {
+			Wire *w = top->wire(id);
+			log_assert(w);
+			if (w->port_input && !w->port_output)
+			for (int i = 0; i < w->width; i++) {
+				pi_literal(SigBit(w, i)) = lit_counter;
+				inputs.push_back({SigBit(w, i), lit_counter});
+				lit_counter += 2;
+			}
+		}
+
+		std::vector<std::pair<SigBit, Lit>> outputs;
+		for (auto id : top->ports) {
+			Wire *w = top->wire(id);
+			log_assert(w);
+			if (w->port_output)
+			for (int i = 0; i < w->width; i++)
+				outputs.push_back({SigBit(w, i), eval_po(SigBit(w, i))});
+		}
+
+		// The problem is satisfiable iff any of the outputs can be driven high
+		for (auto &pair : outputs)
+			put_lit(pair.second);
+		f->write("0\n", 2);
+		nclauses++;
+
+		for (auto &pair : inputs) {
+			std::string line = stringf("c input %s %d ", log_signal(pair.first), pair.second / 2 + 1);
+			f->write(line.data(), line.size());
+			f->put('\n');
+		}
+		for (auto &pair : outputs) {
+			std::string line = stringf("c output %s ", log_signal(pair.first));
+			f->write(line.data(), line.size());
+			put_lit(pair.second);
+			f->put('\n');
+		}
+
+		auto file_end = f->tellp();
+		f->seekp(file_start);
+		write_header();
+		f->seekp(file_end);
+
+		log("Wrote %u variables and %d clauses.\n", lit_counter / 2, nclauses);
+	}
+};
+
 struct XAigerAnalysis : Index<XAigerAnalysis, int, 0, 0> {
 	const static constexpr int EMPTY_LIT = -1;
 
@@ -1485,4 +1601,64 @@ struct XAiger2Backend : Backend {
 	}
 } XAiger2Backend;
 
+struct Cnf2Backend : Backend {
+	Cnf2Backend() : Backend("cnf", "(experimental) write design to DIMACS CNF file")
+	{
+		experimental();
+	}
+
+	void help() override
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    write_cnf [options] [filename]\n");
+		log("\n");
+		log("Write the selected module to a DIMACS CNF file. The CNF is satisfiable iff there\n");
+		log("is an input assignment driving any of the module outputs high, so e.g. writing\n");
+		log("a module created with 'miter -equiv' yields an equivalence check that can be\n");
+		log("passed to an external SAT solver.\n");
+		log("\n");
+		log("The CNF is generated directly from the netlist (using the same cell support as\n");
+		log("write_aiger2) and is written while it is generated, without building an\n");
+		log("in-memory SAT problem first. Comment lines at the end of the file map module\n");
+		log("inputs to CNF variables and module outputs to CNF literals.\n");
+		log("\n");
+		log("    -strash\n");
+		log("        perform structural hashing while writing\n");
+		log("\n");
+		log("    -flatten\n");
+		log("        allow descending into submodules and write a flattened view of the design\n");
+		log("        hierarchy starting at the selected top\n");
+		log("\n");
+	}
+
+	void execute(std::ostream *&f, std::string filename, std::vector<std::string> args, Design *design) override
+	{
+		log_header(design, "Executing CNF backend.\n");
+
+		size_t argidx;
+		CnfWriter writer;
+		writer.const_folding = true;
+		for (argidx = 1; argidx < args.size(); argidx++) {
+			if (args[argidx] == "-strash")
+				writer.strashing = true;
+			else if (args[argidx] == "-flatten")
+				writer.flatten = true;
+			else
+				break;
+		}
+		extra_args(f, filename, args, argidx);
+
+		Module *top = design->top_module();
+
+		if (!top || !design->selected_whole_module(top))
+			log_cmd_error("No top module selected\n");
+
+		design->bufNormalize(true);
+		writer.setup(top);
+		writer.write(f);
+		design->bufNormalize(false);
+	}
+} Cnf2Backend;
+
 PRIVATE_NAMESPACE_END
@@ -28,6 +28,7 @@
 #include "kernel/celltypes.h"
 #include "kernel/log.h"
 #include "kernel/mem.h"
+#include "kernel/coi.h"
 #include "kernel/json.h"
 #include "kernel/yw.h"
 #include "kernel/utils.h"
@@ -1578,10 +1579,20 @@ struct BtorBackend : public Backend {
 		log("  -ywmap <filename>\n");
 		log("    Create a map file for conversion to and from Yosys witness traces\n");
 		log("\n");
+		log("  -coi\n");
+		log("    Write a reduced model: merge structurally identical cells and remove all\n");
+		log("    logic outside the cone of influence of the asserts, assumes and covers.\n");
+		log("    Outputs outside of that cone are removed. The design is not modified.\n");
+		log("\n");
+		log("  -coi-outputs\n");
+		log("    Like -coi, but also keep the cone of influence of all outputs\n");
+		log("\n");
 	}
 	void execute(std::ostream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design) override
 	{
 		bool verbose = false, single_bad = false, cover_mode = false, print_internal_names = false;
+		bool coi = false;
+		CoiReduction coi_reduction;
 		string info_filename;
 		string ywmap_filename;
 
@@ -1620,6 +1631,15 @@ struct BtorBackend : public Backend {
 				ywmap_filename = args[++argidx];
 				continue;
 			}
+			if (args[argidx] == "-coi") {
+				coi = true;
+				continue;
+			}
+			if (args[argidx] == "-coi-outputs") {
+				coi = true;
+				coi_reduction.keep_outputs = true;
+				continue;
+			}
 			break;
 		}
 		extra_args(f, filename, args, argidx);
@@ -1629,6 +1649,13 @@ struct BtorBackend : public Backend {
 		if (topmod == nullptr)
 			log_cmd_error("No top module found.\n");
 
+		std::unique_ptr<RTLIL::Design> reduced_design;
+		if (coi) {
+			reduced_design.reset(coi_reduction.reduced_copy(design));
+			topmod = reduced_design->module(topmod->name);
+			coi_reduction.log_summary();
+		}
+
 		*f << stringf("; BTOR description generated by %s for module %s.\n",
 				yosys_maybe_version(), log_id(topmod));
 
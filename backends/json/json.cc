@@ -200,7 +200,7 @@ struct JsonWriter
 			f << stringf("          \"hide_name\": %s,\n", c->name[0] == '$' ? "1" : "0");
 			f << stringf("          \"type\": %s,\n", get_name(c->type));
 			if (aig_mode) {
-				Aig aig(c);
+				const Aig &aig = Aig::cached(c);
 				if (!aig.name.empty()) {
 					f << stringf("          \"model\": \"%s\",\n", aig.name);
 					aig_models.insert(aig);
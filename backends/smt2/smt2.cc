@@ -23,6 +23,7 @@
 #include "kernel/celltypes.h"
 #include "kernel/log.h"
 #include "kernel/mem.h"
+#include "kernel/coi.h"
 #include "libs/json11/json11.hpp"
 #include "kernel/utils.h"
 #include <string>
@@ -1707,6 +1708,15 @@ struct Smt2Backend : public Backend {
 		log("        emit a `; yosys-smt2-solver-option` directive for yosys-smtbmc to write\n");
 		log("        the given option as a `(set-option ...)` command in the SMT-LIBv2.\n");
 		log("\n");
+		log("    -coi\n");
+		log("        write a reduced model: merge structurally identical cells and remove all\n");
+		log("        logic outside the cone of influence of the asserts, assumes and covers\n");
+		log("        (and of the outputs of non-top modules). outputs of the top module\n");
+		log("        outside of that cone are removed. the design is not modified.\n");
+		log("\n");
+		log("    -coi-outputs\n");
+		log("        like -coi, but also keep the cone of influence of all top module outputs.\n");
+		log("\n");
 		log("[1] For more information on SMT-LIBv2 visit http://smt-lib.org/ or read David\n");
 		log("R. Cok's tutorial: https://smtlib.github.io/jSMTLIB/SMTLIBTutorial.pdf\n");
 		log("\n");
@@ -1760,7 +1770,8 @@ struct Smt2Backend : public Backend {
 	{
 		std::ifstream template_f;
 		bool bvmode = true, memmode = true, wiresmode = false, verbose = false, statebv = false, statedt = false;
-		bool forallmode = false;
+		bool forallmode = false, coi = false;
+		CoiReduction coi_reduction;
 		dict<std::string, std::string> solver_options;
 
 		log_header(design, "Executing SMT2 backend.\n");
@@ -1815,10 +1826,26 @@ struct Smt2Backend : public Backend {
 				argidx += 2;
 				continue;
 			}
+			if (args[argidx] == "-coi") {
+				coi = true;
+				continue;
+			}
+			if (args[argidx] == "-coi-outputs") {
+				coi = true;
+				coi_reduction.keep_outputs = true;
+				continue;
+			}
 			break;
 		}
 		extra_args(f, filename, args, argidx);
 
+		std::unique_ptr<RTLIL::Design> reduced_design;
+		if (coi) {
+			reduced_design.reset(coi_reduction.reduced_copy(design));
+			design = reduced_design.get();
+			coi_reduction.log_summary();
+		}
+
 		if (template_f.is_open()) {
 			std::string line;
 			while (std::getline(template_f, line)) {
@@ -19,6 +19,8 @@
 
 #include "kernel/cellaigs.h"
 
+#include <mutex>
+
 YOSYS_NAMESPACE_BEGIN
 
 AigNode::AigNode()
@@ -533,4 +535,71 @@ optimize:;
 	new_nodes.swap(nodes);
 }
 
+static std::mutex aig_cache_mutex;
+static dict<std::string, std::unique_ptr<Aig>> aig_cache;
+// Whether there is a model only depends on the cell type, so the cells of
+// unsupported types all share one empty model instead of an entry per
+// parameter set
+static pool<std::string> aig_supported_types, aig_unsupported_types;
+
+static std::string aig_cache_key(Cell *cell)
+{
+	// Keyed by strings, the cache must not keep identifiers of deleted cell types alive
+	vector<std::string> items;
+	for (auto &it : cell->parameters)
+		items.push_back(stringf("%s=%s", it.first, it.second.as_string()));
+	for (auto &it : cell->connections())
+		items.push_back(stringf("%s:%d", it.first, GetSize(it.second)));
+	std::sort(items.begin(), items.end());
+
+	std::string key = cell->type.str();
+	for (auto &item : items)
+		key += " " + item;
+	return key;
+}
+
+const Aig &Aig::cached(Cell *cell)
+{
+	static const Aig empty;
+	if (cell->type[0] != '$')
+		return empty;
+
+	std::unique_lock<std::mutex> lock(aig_cache_mutex);
+	if (aig_unsupported_types.count(cell->type.str()))
+		return empty;
+	bool supported = aig_supported_types.count(cell->type.str());
+	lock.unlock();
+
+	// The first cell of a type is checked before its key is built
+	std::unique_ptr<Aig> aig;
+	if (!supported) {
+		aig = std::make_unique<Aig>(cell);
+		if (aig->name.empty()) {
+			lock.lock();
+			aig_unsupported_types.insert(cell->type.str());
+			return empty;
+		}
+	}
+
+	std::string key = aig_cache_key(cell);
+	lock.lock();
+	aig_supported_types.insert(cell->type.str());
+	auto it = aig_cache.find(key);
+	if (it != aig_cache.end())
+		return *it->second;
+
+	if (aig == nullptr)
+		aig = std::make_unique<Aig>(cell);
+	aig->nodes.shrink_to_fit();
+	return *(aig_cache[key] = std::move(aig));
+}
+
+void Aig::clear_cache()
+{
+	std::lock_guard<std::mutex> lock(aig_cache_mutex);
+	aig_cache.clear();
+	aig_supported_types.clear();
+	aig_unsupported_types.clear();
+}
+
 YOSYS_NAMESPACE_END
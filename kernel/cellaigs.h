@@ -41,8 +41,15 @@ struct Aig
 {
 	string name;
 	vector<AigNode> nodes;
+	// Empty model
+	Aig() { }
 	Aig(Cell *cell);
 
+	// Shared model for cells with the same type, parameters and port widths,
+	// built on first use. The name is empty for cells without a model.
+	static const Aig &cached(Cell *cell);
+	static void clear_cache();
+
 	bool operator==(const Aig &other) const;
 	[[nodiscard]] Hasher hash_into(Hasher h) const;
 };
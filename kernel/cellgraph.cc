@@ -0,0 +1,310 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/cellgraph.h"
+#include "kernel/topo_scc.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+namespace {
+
+// Adapts the CSR successors of a CellGraph to TopoSortedSccs, optionally
+// restricted to the nodes set in a mask
+struct MaskedCellGraph
+{
+	typedef int node_type;
+
+	struct successor_enumerator {
+		const int *current, *end;
+		const std::vector<bool> *mask;
+		void skip() {
+			if (mask)
+				while (current != end && !(*mask)[*current])
+					++current;
+		}
+		bool finished() const { return current == end; }
+		node_type next() {
+			log_assert(!finished());
+			node_type result = *current++;
+			skip();
+			return result;
+		}
+	};
+
+	struct node_enumerator {
+		int current, end;
+		const std::vector<bool> *mask;
+		void skip() {
+			if (mask)
+				while (current != end && !(*mask)[current])
+					++current;
+		}
+		bool finished() const { return current == end; }
+		node_type next() {
+			log_assert(!finished());
+			node_type result = current++;
+			skip();
+			return result;
+		}
+	};
+
+	const CellGraph &graph;
+	const std::vector<bool> *mask;
+	std::vector<int> indices;
+
+	MaskedCellGraph(const CellGraph &graph, const std::vector<bool> *mask) : graph(graph), mask(mask), indices(graph.size(), -1) {}
+
+	node_enumerator enumerate_nodes() {
+		node_enumerator nodes = {0, graph.size(), mask};
+		nodes.skip();
+		return nodes;
+	}
+
+	successor_enumerator enumerate_successors(node_type node) const {
+		auto range = graph.successors(node);
+		successor_enumerator successors = {range.first, range.second, mask};
+		successors.skip();
+		return successors;
+	}
+
+	int &dfs_index(node_type node) {
+		return indices[node];
+	}
+};
+
+}
+
+CellGraph::CellGraph(RTLIL::Module *module, CellFilter cell_filter, PortClassifier port_classifier, BitFilter bit_filter) :
+		module(module), cell_filter(std::move(cell_filter)), port_classifier(std::move(port_classifier)), bit_filter(std::move(bit_filter))
+{
+	module->monitors.insert(this);
+	update();
+}
+
+CellGraph::~CellGraph()
+{
+	module->monitors.erase(this);
+}
+
+CellGraph &CellGraph::get(RTLIL::Module *module, const std::string &key, CellFilter cell_filter, PortClassifier port_classifier)
+{
+	CellGraph *&graph = module->cell_graph_cache[key];
+	if (graph == nullptr)
+		graph = new CellGraph(module, std::move(cell_filter), std::move(port_classifier));
+	else
+		graph->update();
+	return *graph;
+}
+
+int CellGraph::bit(RTLIL::SigBit b)
+{
+	auto it = bit_index.find(b);
+	if (it != bit_index.end())
+		return it->second;
+	int id = GetSize(bits);
+	bit_index.emplace(b, id);
+	bits.push_back(b);
+	return id;
+}
+
+void CellGraph::scan(int node)
+{
+	RTLIL::Cell *cell = cells[node];
+	NodeData &data = node_data[node];
+	data.name = cell->name;
+	data.type = cell->type;
+	data.inputs.clear();
+	data.outputs.clear();
+
+	for (auto &conn : cell->connections()) {
+		int dir = port_classifier(cell, conn.first);
+		if (dir == 0)
+			continue;
+		for (auto b : sigmap(conn.second)) {
+			if (!b.wire || (bit_filter && !bit_filter(b)))
+				continue;
+			int id = bit(b);
+			if (dir & PORT_INPUT)
+				data.inputs.push_back(id);
+			if (dir & PORT_OUTPUT)
+				data.outputs.push_back(id);
+		}
+	}
+
+	for (auto vec : {&data.inputs, &data.outputs}) {
+		std::sort(vec->begin(), vec->end());
+		vec->erase(std::unique(vec->begin(), vec->end()), vec->end());
+	}
+}
+
+void CellGraph::rebuild()
+{
+	sigmap.set(module);
+	cells.clear();
+	node_index.clear();
+	bits.clear();
+	bit_index.clear();
+
+	for (auto cell : module->cells())
+		if (cell_filter(cell)) {
+			node_index[cell->name] = GetSize(cells);
+			cells.push_back(cell);
+		}
+
+	node_data.clear();
+	node_data.resize(GetSize(cells));
+	for (int n = 0; n < GetSize(cells); n++)
+		scan(n);
+	num_module_cells = GetSize(module->cells_);
+}
+
+void CellGraph::build_csr()
+{
+	// Drivers of each bit, CSR indexed
+	std::vector<int> driver_start(GetSize(bits) + 1, 0), drivers;
+	for (auto &data : node_data)
+		for (int b : data.outputs)
+			driver_start[b + 1]++;
+	for (int b = 0; b < GetSize(bits); b++)
+		driver_start[b + 1] += driver_start[b];
+	drivers.resize(driver_start.back());
+	std::vector<int> fill(driver_start.begin(), driver_start.end() - 1);
+	for (int n = 0; n < GetSize(node_data); n++)
+		for (int b : node_data[n].outputs)
+			drivers[fill[b]++] = n;
+
+	std::vector<std::pair<int, int>> edges;
+	for (int n = 0; n < GetSize(node_data); n++)
+		for (int b : node_data[n].inputs)
+			for (int i = driver_start[b]; i < driver_start[b + 1]; i++)
+				edges.emplace_back(drivers[i], n);
+	std::sort(edges.begin(), edges.end());
+	edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+	succ_start.assign(GetSize(cells) + 1, 0);
+	succ_nodes.clear();
+	succ_nodes.reserve(edges.size());
+	for (auto &edge : edges) {
+		succ_start[edge.first + 1]++;
+		succ_nodes.push_back(edge.second);
+	}
+	for (int n = 0; n < GetSize(cells); n++)
+		succ_start[n + 1] += succ_start[n];
+}
+
+void CellGraph::update()
+{
+	// Any change of the module that was not reported to the monitor, such as
+	// removed or renamed wires, requires a rebuild, as sigmap and bits may
+	// still refer to deleted wires
+	if (module->content_generation - generation != notified_changes)
+		rebuild_needed = true;
+
+	if (!rebuild_needed) {
+		// Cell type changes are not reported by RTLIL
+		for (int n = 0; n < GetSize(cells); n++)
+			if (cells[n]->type != node_data[n].type)
+				dirty_cells.insert(node_data[n].name);
+		if (dirty_cells.empty()) {
+			generation = module->content_generation;
+			notified_changes = 0;
+			return;
+		}
+	}
+
+	// The incremental update requires the same set of cells
+	if (!rebuild_needed && GetSize(module->cells_) == num_module_cells) {
+		for (int n = 0; n < GetSize(cells) && !rebuild_needed; n++) {
+			auto it = module->cells_.find(node_data[n].name);
+			if (it == module->cells_.end() || it->second != cells[n])
+				rebuild_needed = true;
+		}
+		for (auto name : dirty_cells) {
+			if (rebuild_needed)
+				break;
+			auto it = node_index.find(name);
+			if (it == node_index.end() || !cell_filter(cells[it->second]))
+				rebuild_needed = true;
+			else
+				scan(it->second);
+		}
+	} else
+		rebuild_needed = true;
+
+	if (rebuild_needed)
+		rebuild();
+
+	build_csr();
+	dirty_cells.clear();
+	rebuild_needed = false;
+	generation = module->content_generation;
+	notified_changes = 0;
+}
+
+bool CellGraph::has_self_loop(int node) const
+{
+	auto range = successors(node);
+	return std::binary_search(range.first, range.second, node);
+}
+
+std::vector<std::vector<int>> CellGraph::sccs(const std::vector<bool> *mask) const
+{
+	std::vector<std::vector<int>> components;
+	MaskedCellGraph graph(*this, mask);
+	TopoSortedSccs(graph, [&](int *begin, int *end) {
+		components.emplace_back(begin, end);
+	}).process_all();
+	// Tarjan's algorithm emits the components in reverse topological order
+	std::reverse(components.begin(), components.end());
+	return components;
+}
+
+bool CellGraph::topo_order(std::vector<int> &order, const std::vector<bool> *mask) const
+{
+	bool acyclic = true;
+	order.clear();
+	for (auto &component : sccs(mask)) {
+		if (GetSize(component) > 1 || has_self_loop(component.front()))
+			acyclic = false;
+		order.insert(order.end(), component.begin(), component.end());
+	}
+	return acyclic;
+}
+
+void CellGraph::notify_connect(RTLIL::Cell *cell, RTLIL::IdString, const RTLIL::SigSpec &, const RTLIL::SigSpec &)
+{
+	dirty_cells.insert(cell->name);
+	// Cell::setPort() and unsetPort() count one change before notifying
+	notified_changes++;
+}
+
+void CellGraph::notify_connect(RTLIL::Module *, const RTLIL::SigSig &)
+{
+	rebuild_needed = true;
+}
+
+void CellGraph::notify_connect(RTLIL::Module *, const std::vector<RTLIL::SigSig> &)
+{
+	rebuild_needed = true;
+}
+
+void CellGraph::notify_blackout(RTLIL::Module *)
+{
+	rebuild_needed = true;
+}
+
+YOSYS_NAMESPACE_END
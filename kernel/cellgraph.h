@@ -0,0 +1,142 @@
+/* -*- c++ -*-
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef CELLGRAPH_H
+#define CELLGRAPH_H
+
+#include "kernel/yosys.h"
+#include "kernel/sigtools.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// Cell level dependency graph of a module. A cell has an edge to every cell
+// that reads a (sigmapped) wire bit driven by it. Which cells and ports take
+// part in the graph is decided by a cell filter and a port classifier, the
+// successors are kept in CSR form.
+//
+// The graph is a monitor of its module. update() brings it up to date after
+// changes of the module, rescanning only the cells whose connections were
+// changed if all changes counted by the module's content_generation were
+// reported to the monitor as cell connection changes. Any other change (wires
+// added, removed or renamed, module connections, parameters) rebuilds the
+// graph. Cell type changes (which RTLIL does not report) are detected by
+// comparing the types of all nodes. Code that writes connections_ of cells or
+// modules directly must call invalidate_content_hash() of the module, such
+// changes are otherwise not seen by update().
+//
+// Graphs shared between passes are obtained with CellGraph::get(), which
+// caches them in the module under a key that has to describe the filter and
+// classifier completely. Changes of the port directions of other modules in
+// the design are not detected.
+struct CellGraph : RTLIL::Monitor
+{
+	enum {
+		PORT_INPUT = 1,
+		PORT_OUTPUT = 2,
+		PORT_INOUT = PORT_INPUT | PORT_OUTPUT
+	};
+
+	// Returns false for cells that are not part of the graph
+	typedef std::function<bool(RTLIL::Cell *cell)> CellFilter;
+	// Returns the PORT_* flags for a port, 0 for ports that are ignored
+	typedef std::function<int(RTLIL::Cell *cell, RTLIL::IdString port)> PortClassifier;
+	// Returns false for bits that do not connect cells
+	typedef std::function<bool(RTLIL::SigBit bit)> BitFilter;
+
+	RTLIL::Module *module;
+	SigMap sigmap;
+
+	// Nodes in the order of module->cells()
+	std::vector<RTLIL::Cell*> cells;
+	dict<RTLIL::IdString, int> node_index;
+	// Wire bits connecting cells, indexed by the bit ids of the nodes
+	std::vector<RTLIL::SigBit> bits;
+
+	CellGraph(RTLIL::Module *module, CellFilter cell_filter, PortClassifier port_classifier, BitFilter bit_filter = nullptr);
+	~CellGraph();
+
+	// Returns the graph of `module` cached under `key`, creating it if needed.
+	// The filter and classifier must not refer to state outside of the
+	// functions and the design.
+	static CellGraph &get(RTLIL::Module *module, const std::string &key, CellFilter cell_filter, PortClassifier port_classifier);
+
+	// Brings the graph up to date with the module, incrementally if possible
+	void update();
+
+	int node(RTLIL::Cell *cell) const
+	{
+		auto it = node_index.find(cell->name);
+		return it == node_index.end() || cells[it->second] != cell ? -1 : it->second;
+	}
+	int size() const { return GetSize(cells); }
+
+	// Successors of a node, as a range of node ids
+	std::pair<const int*, const int*> successors(int node) const
+	{
+		return {succ_nodes.data() + succ_start[node], succ_nodes.data() + succ_start[node + 1]};
+	}
+	bool has_self_loop(int node) const;
+
+	// Bit ids of the inputs and outputs of a node
+	const std::vector<int> &inputs(int node) const { return node_data[node].inputs; }
+	const std::vector<int> &outputs(int node) const { return node_data[node].outputs; }
+
+	// Strongly connected components in topological order (drivers first).
+	// With a mask only the subgraph induced by the nodes set in the mask is
+	// considered.
+	std::vector<std::vector<int>> sccs(const std::vector<bool> *mask = nullptr) const;
+	// Nodes in topological order, nodes of a cycle are in arbitrary order.
+	// Returns false if there are cycles (including self loops).
+	bool topo_order(std::vector<int> &order, const std::vector<bool> *mask = nullptr) const;
+
+	void notify_connect(RTLIL::Cell *cell, RTLIL::IdString port, const RTLIL::SigSpec &old_sig, const RTLIL::SigSpec &new_sig) override;
+	void notify_connect(RTLIL::Module *module, const RTLIL::SigSig &sigsig) override;
+	void notify_connect(RTLIL::Module *module, const std::vector<RTLIL::SigSig> &sigsig_vec) override;
+	void notify_blackout(RTLIL::Module *module) override;
+
+private:
+	struct NodeData
+	{
+		RTLIL::IdString name, type;
+		std::vector<int> inputs, outputs;
+	};
+
+	CellFilter cell_filter;
+	PortClassifier port_classifier;
+	BitFilter bit_filter;
+
+	std::vector<NodeData> node_data;
+	dict<RTLIL::SigBit, int> bit_index;
+	std::vector<int> succ_start, succ_nodes;
+
+	pool<RTLIL::IdString> dirty_cells;
+	bool rebuild_needed = true;
+	unsigned int generation = 0;
+	// Changes of content_generation since the last update that were reported
+	// through notify_connect() for a cell
+	unsigned int notified_changes = 0;
+	int num_module_cells = 0;
+
+	int bit(RTLIL::SigBit b);
+	void scan(int node);
+	void rebuild();
+	void build_csr();
+};
+
+YOSYS_NAMESPACE_END
+
+#endif
@@ -0,0 +1,329 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/coi.h"
+#include "kernel/sigtools.h"
+#include "kernel/celltypes.h"
+#include "kernel/ffinit.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+static bool is_property_cell(RTLIL::Cell *cell)
+{
+	return cell->type.in(ID($assert), ID($assume), ID($cover), ID($live), ID($fair), ID($check));
+}
+
+static bool is_commutative(RTLIL::Cell *cell)
+{
+	if (cell->type.in(ID($_AND_), ID($_NAND_), ID($_OR_), ID($_NOR_), ID($_XOR_), ID($_XNOR_)))
+		return true;
+	if (!cell->type.in(ID($and), ID($or), ID($xor), ID($xnor), ID($add), ID($mul),
+			ID($eq), ID($ne), ID($eqx), ID($nex), ID($logic_and), ID($logic_or)))
+		return false;
+	return cell->getParam(ID::A_SIGNED) == cell->getParam(ID::B_SIGNED) &&
+			cell->getParam(ID::A_WIDTH) == cell->getParam(ID::B_WIDTH);
+}
+
+int CoiReduction::strash_round(RTLIL::Module *module)
+{
+	static CellTypes ct_comb;
+	if (ct_comb.cell_types.empty()) {
+		ct_comb.setup_internals_eval();
+		ct_comb.setup_stdcells();
+	}
+
+	SigMap sigmap(module);
+	FfInitVals initvals(&sigmap, module);
+
+	// Output bits of merged cells point to the outputs of the cell they
+	// were merged into. That cell is never merged itself in this round, so
+	// one lookup suffices.
+	dict<RTLIL::SigBit, RTLIL::SigBit> replaced;
+	auto canonical = [&](RTLIL::SigSpec sig) {
+		sigmap.apply(sig);
+		for (auto &bit : sig) {
+			auto it = replaced.find(bit);
+			if (it != replaced.end())
+				bit = it->second;
+		}
+		return sig;
+	};
+
+	std::vector<RTLIL::Cell*> comb_cells, ff_cells;
+	for (auto cell : module->cells()) {
+		if (cell->has_keep_attr())
+			continue;
+		bool const_output = false;
+		for (auto &conn : cell->connections())
+			if (cell->output(conn.first) && conn.second.has_const())
+				const_output = true;
+		if (const_output)
+			continue;
+		if (ct_comb.cell_known(cell->type))
+			comb_cells.push_back(cell);
+		else if (RTLIL::builtin_ff_cell_types().count(cell->type) && cell->type != ID($anyinit))
+			ff_cells.push_back(cell);
+	}
+
+	// Order combinational cells topologically so that all inputs of a cell
+	// are canonical by the time the cell is hashed.
+	dict<RTLIL::SigBit, int> bit_driver;
+	for (int i = 0; i < GetSize(comb_cells); i++)
+		for (auto &conn : comb_cells[i]->connections())
+			if (comb_cells[i]->output(conn.first))
+				for (auto bit : sigmap(conn.second))
+					bit_driver[bit] = i;
+
+	std::vector<std::vector<int>> users(comb_cells.size());
+	std::vector<int> pending(comb_cells.size());
+	for (int i = 0; i < GetSize(comb_cells); i++) {
+		pool<int> drivers;
+		for (auto &conn : comb_cells[i]->connections())
+			if (comb_cells[i]->input(conn.first))
+				for (auto bit : sigmap(conn.second)) {
+					auto it = bit_driver.find(bit);
+					if (it != bit_driver.end() && it->second != i)
+						drivers.insert(it->second);
+				}
+		pending[i] = GetSize(drivers);
+		for (int d : drivers)
+			users[d].push_back(i);
+	}
+
+	std::vector<RTLIL::Cell*> order;
+	std::vector<int> queue;
+	for (int i = 0; i < GetSize(comb_cells); i++)
+		if (pending[i] == 0)
+			queue.push_back(i);
+	for (int q = 0; q < GetSize(queue); q++) {
+		order.push_back(comb_cells[queue[q]]);
+		for (int u : users[queue[q]])
+			if (--pending[u] == 0)
+				queue.push_back(u);
+	}
+	// Cells on combinational loops are hashed last
+	for (int i = 0; i < GetSize(comb_cells); i++)
+		if (pending[i] > 0)
+			order.push_back(comb_cells[i]);
+	order.insert(order.end(), ff_cells.begin(), ff_cells.end());
+
+	dict<std::pair<std::string, std::vector<RTLIL::SigBit>>, RTLIL::Cell*> cache;
+	std::vector<RTLIL::Cell*> to_remove;
+
+	for (auto cell : order)
+	{
+		std::string key = cell->type.str();
+		for (auto &param : cell->parameters)
+			key += stringf(" %s=%s", param.first.c_str(), param.second.as_string());
+
+		if (RTLIL::builtin_ff_cell_types().count(cell->type)) {
+			Const init = initvals(cell->getPort(ID::Q));
+			if (!init.is_fully_def())
+				continue;
+			key += " init=" + init.as_string();
+		}
+
+		std::vector<RTLIL::IdString> ports;
+		for (auto &conn : cell->connections())
+			if (cell->input(conn.first))
+				ports.push_back(conn.first);
+		std::sort(ports.begin(), ports.end(), RTLIL::sort_by_id_str());
+
+		dict<RTLIL::IdString, RTLIL::SigSpec> inputs;
+		for (auto port : ports)
+			inputs[port] = canonical(cell->getPort(port));
+		if (is_commutative(cell) && inputs.count(ID::B) && inputs.at(ID::B) < inputs.at(ID::A))
+			std::swap(inputs.at(ID::A), inputs.at(ID::B));
+
+		std::vector<RTLIL::SigBit> bits;
+		for (auto port : ports) {
+			key += stringf(" %s:%d", port.c_str(), GetSize(inputs.at(port)));
+			for (auto bit : inputs.at(port))
+				bits.push_back(bit);
+		}
+
+		auto it = cache.find(std::make_pair(key, bits));
+		if (it == cache.end()) {
+			cache[std::make_pair(std::move(key), std::move(bits))] = cell;
+			continue;
+		}
+
+		RTLIL::Cell *other = it->second;
+		for (auto &conn : cell->connections()) {
+			if (!cell->output(conn.first))
+				continue;
+			RTLIL::SigSpec other_sig = other->getPort(conn.first);
+			module->connect(conn.second, other_sig);
+			RTLIL::SigSpec from = sigmap(conn.second), to = sigmap(other_sig);
+			for (int i = 0; i < GetSize(from); i++)
+				if (from[i].wire != nullptr)
+					replaced[from[i]] = to[i];
+		}
+		to_remove.push_back(cell);
+	}
+
+	for (auto cell : to_remove)
+		module->remove(cell);
+	return GetSize(to_remove);
+}
+
+void CoiReduction::remove_outside_coi(RTLIL::Module *module, bool is_top)
+{
+	SigMap sigmap(module);
+
+	dict<RTLIL::SigBit, RTLIL::Cell*> bit_driver;
+	dict<RTLIL::IdString, std::vector<RTLIL::Cell*>> mem_cells;
+	for (auto cell : module->cells()) {
+		for (auto &conn : cell->connections())
+			if (cell->output(conn.first))
+				for (auto bit : sigmap(conn.second))
+					bit_driver[bit] = cell;
+		if (cell->is_mem_cell())
+			mem_cells[cell->getParam(ID::MEMID).decode_string()].push_back(cell);
+	}
+
+	pool<RTLIL::Cell*> cone;
+	pool<RTLIL::SigBit> used_bits;
+	std::vector<RTLIL::Cell*> queue;
+
+	auto add_cell = [&](RTLIL::Cell *cell) {
+		if (cone.insert(cell).second)
+			queue.push_back(cell);
+	};
+	auto add_sig = [&](const RTLIL::SigSpec &sig) {
+		for (auto bit : sigmap(sig)) {
+			if (bit.wire == nullptr || !used_bits.insert(bit).second)
+				continue;
+			auto it = bit_driver.find(bit);
+			if (it != bit_driver.end())
+				add_cell(it->second);
+		}
+	};
+
+	for (auto cell : module->cells())
+		if (is_property_cell(cell) || cell->has_keep_attr() || module->design->module(cell->type) != nullptr)
+			add_cell(cell);
+
+	for (auto wire : module->wires())
+		if (wire->get_bool_attribute(ID::keep) || (wire->port_output && (keep_outputs || !is_top)))
+			add_sig(wire);
+
+	for (int i = 0; i < GetSize(queue); i++)
+	{
+		RTLIL::Cell *cell = queue[i];
+		for (auto &conn : cell->connections()) {
+			if (cell->output(conn.first))
+				for (auto bit : sigmap(conn.second))
+					used_bits.insert(bit);
+			else
+				add_sig(conn.second);
+		}
+		if (cell->is_mem_cell())
+			for (auto other : mem_cells.at(cell->getParam(ID::MEMID).decode_string()))
+				add_cell(other);
+	}
+
+	std::vector<RTLIL::Cell*> remove_cells;
+	for (auto cell : module->cells())
+		if (!cone.count(cell))
+			remove_cells.push_back(cell);
+	for (auto cell : remove_cells)
+		module->remove(cell);
+
+	pool<RTLIL::IdString> used_memids;
+	for (auto cell : module->cells())
+		if (cell->is_mem_cell())
+			used_memids.insert(cell->getParam(ID::MEMID).decode_string());
+	std::vector<RTLIL::IdString> remove_memids;
+	for (auto &it : module->memories)
+		if (!used_memids.count(it.first))
+			remove_memids.push_back(it.first);
+	for (auto memid : remove_memids) {
+		delete module->memories.at(memid);
+		module->memories.erase(memid);
+	}
+
+	pool<RTLIL::Wire*> remove_wires;
+	bool removed_ports = false;
+	for (auto wire : module->wires()) {
+		if (wire->port_input || wire->get_bool_attribute(ID::keep))
+			continue;
+		bool used = false;
+		for (auto bit : sigmap(wire))
+			if (bit.wire == nullptr || used_bits.count(bit)) {
+				used = true;
+				break;
+			}
+		if (used)
+			continue;
+		if (wire->port_output) {
+			if (keep_outputs || !is_top)
+				continue;
+			wire->port_output = false;
+			removed_ports = true;
+		}
+		remove_wires.insert(wire);
+	}
+	module->remove(remove_wires);
+	if (removed_ports)
+		module->fixup_ports();
+}
+
+void CoiReduction::run(RTLIL::Module *module, bool is_top)
+{
+	if (module->has_processes())
+		return;
+
+	cells_before += GetSize(module->cells());
+	wires_before += GetSize(module->wires());
+
+	if (strash) {
+		int merged;
+		do {
+			merged = strash_round(module);
+			merged_cells += merged;
+		} while (merged > 0);
+	}
+
+	remove_outside_coi(module, is_top);
+
+	cells_after += GetSize(module->cells());
+	wires_after += GetSize(module->wires());
+}
+
+RTLIL::Design *CoiReduction::reduced_copy(RTLIL::Design *design)
+{
+	RTLIL::Module *top = design->top_module();
+
+	RTLIL::Design *copy = new RTLIL::Design;
+	for (auto module : design->modules())
+		copy->add(module->clone());
+
+	for (auto module : copy->modules())
+		if (!module->get_blackbox_attribute())
+			run(module, top != nullptr && module->name == top->name);
+
+	return copy;
+}
+
+void CoiReduction::log_summary() const
+{
+	log("Model reduction: %d -> %d cells, %d -> %d wires (%d cells merged by structural hashing).\n",
+			cells_before, cells_after, wires_before, wires_after, merged_cells);
+}
+
+YOSYS_NAMESPACE_END
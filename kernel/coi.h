@@ -0,0 +1,58 @@
+/* -*- c++ -*-
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef COI_H
+#define COI_H
+
+#include "kernel/yosys.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// Model reduction for the formal backends (write_btor, write_smt2).
+//
+// Structural hashing merges cells of the same type and parameters that have
+// identical inputs (combinational cells, and flip-flops with fully defined
+// initial values). Cone-of-influence reduction then removes all cells and
+// wires that cannot affect a formal property ($assert, $assume, $cover,
+// $live, $fair, $check), a cell or wire with the keep attribute, a submodule
+// instance or (for non-top modules, or with keep_outputs) a module output.
+// Top module outputs outside of the cone are removed from the port list.
+struct CoiReduction
+{
+	bool keep_outputs = false;
+	bool strash = true;
+
+	int cells_before = 0, cells_after = 0;
+	int wires_before = 0, wires_after = 0;
+	int merged_cells = 0;
+
+	// Reduces the module in place
+	void run(RTLIL::Module *module, bool is_top);
+
+	// Returns a reduced copy of the design, leaving the original untouched
+	RTLIL::Design *reduced_copy(RTLIL::Design *design);
+
+	void log_summary() const;
+
+private:
+	int strash_round(RTLIL::Module *module);
+	void remove_outside_coi(RTLIL::Module *module, bool is_top);
+};
+
+YOSYS_NAMESPACE_END
+
+#endif
@@ -239,6 +239,9 @@ int main(int argc, char **argv)
 #endif // YOSYS_ENABLE_PYTHON
 		("p,commands", "execute <commands> (to chain commands, separate them with semicolon + whitespace: 'cmd1; cmd2')",
 			cxxopts::value<std::vector<std::string>>(), "<commands>")
+		("server", "after executing the other options, serve scripts on the Unix domain socket <path> " \
+			"and keep designs and library caches in memory between them (see 'help server')",
+			cxxopts::value<std::string>(), "<path>")
 		("r,top", "elaborate the specified HDL <top> module",
 			cxxopts::value<std::string>(), "<top>")
 		("m,plugin", "load the specified <plugin> module",
@@ -271,7 +274,8 @@ int main(int argc, char **argv)
 		("d,detailed-timing", "print more detailed timing stats at exit")
 		("l,logfile", "write log messages to <logfile>",
 			cxxopts::value<std::vector<std::string>>(), "<logfile>")
-		("L,line-buffered-logfile", "like -l but open <logfile> in line buffered mode",
+		("L,line-buffered-logfile", "like -l but open <logfile> in line buffered mode and write it " \
+						   "synchronously, so that it is complete if Yosys crashes",
 			cxxopts::value<std::vector<std::string>>(), "<logfile>")
 		("o,outfile", "write the design to <outfile> on exit",
 			cxxopts::value<std::string>(), "<outfile>")
@@ -363,6 +367,10 @@ int main(int argc, char **argv)
 			passes_commands.insert(passes_commands.end(), cmds.begin(), cmds.end());
 			run_shell = false;
 		}
+		if (result.count("server")) {
+			passes_commands.push_back("server " + result["server"].as<std::string>());
+			run_shell = false;
+		}
 		if (result.count("o")) {
 			output_filename = result["o"].as<std::string>();
 			run_shell = false;
@@ -372,7 +380,10 @@ int main(int argc, char **argv)
 				for (const auto& filename : result[key].as<std::vector<std::string>>()) {
 					if (FILE* f = fopen(filename.c_str(), "wt")) {
 						log_files.push_back(f);
+						// Line buffered log files are meant to survive crashes,
+						// the others are written in the background
 						if (key[0] == 'L') setvbuf(f, NULL, _IOLBF, 0);
+						else log_file_async(f);
 					} else {
 						std::cerr << "Can't open log file `" << filename << "' for writing!\n";
 						exit(1);
@@ -666,6 +677,7 @@ int main(int argc, char **argv)
 
 		if (mode_v && !mode_q)
 			log_files.push_back(stderr);
+		log_outputs_changed();
 
 		if (log_warnings_count)
 			log("Warnings: %d unique messages, %d total\n", GetSize(log_warnings), log_warnings_count);
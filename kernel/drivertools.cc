@@ -18,6 +18,9 @@
  */
 
 #include "kernel/drivertools.h"
+#include "kernel/threading.h"
+
+#include <utility>
 
 YOSYS_NAMESPACE_BEGIN
 
@@ -568,11 +571,8 @@ DriverMap::DriveBitId DriverMap::id_from_drive_bit(DriveBit const &bit)
 			int offset = next_offset;
 			auto insertion = wire_offsets.emplace(wire_bit.wire, offset);
 			if (insertion.second) {
-				if (wire_bit.wire->width == 1) {
-					log_assert(wire_bit.offset == 0);
-					isolated_drive_bits.emplace(offset, bit);
-				} else
-					drive_bits.emplace(offset, DriveBitWire(wire_bit.wire, 0));
+				range_starts.push_back(offset);
+				range_bits.push_back(DriveBitWire(wire_bit.wire, 0));
 				next_offset += wire_bit.wire->width;
 			}
 			return insertion.first->second.id + wire_bit.offset;
@@ -583,13 +583,9 @@ DriverMap::DriveBitId DriverMap::id_from_drive_bit(DriveBit const &bit)
 			int offset = next_offset;
 			auto insertion = port_offsets.emplace(key, offset);
 			if (insertion.second) {
-				int width = port_bit.cell->connections().at(port_bit.port).size();
-				if (width == 1 && offset == 0) {
-					log_assert(port_bit.offset == 0);
-					isolated_drive_bits.emplace(offset, bit);
-				} else
-					drive_bits.emplace(offset, DriveBitPort(port_bit.cell, port_bit.port, 0));
-				next_offset += width;
+				range_starts.push_back(offset);
+				range_bits.push_back(DriveBitPort(port_bit.cell, port_bit.port, 0));
+				next_offset += port_bit.cell->connections().at(port_bit.port).size();
 			}
 			return insertion.first->second.id + port_bit.offset;
 		}
@@ -601,25 +597,56 @@ DriverMap::DriveBitId DriverMap::id_from_drive_bit(DriveBit const &bit)
 
 DriveBit DriverMap::drive_bit_from_id(DriveBitId id)
 {
-	auto found_isolated = isolated_drive_bits.find(id);
-	if (found_isolated != isolated_drive_bits.end())
-		return found_isolated->second;
-
-	auto found = drive_bits.upper_bound(id);
-	if (found == drive_bits.begin()) {
+	auto found = std::upper_bound(range_starts.begin(), range_starts.end(), id.id);
+	if (found == range_starts.begin()) {
 		return id < 0 ? DriveBit() : DriveBit((State) id.id);
 	}
-	--found;
-	DriveBit result = found->second;
+	int index = found - range_starts.begin() - 1;
+	DriveBit result = range_bits[index];
 	if (result.is_wire()) {
-		result.wire().offset += id.id - found->first.id;
+		result.wire().offset += id.id - range_starts[index];
 	} else {
 		log_assert(result.is_port());
-		result.port().offset += id.id - found->first.id;
+		result.port().offset += id.id - range_starts[index];
 	}
 	return result;
 }
 
+DriverMap::DriveBitId DriverMap::allocated_id(SigBit const &bit) const
+{
+	if (bit.wire == nullptr)
+		return (int)bit.data;
+	return wire_offsets.at(bit.wire).id + bit.offset;
+}
+
+DriverMap::BitMode DriverMap::id_mode(DriveBitId id)
+{
+	if (id.id >= 0 && id.id < GetSize(bit_modes))
+		return bit_modes[id.id];
+	return bit_mode(drive_bit_from_id(id));
+}
+
+void DriverMap::update_bit_modes()
+{
+	int begin = GetSize(bit_modes);
+	bit_modes.resize(next_offset);
+
+	// All bits of a constant, wire or cell port range share the same mode
+	for (int id = begin; id < 1 + (int)State::Sm; id++)
+		bit_modes[id] = bit_mode(DriveBit((State) id));
+
+	// The range containing `begin` starts before it
+	auto first = std::upper_bound(range_starts.begin(), range_starts.end(), begin);
+	if (first != range_starts.begin())
+		--first;
+	for (int index = first - range_starts.begin(); index < GetSize(range_starts); index++) {
+		BitMode mode = bit_mode(range_bits[index]);
+		int end = index + 1 < GetSize(range_starts) ? range_starts[index + 1] : next_offset;
+		for (int id = std::max(begin, range_starts[index]); id < end; id++)
+			bit_modes[id] = mode;
+	}
+}
+
 void DriverMap::connect_directed_merge(DriveBitId driven_id, DriveBitId driver_id)
 {
 	if (driven_id == driver_id)
@@ -651,31 +678,99 @@ void DriverMap::connect_undirected(DriveBitId a_id, DriveBitId b_id)
 
 void DriverMap::add(Module *module)
 {
-	for (auto const &conn : module->connections())
-		add(conn.first, conn.second);
-
-	for (auto cell : module->cells())
+	// Allocate the ids of all wires and cell ports up front. Afterwards
+	// turning connections into pairs of ids only reads the map and is done
+	// in parallel for chunks of cells. The pairs are then added serially,
+	// in the same order as adding the connections one by one.
+	for (auto wire : module->wires())
+		if (wire->width > 0)
+			id_from_drive_bit(DriveBitWire(wire, 0));
+
+	std::vector<Cell *> cells = module->cells().to_vector();
+	for (auto cell : cells)
 		for (auto const &conn : cell->connections())
-			add_port(cell, conn.first, conn.second);
+			if (conn.second.size() > 0)
+				id_from_drive_bit(DriveBitPort(cell, conn.first, 0));
+
+	update_bit_modes();
+
+	const int chunk_size = 1024;
+	int num_cell_jobs = (GetSize(cells) + chunk_size - 1) / chunk_size;
+	// Job 0 handles the module connections
+	std::vector<std::vector<std::pair<int, int>>> job_pairs(1 + num_cell_jobs);
+
+	// The jobs run concurrently, so the shared dicts may only be used through
+	// const lookups, as non-const ones can trigger a pending rehash
+	auto run_job = [&](int job) {
+		auto &pairs = job_pairs[job];
+		if (job == 0) {
+			for (auto const &conn : module->connections()) {
+				log_assert(conn.first.size() == conn.second.size());
+				for (int i = 0; i < conn.first.size(); i++)
+					pairs.emplace_back(allocated_id(conn.first[i]).id, allocated_id(conn.second[i]).id);
+			}
+			return;
+		}
+		int end = std::min(job * chunk_size, GetSize(cells));
+		for (int i = (job - 1) * chunk_size; i < end; i++) {
+			Cell *cell = cells[i];
+			for (auto const &conn : cell->connections()) {
+				if (conn.second.size() == 0)
+					continue;
+				int port_id = std::as_const(port_offsets).at({cell, conn.first}).id;
+				int offset = 0;
+				for (auto const &chunk : conn.second.chunks()) {
+					for (int k = 0; k < chunk.width; k++) {
+						int sig_id = chunk.wire ? std::as_const(wire_offsets).at(chunk.wire).id + chunk.offset + k : (int)chunk.data[k];
+						pairs.emplace_back(sig_id, port_id + offset + k);
+					}
+					offset += chunk.width;
+				}
+			}
+		}
+	};
+
+	int num_workers = num_cell_jobs > 1 ? ThreadPool::pool_size(1, num_cell_jobs) : 0;
+	ConcurrentQueue<int> jobs;
+	{
+		ThreadPool pool(num_workers, [&](int) {
+				while (std::optional<int> job = jobs.pop_front())
+					run_job(*job);
+			});
+		for (int job = 0; job < GetSize(job_pairs); job++) {
+			if (num_workers == 0)
+				run_job(job);
+			else
+				jobs.push_back(job);
+		}
+		jobs.close();
+		while (std::optional<int> job = jobs.pop_front())
+			run_job(*job);
+	}
+
+	for (auto &pairs : job_pairs) {
+		for (auto const &pair : pairs)
+			add_ids(pair.first, pair.second);
+		pairs = {};
+	}
 }
 
 // Add a single bit connection to the driver map.
 void DriverMap::add(DriveBit const &a, DriveBit const &b)
 {
-	DriveBitId a_id = id_from_drive_bit(a);
-	DriveBitId b_id = id_from_drive_bit(b);
-
-	DriveBitId orig_a_id = a_id;
-	DriveBitId orig_b_id = b_id;
+	add_ids(id_from_drive_bit(a), id_from_drive_bit(b));
+}
 
+void DriverMap::add_ids(DriveBitId a_id, DriveBitId b_id)
+{
 	a_id = same_driver.find(a_id);
 	b_id = same_driver.find(b_id);
 
 	if (a_id == b_id)
 		return;
 
-	BitMode a_mode = bit_mode(orig_a_id == a_id ? a : drive_bit_from_id(a_id));
-	BitMode b_mode = bit_mode(orig_b_id == b_id ? b : drive_bit_from_id(b_id));
+	BitMode a_mode = id_mode(a_id);
+	BitMode b_mode = id_mode(b_id);
 
 	// If either bit is just a wire that we don't need to keep, merge and
 	// use the other end as representative bit.
@@ -767,9 +862,8 @@ void DriverMap::orient_undirected(DriveBitId id)
 
 	for (int pos = 0; pos < GetSize(seen); ++pos) {
 		DriveBitId current = *seen.element(seen.size() - 1 - pos);
-		DriveBit bit = drive_bit_from_id(current);
 
-		BitMode mode = bit_mode(bit);
+		BitMode mode = id_mode(current);
 
 		if (mode == BitMode::DRIVER || mode == BitMode::TRISTATE)
 			drivers.emplace(current);
@@ -830,7 +924,7 @@ DriveBit DriverMap::operator()(DriveBit const &bit)
 
 	DriveBit bit_repr = drive_bit_from_id(bit_repr_id);
 
-	BitMode mode = bit_mode(bit_repr);
+	BitMode mode = id_mode(bit_repr_id);
 
 	if (mode == BitMode::KEEP && bit_repr_id != bit_id)
 		return bit_repr;
@@ -1143,16 +1143,12 @@ private:
 	// for that cell port.
 	dict<pair<Cell *, IdString>, DriveBitId> port_offsets;
 
-	// For the inverse map that maps DriveBitIds back to DriveBits we use a
-	// sorted map containing only the first DriveBit for each wire and cell
-	// port.
-	std::map<DriveBitId, DriveBit> drive_bits;
-
-	// As a memory optimization for gate level net lists we store single-bit
-	// wires and cell ports in a `dict` which requires less memory and fewer
-	// allocations than `std::map` but doesn't support the kind of lookups we
-	// need for a sparse coarse grained mapping.
-	dict<DriveBitId, DriveBit> isolated_drive_bits;
+	// For the inverse map that maps DriveBitIds back to DriveBits we store
+	// only the first DriveBit for each wire and cell port, next to the first
+	// DriveBitId of its range. Ids are allocated in increasing order, so
+	// appending keeps `range_starts` sorted and lookups are binary searches.
+	std::vector<int> range_starts;
+	std::vector<DriveBit> range_bits;
 
 	// Used for allocating DriveBitIds, none and constant states use a fixewd
 	// mapping to the first few ids, which we need to skip.
@@ -1194,9 +1190,18 @@ private:
 		DRIVER = 5, // Drives a value
 	};
 
+	// BitMode of every DriveBitId below its size, filled in by add(Module *)
+	// for all ids allocated up to that point
+	std::vector<BitMode> bit_modes;
+
 	BitMode bit_mode(DriveBit const &bit);
+	BitMode id_mode(DriveBitId id);
+	void update_bit_modes();
 	DriveBitId id_from_drive_bit(DriveBit const &bit);
 	DriveBit drive_bit_from_id(DriveBitId id);
+	// Only for wires and ports with allocated ids, doesn't modify the map
+	DriveBitId allocated_id(SigBit const &bit) const;
+	void add_ids(DriveBitId a_id, DriveBitId b_id);
 
 	void connect_directed_merge(DriveBitId driven_id, DriveBitId driver_id);
 	void connect_directed_buffer(DriveBitId driven_id, DriveBitId driver_id);
@@ -1255,7 +1260,7 @@ public:
 private:
 	bool keep_wire(Wire *wire) {
 		// TODO configurable
-		return wire->has_attribute(ID(keep));
+		return wire->has_attribute(ID::keep);
 	}
 };
 
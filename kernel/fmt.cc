@@ -652,8 +652,14 @@ std::string escape_cxx_string(const std::string &input)
 void Fmt::emit_cxxrtl(std::ostream &os, std::string indent, std::function<void(const RTLIL::SigSpec &)> emit_sig, const std::string &context) const
 {
 	os << indent << "std::string buf;\n";
-	for (auto &part : parts) {
-		os << indent << "buf += fmt_part { ";
+	for (size_t index = 0; index < parts.size(); index++) {
+		auto &part = parts[index];
+		if (part.type == FmtPart::LITERAL) {
+			os << indent << "buf += " << escape_cxx_string(part.str) << ";\n";
+			continue;
+		}
+		// The parts are constant, so they are only constructed once
+		os << indent << "static const fmt_part part" << index << " { ";
 		os << "fmt_part::";
 		switch (part.type) {
 			case FmtPart::LITERAL:   os << "LITERAL";   break;
@@ -686,196 +692,296 @@ void Fmt::emit_cxxrtl(std::ostream &os, std::string indent, std::function<void(c
 		os << part.show_base << ", ";
 		os << part.group << ", ";
 		os << part.realtime;
-		os << " }.render(";
+		os << " };\n";
+		os << indent << "buf += part" << index << ".render(";
 		emit_sig(part.sig);
 		os << ", " << context << ");\n";
 	}
 	os << indent << "return buf;\n";
 }
 
-std::string Fmt::render() const
+// Renders a fully defined integer of at most 64 bits with native arithmetic.
+// Produces the digits in reverse order, exactly as the generic path below.
+static bool render_integer_fast(const FmtPart &part, const RTLIL::Const &value, std::string &buf, std::string &prefix)
 {
-	std::string str;
+	int width = value.size();
+	if (width == 0 || width > 64 || !value.is_fully_def())
+		return false;
+	if (part.base != 2 && part.base != 8 && part.base != 10 && part.base != 16)
+		return false;
+
+	uint64_t bits = 0;
+	for (int index = 0; index < width; index++)
+		if (value[index] == State::S1)
+			bits |= uint64_t(1) << index;
+
+	if (part.signed_ && ((bits >> (width - 1)) & 1)) {
+		prefix = "-";
+		if (width < 64)
+			bits |= ~uint64_t(0) << width;
+		bits = 0 - bits;
+	} else {
+		switch (part.sign) {
+			case FmtPart::MINUS:       break;
+			case FmtPart::PLUS_MINUS:  prefix = "+"; break;
+			case FmtPart::SPACE_MINUS: prefix = " "; break;
+		}
+	}
 
-	for (auto &part : parts) {
-		switch (part.type) {
-			case FmtPart::LITERAL:
-				str += part.str;
-				break;
+	if (part.base == 10) {
+		if (part.show_base)
+			prefix += "0d";
+		if (bits == 0)
+			buf += '0';
+		for (size_t index = 0; bits != 0; index++) {
+			if (part.group && index > 0 && index % 3 == 0)
+				buf += '_';
+			buf += (char)('0' + bits % 10);
+			bits /= 10;
+		}
+		return true;
+	}
 
-			case FmtPart::UNICHAR: {
-				RTLIL::Const value = part.sig.as_const();
-				uint32_t codepoint = value.as_int();
-				if (codepoint >= 0x10000)
-					str += (char)(0xf0 |  (codepoint >> 18));
-				else if (codepoint >= 0x800)
-					str += (char)(0xe0 |  (codepoint >> 12));
-				else if (codepoint >= 0x80)
-					str += (char)(0xc0 |  (codepoint >>  6));
-				else
-					str += (char)codepoint;
-				if (codepoint >= 0x10000)
-					str += (char)(0x80 | ((codepoint >> 12) & 0x3f));
-				if (codepoint >= 0x800)
-					str += (char)(0x80 | ((codepoint >>  6) & 0x3f));
-				if (codepoint >= 0x80)
-					str += (char)(0x80 | ((codepoint >>  0) & 0x3f));
-				break;
-			}
+	size_t minimum_size = 1;
+	while (minimum_size < 64 && (bits >> minimum_size) != 0)
+		minimum_size++;
+
+	if (part.base == 2) {
+		if (part.show_base)
+			prefix += "0b";
+		for (size_t index = 0; index < minimum_size; index++) {
+			if (part.group && index > 0 && index % 4 == 0)
+				buf += '_';
+			buf += ((bits >> index) & 1) ? '1' : '0';
+		}
+	} else {
+		if (part.show_base)
+			prefix += (part.base == 16) ? (part.hex_upper ? "0X" : "0x") : "0o";
+		size_t step = (part.base == 16) ? 4 : 3;
+		for (size_t index = 0; index < minimum_size; index += step) {
+			if (part.group && index > 0 && index % (4 * step) == 0)
+				buf += '_';
+			buf += (part.hex_upper ? "0123456789ABCDEF" : "0123456789abcdef")[(bits >> index) & ((1 << step) - 1)];
+		}
+	}
+	return true;
+}
 
-			case FmtPart::INTEGER:
-			case FmtPart::STRING:
-			case FmtPart::VLOG_TIME: {
-				std::string buf;
-				std::string prefix;
-				if (part.type == FmtPart::INTEGER) {
-					RTLIL::Const value = part.sig.as_const();
-					bool has_x = false, all_x = true, has_z = false, all_z = true;
-					for (State bit : value) {
-						if (bit == State::Sx)
-							has_x = true;
-						else
-							all_x = false;
-						if (bit == State::Sz)
-							has_z = true;
-						else
-							all_z = false;
-					}
+static void render_integer(const FmtPart &part, RTLIL::Const value, std::string &buf, std::string &prefix)
+{
+	bool has_x = false, all_x = true, has_z = false, all_z = true;
+	for (State bit : value) {
+		if (bit == State::Sx)
+			has_x = true;
+		else
+			all_x = false;
+		if (bit == State::Sz)
+			has_z = true;
+		else
+			all_z = false;
+	}
 
-					if (!has_z && !has_x && part.signed_ && value[value.size() - 1]) {
-						prefix = "-";
-						value = RTLIL::const_neg(value, {}, part.signed_, {}, value.size() + 1);
-					} else {
-						switch (part.sign) {
-							case FmtPart::MINUS:       break;
-							case FmtPart::PLUS_MINUS:  prefix = "+"; break;
-							case FmtPart::SPACE_MINUS: prefix = " "; break;
-						}
-					}
+	if (!has_z && !has_x && part.signed_ && value[value.size() - 1]) {
+		prefix = "-";
+		value = RTLIL::const_neg(value, {}, part.signed_, {}, value.size() + 1);
+	} else {
+		switch (part.sign) {
+			case FmtPart::MINUS:       break;
+			case FmtPart::PLUS_MINUS:  prefix = "+"; break;
+			case FmtPart::SPACE_MINUS: prefix = " "; break;
+		}
+	}
 
-					if (part.base != 10) {
-						size_t minimum_size = 1;
-						for (size_t index = 0; index < (size_t)value.size(); index++)
-							if (value[index] != State::S0)
-								minimum_size = index + 1;
-						value = value.extract(0, minimum_size);
-					}
+	if (part.base != 10) {
+		size_t minimum_size = 1;
+		for (size_t index = 0; index < (size_t)value.size(); index++)
+			if (value[index] != State::S0)
+				minimum_size = index + 1;
+		value = value.extract(0, minimum_size);
+	}
 
-					if (part.base == 2) {
-						if (part.show_base)
-							prefix += "0b";
-						for (size_t index = 0; index < (size_t)value.size(); index++) {
-							if (part.group && index > 0 && index % 4 == 0)
-								buf += '_';
-							RTLIL::State bit = value[index];
-							if (bit == State::Sx)
-								buf += 'x';
-							else if (bit == State::Sz)
-								buf += 'z';
-							else if (bit == State::S1)
-								buf += '1';
-							else /* if (bit == State::S0) */
-								buf += '0';
-						}
-					} else if (part.base == 8 || part.base == 16) {
-						if (part.show_base)
-							prefix += (part.base == 16) ? (part.hex_upper ? "0X" : "0x") : "0o";
-						size_t step = (part.base == 16) ? 4 : 3;
-						for (size_t index = 0; index < (size_t)value.size(); index += step) {
-							if (part.group && index > 0 && index % (4 * step) == 0)
-								buf += '_';
-							RTLIL::Const subvalue = value.extract(index, min(step, value.size() - index));
-							bool has_x = false, all_x = true, has_z = false, all_z = true;
-							for (State bit : subvalue) {
-								if (bit == State::Sx)
-									has_x = true;
-								else
-									all_x = false;
-								if (bit == State::Sz)
-									has_z = true;
-								else
-									all_z = false;
-							}
-							if (all_x)
-								buf += 'x';
-							else if (all_z)
-								buf += 'z';
-							else if (has_x)
-								buf += 'X';
-							else if (has_z)
-								buf += 'Z';
-							else
-								buf += (part.hex_upper ? "0123456789ABCDEF" : "0123456789abcdef")[subvalue.as_int()];
-						}
-					} else if (part.base == 10) {
-						if (part.show_base)
-							prefix += "0d";
-						if (all_x)
-							buf += 'x';
-						else if (all_z)
-							buf += 'z';
-						else if (has_x)
-							buf += 'X';
-						else if (has_z)
-							buf += 'Z';
-						else {
-							log_assert(value.is_fully_def());
-							if (value.is_fully_zero())
-								buf += '0';
-							size_t index = 0;
-							while (!value.is_fully_zero())	{
-								if (part.group && index > 0 && index % 3 == 0)
-									buf += '_';
-								buf += '0' + RTLIL::const_mod(value, 10, false, false, 4).as_int();
-								value = RTLIL::const_div(value, 10, false, false, value.size());
-								index++;
-							}
-						}
-					} else log_abort();
-					if (part.justify == FmtPart::NUMERIC && part.group && part.padding == '0') {
-						size_t group_size = part.base == 10 ? 3 : 4;
-						while (prefix.size() + buf.size() < part.width) {
-							if (buf.size() % (group_size + 1) == group_size)
-								buf += '_';
-							buf += '0';
-						}
+	if (part.base == 2) {
+		if (part.show_base)
+			prefix += "0b";
+		for (size_t index = 0; index < (size_t)value.size(); index++) {
+			if (part.group && index > 0 && index % 4 == 0)
+				buf += '_';
+			RTLIL::State bit = value[index];
+			if (bit == State::Sx)
+				buf += 'x';
+			else if (bit == State::Sz)
+				buf += 'z';
+			else if (bit == State::S1)
+				buf += '1';
+			else /* if (bit == State::S0) */
+				buf += '0';
+		}
+	} else if (part.base == 8 || part.base == 16) {
+		if (part.show_base)
+			prefix += (part.base == 16) ? (part.hex_upper ? "0X" : "0x") : "0o";
+		size_t step = (part.base == 16) ? 4 : 3;
+		for (size_t index = 0; index < (size_t)value.size(); index += step) {
+			if (part.group && index > 0 && index % (4 * step) == 0)
+				buf += '_';
+			RTLIL::Const subvalue = value.extract(index, min(step, value.size() - index));
+			bool has_x = false, all_x = true, has_z = false, all_z = true;
+			for (State bit : subvalue) {
+				if (bit == State::Sx)
+					has_x = true;
+				else
+					all_x = false;
+				if (bit == State::Sz)
+					has_z = true;
+				else
+					all_z = false;
+			}
+			if (all_x)
+				buf += 'x';
+			else if (all_z)
+				buf += 'z';
+			else if (has_x)
+				buf += 'X';
+			else if (has_z)
+				buf += 'Z';
+			else
+				buf += (part.hex_upper ? "0123456789ABCDEF" : "0123456789abcdef")[subvalue.as_int()];
+		}
+	} else if (part.base == 10) {
+		if (part.show_base)
+			prefix += "0d";
+		if (all_x)
+			buf += 'x';
+		else if (all_z)
+			buf += 'z';
+		else if (has_x)
+			buf += 'X';
+		else if (has_z)
+			buf += 'Z';
+		else {
+			log_assert(value.is_fully_def());
+			if (value.is_fully_zero())
+				buf += '0';
+			size_t index = 0;
+			while (!value.is_fully_zero())	{
+				if (part.group && index > 0 && index % 3 == 0)
+					buf += '_';
+				buf += '0' + RTLIL::const_mod(value, 10, false, false, 4).as_int();
+				value = RTLIL::const_div(value, 10, false, false, value.size());
+				index++;
+			}
+		}
+	} else log_abort();
+}
+
+// Appends one part with the given value to `str`. The `buf` and `prefix`
+// strings are scratch space, passed in so that callers can reuse them.
+static void render_part(const FmtPart &part, const RTLIL::Const &value, std::string &str, std::string &buf, std::string &prefix)
+{
+	switch (part.type) {
+		case FmtPart::LITERAL:
+			str += part.str;
+			break;
+
+		case FmtPart::UNICHAR: {
+			uint32_t codepoint = value.as_int();
+			if (codepoint >= 0x10000)
+				str += (char)(0xf0 |  (codepoint >> 18));
+			else if (codepoint >= 0x800)
+				str += (char)(0xe0 |  (codepoint >> 12));
+			else if (codepoint >= 0x80)
+				str += (char)(0xc0 |  (codepoint >>  6));
+			else
+				str += (char)codepoint;
+			if (codepoint >= 0x10000)
+				str += (char)(0x80 | ((codepoint >> 12) & 0x3f));
+			if (codepoint >= 0x800)
+				str += (char)(0x80 | ((codepoint >>  6) & 0x3f));
+			if (codepoint >= 0x80)
+				str += (char)(0x80 | ((codepoint >>  0) & 0x3f));
+			break;
+		}
+
+		case FmtPart::INTEGER:
+		case FmtPart::STRING:
+		case FmtPart::VLOG_TIME: {
+			buf.clear();
+			prefix.clear();
+			if (part.type == FmtPart::INTEGER) {
+				if (!render_integer_fast(part, value, buf, prefix))
+					render_integer(part, value, buf, prefix);
+				if (part.justify == FmtPart::NUMERIC && part.group && part.padding == '0') {
+					size_t group_size = part.base == 10 ? 3 : 4;
+					while (prefix.size() + buf.size() < part.width) {
+						if (buf.size() % (group_size + 1) == group_size)
+							buf += '_';
+						buf += '0';
 					}
-					std::reverse(buf.begin(), buf.end());
-				} else if (part.type == FmtPart::STRING) {
-					buf = part.sig.as_const().decode_string();
-				} else if (part.type == FmtPart::VLOG_TIME) {
-					// We only render() during initial, so time is always zero.
-					buf = "0";
 				}
+				std::reverse(buf.begin(), buf.end());
+			} else if (part.type == FmtPart::STRING) {
+				buf = value.decode_string();
+			} else if (part.type == FmtPart::VLOG_TIME) {
+				// We only render() during initial, so time is always zero.
+				buf = "0";
+			}
 
-				log_assert(part.width == 0 || part.padding != '\0');
-				if (prefix.size() + buf.size() < part.width) {
-					size_t pad_width = part.width - prefix.size() - buf.size();
-					switch (part.justify) {
-						case FmtPart::LEFT:
-							str += prefix;
-							str += buf;
-							str += std::string(pad_width, part.padding);
-							break;
-						case FmtPart::RIGHT:
-							str += std::string(pad_width, part.padding);
-							str += prefix;
-							str += buf;
-							break;
-						case FmtPart::NUMERIC:
-							str += prefix;
-							str += std::string(pad_width, part.padding);
-							str += buf;
-							break;
-					}
-				} else {
-					str += prefix;
-					str += buf;
+			log_assert(part.width == 0 || part.padding != '\0');
+			if (prefix.size() + buf.size() < part.width) {
+				size_t pad_width = part.width - prefix.size() - buf.size();
+				switch (part.justify) {
+					case FmtPart::LEFT:
+						str += prefix;
+						str += buf;
+						str.append(pad_width, part.padding);
+						break;
+					case FmtPart::RIGHT:
+						str.append(pad_width, part.padding);
+						str += prefix;
+						str += buf;
+						break;
+					case FmtPart::NUMERIC:
+						str += prefix;
+						str.append(pad_width, part.padding);
+						str += buf;
+						break;
 				}
-				break;
+			} else {
+				str += prefix;
+				str += buf;
 			}
+			break;
 		}
 	}
+}
+
+std::string Fmt::render() const
+{
+	std::string str, buf, prefix;
+
+	for (auto &part : parts)
+		render_part(part, part.type == FmtPart::LITERAL ? RTLIL::Const() : part.sig.as_const(), str, buf, prefix);
 
 	return str;
 }
+
+CompiledFmt::CompiledFmt(const Fmt &fmt)
+{
+	int offset = 0;
+	for (auto &part : fmt.parts) {
+		parts.push_back({part, offset, part.sig.size()});
+		parts.back().part.sig = RTLIL::SigSpec();
+		offset += part.sig.size();
+	}
+	args_width = offset;
+}
+
+void CompiledFmt::render(const RTLIL::Const &args, std::string &str)
+{
+	log_assert(args.size() == args_width);
+	for (auto &it : parts) {
+		if (it.part.type == FmtPart::LITERAL)
+			str += it.part.str;
+		else
+			render_part(it.part, args.extract(it.offset, it.width), str, buf, prefix);
+	}
+}
@@ -111,6 +111,32 @@ private:
 	void apply_verilog_automatic_sizing_and_add(FmtPart &part);
 };
 
+// Rendering plan for a format whose arguments change but whose parts do not,
+// such as a $print cell during simulation. Each part takes its value from the
+// concatenated arguments at a fixed offset, fully defined integers of up to
+// 64 bits are converted with native arithmetic, and the scratch buffers are
+// kept between calls.
+struct CompiledFmt {
+	CompiledFmt() { }
+	CompiledFmt(const Fmt &fmt);
+
+	// Appends the output for the given value of the concatenated arguments
+	// (the ARGS port of a $print cell) to `str`.
+	void render(const RTLIL::Const &args, std::string &str);
+
+private:
+	struct Part {
+		FmtPart part;
+		int offset;
+		int width;
+	};
+
+	std::vector<Part> parts;
+	int args_width = 0;
+	std::string buf;
+	std::string prefix;
+};
+
 YOSYS_NAMESPACE_END
 
 #endif
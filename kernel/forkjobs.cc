@@ -0,0 +1,117 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/forkjobs.h"
+
+#include <fstream>
+
+#ifndef _WIN32
+#  include <sys/wait.h>
+#  include <unistd.h>
+#endif
+
+YOSYS_NAMESPACE_BEGIN
+
+#ifndef _WIN32
+
+ForkJobs::ForkJobs(const std::string &name)
+{
+	tempdir = make_temp_dir(get_base_tmpdir() + "/yosys_" + name + "_XXXXXX");
+}
+
+ForkJobs::~ForkJobs()
+{
+	remove_directory(tempdir);
+}
+
+std::string ForkJobs::path(int index, const char *suffix) const
+{
+	return stringf("%s/%d.%s", tempdir, index, suffix);
+}
+
+std::string ForkJobs::read_file(int index, const char *suffix) const
+{
+	std::ifstream in(path(index, suffix));
+	return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+std::string ForkJobs::status_text(int status)
+{
+	if (WIFSIGNALED(status))
+		return stringf("killed by signal %d", WTERMSIG(status));
+	return stringf("exit status %d", WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+}
+
+void ForkJobs::run(int count, int jobs, const std::function<int(int)> &child, const std::function<void(int, int)> &done)
+{
+	std::vector<pid_t> pids(count, -1);
+	int next = 0, running = 0;
+
+	while (next < count || running > 0)
+	{
+		if (next < count && running < jobs) {
+			int index = next++;
+			log_flush();
+			fflush(stdout);
+			fflush(stderr);
+			pid_t pid = fork();
+			if (pid == -1)
+				log_cmd_error("fork failed: %s\n", strerror(errno));
+			if (pid == 0) {
+				FILE *f = fopen(path(index, "log").c_str(), "w");
+				log_files.clear();
+				log_streams.clear();
+				if (f != nullptr)
+					log_files.push_back(f);
+				log_outputs_changed();
+				log_cmd_error_throw = true;
+				int exit_code = 1;
+				try {
+					exit_code = child(index);
+				} catch (...) {
+					// Must not unwind into the code of the parent
+				}
+				if (f != nullptr)
+					fclose(f);
+				// Skip the destructors of the state shared with the parent
+				_exit(exit_code);
+			}
+			pids[index] = pid;
+			running++;
+			continue;
+		}
+
+		int status;
+		pid_t pid = waitpid(-1, &status, 0);
+		if (pid == -1) {
+			if (errno == EINTR)
+				continue;
+			log_cmd_error("waitpid failed: %s\n", strerror(errno));
+		}
+		for (int i = 0; i < count; i++)
+			if (pids[i] == pid) {
+				pids[i] = -1;
+				running--;
+				done(i, status);
+				break;
+			}
+	}
+}
+
+#endif
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,58 @@
+/* -*- c++ -*-
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef FORKJOBS_H
+#define FORKJOBS_H
+
+#include "kernel/yosys.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+#ifndef _WIN32
+
+// Runs jobs in forked processes that share the memory of this process,
+// including the design, until they modify it. Each job writes its log and
+// any results to files in a temporary directory, which is removed when the
+// ForkJobs object is destroyed.
+struct ForkJobs
+{
+	std::string tempdir;
+
+	// The temporary directory is created as <tmpdir>/yosys_<name>_XXXXXX
+	ForkJobs(const std::string &name);
+	~ForkJobs();
+
+	// Path of a result file of job `index'
+	std::string path(int index, const char *suffix) const;
+	// Content of a result file, empty if it doesn't exist
+	std::string read_file(int index, const char *suffix) const;
+	// Description of a waitpid() status of a failed job
+	static std::string status_text(int status);
+
+	// Runs `child' for the jobs 0 to count-1, at most `jobs' at the same
+	// time. In the child process the log goes to path(index, "log"), command
+	// errors throw, and the process exits with the code returned by `child'.
+	// `done' is called in this process with the waitpid() status of each
+	// finished job.
+	void run(int count, int jobs, const std::function<int(int)> &child, const std::function<void(int, int)> &done);
+};
+
+#endif
+
+YOSYS_NAMESPACE_END
+
+#endif
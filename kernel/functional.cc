@@ -730,6 +730,10 @@ IR IR::from_module(Module *module) {
     ctor.process_queue();
     ir.topological_sort();
     ir.forward_buf();
+    ir.simplify();
+    ir.topological_sort();
+    log("Functional IR for module %s has %d nodes (%d shared, %d folded, %d dead, %d buffers removed).\n",
+        log_id(module), ir.size(), ir.statistics.shared, ir.statistics.folded, ir.statistics.dead, ir.statistics.forwarded);
     return ir;
 }
 
@@ -757,6 +761,8 @@ void IR::topological_sort() {
 		if(output.has_value())
 			toposort.process(output.value().id());
 	// any nodes untouched by this point are dead code and will be removed by permute
+    statistics.dead += _graph.size() - GetSize(perm);
+    _cons.clear();
     _graph.permute(perm);
     if(scc) log_error("The design contains combinational loops. This is not supported by the functional backend. "
 		"Try `scc -select; simplemap; select -clear` to avoid this error.\n");
@@ -797,9 +803,81 @@ void IR::forward_buf() {
             perm.push_back(i);
         }
     }
+    statistics.forwarded += _graph.size() - GetSize(perm);
+    _cons.clear();
     _graph.permute(perm, alias);
 }
 
+// Recreates a node in another IR through its factory, with the arguments
+// replaced by the nodes they were recreated as
+struct RebuildVisitor : AbstractVisitor<Node> {
+	IR &ir;
+	Factory &factory;
+	std::vector<Node> &map;
+	RebuildVisitor(IR &ir, Factory &factory, std::vector<Node> &map) : ir(ir), factory(factory), map(map) {}
+	Node m(Node n) { return map.at(n.id()); }
+	Node buf(Node, Node n) override { return m(n); }
+	Node slice(Node, Node a, int offset, int out_width) override { return factory.slice(m(a), offset, out_width); }
+	Node zero_extend(Node, Node a, int out_width) override { return factory.extend(m(a), out_width, false); }
+	Node sign_extend(Node, Node a, int out_width) override { return factory.extend(m(a), out_width, true); }
+	Node concat(Node, Node a, Node b) override { return factory.concat(m(a), m(b)); }
+	Node add(Node, Node a, Node b) override { return factory.add(m(a), m(b)); }
+	Node sub(Node, Node a, Node b) override { return factory.sub(m(a), m(b)); }
+	Node mul(Node, Node a, Node b) override { return factory.mul(m(a), m(b)); }
+	Node unsigned_div(Node, Node a, Node b) override { return factory.unsigned_div(m(a), m(b)); }
+	Node unsigned_mod(Node, Node a, Node b) override { return factory.unsigned_mod(m(a), m(b)); }
+	Node bitwise_and(Node, Node a, Node b) override { return factory.bitwise_and(m(a), m(b)); }
+	Node bitwise_or(Node, Node a, Node b) override { return factory.bitwise_or(m(a), m(b)); }
+	Node bitwise_xor(Node, Node a, Node b) override { return factory.bitwise_xor(m(a), m(b)); }
+	Node bitwise_not(Node, Node a) override { return factory.bitwise_not(m(a)); }
+	Node unary_minus(Node, Node a) override { return factory.unary_minus(m(a)); }
+	Node reduce_and(Node, Node a) override { return factory.reduce_and(m(a)); }
+	Node reduce_or(Node, Node a) override { return factory.reduce_or(m(a)); }
+	Node reduce_xor(Node, Node a) override { return factory.reduce_xor(m(a)); }
+	Node equal(Node, Node a, Node b) override { return factory.equal(m(a), m(b)); }
+	Node not_equal(Node, Node a, Node b) override { return factory.not_equal(m(a), m(b)); }
+	Node signed_greater_than(Node, Node a, Node b) override { return factory.signed_greater_than(m(a), m(b)); }
+	Node signed_greater_equal(Node, Node a, Node b) override { return factory.signed_greater_equal(m(a), m(b)); }
+	Node unsigned_greater_than(Node, Node a, Node b) override { return factory.unsigned_greater_than(m(a), m(b)); }
+	Node unsigned_greater_equal(Node, Node a, Node b) override { return factory.unsigned_greater_equal(m(a), m(b)); }
+	Node logical_shift_left(Node, Node a, Node b) override { return factory.logical_shift_left(m(a), m(b)); }
+	Node logical_shift_right(Node, Node a, Node b) override { return factory.logical_shift_right(m(a), m(b)); }
+	Node arithmetic_shift_right(Node, Node a, Node b) override { return factory.arithmetic_shift_right(m(a), m(b)); }
+	Node mux(Node, Node a, Node b, Node s) override { return factory.mux(m(a), m(b), m(s)); }
+	Node constant(Node, RTLIL::Const const &value) override { return factory.constant(value); }
+	Node input(Node, IdString name, IdString kind) override { return factory.value(ir.input(name, kind)); }
+	Node state(Node, IdString name, IdString kind) override { return factory.value(ir.state(name, kind)); }
+	Node memory_read(Node, Node mem, Node addr) override { return factory.memory_read(m(mem), m(addr)); }
+	Node memory_write(Node, Node mem, Node addr, Node data) override { return factory.memory_write(m(mem), m(addr), m(data)); }
+};
+
+void IR::simplify() {
+	// FunctionalIRConstruction connects cells through pending nodes, so the
+	// factory could not see identical or constant arguments while building
+	IR rebuilt;
+	Factory factory = rebuilt.factory();
+	std::vector<Node> map;
+	for (int i = 0; i < _graph.size(); ++i) {
+		Node node(_graph[i]);
+		Node target = node.visit(RebuildVisitor(*this, factory, map));
+		if (node._ref.has_sparse_attr()) {
+			auto target_ref = rebuilt.mutate(target);
+			if (target_ref.has_sparse_attr())
+				target_ref.sparse_attr() = merge_name(target_ref.sparse_attr(), node._ref.sparse_attr());
+			else
+				target_ref.sparse_attr() = node._ref.sparse_attr();
+		}
+		map.push_back(target);
+	}
+	for (auto const &[key, index] : _graph.keys())
+		rebuilt.mutate(map[index]).assign_key(key);
+	statistics.shared += rebuilt.statistics.shared;
+	statistics.folded += rebuilt.statistics.folded;
+	map.clear();
+	std::swap(_graph, rebuilt._graph);
+	std::swap(_cons, rebuilt._cons);
+}
+
 // Quoting routine to make error messages nicer
 static std::string quote_fmt(const char *fmt)
 {
@@ -247,14 +247,27 @@ namespace Functional {
 		dict<std::pair<IdString, IdString>, IRInput> _inputs;
 		dict<std::pair<IdString, IdString>, IROutput> _outputs;
 		dict<std::pair<IdString, IdString>, IRState> _states;
+		// hash-consing table used by Factory, mapping function, sort and arguments to a node index.
+		// cleared whenever the graph is permuted, since that changes the indices
+		dict<std::tuple<NodeData, Sort, std::vector<int>>, int> _cons;
 		IR::Graph::Ref mutate(Node n);
 	public:
+		// counts of nodes saved while building the IR
+		struct Statistics {
+			int shared = 0;     // requested nodes that already existed (hash-consing)
+			int folded = 0;     // operations on constants evaluated during construction
+			int dead = 0;       // nodes that don't reach an output or a next state value
+			int forwarded = 0;  // buffers removed by forward_buf
+		} statistics;
 		static IR from_module(Module *module);
 		Factory factory();
 		int size() const { return _graph.size(); }
 		Node operator[](int i);
 		void topological_sort();
 		void forward_buf();
+		// rebuilds the graph through a Factory, which shares identical nodes and folds constants.
+		// the graph must be topologically sorted and free of buffers, as after forward_buf
+		void simplify();
 		IRInput const& input(IdString name, IdString kind) const { return _inputs.at({name, kind}); }
 		IRInput const& input(IdString name) const { return input(name, ID($input)); }
 		IROutput const& output(IdString name, IdString kind) const { return _outputs.at({name, kind}); }
@@ -455,11 +468,56 @@ namespace Functional {
 		Node add(IR::NodeData &&fn, Sort const &sort, std::initializer_list<Node> args) {
 			log_assert(!sort.is_signal() || sort.width() > 0);
 			log_assert(!sort.is_memory() || (sort.addr_width() > 0 && sort.data_width() > 0));
-			IR::Graph::Ref ref = _ir._graph.add(std::move(fn), {std::move(sort)});
+			// pending nodes get their argument later and must stay distinct
+			bool pending = fn.fn() == Fn::buf;
+			std::vector<int> arg_ids;
+			if (!pending) {
+				for (auto arg : args)
+					arg_ids.push_back(arg.id());
+				auto it = _ir._cons.find({fn, sort, arg_ids});
+				if (it != _ir._cons.end()) {
+					_ir.statistics.shared++;
+					return Node(_ir._graph[it->second]);
+				}
+			}
+			IR::Graph::Ref ref = _ir._graph.add(fn, {sort});
 			for (auto arg : args)
 				ref.append_arg(IR::Graph::ConstRef(arg));
+			if (!pending)
+				_ir._cons.emplace({std::move(fn), sort, std::move(arg_ids)}, ref.index());
 			return Node(ref);
 		}
+		// follows pending nodes that have been updated
+		static Node resolve(Node n) {
+			while (n.fn() == Fn::buf && n.arg_count() == 1)
+				n = n.arg(0);
+			return n;
+		}
+		static bool fully_def_constant(Node n, RTLIL::Const &value) {
+			n = resolve(n);
+			if (n.fn() != Fn::constant)
+				return false;
+			value = n._ref.function().as_const();
+			return value.is_fully_def();
+		}
+		using ConstEval = RTLIL::Const (*)(const RTLIL::Const &, const RTLIL::Const &, bool, bool, int);
+		// evaluates operations on fully defined constants instead of adding a node
+		Node fold(Fn fn, Sort const &sort, Node a, ConstEval eval) {
+			RTLIL::Const ca;
+			if (fully_def_constant(a, ca)) {
+				_ir.statistics.folded++;
+				return constant(eval(ca, RTLIL::Const(), false, false, sort.width()));
+			}
+			return add(fn, sort, {a});
+		}
+		Node fold(Fn fn, Sort const &sort, Node a, Node b, ConstEval eval, bool signed1 = false, bool signed2 = false) {
+			RTLIL::Const ca, cb;
+			if (fully_def_constant(a, ca) && fully_def_constant(b, cb)) {
+				_ir.statistics.folded++;
+				return constant(eval(ca, cb, signed1, signed2, sort.width()));
+			}
+			return add(fn, sort, {a, b});
+		}
 		void check_basic_binary(Node const &a, Node const &b) { log_assert(a.sort().is_signal() && a.sort() == b.sort()); }
 		void check_shift(Node const &a, Node const &b) { log_assert(a.sort().is_signal() && b.sort().is_signal() && b.width() == ceil_log2(a.width())); }
 		void check_unary(Node const &a) { log_assert(a.sort().is_signal()); }
@@ -469,6 +527,11 @@ namespace Functional {
 			log_assert(a.sort().is_signal() && offset + out_width <= a.sort().width());
 			if(offset == 0 && out_width == a.width())
 				return a;
+			RTLIL::Const ca;
+			if(fully_def_constant(a, ca)) {
+				_ir.statistics.folded++;
+				return constant(ca.extract(offset, out_width));
+			}
 			return add(IR::NodeData(Fn::slice, offset), Sort(out_width), {a});
 		}
 		// extend will either extend or truncate the provided value to reach the desired width
@@ -479,6 +542,15 @@ namespace Functional {
 				return a;
 			if(in_width > out_width)
 				return slice(a, 0, out_width);
+			RTLIL::Const ca;
+			if(fully_def_constant(a, ca)) {
+				_ir.statistics.folded++;
+				if(is_signed)
+					ca.exts(out_width);
+				else
+					ca.extu(out_width);
+				return constant(ca);
+			}
 			if(is_signed)
 				return add(Fn::sign_extend, Sort(out_width), {a});
 			else
@@ -486,47 +558,62 @@ namespace Functional {
 		}
 		Node concat(Node a, Node b) {
 			log_assert(a.sort().is_signal() && b.sort().is_signal());
+			RTLIL::Const ca, cb;
+			if(fully_def_constant(a, ca) && fully_def_constant(b, cb)) {
+				_ir.statistics.folded++;
+				ca.append(cb);
+				return constant(ca);
+			}
 			return add(Fn::concat, Sort(a.sort().width() + b.sort().width()), {a, b});
 		}
-		Node add(Node a, Node b) { check_basic_binary(a, b); return add(Fn::add, a.sort(), {a, b}); }
-		Node sub(Node a, Node b) { check_basic_binary(a, b); return add(Fn::sub, a.sort(), {a, b}); }
-		Node mul(Node a, Node b) { check_basic_binary(a, b); return add(Fn::mul, a.sort(), {a, b}); }
+		Node add(Node a, Node b) { check_basic_binary(a, b); return fold(Fn::add, a.sort(), a, b, RTLIL::const_add); }
+		Node sub(Node a, Node b) { check_basic_binary(a, b); return fold(Fn::sub, a.sort(), a, b, RTLIL::const_sub); }
+		Node mul(Node a, Node b) { check_basic_binary(a, b); return fold(Fn::mul, a.sort(), a, b, RTLIL::const_mul); }
 		Node unsigned_div(Node a, Node b) { check_basic_binary(a, b); return add(Fn::unsigned_div, a.sort(), {a, b}); }
 		Node unsigned_mod(Node a, Node b) { check_basic_binary(a, b); return add(Fn::unsigned_mod, a.sort(), {a, b}); }
-		Node bitwise_and(Node a, Node b) { check_basic_binary(a, b); return add(Fn::bitwise_and, a.sort(), {a, b}); }
-		Node bitwise_or(Node a, Node b) { check_basic_binary(a, b); return add(Fn::bitwise_or, a.sort(), {a, b}); }
-		Node bitwise_xor(Node a, Node b) { check_basic_binary(a, b); return add(Fn::bitwise_xor, a.sort(), {a, b}); }
-		Node bitwise_not(Node a) { check_unary(a); return add(Fn::bitwise_not, a.sort(), {a}); }
-		Node unary_minus(Node a) { check_unary(a); return add(Fn::unary_minus, a.sort(), {a}); }
+		Node bitwise_and(Node a, Node b) { check_basic_binary(a, b); return fold(Fn::bitwise_and, a.sort(), a, b, RTLIL::const_and); }
+		Node bitwise_or(Node a, Node b) { check_basic_binary(a, b); return fold(Fn::bitwise_or, a.sort(), a, b, RTLIL::const_or); }
+		Node bitwise_xor(Node a, Node b) { check_basic_binary(a, b); return fold(Fn::bitwise_xor, a.sort(), a, b, RTLIL::const_xor); }
+		Node bitwise_not(Node a) { check_unary(a); return fold(Fn::bitwise_not, a.sort(), a, RTLIL::const_not); }
+		Node unary_minus(Node a) { check_unary(a); return fold(Fn::unary_minus, a.sort(), a, RTLIL::const_neg); }
 		Node reduce_and(Node a) {
 			check_unary(a);
 			if(a.width() == 1)
 				return a;
-			return add(Fn::reduce_and, Sort(1), {a});
+			return fold(Fn::reduce_and, Sort(1), a, RTLIL::const_reduce_and);
 		}
 		Node reduce_or(Node a) {
 			check_unary(a);
 			if(a.width() == 1)
 				return a;
-			return add(Fn::reduce_or, Sort(1), {a});
+			return fold(Fn::reduce_or, Sort(1), a, RTLIL::const_reduce_or);
 		}
 		Node reduce_xor(Node a) { 
 			check_unary(a);
 			if(a.width() == 1)
 				return a;
-			return add(Fn::reduce_xor, Sort(1), {a});
+			return fold(Fn::reduce_xor, Sort(1), a, RTLIL::const_reduce_xor);
 		}
-		Node equal(Node a, Node b) { check_basic_binary(a, b); return add(Fn::equal, Sort(1), {a, b}); }
-		Node not_equal(Node a, Node b) { check_basic_binary(a, b); return add(Fn::not_equal, Sort(1), {a, b}); }
-		Node signed_greater_than(Node a, Node b) { check_basic_binary(a, b); return add(Fn::signed_greater_than, Sort(1), {a, b}); }
-		Node signed_greater_equal(Node a, Node b) { check_basic_binary(a, b); return add(Fn::signed_greater_equal, Sort(1), {a, b}); }
-		Node unsigned_greater_than(Node a, Node b) { check_basic_binary(a, b); return add(Fn::unsigned_greater_than, Sort(1), {a, b}); }
-		Node unsigned_greater_equal(Node a, Node b) { check_basic_binary(a, b); return add(Fn::unsigned_greater_equal, Sort(1), {a, b}); }
-		Node logical_shift_left(Node a, Node b) { check_shift(a, b); return add(Fn::logical_shift_left, a.sort(), {a, b}); }
-		Node logical_shift_right(Node a, Node b) { check_shift(a, b); return add(Fn::logical_shift_right, a.sort(), {a, b}); }
-		Node arithmetic_shift_right(Node a, Node b) { check_shift(a, b); return add(Fn::arithmetic_shift_right, a.sort(), {a, b}); }
+		Node equal(Node a, Node b) { check_basic_binary(a, b); return fold(Fn::equal, Sort(1), a, b, RTLIL::const_eq); }
+		Node not_equal(Node a, Node b) { check_basic_binary(a, b); return fold(Fn::not_equal, Sort(1), a, b, RTLIL::const_ne); }
+		Node signed_greater_than(Node a, Node b) { check_basic_binary(a, b); return fold(Fn::signed_greater_than, Sort(1), a, b, RTLIL::const_gt, true, true); }
+		Node signed_greater_equal(Node a, Node b) { check_basic_binary(a, b); return fold(Fn::signed_greater_equal, Sort(1), a, b, RTLIL::const_ge, true, true); }
+		Node unsigned_greater_than(Node a, Node b) { check_basic_binary(a, b); return fold(Fn::unsigned_greater_than, Sort(1), a, b, RTLIL::const_gt); }
+		Node unsigned_greater_equal(Node a, Node b) { check_basic_binary(a, b); return fold(Fn::unsigned_greater_equal, Sort(1), a, b, RTLIL::const_ge); }
+		Node logical_shift_left(Node a, Node b) { check_shift(a, b); return fold(Fn::logical_shift_left, a.sort(), a, b, RTLIL::const_shl); }
+		Node logical_shift_right(Node a, Node b) { check_shift(a, b); return fold(Fn::logical_shift_right, a.sort(), a, b, RTLIL::const_shr); }
+		Node arithmetic_shift_right(Node a, Node b) { check_shift(a, b); return fold(Fn::arithmetic_shift_right, a.sort(), a, b, RTLIL::const_sshr, true, false); }
 		Node mux(Node a, Node b, Node s) {
 			log_assert(a.sort().is_signal() && a.sort() == b.sort() && s.sort() == Sort(1));
+			RTLIL::Const cs;
+			if(fully_def_constant(s, cs)) {
+				_ir.statistics.folded++;
+				return cs.as_bool() ? b : a;
+			}
+			if(resolve(a).id() == resolve(b).id()) {
+				_ir.statistics.folded++;
+				return a;
+			}
 			return add(Fn::mux, a.sort(), {a, b, s});
 		}
 		Node memory_read(Node mem, Node addr) {
@@ -572,7 +659,11 @@ namespace Functional {
 			return add(IR::NodeData(Fn::state, std::pair(state.name, state.kind)), state.sort, {});
 		}
 		void suggest_name(Node node, IdString name) {
-			_ir.mutate(node).sparse_attr() = name;
+			// nodes can be shared, never replace a public name with an internal one
+			auto ref = _ir.mutate(node);
+			if(ref.has_sparse_attr() && ref.sparse_attr()[0] == '\\' && name[0] == '$')
+				return;
+			ref.sparse_attr() = name;
 		}
 	};
 	inline Factory IR::factory() { return Factory(*this); }
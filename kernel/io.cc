@@ -1,5 +1,6 @@
 #include "kernel/yosys_common.h"
 #include "kernel/log.h"
+#include "libs/sha1/sha1.h"
 #include <iostream>
 #include <string>
 #include <filesystem>
@@ -296,6 +297,16 @@ bool check_directory_exists(const std::string& filename, bool is_exec)
 	return check_accessible(filename, is_exec) && check_is_directory(filename);
 }
 
+// SHA1 of the file content, or an empty string if the file can't be read.
+// Used to notice changed files, unlike the modification time it also catches
+// edits within the timestamp resolution of the file system.
+std::string file_content_hash(const std::string& filename)
+{
+	if (!check_file_exists(filename))
+		return std::string();
+	return SHA1::from_file(filename);
+}
+
 bool is_absolute_path(std::string filename)
 {
 #ifdef _WIN32
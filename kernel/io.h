@@ -465,6 +465,7 @@ std::string make_temp_file(std::string template_str = get_base_tmpdir() + "/yosy
 std::string make_temp_dir(std::string template_str = get_base_tmpdir() + "/yosys_XXXXXX");
 bool check_file_exists(const std::string& filename, bool is_exec = false);
 bool check_directory_exists(const std::string& dirname, bool is_exec = false);
+std::string file_content_hash(const std::string& filename);
 bool is_absolute_path(std::string filename);
 void remove_directory(std::string dirname);
 bool create_directory(const std::string& dirname);
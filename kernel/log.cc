@@ -36,6 +36,15 @@
 #include <vector>
 #include <list>
 
+#ifdef YOSYS_ENABLE_THREADS
+#  include <condition_variable>
+#  include <mutex>
+#  include <thread>
+#  ifndef _WIN32
+#    include <pthread.h>
+#  endif
+#endif
+
 YOSYS_NAMESPACE_BEGIN
 
 std::vector<FILE*> log_files;
@@ -73,8 +82,228 @@ static struct timeval initial_tv = { 0, 0 };
 static bool next_print_log = false;
 static int log_newline_count = 0;
 
-static void log_id_cache_clear()
+std::atomic<bool> log_discard_messages{false};
+
+#ifdef YOSYS_ENABLE_THREADS
+// Allocated, so that the forked child can replace it: the copy that is
+// locked across fork() is owned by a thread of the parent.
+static std::recursive_mutex *log_mutex = new std::recursive_mutex;
+#endif
+
+// Serializes logging from multiple threads
+struct LogLock
+{
+#ifdef YOSYS_ENABLE_THREADS
+	std::lock_guard<std::recursive_mutex> guard{*log_mutex};
+#endif
+};
+
+// Background writer of the asynchronous log files. Messages are appended to a
+// per file buffer, which the writer thread swaps out and writes as a whole.
+//
+// fork() only copies the calling thread, so the buffers are drained and the
+// locks are held across fork() (see log_atfork_prepare()). The child process
+// writes its log files synchronously.
+struct AsyncLogWriter
+{
+	std::set<FILE*> files;
+#ifdef YOSYS_ENABLE_THREADS
+	std::unique_ptr<std::mutex> mutex = std::make_unique<std::mutex>();
+	std::unique_ptr<std::condition_variable> wakeup = std::make_unique<std::condition_variable>();
+	std::unique_ptr<std::condition_variable> idle = std::make_unique<std::condition_variable>();
+	std::vector<std::pair<FILE*, std::string>> buffers;
+	bool busy = false, stop = false;
+	std::unique_ptr<std::thread> thread;
+
+	AsyncLogWriter();
+
+	void write(FILE *f, const std::string &str)
+	{
+		{
+			std::lock_guard<std::mutex> lock(*mutex);
+			auto it = std::find_if(buffers.begin(), buffers.end(), [f](const std::pair<FILE*, std::string> &b) { return b.first == f; });
+			if (it == buffers.end())
+				buffers.emplace_back(f, str);
+			else
+				it->second += str;
+		}
+		wakeup->notify_one();
+	}
+
+	void run()
+	{
+		std::unique_lock<std::mutex> lock(*mutex);
+		while (true) {
+			wakeup->wait(lock, [this] { return stop || !buffers.empty(); });
+			if (buffers.empty())
+				break;
+			std::vector<std::pair<FILE*, std::string>> batch;
+			batch.swap(buffers);
+			busy = true;
+			lock.unlock();
+			for (auto &[f, str] : batch) {
+				fwrite(str.data(), 1, str.size(), f);
+				fflush(f);
+			}
+			lock.lock();
+			busy = false;
+			idle->notify_all();
+		}
+	}
+
+	void flush()
+	{
+		std::unique_lock<std::mutex> lock(*mutex);
+		idle->wait(lock, [this] { return buffers.empty() && !busy; });
+	}
+
+	void add(FILE *f)
+	{
+		if (files.empty()) {
+			stop = false;
+			thread = std::make_unique<std::thread>([this] { run(); });
+		}
+		files.insert(f);
+	}
+
+	void stop_thread()
+	{
+		{
+			std::lock_guard<std::mutex> lock(*mutex);
+			stop = true;
+		}
+		wakeup->notify_one();
+		thread->join();
+		thread.reset();
+	}
+
+	void remove(FILE *f)
+	{
+		flush();
+		files.erase(f);
+		if (files.empty())
+			stop_thread();
+	}
+
+	void fork_prepare()
+	{
+		std::unique_lock<std::mutex> lock(*mutex);
+		idle->wait(lock, [this] { return buffers.empty() && !busy; });
+		lock.release();
+	}
+
+	void fork_parent()
+	{
+		mutex->unlock();
+	}
+
+	void fork_child()
+	{
+		// The writer thread does not exist in the child. Its mutex and
+		// condition variables are left alone (and leaked), as they may still
+		// count it as a waiter.
+		(void)thread.release();
+		(void)mutex.release();
+		(void)wakeup.release();
+		(void)idle.release();
+		mutex = std::make_unique<std::mutex>();
+		wakeup = std::make_unique<std::condition_variable>();
+		idle = std::make_unique<std::condition_variable>();
+		files.clear();
+		stop = false;
+	}
+
+	// Writes out what is left when exiting without yosys_shutdown()
+	~AsyncLogWriter()
+	{
+		if (thread)
+			stop_thread();
+	}
+#else
+	void write(FILE *f, const std::string &str) { fputs(str.c_str(), f); }
+	void flush() { }
+	void add(FILE *f) { files.insert(f); }
+	void remove(FILE *f) { files.erase(f); }
+#endif
+};
+
+static AsyncLogWriter async_log_writer;
+
+#ifdef YOSYS_ENABLE_THREADS
+#ifndef _WIN32
+static void log_atfork_prepare()
+{
+	log_mutex->lock();
+	async_log_writer.fork_prepare();
+}
+
+static void log_atfork_parent()
+{
+	async_log_writer.fork_parent();
+	log_mutex->unlock();
+}
+
+// The locks are owned by the forking thread of the parent, the child can't
+// unlock them and replaces them instead
+static void log_atfork_child()
+{
+	async_log_writer.fork_child();
+	log_mutex = new std::recursive_mutex;
+}
+
+AsyncLogWriter::AsyncLogWriter()
+{
+	pthread_atfork(log_atfork_prepare, log_atfork_parent, log_atfork_child);
+}
+#else
+AsyncLogWriter::AsyncLogWriter() { }
+#endif
+#endif
+
+static void log_write_file(FILE *f, const std::string &str)
+{
+	if (!async_log_writer.files.empty() && async_log_writer.files.count(f))
+		async_log_writer.write(f, str);
+	else
+		fputs(str.c_str(), f);
+}
+
+void log_file_async(FILE *f)
+{
+	LogLock lock;
+	if (!async_log_writer.files.count(f))
+		async_log_writer.add(f);
+}
+
+void log_file_sync(FILE *f)
 {
+	LogLock lock;
+	if (async_log_writer.files.count(f))
+		async_log_writer.remove(f);
+}
+
+// Flushes the synchronous outputs, without waiting for the background writes
+// of the asynchronous log files
+static void log_flush_sync()
+{
+	LogLock lock;
+	for (auto f : log_files)
+		if (!async_log_writer.files.count(f))
+			fflush(f);
+	for (auto f : log_streams)
+		f->flush();
+}
+
+void log_outputs_changed()
+{
+	LogLock lock;
+	log_discard_messages.store(log_files.empty() && log_streams.empty() && log_scratchpads.empty() && log_hasher == nullptr &&
+			log_warn_regexes.empty() && log_expect_log.empty() && log_expect_prefix_log.empty(), std::memory_order_relaxed);
+}
+
+void log_id_cache_clear()
+{
+	LogLock lock;
 	for (auto p : log_id_cache)
 		free(p);
 	log_id_cache.clear();
@@ -152,14 +381,14 @@ static void logv_string(std::string_view format, std::string str) {
 			next_print_log = true;
 
 		for (auto f : log_files)
-			fputs(time_str.c_str(), f);
+			log_write_file(f, time_str);
 
 		for (auto f : log_streams)
 			*f << time_str;
 	}
 
 	for (auto f : log_files)
-		fputs(str.c_str(), f);
+		log_write_file(f, str);
 
 	for (auto f : log_streams)
 		*f << str;
@@ -203,7 +432,7 @@ static void logv_string(std::string_view format, std::string str) {
 
 void log_formatted_string(std::string_view format, std::string str)
 {
-	log_assert(!Multithreading::active());
+	LogLock lock;
 
 	if (log_make_debug && !ys_debug(1))
 		return;
@@ -222,6 +451,7 @@ void log_formatted_header(RTLIL::Design *design, std::string_view format, std::s
 
 	if (int(header_count.size()) <= log_verbose_level && log_errfile != NULL) {
 		log_files.push_back(log_errfile);
+		log_outputs_changed();
 		pop_errfile = true;
 	}
 
@@ -232,7 +462,7 @@ void log_formatted_header(RTLIL::Design *design, std::string_view format, std::s
 
 	log("%s. ", header_id);
 	log_formatted_string(format, std::move(str));
-	log_flush();
+	log_flush_sync();
 
 	if (log_hdump_all)
 		log_hdump[header_id].insert("yosys_dump_" + header_id + ".il");
@@ -247,13 +477,15 @@ void log_formatted_header(RTLIL::Design *design, std::string_view format, std::s
 				log("#X# -- end of dump --\n");
 		}
 
-	if (pop_errfile)
+	if (pop_errfile) {
 		log_files.pop_back();
+		log_outputs_changed();
+	}
 }
 
 void log_formatted_warning(std::string_view prefix, std::string message)
 {
-	log_assert(!Multithreading::active());
+	LogLock lock;
 
 	bool suppressed = false;
 
@@ -290,18 +522,22 @@ void log_formatted_warning(std::string_view prefix, std::string message)
 		if (log_warnings.count(message))
 		{
 			log("%s%s", prefix, message);
-			log_flush();
+			log_flush_sync();
 		}
 		else
 		{
-			if (log_errfile != NULL && !log_quiet_warnings)
+			if (log_errfile != NULL && !log_quiet_warnings) {
 				log_files.push_back(log_errfile);
+				log_outputs_changed();
+			}
 
 			log("%s%s", prefix, message);
-			log_flush();
+			log_flush_sync();
 
-			if (log_errfile != NULL && !log_quiet_warnings)
+			if (log_errfile != NULL && !log_quiet_warnings) {
 				log_files.pop_back();
+				log_outputs_changed();
+			}
 
 			log_warnings.insert(message);
 		}
@@ -327,6 +563,7 @@ void log_formatted_file_info(std::string_view filename, int lineno, std::string
 [[noreturn]]
 static void log_error_with_prefix(std::string_view prefix, std::string str)
 {
+	LogLock lock;
 #ifdef EMSCRIPTEN
 	auto backup_log_files = log_files;
 #endif
@@ -336,6 +573,7 @@ static void log_error_with_prefix(std::string_view prefix, std::string str)
 
 	if (log_errfile != NULL)
 		log_files.push_back(log_errfile);
+	log_outputs_changed();
 
 	if (log_error_stderr) {
 		log_flush(); // Make sure we flush stdout before replacing it with stderr
@@ -370,6 +608,7 @@ static void log_error_with_prefix(std::string_view prefix, std::string str)
 
 #ifdef EMSCRIPTEN
 	log_files = backup_log_files;
+	log_outputs_changed();
 	throw 0;
 #elif defined(_MSC_VER)
 	_exit(1);
@@ -428,14 +667,17 @@ void log_formatted_cmd_error(std::string str)
 		bool pop_errfile = false;
 		if (log_errfile != NULL) {
 			log_files.push_back(log_errfile);
+			log_outputs_changed();
 			pop_errfile = true;
 		}
 
 		log("ERROR: %s", log_last_error);
 		log_flush();
 
-		if (pop_errfile)
+		if (pop_errfile) {
 			log_files.pop_back();
+			log_outputs_changed();
+		}
 
 		throw log_cmd_error_exception();
 	}
@@ -457,8 +699,7 @@ void log_push()
 void log_pop()
 {
 	header_count.pop_back();
-	log_id_cache_clear();
-	log_flush();
+	log_flush_sync();
 }
 
 #if (defined(__linux__) || defined(__FreeBSD__)) && defined(YOSYS_ENABLE_PLUGINS)
@@ -568,6 +809,9 @@ void log_reset_stack()
 
 void log_flush()
 {
+	LogLock lock;
+	async_log_writer.flush();
+
 	for (auto f : log_files)
 		fflush(f);
 
@@ -604,6 +848,7 @@ std::string log_const(const RTLIL::Const &value, bool autoint)
 
 const char *log_id(const RTLIL::IdString &str)
 {
+	LogLock lock;
 	std::string unescaped = RTLIL::unescape_id(str);
 	log_id_cache.push_back(strdup(unescaped.c_str()));
 	return log_id_cache.back();
@@ -642,6 +887,7 @@ void log_check_expected()
 	std::swap(expect_prefix_warning, log_expect_prefix_warning);
 	std::swap(expect_prefix_log, log_expect_prefix_log);
 	std::swap(expect_prefix_error, log_expect_prefix_error);
+	log_outputs_changed();
 
 	auto check = [&](const std::string kind, std::string pattern, LogExpectedItem item) {
 		if (item.current_count == 0) {
@@ -133,12 +133,25 @@ static inline bool ys_debug(int = 0) { return false; }
 #endif
 #  define log_debug(...) do { if (ys_debug(1)) log(__VA_ARGS__); } while (0)
 
+// True if nothing would observe a log() message (no log files, streams,
+// scratchpads, hashers or log patterns), so formatting it can be skipped.
+// Code that changes these outputs must call log_outputs_changed(), the flag
+// is also updated before and after each pass.
+extern std::atomic<bool> log_discard_messages;
+void log_outputs_changed();
+static inline bool log_discarded() { return log_discard_messages.load(std::memory_order_relaxed); }
+
+// log() and the warning functions may be called from worker threads, the
+// messages are serialized by a lock. Headers must be logged from the main
+// thread.
 void log_formatted_string(std::string_view format, std::string str);
 template <typename... Args>
 inline void log(FmtString<TypeIdentity<Args>...> fmt, const Args &... args)
 {
 	if (log_make_debug && !ys_debug(1))
 		return;
+	if (log_discarded())
+		return;
 	log_formatted_string(fmt.format_string(), fmt.format(args...));
 }
 
@@ -240,11 +253,24 @@ struct LogMakeDebugHdl {
 void log_spacer();
 void log_push();
 void log_pop();
+// Frees the strings returned by log_id(). This happens when the outermost
+// pass returns, so that they stay valid across nested passes and for worker
+// threads.
+void log_id_cache_clear();
 
 void log_backtrace(const char *prefix, int levels);
 void log_reset_stack();
+// Writes out all buffered log output, including that of asynchronous log files
 void log_flush();
 
+// Writes to the log file `f` (which must be in log_files) are buffered and
+// done by a background thread, so that slow file systems don't stall Yosys.
+// Buffered output is lost if Yosys crashes. log_file_sync() writes out the
+// buffered output and stops the asynchronous writes, it must be called
+// before the file is closed.
+void log_file_async(FILE *f);
+void log_file_sync(FILE *f);
+
 struct LogExpectedItem
 {
 	LogExpectedItem(const std::regex &pat, int expected) :
@@ -19,6 +19,7 @@
 
 #include "kernel/yosys.h"
 #include "kernel/satgen.h"
+#include "libs/ezsat/ezcdcl.h"
 #include "kernel/json.h"
 #include "kernel/gzip.h"
 #include "kernel/log_help.h"
@@ -118,6 +119,7 @@ Pass::pre_post_exec_state_t Pass::pre_execute()
 	state.parent_pass = current_pass;
 	current_pass = this;
 	clear_flags();
+	log_outputs_changed();
 	return state;
 }
 
@@ -130,6 +132,10 @@ void Pass::post_execute(Pass::pre_post_exec_state_t state)
 	runtime_ns += time_ns;
 	current_pass = state.parent_pass;
 	subtract_from_current_runtime_ns(time_ns);
+
+	if (current_pass == nullptr)
+		log_id_cache_clear();
+	log_outputs_changed();
 }
 
 void Pass::subtract_from_current_runtime_ns(int64_t time_ns)
@@ -797,8 +803,10 @@ struct HelpPass : public Pass {
 				// dump command help
 				std::ostringstream buf;
 				log_streams.push_back(&buf);
+				log_outputs_changed();
 				pass->help();
 				log_streams.pop_back();
+				log_outputs_changed();
 				std::stringstream ss;
 				ss << buf.str();
 
@@ -1183,6 +1191,13 @@ struct MinisatSatSolver : public SatSolver {
 	}
 } MinisatSatSolver;
 
+struct CdclSatSolver : public SatSolver {
+	CdclSatSolver() : SatSolver("cdcl") { }
+	ezSAT *create() override {
+		return new ezCDCL();
+	}
+} CdclSatSolver;
+
 struct LicensePass : public Pass {
 	LicensePass() : Pass("license", "print license terms") { }
 	void help() override
@@ -22,6 +22,7 @@
 #include "kernel/celltypes.h"
 #include "kernel/binding.h"
 #include "kernel/sigtools.h"
+#include "kernel/cellgraph.h"
 #include "frontends/verilog/verilog_frontend.h"
 #include "frontends/verilog/preproc.h"
 #include "backends/rtlil/rtlil_backend.h"
@@ -1619,6 +1620,8 @@ RTLIL::Module::Module()
 
 RTLIL::Module::~Module()
 {
+	for (auto &it : cell_graph_cache)
+		delete it.second;
 	for (auto &pr : wires_)
 		delete pr.second;
 	for (auto &pr : memories)
@@ -2975,44 +2978,51 @@ bool RTLIL::Module::is_selected_whole() const
 	return design->selected_whole_module(this->name);
 }
 
-std::vector<RTLIL::Wire*> RTLIL::Module::selected_wires() const
+// The module-level part of the selection check is the same for all objects
+// of a module, so it is done once: whole modules return all objects, for
+// partially selected modules the member set is looked up directly.
+template<typename T>
+static std::vector<T*> selected_objects(const RTLIL::Module *module, const dict<RTLIL::IdString, T*> &objects)
 {
-	std::vector<RTLIL::Wire*> result;
-	result.reserve(wires_.size());
-	for (auto &it : wires_)
-		if (design->selected(this, it.second))
+	std::vector<T*> result;
+	const RTLIL::Design *design = module->design;
+	if (design->selected_whole_module(module->name)) {
+		result.reserve(objects.size());
+		for (auto &it : objects)
+			result.push_back(it.second);
+		return result;
+	}
+	if (!design->selected_module(module->name))
+		return result;
+	auto &selected_members = design->selection().selected_members;
+	auto members_it = selected_members.find(module->name);
+	if (members_it == selected_members.end())
+		return result;
+	const pool<RTLIL::IdString> &members = members_it->second;
+	for (auto &it : objects)
+		if (members.count(it.first))
 			result.push_back(it.second);
 	return result;
 }
 
+std::vector<RTLIL::Wire*> RTLIL::Module::selected_wires() const
+{
+	return selected_objects(this, wires_);
+}
+
 std::vector<RTLIL::Cell*> RTLIL::Module::selected_cells() const
 {
-	std::vector<RTLIL::Cell*> result;
-	result.reserve(cells_.size());
-	for (auto &it : cells_)
-		if (design->selected(this, it.second))
-			result.push_back(it.second);
-	return result;
+	return selected_objects(this, cells_);
 }
 
 std::vector<RTLIL::Memory*> RTLIL::Module::selected_memories() const
 {
-	std::vector<RTLIL::Memory*> result;
-	result.reserve(memories.size());
-	for (auto &it : memories)
-		if (design->selected(this, it.second))
-			result.push_back(it.second);
-	return result;
+	return selected_objects(this, memories);
 }
 
 std::vector<RTLIL::Process*> RTLIL::Module::selected_processes() const
 {
-	std::vector<RTLIL::Process*> result;
-	result.reserve(processes.size());
-	for (auto &it : processes)
-		if (design->selected(this, it.second))
-			result.push_back(it.second);
-	return result;
+	return selected_objects(this, processes);
 }
 
 std::vector<RTLIL::NamedObject*> RTLIL::Module::selected_members() const
@@ -3315,6 +3325,7 @@ void RTLIL::Module::fixup_ports()
 		ports.push_back(all_ports[i]->name);
 		all_ports[i]->port_id = i+1;
 	}
+	invalidate_content_hash();  // Zyphar: track changes
 }
 
 RTLIL::Wire *RTLIL::Module::addWire(RTLIL::IdString name, int width)
@@ -4531,11 +4542,15 @@ bool RTLIL::Cell::hasParam(RTLIL::IdString paramname) const
 void RTLIL::Cell::unsetParam(RTLIL::IdString paramname)
 {
 	parameters.erase(paramname);
+	if (module)
+		module->invalidate_content_hash();  // Zyphar: track changes
 }
 
 void RTLIL::Cell::setParam(RTLIL::IdString paramname, RTLIL::Const value)
 {
 	parameters[paramname] = std::move(value);
+	if (module)
+		module->invalidate_content_hash();  // Zyphar: track changes
 }
 
 const RTLIL::Const &RTLIL::Cell::getParam(RTLIL::IdString paramname) const
@@ -28,6 +28,8 @@
 
 YOSYS_NAMESPACE_BEGIN
 
+struct CellGraph;
+
 namespace RTLIL
 {
 	enum State : unsigned char {
@@ -1763,6 +1765,9 @@ struct RTLIL::Selection
 	// selection covers full design, not including boxed modules
 	bool full_selection;
 	pool<RTLIL::IdString> selected_modules;
+	// TODO: store members as bitsets over dense per-module object ids, with
+	// the name sets only as a view. Many passes use this dict directly, so
+	// for now selected_*() only avoid repeating the per-module checks.
 	dict<RTLIL::IdString, pool<RTLIL::IdString>> selected_members;
 	RTLIL::Design *current_design;
 
@@ -2118,7 +2123,13 @@ public:
 	uint64_t get_content_hash() const;
 
 	// Invalidate hash (called when module is modified)
-	void invalidate_content_hash() { zyphar_hash_valid = false; }
+	void invalidate_content_hash() { zyphar_hash_valid = false; content_generation++; }
+
+	// Number of changes tracked by invalidate_content_hash(), never reset
+	unsigned int content_generation = 0;
+
+	// Cached cell graphs (see kernel/cellgraph.h), owned by the module
+	std::map<std::string, CellGraph*> cell_graph_cache;
 
 	// Check if module content matches a given hash
 	bool content_matches(uint64_t hash) const { return get_content_hash() == hash; }
@@ -2759,6 +2770,7 @@ void RTLIL::Module::rewrite_sigspecs(T &functor)
 		functor(it.first);
 		functor(it.second);
 	}
+	invalidate_content_hash();
 }
 
 template<typename T>
@@ -2771,18 +2783,23 @@ void RTLIL::Module::rewrite_sigspecs2(T &functor)
 	for (auto &it : connections_) {
 		functor(it.first, it.second);
 	}
+	invalidate_content_hash();
 }
 
 template<typename T>
 void RTLIL::Cell::rewrite_sigspecs(T &functor) {
 	for (auto &it : connections_)
 		functor(it.second);
+	if (module != nullptr)
+		module->invalidate_content_hash();
 }
 
 template<typename T>
 void RTLIL::Cell::rewrite_sigspecs2(T &functor) {
 	for (auto &it : connections_)
 		functor(it.second);
+	if (module != nullptr)
+		module->invalidate_content_hash();
 }
 
 template<typename T>
@@ -533,6 +533,8 @@ void RTLIL::Cell::unsetPort(RTLIL::IdString portname)
 
 	if (conn_it != connections_.end())
 	{
+		module->invalidate_content_hash();  // Zyphar: track changes
+
 		for (auto mon : module->monitors)
 			mon->notify_connect(this, conn_it->first, conn_it->second, signal);
 
@@ -593,6 +595,8 @@ void RTLIL::Cell::setPort(RTLIL::IdString portname, RTLIL::SigSpec signal)
 	if (!r.second && conn_it->second == signal)
 		return;
 
+	module->invalidate_content_hash();  // Zyphar: track changes
+
 	for (auto mon : module->monitors)
 		mon->notify_connect(this, conn_it->first, conn_it->second, signal);
 
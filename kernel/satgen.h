@@ -44,6 +44,14 @@ struct SatSolver
 		yosys_satsolver_list = this;
 	}
 
+	// Returns the registered solver with the given name, or nullptr
+	static SatSolver *find(const string &name) {
+		for (auto solver = yosys_satsolver_list; solver != nullptr; solver = solver->next)
+			if (solver->name == name)
+				return solver;
+		return nullptr;
+	}
+
 	virtual ~SatSolver() {
 		auto p = &yosys_satsolver_list;
 		while (*p) {
@@ -59,6 +67,7 @@ struct SatSolver
 
 struct ezSatPtr : public std::unique_ptr<ezSAT> {
 	ezSatPtr() : unique_ptr<ezSAT>(yosys_satsolver->create()) { }
+	ezSatPtr(SatSolver *solver) : unique_ptr<ezSAT>(solver->create()) { }
 };
 
 struct SatGen
@@ -0,0 +1,550 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/simsig.h"
+#include "kernel/celltypes.h"
+#include "kernel/ff.h"
+
+USING_YOSYS_NAMESPACE
+
+// Fixed indices of the constant bits, the x/z constant is always opaque
+static const int BIT_S0 = 0, BIT_S1 = 1, BIT_SX = 2;
+
+static bool param_signed(RTLIL::Cell *cell, RTLIL::IdString param)
+{
+	return cell->hasParam(param) && cell->getParam(param).as_bool();
+}
+
+static RTLIL::SigSpec extended_port(RTLIL::Cell *cell, RTLIL::IdString port, int width, bool is_signed)
+{
+	RTLIL::SigSpec sig = cell->getPort(port);
+	sig.extend_u0(width, is_signed);
+	return sig;
+}
+
+SimSignatures::SimSignatures(RTLIL::Module *module, const SigMap &sigmap, int num_steps, uint64_t seed) :
+		sigmap(sigmap), num_steps(num_steps)
+{
+	log_assert(num_steps >= 1);
+	rng_state = seed * 0x9e3779b97f4a7c15ULL + 0x2545f4914f6cdd1dULL;
+
+	bit_index(RTLIL::SigBit(RTLIL::State::S0));
+	bit_index(RTLIL::SigBit(RTLIL::State::S1));
+	bit_index(RTLIL::SigBit(RTLIL::State::Sx));
+
+	for (auto wire : module->wires())
+		import_sig(wire);
+
+	std::vector<std::vector<int>> opaque_outputs;
+
+	for (auto cell : module->cells())
+	{
+		if (cell->is_builtin_ff() || cell->type == ID($anyinit))
+		{
+			// In a single time step flip-flop outputs are free.
+			if (num_steps == 1)
+				continue;
+
+			FfData ff(nullptr, cell);
+			if (ff.has_aload || ff.has_arst || ff.has_sr) {
+				opaque_outputs.push_back(import_sig(ff.sig_q));
+				continue;
+			}
+
+			SimFf sim_ff;
+			sim_ff.q = import_sig(ff.sig_q);
+			sim_ff.d = import_sig(ff.sig_d);
+			if (ff.has_ce) {
+				sim_ff.ce = import_sig(ff.sig_ce).at(0);
+				sim_ff.pol_ce = ff.pol_ce;
+			}
+			if (ff.has_srst) {
+				sim_ff.srst = import_sig(ff.sig_srst).at(0);
+				sim_ff.pol_srst = ff.pol_srst;
+				sim_ff.rval = import_sig(ff.val_srst);
+				sim_ff.ce_over_srst = ff.has_ce && ff.ce_over_srst;
+			}
+			ffs.push_back(std::move(sim_ff));
+			continue;
+		}
+
+		SimCell sim_cell;
+		sim_cell.cell = cell;
+		sim_cell.kind = KIND_GENERIC;
+
+		static const dict<RTLIL::IdString, CellKind> gate_kinds = {
+			{ID($_BUF_), KIND_BUF}, {ID($_NOT_), KIND_NOT}, {ID($_AND_), KIND_AND}, {ID($_NAND_), KIND_NAND},
+			{ID($_OR_), KIND_OR}, {ID($_NOR_), KIND_NOR}, {ID($_XOR_), KIND_XOR}, {ID($_XNOR_), KIND_XNOR},
+			{ID($_ANDNOT_), KIND_ANDNOT}, {ID($_ORNOT_), KIND_ORNOT}, {ID($_MUX_), KIND_MUX}, {ID($_NMUX_), KIND_NMUX},
+			{ID($_AOI3_), KIND_AOI3}, {ID($_OAI3_), KIND_OAI3}, {ID($_AOI4_), KIND_AOI4}, {ID($_OAI4_), KIND_OAI4},
+		};
+
+		if (gate_kinds.count(cell->type))
+		{
+			sim_cell.kind = gate_kinds.at(cell->type);
+			sim_cell.a = import_sig(cell->getPort(ID::A));
+			if (cell->hasPort(ID::B))
+				sim_cell.b = import_sig(cell->getPort(ID::B));
+			if (cell->hasPort(ID::C))
+				sim_cell.c = import_sig(cell->getPort(ID::C));
+			if (cell->hasPort(ID::S))
+				sim_cell.c = import_sig(cell->getPort(ID::S));
+			if (cell->hasPort(ID::D))
+				sim_cell.d = import_sig(cell->getPort(ID::D));
+			sim_cell.y = import_sig(cell->getPort(ID::Y));
+		}
+		else if (cell->type.in(ID($buf), ID($pos), ID($not), ID($equiv)))
+		{
+			int width = GetSize(cell->getPort(ID::Y));
+			sim_cell.kind = cell->type == ID($not) ? KIND_NOT : KIND_BUF;
+			sim_cell.a = import_sig(extended_port(cell, ID::A, width, param_signed(cell, ID::A_SIGNED)));
+			sim_cell.y = import_sig(cell->getPort(ID::Y));
+		}
+		else if (cell->type.in(ID($and), ID($or), ID($xor), ID($xnor)))
+		{
+			int width = GetSize(cell->getPort(ID::Y));
+			bool is_signed = param_signed(cell, ID::A_SIGNED) && param_signed(cell, ID::B_SIGNED);
+			sim_cell.kind = cell->type == ID($and) ? KIND_AND : cell->type == ID($or) ? KIND_OR :
+					cell->type == ID($xor) ? KIND_XOR : KIND_XNOR;
+			sim_cell.a = import_sig(extended_port(cell, ID::A, width, is_signed));
+			sim_cell.b = import_sig(extended_port(cell, ID::B, width, is_signed));
+			sim_cell.y = import_sig(cell->getPort(ID::Y));
+		}
+		else if (cell->type.in(ID($mux), ID($bwmux)))
+		{
+			sim_cell.kind = KIND_MUX;
+			sim_cell.a = import_sig(cell->getPort(ID::A));
+			sim_cell.b = import_sig(cell->getPort(ID::B));
+			sim_cell.c = import_sig(cell->getPort(ID::S));
+			sim_cell.y = import_sig(cell->getPort(ID::Y));
+			if (cell->type == ID($mux))
+				sim_cell.c.resize(GetSize(sim_cell.y), sim_cell.c.at(0));
+		}
+		else if (cell->type == ID($fa))
+		{
+			sim_cell.kind = KIND_FA;
+			sim_cell.a = import_sig(cell->getPort(ID::A));
+			sim_cell.b = import_sig(cell->getPort(ID::B));
+			sim_cell.c = import_sig(cell->getPort(ID::C));
+			sim_cell.y = import_sig(cell->getPort(ID::Y));
+			sim_cell.x = import_sig(cell->getPort(ID::X));
+		}
+		else if (cell->type.in(ID($reduce_and), ID($reduce_or), ID($reduce_xor), ID($reduce_xnor), ID($reduce_bool),
+				ID($logic_not), ID($neg), ID($slice), ID($lut), ID($sop)))
+		{
+			sim_cell.args.push_back(import_sig(cell->getPort(ID::A)));
+			sim_cell.args.push_back(std::vector<int>());
+			sim_cell.y = import_sig(cell->getPort(ID::Y));
+		}
+		else if (cell->type.in(ID($add), ID($sub), ID($mul), ID($div), ID($mod), ID($divfloor), ID($modfloor), ID($pow),
+				ID($shl), ID($shr), ID($sshl), ID($sshr), ID($shift), ID($shiftx),
+				ID($lt), ID($le), ID($eq), ID($ne), ID($eqx), ID($nex), ID($ge), ID($gt),
+				ID($logic_and), ID($logic_or), ID($concat), ID($bweqx)))
+		{
+			sim_cell.args.push_back(import_sig(cell->getPort(ID::A)));
+			sim_cell.args.push_back(import_sig(cell->getPort(ID::B)));
+			sim_cell.y = import_sig(cell->getPort(ID::Y));
+		}
+		else if (cell->type.in(ID($bmux), ID($demux)))
+		{
+			sim_cell.args.push_back(import_sig(cell->getPort(ID::A)));
+			sim_cell.args.push_back(import_sig(cell->getPort(ID::S)));
+			sim_cell.y = import_sig(cell->getPort(ID::Y));
+		}
+		else if (cell->type == ID($pmux))
+		{
+			sim_cell.args.push_back(import_sig(cell->getPort(ID::A)));
+			sim_cell.args.push_back(import_sig(cell->getPort(ID::B)));
+			sim_cell.args.push_back(import_sig(cell->getPort(ID::S)));
+			sim_cell.y = import_sig(cell->getPort(ID::Y));
+		}
+		else
+		{
+			// Unsupported internal cells are modelled by the SAT side, so their
+			// outputs must not be treated as free. Unknown (user) cells and
+			// $anyseq are free.
+			if (yosys_celltypes.cell_known(cell->type) && cell->type != ID($anyseq)) {
+				std::vector<int> outputs;
+				for (auto &conn : cell->connections())
+					if (yosys_celltypes.cell_output(cell->type, conn.first))
+						for (int idx : import_sig(conn.second))
+							outputs.push_back(idx);
+				opaque_outputs.push_back(outputs);
+			}
+			continue;
+		}
+
+		cells.push_back(std::move(sim_cell));
+	}
+
+	int nbits = GetSize(bit_index);
+	opaque.assign(nbits, false);
+	opaque[BIT_SX] = true;
+
+	// -1: undriven, -2: driven by a flip-flop or unsupported cell, >= 0: cell index
+	std::vector<int> driver(nbits, -1);
+	auto add_driver = [&](int idx, int drv) {
+		if (idx <= BIT_SX)
+			return false;
+		if (driver[idx] != -1)
+			opaque[idx] = true;
+		driver[idx] = drv;
+		return true;
+	};
+
+	std::vector<bool> cell_valid(GetSize(cells), true);
+	for (int i = 0; i < GetSize(cells); i++) {
+		for (int idx : cells[i].y)
+			cell_valid[i] = add_driver(idx, i) && cell_valid[i];
+		for (int idx : cells[i].x)
+			cell_valid[i] = add_driver(idx, i) && cell_valid[i];
+	}
+	for (auto &ff : ffs)
+		for (int idx : ff.q)
+			add_driver(idx, -2);
+	for (auto &outputs : opaque_outputs)
+		for (int idx : outputs)
+			if (add_driver(idx, -2))
+				opaque[idx] = true;
+
+	for (int idx = BIT_SX + 1; idx < nbits; idx++)
+		if (driver[idx] == -1)
+			free_bits.push_back(idx);
+
+	// Order the cells topologically, cells that are part of or depend on
+	// logic loops (or that drive constants) can't be simulated.
+	std::vector<int> indegree(GetSize(cells), 0);
+	std::vector<std::vector<int>> successors(GetSize(cells));
+	for (int i = 0; i < GetSize(cells); i++) {
+		auto add_inputs = [&](const std::vector<int> &inputs) {
+			for (int idx : inputs)
+				if (driver[idx] >= 0) {
+					successors[driver[idx]].push_back(i);
+					indegree[i]++;
+				}
+		};
+		add_inputs(cells[i].a);
+		add_inputs(cells[i].b);
+		add_inputs(cells[i].c);
+		add_inputs(cells[i].d);
+		for (auto &arg : cells[i].args)
+			add_inputs(arg);
+	}
+
+	std::vector<int> order;
+	order.reserve(GetSize(cells));
+	for (int i = 0; i < GetSize(cells); i++)
+		if (indegree[i] == 0)
+			order.push_back(i);
+	for (int k = 0; k < GetSize(order); k++)
+		for (int succ : successors[order[k]])
+			if (--indegree[succ] == 0)
+				order.push_back(succ);
+
+	std::vector<bool> ordered(GetSize(cells), false);
+	for (int i : order)
+		ordered[i] = true;
+
+	std::vector<SimCell> sorted_cells;
+	sorted_cells.reserve(GetSize(order));
+	for (int i = 0; i < GetSize(cells); i++)
+		if (!ordered[i] || !cell_valid[i]) {
+			for (int idx : cells[i].y)
+				opaque[idx] = true;
+			for (int idx : cells[i].x)
+				opaque[idx] = true;
+		}
+	for (int i : order)
+		if (cell_valid[i])
+			sorted_cells.push_back(std::move(cells[i]));
+	cells.swap(sorted_cells);
+}
+
+uint64_t SimSignatures::rng()
+{
+	// xorshift64*
+	uint64_t x = rng_state;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	rng_state = x;
+	return x * 0x2545f4914f6cdd1dULL;
+}
+
+int SimSignatures::lookup(RTLIL::SigBit bit) const
+{
+	bit = sigmap(bit);
+	if (bit.wire == nullptr)
+		return bit.data == RTLIL::State::S0 ? BIT_S0 : bit.data == RTLIL::State::S1 ? BIT_S1 : BIT_SX;
+	return bit_index.at(bit, -1);
+}
+
+std::vector<int> SimSignatures::import_sig(const RTLIL::SigSpec &sig)
+{
+	std::vector<int> result;
+	result.reserve(GetSize(sig));
+	for (auto bit : sigmap(sig)) {
+		if (bit.wire == nullptr && bit.data != RTLIL::State::S0 && bit.data != RTLIL::State::S1)
+			bit = RTLIL::State::Sx;
+		result.push_back(bit_index(bit));
+	}
+	return result;
+}
+
+void SimSignatures::eval_cell(SimCell &cell, std::vector<uint64_t> &val)
+{
+	auto any_opaque = [&](const std::vector<int> &inputs) {
+		for (int idx : inputs)
+			if (opaque[idx])
+				return true;
+		return false;
+	};
+
+	bool inputs_opaque = any_opaque(cell.a) || any_opaque(cell.b) || any_opaque(cell.c) || any_opaque(cell.d);
+	for (auto &arg : cell.args)
+		inputs_opaque = inputs_opaque || any_opaque(arg);
+	if (inputs_opaque) {
+		for (int idx : cell.y)
+			opaque[idx] = true;
+		for (int idx : cell.x)
+			opaque[idx] = true;
+		return;
+	}
+
+	if (cell.kind != KIND_GENERIC)
+	{
+		for (int i = 0; i < GetSize(cell.y); i++)
+		{
+			uint64_t a = val[cell.a[i]];
+			uint64_t b = cell.b.empty() ? 0 : val[cell.b[i]];
+			uint64_t c = cell.c.empty() ? 0 : val[cell.c[i]];
+			uint64_t d = cell.d.empty() ? 0 : val[cell.d[i]];
+			uint64_t y = 0;
+
+			switch (cell.kind)
+			{
+			case KIND_BUF:    y = a; break;
+			case KIND_NOT:    y = ~a; break;
+			case KIND_AND:    y = a & b; break;
+			case KIND_NAND:   y = ~(a & b); break;
+			case KIND_OR:     y = a | b; break;
+			case KIND_NOR:    y = ~(a | b); break;
+			case KIND_XOR:    y = a ^ b; break;
+			case KIND_XNOR:   y = ~(a ^ b); break;
+			case KIND_ANDNOT: y = a & ~b; break;
+			case KIND_ORNOT:  y = a | ~b; break;
+			case KIND_MUX:    y = (a & ~c) | (b & c); break;
+			case KIND_NMUX:   y = ~((a & ~c) | (b & c)); break;
+			case KIND_AOI3:   y = ~((a & b) | c); break;
+			case KIND_OAI3:   y = ~((a | b) & c); break;
+			case KIND_AOI4:   y = ~((a & b) | (c & d)); break;
+			case KIND_OAI4:   y = ~((a | b) & (c | d)); break;
+			case KIND_FA:
+				y = a ^ b ^ c;
+				val[cell.x[i]] = (a & b) | (a & c) | (b & c);
+				break;
+			default:
+				log_abort();
+			}
+
+			val[cell.y[i]] = y;
+		}
+		return;
+	}
+
+	std::vector<uint64_t> y_words(GetSize(cell.y), 0);
+	std::vector<RTLIL::Const> args(GetSize(cell.args));
+
+	for (int p = 0; p < 64; p++)
+	{
+		for (int k = 0; k < GetSize(cell.args); k++) {
+			std::vector<RTLIL::State> bits;
+			bits.reserve(GetSize(cell.args[k]));
+			for (int idx : cell.args[k])
+				bits.push_back((val[idx] >> p) & 1 ? RTLIL::State::S1 : RTLIL::State::S0);
+			args[k] = RTLIL::Const(bits);
+		}
+
+		bool err = false;
+		RTLIL::Const result = GetSize(args) == 2 ? CellTypes::eval(cell.cell, args[0], args[1], &err) :
+				CellTypes::eval(cell.cell, args[0], args[1], args[2], &err);
+
+		if (err || GetSize(result) != GetSize(cell.y)) {
+			for (int idx : cell.y)
+				opaque[idx] = true;
+			return;
+		}
+
+		for (int i = 0; i < GetSize(cell.y); i++) {
+			RTLIL::State bit = result[i];
+			if (bit == RTLIL::State::S1)
+				y_words[i] |= uint64_t(1) << p;
+			else if (bit != RTLIL::State::S0)
+				opaque[cell.y[i]] = true;
+		}
+	}
+
+	for (int i = 0; i < GetSize(cell.y); i++)
+		val[cell.y[i]] = y_words[i];
+}
+
+void SimSignatures::simulate_word(const std::vector<uint64_t> *fixed_mask, const std::vector<uint64_t> *fixed_value)
+{
+	int nbits = GetSize(bit_index);
+	std::vector<uint64_t> val(nbits, 0);
+	val[BIT_S1] = ~uint64_t(0);
+
+	std::vector<uint64_t> ff_next;
+
+	for (int step = 0; step < num_steps; step++)
+	{
+		for (int idx : free_bits) {
+			uint64_t word = rng();
+			if (fixed_mask != nullptr)
+				word = (word & ~(*fixed_mask)[idx]) | ((*fixed_value)[idx] & (*fixed_mask)[idx]);
+			val[idx] = word;
+		}
+
+		int k = 0;
+		for (auto &ff : ffs)
+			for (int idx : ff.q)
+				val[idx] = step == 0 ? rng() : ff_next[k++];
+
+		for (auto &cell : cells)
+			eval_cell(cell, val);
+
+		if (step + 1 == num_steps)
+			break;
+
+		// Mirrors the unrolled flip-flop model of SatGen::importCell()
+		ff_next.clear();
+		for (auto &ff : ffs)
+		{
+			uint64_t srst = ff.srst < 0 ? 0 : ff.pol_srst ? val[ff.srst] : ~val[ff.srst];
+			uint64_t ce = ff.ce < 0 ? ~uint64_t(0) : ff.pol_ce ? val[ff.ce] : ~val[ff.ce];
+			bool ctrl_opaque = (ff.srst >= 0 && opaque[ff.srst]) || (ff.ce >= 0 && opaque[ff.ce]);
+
+			for (int i = 0; i < GetSize(ff.q); i++)
+			{
+				uint64_t next = val[ff.d[i]];
+				uint64_t rval = ff.srst < 0 ? 0 : val[ff.rval[i]];
+				if (ff.srst >= 0 && ff.ce_over_srst)
+					next = (next & ~srst) | (rval & srst);
+				next = (val[ff.q[i]] & ~ce) | (next & ce);
+				if (ff.srst >= 0 && !ff.ce_over_srst)
+					next = (next & ~srst) | (rval & srst);
+				ff_next.push_back(next);
+
+				if (ctrl_opaque || opaque[ff.d[i]] || (ff.srst >= 0 && opaque[ff.rval[i]]))
+					opaque[ff.q[i]] = true;
+			}
+		}
+	}
+
+	sig_data.insert(sig_data.end(), val.begin(), val.end());
+	words++;
+}
+
+void SimSignatures::add_random_words(int count)
+{
+	for (int i = 0; i < count; i++)
+		simulate_word(nullptr, nullptr);
+}
+
+void SimSignatures::add_pattern(const std::vector<RTLIL::SigBit> &bits, const std::vector<bool> &values)
+{
+	log_assert(GetSize(bits) == GetSize(values));
+
+	std::vector<int> indices;
+	std::vector<bool> pattern_values;
+	for (int i = 0; i < GetSize(bits); i++) {
+		int idx = lookup(bits[i]);
+		if (idx > BIT_SX) {
+			indices.push_back(idx);
+			pattern_values.push_back(values[i]);
+		}
+	}
+	pending_patterns.emplace_back(std::move(indices), std::move(pattern_values));
+
+	if (GetSize(pending_patterns) == 64)
+		flush_patterns();
+}
+
+void SimSignatures::flush_patterns()
+{
+	if (pending_patterns.empty())
+		return;
+
+	int nbits = GetSize(bit_index);
+	std::vector<uint64_t> mask(nbits, 0), value(nbits, 0);
+	for (int p = 0; p < GetSize(pending_patterns); p++) {
+		auto &pattern = pending_patterns[p];
+		for (int i = 0; i < GetSize(pattern.first); i++) {
+			mask[pattern.first[i]] |= uint64_t(1) << p;
+			if (pattern.second[i])
+				value[pattern.first[i]] |= uint64_t(1) << p;
+		}
+	}
+	pending_patterns.clear();
+
+	simulate_word(&mask, &value);
+}
+
+bool SimSignatures::known(RTLIL::SigBit bit) const
+{
+	int idx = lookup(bit);
+	return idx >= 0 && !opaque[idx] && words > 0;
+}
+
+SimSignatures::signature_t SimSignatures::signature(RTLIL::SigBit bit, bool canonical) const
+{
+	int idx = lookup(bit);
+	log_assert(idx >= 0 && !opaque[idx]);
+
+	int nbits = GetSize(bit_index);
+	signature_t sig(words);
+	for (int w = 0; w < words; w++)
+		sig[w] = sig_data[size_t(w) * nbits + idx];
+
+	if (canonical && !sig.empty() && (sig[0] & 1))
+		for (auto &word : sig)
+			word = ~word;
+	return sig;
+}
+
+bool SimSignatures::may_equal(RTLIL::SigBit a, RTLIL::SigBit b, bool inverted) const
+{
+	if (!known(a) || !known(b))
+		return true;
+
+	int idx_a = lookup(a), idx_b = lookup(b);
+	int nbits = GetSize(bit_index);
+	uint64_t xor_mask = inverted ? ~uint64_t(0) : 0;
+	for (int w = 0; w < words; w++)
+		if ((sig_data[size_t(w) * nbits + idx_a] ^ sig_data[size_t(w) * nbits + idx_b]) != xor_mask)
+			return false;
+	return true;
+}
+
+int SimSignatures::num_opaque_bits() const
+{
+	int count = 0;
+	for (int idx = BIT_SX + 1; idx < GetSize(opaque); idx++)
+		if (opaque[idx])
+			count++;
+	return count;
+}
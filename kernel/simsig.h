@@ -0,0 +1,121 @@
+/* -*- c++ -*-
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef SIMSIG_H
+#define SIMSIG_H
+
+#include "kernel/yosys.h"
+#include "kernel/sigtools.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// Bit-parallel random simulation of a module, computing a signature (the
+// simulated values over all patterns) for every net bit. This is meant as a
+// cheap filter in front of SAT-based equivalence checks: two bits with
+// different signatures are known to be different, while bits with equal
+// signatures are merely candidates that still need to be proven.
+//
+// Each simulated word holds 64 patterns. Bits that are not driven by a
+// simulated cell (module inputs, outputs of non-internal cells, and in the
+// first time step also flip-flop outputs) are free and receive random values.
+// With num_steps > 1 the flip-flops are clocked num_steps-1 times and the
+// signature is taken from the last time step, matching the unrolled models
+// SatGen builds for sequential equivalence checks.
+//
+// Bits whose value cannot be simulated faithfully (outputs of unsupported
+// internal cells, logic loops, undefined results) are marked as opaque and
+// have no signature; they must never be excluded based on simulation.
+struct SimSignatures
+{
+	typedef std::vector<uint64_t> signature_t;
+
+	SimSignatures(RTLIL::Module *module, const SigMap &sigmap, int num_steps = 1, uint64_t seed = 1);
+
+	// Simulates `count` further words of random patterns.
+	void add_random_words(int count = 1);
+
+	// Queues a pattern (e.g. a SAT counterexample) assigning the given values
+	// to free bits; unassigned free bits are filled randomly. Queued patterns
+	// are simulated once a full word has been collected or on flush_patterns().
+	void add_pattern(const std::vector<RTLIL::SigBit> &bits, const std::vector<bool> &values);
+	void flush_patterns();
+
+	// Returns true if the bit has a usable signature.
+	bool known(RTLIL::SigBit bit) const;
+
+	// Returns the signature of a known bit. With `canonical` the signature is
+	// inverted if needed so that the first pattern is zero, allowing bits that
+	// are equivalent up to inversion to share a signature.
+	signature_t signature(RTLIL::SigBit bit, bool canonical = false) const;
+
+	// Returns false if simulation proves that a and b (or a and ~b when
+	// `inverted` is set) are different. Always returns true for opaque bits.
+	bool may_equal(RTLIL::SigBit a, RTLIL::SigBit b, bool inverted = false) const;
+
+	int num_words() const { return words; }
+	int num_patterns() const { return 64 * words; }
+	int num_opaque_bits() const;
+
+private:
+	enum CellKind {
+		KIND_BUF, KIND_NOT, KIND_AND, KIND_NAND, KIND_OR, KIND_NOR, KIND_XOR, KIND_XNOR,
+		KIND_ANDNOT, KIND_ORNOT, KIND_MUX, KIND_NMUX, KIND_AOI3, KIND_OAI3, KIND_AOI4, KIND_OAI4,
+		KIND_FA, KIND_GENERIC
+	};
+
+	// Gate kinds evaluate y[i] from a[i], b[i], c[i], d[i] word-parallel (x[i]
+	// is the carry output of $fa). Generic cells are evaluated per pattern with
+	// CellTypes::eval() on args.
+	struct SimCell {
+		RTLIL::Cell *cell;
+		CellKind kind;
+		std::vector<int> a, b, c, d, y, x;
+		std::vector<std::vector<int>> args;
+	};
+
+	struct SimFf {
+		std::vector<int> q, d, rval;
+		int ce = -1, srst = -1;
+		bool pol_ce = true, pol_srst = true, ce_over_srst = false;
+	};
+
+	const SigMap &sigmap;
+	int num_steps;
+	uint64_t rng_state;
+
+	idict<RTLIL::SigBit> bit_index;
+	std::vector<SimCell> cells;
+	std::vector<SimFf> ffs;
+	std::vector<int> free_bits;
+	std::vector<bool> opaque;
+
+	int words = 0;
+	// Signature storage, word-major: sig_data[w * nbits + bit]
+	std::vector<uint64_t> sig_data;
+
+	std::vector<std::pair<std::vector<int>, std::vector<bool>>> pending_patterns;
+
+	uint64_t rng();
+	int lookup(RTLIL::SigBit bit) const;
+	std::vector<int> import_sig(const RTLIL::SigSpec &sig);
+	void simulate_word(const std::vector<uint64_t> *fixed_mask, const std::vector<uint64_t> *fixed_value);
+	void eval_cell(SimCell &cell, std::vector<uint64_t> &val);
+};
+
+YOSYS_NAMESPACE_END
+
+#endif
@@ -0,0 +1,868 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/timinggraph.h"
+#include "kernel/gzip.h"
+#include "passes/techmap/libparse.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// ---- Liberty NLDM tables ----
+
+static void interpolation_point(const std::vector<double> &index, double x, int &i, double &f)
+{
+	int n = GetSize(index);
+	if (n < 2) {
+		i = 0, f = 0;
+		return;
+	}
+	i = 0;
+	while (i < n - 2 && x > index[i + 1])
+		i++;
+	double span = index[i + 1] - index[i];
+	f = span != 0 ? (x - index[i]) / span : 0;
+}
+
+double LibertyTiming::Table::lookup(double transition, double load) const
+{
+	if (values.empty())
+		return 0;
+	if (index_1.empty() || GetSize(values) == 1)
+		return values[0];
+
+	auto variable = [&](Variable var) {
+		switch (var) {
+			case INPUT_TRANSITION: return transition;
+			case OUTPUT_LOAD: return load;
+			default: return 0.0;
+		}
+	};
+
+	int i, j;
+	double fi, fj;
+	interpolation_point(index_1, variable(var_1), i, fi);
+	int n1 = GetSize(index_1), n2 = GetSize(index_2);
+
+	if (n2 == 0) {
+		if (n1 < 2)
+			return values[0];
+		return values[i] + fi * (values[i + 1] - values[i]);
+	}
+
+	interpolation_point(index_2, variable(var_2), j, fj);
+	auto at = [&](int a, int b) { return values[std::min(a, n1 - 1) * n2 + std::min(b, n2 - 1)]; };
+	double v0 = at(i, j) + fj * (at(i, j + 1) - at(i, j));
+	double v1 = at(i + 1, j) + fj * (at(i + 1, j + 1) - at(i + 1, j));
+	return n1 < 2 ? v0 : v0 + fi * (v1 - v0);
+}
+
+double LibertyTiming::Arc::max_delay(double in_transition, double load) const
+{
+	return std::max(delay[0].lookup(in_transition, load), delay[1].lookup(in_transition, load));
+}
+
+double LibertyTiming::Arc::max_transition(double in_transition, double load) const
+{
+	return std::max(transition[0].lookup(in_transition, load), transition[1].lookup(in_transition, load));
+}
+
+static std::vector<double> parse_numbers(const std::vector<std::string> &args)
+{
+	std::vector<double> result;
+	for (auto &arg : args) {
+		std::string text = arg;
+		for (auto &c : text)
+			if (c == ',' || c == '\\' || c == '"')
+				c = ' ';
+		const char *p = text.c_str();
+		while (true) {
+			char *end;
+			double value = strtod(p, &end);
+			if (end == p)
+				break;
+			result.push_back(value);
+			p = end;
+		}
+	}
+	return result;
+}
+
+static LibertyTiming::Table::Variable parse_variable(const std::string &name)
+{
+	if (name == "input_net_transition" || name == "constrained_pin_transition")
+		return LibertyTiming::Table::INPUT_TRANSITION;
+	if (name == "total_output_net_capacitance")
+		return LibertyTiming::Table::OUTPUT_LOAD;
+	if (name == "related_pin_transition")
+		return LibertyTiming::Table::RELATED_TRANSITION;
+	return LibertyTiming::Table::OTHER;
+}
+
+static double parse_time_unit(const std::string &unit)
+{
+	const char *p = unit.c_str();
+	char *end;
+	double value = strtod(p, &end);
+	if (end == p)
+		value = 1;
+	std::string suffix = end;
+	if (suffix == "ns")
+		return value * 1e3;
+	if (suffix == "ps")
+		return value;
+	if (suffix == "us")
+		return value * 1e6;
+	if (suffix == "fs")
+		return value * 1e-3;
+	log_warning("Unsupported Liberty time unit `%s', assuming 1ns.\n", unit);
+	return 1e3;
+}
+
+void LibertyTiming::load(const std::string &filename)
+{
+	std::istream *f = uncompressed(filename.c_str());
+	yosys_input_files.insert(filename);
+	LibertyParser libparser(*f, filename);
+	delete f;
+
+	const LibertyAst *library = libparser.ast;
+	double time_scale = 1e3;
+	dict<std::string, Table> templates;
+
+	for (auto child : library->children) {
+		if (child->id == "time_unit")
+			time_scale = parse_time_unit(child->value);
+		if (child->id == "lu_table_template" && child->args.size() == 1) {
+			Table &tpl = templates[child->args[0]];
+			for (auto item : child->children) {
+				if (item->id == "variable_1")
+					tpl.var_1 = parse_variable(item->value);
+				if (item->id == "variable_2")
+					tpl.var_2 = parse_variable(item->value);
+				if (item->id == "index_1")
+					tpl.index_1 = parse_numbers(item->args);
+				if (item->id == "index_2")
+					tpl.index_2 = parse_numbers(item->args);
+			}
+		}
+	}
+
+	// All tables yield times, transition indices are times as well
+	auto parse_table = [&](const LibertyAst *ast) {
+		Table table;
+		if (ast == nullptr)
+			return table;
+		if (ast->args.size() == 1) {
+			auto it = templates.find(ast->args[0]);
+			if (it != templates.end())
+				table = it->second;
+		}
+		for (auto item : ast->children) {
+			if (item->id == "index_1")
+				table.index_1 = parse_numbers(item->args);
+			if (item->id == "index_2")
+				table.index_2 = parse_numbers(item->args);
+			if (item->id == "values")
+				table.values = parse_numbers(item->args);
+		}
+		size_t expected = std::max<size_t>(table.index_1.size(), 1) * std::max<size_t>(table.index_2.size(), 1);
+		if (!table.values.empty() && table.values.size() != expected && table.values.size() != 1) {
+			log_warning("Ignoring Liberty table with %d values (expected %d).\n", GetSize(table.values), int(expected));
+			table.values.clear();
+		}
+		if (table.var_1 == Table::INPUT_TRANSITION || table.var_1 == Table::RELATED_TRANSITION)
+			for (auto &v : table.index_1)
+				v *= time_scale;
+		if (table.var_2 == Table::INPUT_TRANSITION || table.var_2 == Table::RELATED_TRANSITION)
+			for (auto &v : table.index_2)
+				v *= time_scale;
+		for (auto &v : table.values)
+			v *= time_scale;
+		return table;
+	};
+
+	int num_cells = 0, num_arcs = 0;
+
+	for (auto cell_ast : library->children)
+	{
+		if (cell_ast->id != "cell" || cell_ast->args.size() != 1)
+			continue;
+
+		Cell &cell = cells[RTLIL::escape_id(cell_ast->args[0])];
+		cell.pins.clear();
+		num_cells++;
+
+		for (auto pin_ast : cell_ast->children)
+		{
+			if (pin_ast->id != "pin" || pin_ast->args.size() != 1)
+				continue;
+
+			Pin &pin = cell.pins[RTLIL::escape_id(pin_ast->args[0])];
+			for (auto item : pin_ast->children) {
+				if (item->id == "direction")
+					pin.output = item->value == "output" || item->value == "inout";
+				if (item->id == "capacitance" || item->id == "rise_capacitance" || item->id == "fall_capacitance")
+					pin.capacitance = std::max(pin.capacitance, atof(item->value.c_str()));
+			}
+
+			for (auto timing_ast : pin_ast->children)
+			{
+				if (timing_ast->id != "timing")
+					continue;
+
+				const LibertyAst *type_ast = timing_ast->find("timing_type");
+				std::string type = type_ast ? type_ast->value : "combinational";
+				bool is_setup = type == "setup_rising" || type == "setup_falling";
+				bool is_edge = type == "rising_edge" || type == "falling_edge";
+				if (!is_setup && !is_edge && type != "combinational" && type != "combinational_rise" && type != "combinational_fall")
+					continue;
+
+				Arc arc;
+				arc.clock_edge = is_edge;
+				if (is_setup) {
+					arc.delay[0] = parse_table(timing_ast->find("rise_constraint"));
+					arc.delay[1] = parse_table(timing_ast->find("fall_constraint"));
+				} else {
+					arc.delay[0] = parse_table(timing_ast->find("cell_rise"));
+					arc.delay[1] = parse_table(timing_ast->find("cell_fall"));
+					arc.transition[0] = parse_table(timing_ast->find("rise_transition"));
+					arc.transition[1] = parse_table(timing_ast->find("fall_transition"));
+				}
+
+				const LibertyAst *related_ast = timing_ast->find("related_pin");
+				if (related_ast == nullptr)
+					continue;
+				for (auto &name : split_tokens(related_ast->value)) {
+					arc.related_pin = RTLIL::escape_id(name);
+					(is_setup ? pin.setup : pin.arcs).push_back(arc);
+					num_arcs++;
+				}
+			}
+		}
+	}
+
+	log("Read timing of %d cells with %d arcs from `%s'.\n", num_cells, num_arcs, filename);
+}
+
+// ---- Timing graph ----
+
+TimingGraph::TimingGraph(RTLIL::Module *module, const LibertyTiming *liberty) :
+		module(module), liberty(liberty)
+{
+	module->monitors.insert(this);
+}
+
+TimingGraph::~TimingGraph()
+{
+	module->monitors.erase(this);
+}
+
+void TimingGraph::notify_connect(RTLIL::Cell *cell, RTLIL::IdString, const RTLIL::SigSpec&, const RTLIL::SigSpec&)
+{
+	if (cell->module == module)
+		dirty_cells.insert(cell->name);
+}
+
+void TimingGraph::notify_connect(RTLIL::Module *mod, const RTLIL::SigSig&)
+{
+	if (mod == module)
+		rebuild_needed = true;
+}
+
+void TimingGraph::notify_connect(RTLIL::Module *mod, const std::vector<RTLIL::SigSig>&)
+{
+	if (mod == module)
+		rebuild_needed = true;
+}
+
+void TimingGraph::notify_blackout(RTLIL::Module *mod)
+{
+	if (mod == module)
+		rebuild_needed = true;
+}
+
+int TimingGraph::node(RTLIL::SigBit bit)
+{
+	bit = sigmap(bit);
+	if (bit.wire == nullptr)
+		return -1;
+	auto it = bit_index.find(bit);
+	if (it != bit_index.end())
+		return it->second;
+	int n = GetSize(bits);
+	bits.push_back(bit);
+	bit_index[bit] = n;
+	return n;
+}
+
+TimingGraph::CellTiming TimingGraph::setup_cell(RTLIL::Cell *cell)
+{
+	CellTiming result;
+
+	const LibertyTiming::Cell *lib_cell = liberty ? liberty->cell(cell->type) : nullptr;
+	if (lib_cell != nullptr)
+	{
+		// Liberty pins are single bits, bus pins are not read
+		for (auto &conn : cell->connections())
+			if (GetSize(conn.second) > 1) {
+				if (warned_types.insert(cell->type).second)
+					log_warning("Port %s of cell type '%s' is %d bits wide, only single-bit Liberty pins are supported! Ignoring.\n",
+							log_id(conn.first), log_id(cell->type), GetSize(conn.second));
+				return result;
+			}
+
+		auto pin_node = [&](RTLIL::IdString port) {
+			if (!cell->hasPort(port) || cell->getPort(port).empty())
+				return -1;
+			return node(cell->getPort(port)[0]);
+		};
+
+		for (auto &it : lib_cell->pins)
+		{
+			int n = pin_node(it.first);
+			if (n < 0)
+				continue;
+			const LibertyTiming::Pin &pin = it.second;
+
+			if (!pin.output)
+				result.sinks.push_back({n, pin.capacitance});
+
+			for (auto &arc : pin.arcs) {
+				int from = pin_node(arc.related_pin);
+				if (from >= 0)
+					result.edges.push_back({from, n, cell, arc.related_pin, it.first, 0, &arc});
+			}
+
+			for (auto &arc : pin.setup)
+				result.checks.push_back({n, cell, it.first, &arc, 0});
+		}
+		return result;
+	}
+
+	RTLIL::Design *design = module->design;
+	RTLIL::Module *inst_module = design->module(cell->type);
+	if (!inst_module) {
+		if (warned_types.insert(cell->type).second)
+			log_warning("Cell type '%s' not recognised! Ignoring.\n", log_id(cell->type));
+		return result;
+	}
+
+	if (!inst_module->get_blackbox_attribute()) {
+		if (warned_types.insert(cell->type).second)
+			log_warning("Cell type '%s' is not a black- nor white-box! Ignoring.\n", log_id(cell->type));
+		return result;
+	}
+
+	RTLIL::IdString derived_type = inst_module->derive(design, cell->parameters);
+	inst_module = design->module(derived_type);
+	log_assert(inst_module);
+
+	if (!timing.count(derived_type)) {
+		auto &t = timing.setup_module(inst_module);
+		if (t.has_inputs && t.comb.empty() && t.arrival.empty() && t.required.empty())
+			log_warning("Module '%s' has no timing arcs!\n", log_id(cell->type));
+	}
+
+	auto &t = timing.at(derived_type);
+	if (t.comb.empty() && t.arrival.empty() && t.required.empty())
+		return result;
+
+	std::vector<std::pair<int, TimingInfo::NameBit>> src_bits, dst_bits;
+
+	for (auto &conn : cell->connections()) {
+		for (int i = 0; i < GetSize(conn.second); i++) {
+			int n = node(conn.second[i]);
+			if (n < 0)
+				continue;
+			TimingInfo::NameBit namebit(conn.first, i);
+			if (cell->input(conn.first)) {
+				src_bits.push_back({n, namebit});
+				auto it = t.required.find(namebit);
+				if (it != t.required.end())
+					result.checks.push_back({n, cell, conn.first, nullptr, double(it->second.first)});
+			}
+			if (cell->output(conn.first)) {
+				dst_bits.push_back({n, namebit});
+				auto it = t.arrival.find(namebit);
+				if (it == t.arrival.end())
+					continue;
+				const auto &s = it->second.second;
+				if (cell->hasPort(s.name) && s.offset < GetSize(cell->getPort(s.name))) {
+					int from = node(cell->getPort(s.name)[s.offset]);
+					if (from >= 0)
+						result.edges.push_back({from, n, cell, s.name, conn.first, double(it->second.first), nullptr});
+				}
+			}
+		}
+	}
+
+	for (auto &s : src_bits)
+		for (auto &d : dst_bits) {
+			auto it = t.comb.find(TimingInfo::BitBit(s.second, d.second));
+			if (it != t.comb.end())
+				result.edges.push_back({s.first, d.first, cell, s.second.name, d.second.name, double(it->second), nullptr});
+		}
+
+	return result;
+}
+
+void TimingGraph::build_csr()
+{
+	int num_nodes = GetSize(bits);
+
+	arrival.resize(num_nodes, -INFINITY_TIME);
+	required.resize(num_nodes, INFINITY_TIME);
+	transition.resize(num_nodes, 0);
+	setup.resize(num_nodes, 0);
+	arrival_edge.resize(num_nodes, -1);
+	startpoint.resize(num_nodes, false);
+
+	std::vector<Edge> old_edges;
+	std::vector<double> old_edge_delay;
+	std::vector<int> old_fanin_start, old_fanin_edges;
+	old_edges.swap(edges);
+	old_edge_delay.swap(edge_delay);
+	old_fanin_start.swap(fanin_start);
+	old_fanin_edges.swap(fanin_edges);
+
+	checks.clear();
+	load.assign(num_nodes, 0);
+	for (auto &it : cell_timing) {
+		edges.insert(edges.end(), it.second.edges.begin(), it.second.edges.end());
+		checks.insert(checks.end(), it.second.checks.begin(), it.second.checks.end());
+		for (auto &sink : it.second.sinks)
+			load[sink.first] += sink.second;
+	}
+	edge_delay.assign(GetSize(edges), 0);
+
+	auto make_csr = [&](std::vector<int> &start, std::vector<int> &list, bool by_from) {
+		start.assign(num_nodes + 1, 0);
+		for (auto &e : edges)
+			start[(by_from ? e.from : e.to) + 1]++;
+		for (int n = 0; n < num_nodes; n++)
+			start[n + 1] += start[n];
+		list.resize(GetSize(edges));
+		std::vector<int> fill(start.begin(), start.end() - 1);
+		for (int e = 0; e < GetSize(edges); e++)
+			list[fill[by_from ? edges[e].from : edges[e].to]++] = e;
+	};
+	make_csr(fanout_start, fanout_edges, true);
+	make_csr(fanin_start, fanin_edges, false);
+
+	// Edges are renumbered, carry over the delays and arrival edges of the
+	// edges that are still present, as only the changed cones are recomputed
+	std::vector<int> edge_map(GetSize(old_edges), -1);
+	for (int e = 0; e < GetSize(edges); e++) {
+		const Edge &edge = edges[e];
+		if (edge.to + 1 >= GetSize(old_fanin_start))
+			continue;
+		for (int i = old_fanin_start[edge.to]; i < old_fanin_start[edge.to + 1]; i++) {
+			int old_e = old_fanin_edges[i];
+			const Edge &old = old_edges[old_e];
+			if (edge_map[old_e] < 0 && old.cell == edge.cell && old.from == edge.from && old.arc == edge.arc &&
+					old.from_port == edge.from_port && old.to_port == edge.to_port && old.fixed_delay == edge.fixed_delay) {
+				edge_map[old_e] = e;
+				edge_delay[e] = old_edge_delay[old_e];
+				break;
+			}
+		}
+	}
+	for (auto &e : arrival_edge)
+		if (e >= 0)
+			e = edge_map[e];
+
+	std::stable_sort(checks.begin(), checks.end(), [](const Check &a, const Check &b) { return a.node < b.node; });
+	check_start.assign(num_nodes + 1, 0);
+	for (auto &check : checks)
+		check_start[check.node + 1]++;
+	for (int n = 0; n < num_nodes; n++)
+		check_start[n + 1] += check_start[n];
+
+	driven.assign(num_nodes, false);
+	endpoint.assign(num_nodes, false);
+	endpoint_cell.assign(num_nodes, nullptr);
+	endpoint_port.assign(num_nodes, RTLIL::IdString());
+	for (int n = 0; n < num_nodes; n++) {
+		driven[n] = startpoint[n] || fanin_start[n] < fanin_start[n + 1];
+		if (check_start[n] < check_start[n + 1]) {
+			endpoint[n] = true;
+			endpoint_cell[n] = checks[check_start[n]].cell;
+			endpoint_port[n] = checks[check_start[n]].port;
+		}
+	}
+	// Output bits that no timed cell connects to have no node and are not
+	// added here, the per node arrays are already sized
+	for (auto wire : module->wires())
+		if (wire->port_output)
+			for (auto bit : RTLIL::SigSpec(wire)) {
+				auto it = bit_index.find(sigmap(bit));
+				if (it != bit_index.end())
+					endpoint[it->second] = true;
+			}
+}
+
+void TimingGraph::levelize()
+{
+	// Kahn's algorithm. Nodes on loops are levelized when nothing else is
+	// left, edges closing a loop then go to a lower or equal level and are
+	// ignored during propagation.
+	int num_nodes = GetSize(bits);
+	std::vector<int> pending(num_nodes, 0), queue;
+	std::vector<bool> done(num_nodes, false);
+	level.assign(num_nodes, 0);
+	has_loops = false;
+
+	for (auto &e : edges)
+		pending[e.to]++;
+	for (int n = 0; n < num_nodes; n++)
+		if (pending[n] == 0)
+			queue.push_back(n);
+
+	int next_unleveled = 0;
+	for (int q = 0;; q++) {
+		if (q == GetSize(queue)) {
+			while (next_unleveled < num_nodes && (done[next_unleveled] || pending[next_unleveled] == 0))
+				next_unleveled++;
+			if (next_unleveled == num_nodes)
+				break;
+			has_loops = true;
+			pending[next_unleveled] = 0;
+			queue.push_back(next_unleveled);
+		}
+		int n = queue[q];
+		done[n] = true;
+		for (int i = fanout_start[n]; i < fanout_start[n + 1]; i++) {
+			int to = edges[fanout_edges[i]].to;
+			if (done[to])
+				continue;
+			level[to] = std::max(level[to], level[n] + 1);
+			if (--pending[to] == 0)
+				queue.push_back(to);
+		}
+	}
+}
+
+double TimingGraph::compute_setup(int n) const
+{
+	double result = 0;
+	for (int i = check_start[n]; i < check_start[n + 1]; i++) {
+		const Check &check = checks[i];
+		result = std::max(result, check.arc ? check.arc->max_delay(transition[n], 0) : check.fixed_setup);
+	}
+	return result;
+}
+
+bool TimingGraph::compute_arrival(int n)
+{
+	double new_arrival = startpoint[n] ? 0 : -INFINITY_TIME;
+	double new_transition = startpoint[n] && liberty ? liberty->input_transition : 0;
+	int new_edge = -1;
+
+	for (int i = fanin_start[n]; i < fanin_start[n + 1]; i++) {
+		int e = fanin_edges[i];
+		const Edge &edge = edges[e];
+		if (level[edge.from] >= level[n])
+			continue;
+		double in_transition = transition[edge.from];
+		edge_delay[e] = edge.arc ? edge.arc->max_delay(in_transition, load[n]) : edge.fixed_delay;
+		if (!reached(edge.from))
+			continue;
+		if (edge.arc)
+			new_transition = std::max(new_transition, edge.arc->max_transition(in_transition, load[n]));
+		if (arrival[edge.from] + edge_delay[e] > new_arrival) {
+			new_arrival = arrival[edge.from] + edge_delay[e];
+			new_edge = e;
+		}
+	}
+
+	bool changed = new_arrival != arrival[n] || new_transition != transition[n] || new_edge != arrival_edge[n];
+	arrival[n] = new_arrival;
+	transition[n] = new_transition;
+	arrival_edge[n] = new_edge;
+	return changed;
+}
+
+bool TimingGraph::compute_required(int n)
+{
+	double new_required = endpoint[n] ? effective_period - setup[n] : INFINITY_TIME;
+	for (int i = fanout_start[n]; i < fanout_start[n + 1]; i++) {
+		int e = fanout_edges[i];
+		int to = edges[e].to;
+		if (level[to] <= level[n] || required[to] >= INFINITY_TIME)
+			continue;
+		new_required = std::min(new_required, required[to] - edge_delay[e]);
+	}
+	bool changed = new_required != required[n];
+	required[n] = new_required;
+	return changed;
+}
+
+// Both propagations process nodes level by level, starting from the seeds,
+// and only continue into the fanout (or fanin) of nodes whose values changed.
+void TimingGraph::propagate_arrival(const pool<int> &seeds, pool<int> &required_seeds)
+{
+	int max_level = 0;
+	for (int l : level)
+		max_level = std::max(max_level, l);
+
+	std::vector<std::vector<int>> buckets(max_level + 1);
+	std::vector<bool> queued(GetSize(bits), false);
+	for (int n : seeds) {
+		buckets[level[n]].push_back(n);
+		queued[n] = true;
+	}
+
+	for (int l = 0; l <= max_level; l++)
+		for (int k = 0; k < GetSize(buckets[l]); k++) {
+			int n = buckets[l][k];
+			updated_arrivals++;
+
+			std::vector<double> old_delays;
+			for (int i = fanin_start[n]; i < fanin_start[n + 1]; i++)
+				old_delays.push_back(edge_delay[fanin_edges[i]]);
+
+			bool changed = compute_arrival(n);
+
+			// Required times upstream depend on the edge delays
+			for (int i = fanin_start[n]; i < fanin_start[n + 1]; i++)
+				if (edge_delay[fanin_edges[i]] != old_delays[i - fanin_start[n]])
+					required_seeds.insert(edges[fanin_edges[i]].from);
+
+			if (endpoint[n]) {
+				double new_setup = compute_setup(n);
+				if (new_setup != setup[n]) {
+					setup[n] = new_setup;
+					required_seeds.insert(n);
+				}
+			}
+
+			if (!changed)
+				continue;
+			for (int i = fanout_start[n]; i < fanout_start[n + 1]; i++) {
+				int to = edges[fanout_edges[i]].to;
+				if (level[to] > l && !queued[to]) {
+					buckets[level[to]].push_back(to);
+					queued[to] = true;
+				}
+			}
+		}
+}
+
+void TimingGraph::propagate_required(const pool<int> &seeds)
+{
+	int max_level = 0;
+	for (int l : level)
+		max_level = std::max(max_level, l);
+
+	std::vector<std::vector<int>> buckets(max_level + 1);
+	std::vector<bool> queued(GetSize(bits), false);
+	for (int n : seeds) {
+		buckets[level[n]].push_back(n);
+		queued[n] = true;
+	}
+
+	for (int l = max_level; l >= 0; l--)
+		for (int k = 0; k < GetSize(buckets[l]); k++) {
+			int n = buckets[l][k];
+			updated_requireds++;
+			if (!compute_required(n))
+				continue;
+			for (int i = fanin_start[n]; i < fanin_start[n + 1]; i++) {
+				int from = edges[fanin_edges[i]].from;
+				if (level[from] < l && !queued[from]) {
+					buckets[level[from]].push_back(from);
+					queued[from] = true;
+				}
+			}
+		}
+}
+
+bool TimingGraph::update_period()
+{
+	double new_period = period;
+	if (new_period <= 0) {
+		new_period = 0;
+		for (int n = 0; n < GetSize(bits); n++)
+			if (endpoint[n] && reached(n))
+				new_period = std::max(new_period, arrival[n] + setup[n]);
+	}
+	bool changed = new_period != effective_period;
+	effective_period = new_period;
+	return changed;
+}
+
+void TimingGraph::full_update()
+{
+	rebuild_needed = false;
+	dirty_cells.clear();
+	cell_timing.clear();
+	bits.clear();
+	bit_index.clear();
+	edges.clear();
+	fanin_start.clear();
+	fanin_edges.clear();
+	sigmap.set(module);
+
+	for (auto cell : module->cells())
+		cell_timing[cell->name] = setup_cell(cell);
+
+	std::vector<int> inputs;
+	for (auto wire : module->wires())
+		if (wire->port_input)
+			for (auto bit : RTLIL::SigSpec(wire)) {
+				int n = node(bit);
+				if (n >= 0)
+					inputs.push_back(n);
+			}
+
+	arrival.clear();
+	required.clear();
+	transition.clear();
+	setup.clear();
+	arrival_edge.clear();
+	startpoint.clear();
+	startpoint.resize(GetSize(bits), false);
+	for (int n : inputs)
+		startpoint[n] = true;
+
+	build_csr();
+	levelize();
+
+	pool<int> all_nodes, required_seeds;
+	for (int n = 0; n < GetSize(bits); n++)
+		all_nodes.insert(n);
+	propagate_arrival(all_nodes, required_seeds);
+	update_period();
+	propagate_required(all_nodes);
+}
+
+void TimingGraph::incremental_update()
+{
+	pool<int> changed_nodes;
+	auto collect = [&](const CellTiming &ct) {
+		for (auto &e : ct.edges)
+			changed_nodes.insert(e.from), changed_nodes.insert(e.to);
+		for (auto &c : ct.checks)
+			changed_nodes.insert(c.node);
+		for (auto &s : ct.sinks)
+			changed_nodes.insert(s.first);
+	};
+
+	for (auto name : dirty_cells) {
+		auto it = cell_timing.find(name);
+		if (it != cell_timing.end()) {
+			collect(it->second);
+			cell_timing.erase(it);
+		}
+		RTLIL::Cell *cell = module->cell(name);
+		if (cell != nullptr) {
+			CellTiming &ct = cell_timing[name];
+			ct = setup_cell(cell);
+			collect(ct);
+		}
+	}
+	dirty_cells.clear();
+
+	build_csr();
+	levelize();
+
+	// Changed loads and fanins affect the arrival of the node itself,
+	// removed or added edges the required time of their source
+	pool<int> required_seeds = changed_nodes;
+	propagate_arrival(changed_nodes, required_seeds);
+
+	if (update_period()) {
+		required_seeds.clear();
+		for (int n = 0; n < GetSize(bits); n++)
+			required_seeds.insert(n);
+	}
+	propagate_required(required_seeds);
+}
+
+void TimingGraph::update()
+{
+	updated_arrivals = 0;
+	updated_requireds = 0;
+
+	if (rebuild_needed)
+		full_update();
+	else if (!dirty_cells.empty())
+		incremental_update();
+}
+
+double TimingGraph::worst_slack() const
+{
+	double result = INFINITY_TIME;
+	for (int n = 0; n < GetSize(bits); n++)
+		if (endpoint[n] && reached(n))
+			result = std::min(result, slack(n));
+	return result;
+}
+
+TimingGraph::Path TimingGraph::path_to(int n) const
+{
+	Path path;
+	path.arrival = arrival[n];
+	path.required = required[n];
+	path.slack = slack(n);
+	path.sink = endpoint_cell[n];
+	path.sink_port = endpoint_port[n];
+
+	while (n >= 0) {
+		PathPoint point;
+		point.bit = bits[n];
+		point.arrival = arrival[n];
+		point.cell = nullptr;
+		int e = arrival_edge[n];
+		if (e >= 0) {
+			point.cell = edges[e].cell;
+			point.from_port = edges[e].from_port;
+			point.to_port = edges[e].to_port;
+		}
+		path.points.push_back(point);
+		n = e >= 0 ? edges[e].from : -1;
+	}
+
+	std::reverse(path.points.begin(), path.points.end());
+	return path;
+}
+
+std::vector<TimingGraph::Path> TimingGraph::critical_paths(int count) const
+{
+	std::vector<int> candidates;
+	for (int n = 0; n < GetSize(bits); n++)
+		if (endpoint[n] && reached(n) && arrival_edge[n] >= 0)
+			candidates.push_back(n);
+
+	auto worse = [&](int a, int b) {
+		if (slack(a) != slack(b))
+			return slack(a) < slack(b);
+		return a < b;
+	};
+	if (count < GetSize(candidates)) {
+		std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(), worse);
+		candidates.resize(count);
+	} else
+		std::sort(candidates.begin(), candidates.end(), worse);
+
+	std::vector<Path> paths;
+	for (int n : candidates)
+		paths.push_back(path_to(n));
+	return paths;
+}
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,233 @@
+/* -*- c++ -*-
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef TIMINGGRAPH_H
+#define TIMINGGRAPH_H
+
+#include "kernel/yosys.h"
+#include "kernel/sigtools.h"
+#include "kernel/timinginfo.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// NLDM (non-linear delay model) timing data read from Liberty files. Times
+// are converted to picoseconds, capacitances are kept in the library unit.
+// Rise and fall are not tracked separately: delays and transitions are the
+// maximum of the rise and fall tables. Only single-bit pins are read, bus
+// and bundle groups are skipped.
+struct LibertyTiming
+{
+	struct Table
+	{
+		enum Variable { INPUT_TRANSITION, OUTPUT_LOAD, RELATED_TRANSITION, OTHER };
+		Variable var_1 = INPUT_TRANSITION, var_2 = OUTPUT_LOAD;
+		std::vector<double> index_1, index_2, values;
+
+		bool empty() const { return values.empty(); }
+		// Bilinear interpolation, extrapolated linearly outside of the table
+		double lookup(double transition, double load) const;
+	};
+
+	struct Arc
+	{
+		RTLIL::IdString related_pin;
+		// Launch arc from a clock pin (timing_type rising_edge or falling_edge)
+		bool clock_edge = false;
+		Table delay[2], transition[2];
+
+		double max_delay(double in_transition, double load) const;
+		double max_transition(double in_transition, double load) const;
+	};
+
+	struct Pin
+	{
+		bool output = false;
+		double capacitance = 0;
+		// Arcs ending in this pin
+		std::vector<Arc> arcs;
+		// Setup constraints checked at this pin, stored as arcs with the
+		// constraint tables in `delay`
+		std::vector<Arc> setup;
+	};
+
+	struct Cell
+	{
+		dict<RTLIL::IdString, Pin> pins;
+	};
+
+	dict<RTLIL::IdString, Cell> cells;
+	// Transition at the primary inputs
+	double input_transition = 0;
+
+	// Adds the cells of a Liberty file, cells that are already known are replaced
+	void load(const std::string &filename);
+
+	const Cell *cell(RTLIL::IdString type) const
+	{
+		auto it = cells.find(type);
+		return it == cells.end() ? nullptr : &it->second;
+	}
+};
+
+// Static timing graph of a module. Nodes are the (sigmapped) bits, edges are
+// the timing arcs of the cells, taken from a LibertyTiming library or from
+// the abc9 box timing of blackbox modules (TimingInfo). Cells of Liberty
+// types with multi-bit ports are ignored with a warning. Nodes and edges are
+// kept in dense arrays, fanin and fanout lists in CSR form.
+//
+// Arrival times are propagated from the primary inputs (arriving at time 0)
+// in topological order. Endpoints are primary outputs and cell pins with a
+// setup constraint; their required time is the clock period minus the setup
+// time. If no period is given, the latest endpoint arrival is used, so that
+// the worst slack is zero.
+//
+// The graph registers itself as a monitor of the module. Connection changes
+// of cells (including adding and removing cells) are picked up by update(),
+// which recomputes delays, arrival and required times only in the fanout and
+// fanin cones of the changed cells. Changes of cell types or parameters are
+// not reported by RTLIL and must be announced with invalidate(cell); changes
+// of the module connections or ports cause a full rebuild.
+struct TimingGraph : RTLIL::Monitor
+{
+	struct Edge
+	{
+		int from, to;
+		RTLIL::Cell *cell;
+		RTLIL::IdString from_port, to_port;
+		// Used if there is no Liberty arc (abc9 box timing)
+		double fixed_delay;
+		const LibertyTiming::Arc *arc;
+	};
+
+	struct PathPoint
+	{
+		RTLIL::SigBit bit;
+		double arrival;
+		// Cell and arc driving this point, nullptr for the startpoint
+		RTLIL::Cell *cell;
+		RTLIL::IdString from_port, to_port;
+	};
+
+	struct Path
+	{
+		double arrival, required, slack;
+		// Cell and pin the path ends in, nullptr for primary outputs
+		RTLIL::Cell *sink;
+		RTLIL::IdString sink_port;
+		// From startpoint to endpoint
+		std::vector<PathPoint> points;
+	};
+
+	RTLIL::Module *module;
+	const LibertyTiming *liberty;
+	SigMap sigmap;
+	TimingInfo timing;
+
+	// Clock period for required times, <= 0 to use the latest endpoint arrival
+	double period = 0;
+
+	// Per node data, indexed like `bits`
+	std::vector<RTLIL::SigBit> bits;
+	dict<RTLIL::SigBit, int> bit_index;
+	std::vector<double> arrival, required, transition, load, setup;
+	std::vector<int> arrival_edge, level;
+	std::vector<bool> driven, startpoint, endpoint;
+	std::vector<RTLIL::Cell*> endpoint_cell;
+	std::vector<RTLIL::IdString> endpoint_port;
+
+	// Edges and CSR adjacency
+	std::vector<Edge> edges;
+	std::vector<double> edge_delay;
+	std::vector<int> fanout_start, fanout_edges, fanin_start, fanin_edges;
+
+	bool has_loops = false;
+	double effective_period = 0;
+
+	// Statistics of the last update
+	int updated_arrivals = 0, updated_requireds = 0;
+
+	TimingGraph(RTLIL::Module *module, const LibertyTiming *liberty = nullptr);
+	~TimingGraph();
+
+	// Brings the timing data up to date, incrementally if possible
+	void update();
+
+	// Announce a change of a cell that is not visible as a connection change
+	void invalidate(RTLIL::Cell *cell) { dirty_cells.insert(cell->name); }
+	// Force a full rebuild on the next update()
+	void invalidate() { rebuild_needed = true; }
+
+	bool reached(int node) const { return arrival[node] > -INFINITY_TIME; }
+	double slack(int node) const { return required[node] - arrival[node]; }
+	double worst_slack() const;
+	// The paths to the `count` endpoints with the least slack, worst first
+	std::vector<Path> critical_paths(int count) const;
+	Path path_to(int node) const;
+
+	void notify_connect(RTLIL::Cell *cell, RTLIL::IdString port, const RTLIL::SigSpec &old_sig, const RTLIL::SigSpec &new_sig) override;
+	void notify_connect(RTLIL::Module *module, const RTLIL::SigSig &sigsig) override;
+	void notify_connect(RTLIL::Module *module, const std::vector<RTLIL::SigSig> &sigsig_vec) override;
+	void notify_blackout(RTLIL::Module *module) override;
+
+	static constexpr double INFINITY_TIME = 1e30;
+
+private:
+	// Setup constraint at an endpoint pin, a Liberty arc or a fixed time
+	struct Check
+	{
+		int node;
+		RTLIL::Cell *cell;
+		RTLIL::IdString port;
+		const LibertyTiming::Arc *arc;
+		double fixed_setup;
+	};
+
+	struct CellTiming
+	{
+		std::vector<Edge> edges;
+		std::vector<Check> checks;
+		// Sink pins with their pin capacitance
+		std::vector<std::pair<int, double>> sinks;
+	};
+
+	// Checks sorted by node, CSR indexed
+	std::vector<Check> checks;
+	std::vector<int> check_start;
+
+	// Keyed by cell name, as cells may be deleted before the next update()
+	dict<RTLIL::IdString, CellTiming> cell_timing;
+	pool<RTLIL::IdString> dirty_cells;
+	bool rebuild_needed = true;
+	pool<RTLIL::IdString> warned_types;
+
+	int node(RTLIL::SigBit bit);
+	CellTiming setup_cell(RTLIL::Cell *cell);
+	void build_csr();
+	void levelize();
+	double compute_setup(int n) const;
+	void full_update();
+	void incremental_update();
+	bool compute_arrival(int n);
+	bool compute_required(int n);
+	void propagate_arrival(const pool<int> &seeds, pool<int> &required_seeds);
+	void propagate_required(const pool<int> &seeds);
+	bool update_period();
+};
+
+YOSYS_NAMESPACE_END
+
+#endif
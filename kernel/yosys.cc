@@ -264,6 +264,7 @@ void yosys_setup()
 	yosys_design = new RTLIL::Design;
 	yosys_celltypes.setup();
 	log_push();
+	log_outputs_changed();
 }
 
 bool yosys_already_setup()
@@ -285,11 +286,14 @@ void yosys_shutdown()
 	yosys_design = NULL;
 	RTLIL::OwningIdString::collect_garbage();
 
-	for (auto f : log_files)
+	for (auto f : log_files) {
+		log_file_sync(f);
 		if (f != stderr)
 			fclose(f);
+	}
 	log_errfile = NULL;
 	log_files.clear();
+	log_outputs_changed();
 
 	yosys_celltypes.clear();
 
@@ -75,6 +75,7 @@ void run_pass(std::string command, RTLIL::Design *design = nullptr);
 bool run_frontend(std::string filename, std::string command, RTLIL::Design *design = nullptr, std::string *from_to_label = nullptr);
 void run_backend(std::string filename, std::string command, RTLIL::Design *design = nullptr);
 void shell(RTLIL::Design *design);
+bool fgetline(FILE *f, std::string &buffer);
 
 // journal of all input and output files read (for "yosys -E")
 extern std::set<std::string> yosys_input_files, yosys_output_files;
@@ -88,6 +89,10 @@ const char* yosys_maybe_version();
 extern std::map<std::string, RTLIL::Design*> saved_designs;
 extern std::vector<RTLIL::Design*> pushed_designs;
 
+// from passes/techmap/techmap.cc
+extern bool techmap_cache_enabled;
+void techmap_cache_purge();
+
 // from passes/cmds/pluginc.cc
 extern std::map<std::string, void*> loaded_plugins;
 #ifdef YOSYS_ENABLE_PYTHON
@@ -103,27 +103,193 @@ static std::vector<IdString> get_path(const json11::Json &json)
 	return result;
 }
 
+// Pull parser for witness files. The clock and signal definitions are small
+// and handed to json11 one at a time, while the step values, which make up
+// almost all of a long trace, are copied directly out of the file buffer
+// without building a JSON tree.
+struct WitnessScanner
+{
+	const std::string &filename;
+	const char *p;
+	const char *end;
+
+	WitnessScanner(const std::string &filename, const std::string &buf) :
+		filename(filename), p(buf.data()), end(buf.data() + buf.size()) { }
+
+	[[noreturn]] void error(const std::string &what)
+	{
+		log_error("Failed to parse `%s`: %s\n", filename, what);
+	}
+
+	void skip_ws()
+	{
+		while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+			p++;
+	}
+
+	bool peek(char c)
+	{
+		skip_ws();
+		return p < end && *p == c;
+	}
+
+	void expect(char c)
+	{
+		if (!peek(c))
+			error(p < end ? stringf("expected '%c' but found '%c'", c, *p) : stringf("expected '%c' but found end of input", c));
+		p++;
+	}
+
+	std::string parse_string()
+	{
+		expect('"');
+		const char *start = p;
+		while (p < end && *p != '"' && *p != '\\')
+			p++;
+		if (p < end && *p == '"')
+			return std::string(start, p++);
+
+		// Fall back to json11 for strings with escapes
+		while (p < end && *p != '"')
+			p += *p == '\\' ? 2 : 1;
+		if (p >= end)
+			error("unterminated string");
+		p++;
+		std::string err;
+		json11::Json json = json11::Json::parse(std::string(start - 1, p), err);
+		if (!err.empty())
+			error(err);
+		return json.string_value();
+	}
+
+	void skip_value()
+	{
+		skip_ws();
+		if (p >= end)
+			error("unexpected end of input");
+		if (*p == '"') {
+			parse_string();
+		} else if (*p == '[') {
+			parse_array([&]() { skip_value(); });
+		} else if (*p == '{') {
+			parse_object([&](const std::string &) { skip_value(); });
+		} else {
+			const char *start = p;
+			while (p < end && (isalnum((unsigned char)*p) || *p == '-' || *p == '+' || *p == '.'))
+				p++;
+			if (p == start)
+				error(stringf("unexpected character '%c'", *p));
+		}
+	}
+
+	json11::Json parse_json()
+	{
+		skip_ws();
+		const char *start = p;
+		skip_value();
+		std::string err;
+		json11::Json json = json11::Json::parse(std::string(start, p), err);
+		if (!err.empty())
+			error(err);
+		return json;
+	}
+
+	template<typename F>
+	void parse_array(F item)
+	{
+		expect('[');
+		if (peek(']')) {
+			p++;
+			return;
+		}
+		while (true) {
+			item();
+			if (peek(',')) {
+				p++;
+				continue;
+			}
+			expect(']');
+			return;
+		}
+	}
+
+	template<typename F>
+	void parse_object(F member)
+	{
+		expect('{');
+		if (peek('}')) {
+			p++;
+			return;
+		}
+		while (true) {
+			std::string key = parse_string();
+			expect(':');
+			member(key);
+			if (peek(',')) {
+				p++;
+				continue;
+			}
+			expect('}');
+			return;
+		}
+	}
+};
+
 ReadWitness::ReadWitness(const std::string &filename) :
 	filename(filename)
 {
-	std::ifstream f(filename.c_str());
+	std::ifstream f(filename.c_str(), std::ios::binary);
 	if (f.fail() || GetSize(filename) == 0)
 		log_error("Cannot open file `%s`\n", filename);
-	std::stringstream buf;
-	buf << f.rdbuf();
-	std::string err;
-	json11::Json json = json11::Json::parse(buf.str(), err);
-	if (!err.empty())
-		log_error("Failed to parse `%s`: %s\n", filename, err);
+	std::string buf((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
 
-	std::string format = json["format"].string_value();
+	WitnessScanner scanner(filename, buf);
+	std::string format;
+	std::vector<json11::Json> clocks_json, signals_json;
+
+	scanner.parse_object([&](const std::string &key) {
+		if (key == "format") {
+			format = scanner.parse_json().string_value();
+		} else if (key == "clocks") {
+			scanner.parse_array([&]() { clocks_json.push_back(scanner.parse_json()); });
+		} else if (key == "signals") {
+			scanner.parse_array([&]() { signals_json.push_back(scanner.parse_json()); });
+		} else if (key == "steps") {
+			scanner.parse_array([&]() {
+				Step step;
+				bool has_bits = false;
+				scanner.parse_object([&](const std::string &step_key) {
+					if (step_key != "bits") {
+						scanner.skip_value();
+						return;
+					}
+					if (!scanner.peek('"'))
+						log_error("Failed to parse `%s`: Expected string as bits value for step %d\n", filename, GetSize(steps));
+					step.bits = scanner.parse_string();
+					has_bits = true;
+				});
+				if (!has_bits)
+					log_error("Failed to parse `%s`: Expected string as bits value for step %d\n", filename, GetSize(steps));
+				for (char c : step.bits) {
+					if (c != '0' && c != '1' && c != 'x' && c != '?')
+						log_error("Failed to parse `%s`: Invalid bit '%c' value for step %d\n", filename, c, GetSize(steps));
+				}
+				steps.push_back(std::move(step));
+			});
+		} else {
+			scanner.skip_value();
+		}
+	});
+	scanner.skip_ws();
+	if (scanner.p != scanner.end)
+		scanner.error("unexpected trailing input");
 
 	if (format.empty())
 		log_error("Failed to parse `%s`: Unknown format\n", filename);
 	if (format != "Yosys Witness Trace")
 		log_error("Failed to parse `%s`: Unsupported format `%s`\n", filename, format);
 
-	for (auto &clock_json : json["clocks"].array_items()) {
+	for (auto &clock_json : clocks_json) {
 		Clock clock;
 		clock.path = get_path(clock_json["path"]);
 		if (clock.path.empty())
@@ -144,7 +310,7 @@ ReadWitness::ReadWitness(const std::string &filename) :
 	}
 
 	int bits_offset = 0;
-	for (auto &signal_json : json["signals"].array_items()) {
+	for (auto &signal_json : signals_json) {
 		Signal signal;
 		signal.bits_offset = bits_offset;
 		signal.path = get_path(signal_json["path"]);
@@ -164,18 +330,6 @@ ReadWitness::ReadWitness(const std::string &filename) :
 		signal.init_only = signal_json["init_only"].bool_value();
 		signals.push_back(signal);
 	}
-
-	for (auto &step_json : json["steps"].array_items()) {
-		Step step;
-		if (!step_json["bits"].is_string())
-			log_error("Failed to parse `%s`: Expected string as bits value for step %d\n", filename, GetSize(steps));
-		step.bits = step_json["bits"].string_value();
-		for (char c : step.bits) {
-			if (c != '0' && c != '1' && c != 'x' && c != '?')
-				log_error("Failed to parse `%s`: Invalid bit '%c' value for step %d\n", filename, c, GetSize(steps));
-		}
-		steps.push_back(step);
-	}
 }
 
 RTLIL::Const ReadWitness::get_bits(int t, int bits_offset, int width) const
@@ -0,0 +1,236 @@
+/*
+ *  ezSAT -- A simple and easy to use CNF generator for SAT solvers
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+// Compares the ezMiniSAT and ezCDCL backends on a set of CNF problems.
+//
+// Usage: ./benchmark [file.cnf ...]
+//
+// Without arguments a built-in suite of generated problems is used:
+// multiplier miters (the kind of problem `sat -prove` and `equiv_simple`
+// produce), factoring, random 3-SAT near the phase transition and pigeon hole
+// problems. DIMACS files, e.g. written by `sat -dump_cnf`, can be passed on
+// the command line. Both solvers must agree on every problem and every model
+// is checked with an independent solver instance.
+
+#include "ezminisat.h"
+#include "ezcdcl.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <functional>
+#include <memory>
+
+typedef std::vector<std::vector<int>> cnf_t;
+
+struct Problem {
+	std::string name;
+	std::function<void(ezSAT&, std::vector<int>&)> build;
+};
+
+static uint32_t xorshift32_state = 123456789;
+
+static uint32_t xorshift32()
+{
+	xorshift32_state ^= xorshift32_state << 13;
+	xorshift32_state ^= xorshift32_state >> 17;
+	xorshift32_state ^= xorshift32_state << 5;
+	return xorshift32_state;
+}
+
+static std::vector<int> vec_mul(ezSAT &sat, const std::vector<int> &a, const std::vector<int> &b)
+{
+	std::vector<int> result = sat.vec_const_unsigned(0, a.size());
+	for (int i = 0; i < int(b.size()); i++) {
+		std::vector<int> partial = sat.vec_and(sat.vec_shl(a, i), std::vector<int>(a.size(), b[i]));
+		result = sat.vec_add(result, partial);
+	}
+	return result;
+}
+
+// a*b != b*a, unsatisfiable
+static void build_mul_comm(ezSAT &sat, std::vector<int> &, int width)
+{
+	std::vector<int> a = sat.vec_var(width), b = sat.vec_var(width);
+	sat.assume(sat.vec_ne(vec_mul(sat, a, b), vec_mul(sat, b, a)));
+}
+
+// a*b == c with a, b > 1, satisfiable iff c is not prime
+static void build_factor(ezSAT &sat, std::vector<int> &model, int width, uint64_t c)
+{
+	std::vector<int> a = sat.vec_var(width), b = sat.vec_var(width);
+	std::vector<int> wa = sat.vec_cast(a, 2*width), wb = sat.vec_cast(b, 2*width);
+	sat.assume(sat.vec_eq(vec_mul(sat, wa, wb), sat.vec_const_unsigned(c, 2*width)));
+	sat.assume(sat.vec_gt_unsigned(a, sat.vec_const_unsigned(1, width)));
+	sat.assume(sat.vec_gt_unsigned(b, sat.vec_const_unsigned(1, width)));
+	model.insert(model.end(), a.begin(), a.end());
+	model.insert(model.end(), b.begin(), b.end());
+}
+
+static void build_random_3sat(ezSAT &sat, std::vector<int> &model, int num_vars, int num_clauses, uint32_t seed)
+{
+	xorshift32_state = seed;
+	std::vector<int> vars = sat.vec_var(num_vars);
+	for (int i = 0; i < num_clauses; i++) {
+		std::vector<int> clause;
+		for (int j = 0; j < 3; j++) {
+			int v = vars[xorshift32() % num_vars];
+			clause.push_back(xorshift32() % 2 ? v : sat.NOT(v));
+		}
+		sat.assume(sat.expression(ezSAT::OpOr, clause));
+	}
+	model = vars;
+}
+
+// n+1 pigeons in n holes, unsatisfiable
+static void build_pigeon_hole(ezSAT &sat, std::vector<int> &, int holes)
+{
+	std::vector<std::vector<int>> p(holes + 1);
+	for (auto &row : p)
+		row = sat.vec_var(holes);
+	for (auto &row : p)
+		sat.assume(sat.expression(ezSAT::OpOr, row));
+	for (int h = 0; h < holes; h++)
+		for (int i = 0; i <= holes; i++)
+			for (int j = i + 1; j <= holes; j++)
+				sat.assume(sat.NOT(sat.AND(p[i][h], p[j][h])));
+}
+
+static bool read_dimacs(const char *filename, cnf_t &cnf, int &num_vars)
+{
+	FILE *f = fopen(filename, "r");
+	if (f == NULL)
+		return false;
+
+	num_vars = 0;
+	std::vector<int> clause;
+	char buffer[4096];
+	while (fscanf(f, " %4095s", buffer) == 1) {
+		if (buffer[0] == 'c' || buffer[0] == 'p') {
+			int ch;
+			while ((ch = fgetc(f)) != EOF && ch != '\n') { }
+			continue;
+		}
+		int lit = atoi(buffer);
+		if (lit == 0) {
+			cnf.push_back(clause);
+			clause.clear();
+		} else {
+			clause.push_back(lit);
+			num_vars = std::max(num_vars, abs(lit));
+		}
+	}
+	if (!clause.empty())
+		cnf.push_back(clause);
+
+	fclose(f);
+	return true;
+}
+
+static void build_dimacs(ezSAT &sat, std::vector<int> &model, const cnf_t &cnf, int num_vars)
+{
+	std::vector<int> vars = sat.vec_var(num_vars);
+	for (auto &clause : cnf) {
+		std::vector<int> lits;
+		for (int lit : clause)
+			lits.push_back(lit > 0 ? vars[lit-1] : sat.NOT(vars[-lit-1]));
+		sat.assume(sat.expression(ezSAT::OpOr, lits));
+	}
+	model = vars;
+}
+
+static bool run(ezSAT &sat, const Problem &problem, double &seconds)
+{
+	std::vector<int> model_expr;
+	std::vector<bool> model_values;
+
+	problem.build(sat, model_expr);
+
+	clock_t start = clock();
+	bool result = sat.solve(model_expr, model_values);
+	seconds = double(clock() - start) / CLOCKS_PER_SEC;
+
+	if (result) {
+		// Check the model with an independent solver instance
+		ezMiniSAT check;
+		std::vector<int> check_expr;
+		problem.build(check, check_expr);
+		for (int i = 0; i < int(check_expr.size()); i++)
+			check.assume(model_values[i] ? check_expr[i] : check.NOT(check_expr[i]));
+		if (!check.solve()) {
+			printf("ERROR: model for %s is invalid!\n", problem.name.c_str());
+			exit(1);
+		}
+	}
+
+	return result;
+}
+
+int main(int argc, char **argv)
+{
+	std::vector<Problem> problems;
+
+	if (argc > 1) {
+		for (int i = 1; i < argc; i++) {
+			auto cnf = std::make_shared<cnf_t>();
+			int num_vars = 0;
+			if (!read_dimacs(argv[i], *cnf, num_vars)) {
+				fprintf(stderr, "Can't open `%s'.\n", argv[i]);
+				return 1;
+			}
+			problems.push_back({argv[i], [=](ezSAT &sat, std::vector<int> &model) { build_dimacs(sat, model, *cnf, num_vars); }});
+		}
+	} else {
+		for (int width : {6, 8, 9})
+			problems.push_back({"mul_comm_" + std::to_string(width), [=](ezSAT &sat, std::vector<int> &model) { build_mul_comm(sat, model, width); }});
+		problems.push_back({"factor_sat", [](ezSAT &sat, std::vector<int> &model) { build_factor(sat, model, 12, 3127ULL * 2999ULL); }});
+		problems.push_back({"factor_unsat", [](ezSAT &sat, std::vector<int> &model) { build_factor(sat, model, 12, 8388593ULL); }});
+		for (uint32_t seed = 1; seed <= 8; seed++)
+			problems.push_back({"rand3sat_" + std::to_string(seed), [=](ezSAT &sat, std::vector<int> &model) { build_random_3sat(sat, model, 200, 852, seed); }});
+		for (int holes : {7, 8})
+			problems.push_back({"pigeon_hole_" + std::to_string(holes), [=](ezSAT &sat, std::vector<int> &model) { build_pigeon_hole(sat, model, holes); }});
+	}
+
+	double total_minisat = 0, total_cdcl = 0;
+
+	printf("%-30s %8s %10s %10s %10s\n", "problem", "result", "minisat", "cdcl", "conflicts");
+	for (auto &problem : problems)
+	{
+		double t_minisat, t_cdcl;
+
+		ezMiniSAT minisat;
+		bool r_minisat = run(minisat, problem, t_minisat);
+
+		ezCDCL cdcl;
+		bool r_cdcl = run(cdcl, problem, t_cdcl);
+
+		printf("%-30s %8s %9.3fs %9.3fs %10lld\n", problem.name.c_str(), r_cdcl ? "SAT" : "UNSAT",
+				t_minisat, t_cdcl, (long long)cdcl.stats().conflicts);
+
+		if (r_minisat != r_cdcl) {
+			printf("ERROR: solvers disagree on %s!\n", problem.name.c_str());
+			return 1;
+		}
+
+		total_minisat += t_minisat;
+		total_cdcl += t_cdcl;
+	}
+	printf("%-30s %8s %9.3fs %9.3fs\n", "total", "", total_minisat, total_cdcl);
+
+	return 0;
+}
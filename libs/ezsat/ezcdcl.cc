@@ -0,0 +1,997 @@
+/*
+ *  ezSAT -- A simple and easy to use CNF generator for SAT solvers
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "ezcdcl.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <string.h>
+#include <chrono>
+
+// Literals are encoded as 2*var + sign, clause references are offsets into
+// a flat arena of 32 bit words.
+
+static const uint32_t CREF_NONE = UINT32_MAX;
+
+static inline int lit_var(int lit) { return lit >> 1; }
+
+struct ezCDCLSolver
+{
+	// Tuning knobs
+	int chrono_threshold = 100;     // backjumps longer than this are done chronologically
+	int restart_min_conflicts = 20; // minimum number of conflicts between restarts
+	double restart_margin = 1.1;    // restart when fast LBD average exceeds slow one by this factor
+	int reduce_first = 2000, reduce_inc = 300;
+	int tier1_lbd = 2, tier2_lbd = 6;
+	double var_decay = 0.95, clause_decay = 0.999;
+
+	struct Watcher {
+		uint32_t cref;
+		int blocker;
+	};
+
+	// Clause layout in the arena: size, flags, lbd, activity, literals...
+	enum { HDR_SIZE = 0, HDR_FLAGS = 1, HDR_LBD = 2, HDR_ACT = 3, HDR_WORDS = 4 };
+	enum { FLAG_LEARNT = 1, FLAG_REMOVED = 2, FLAG_USED = 4, FLAG_VIVIFIED = 8 };
+
+	std::vector<uint32_t> arena;
+	size_t wasted = 0;
+	std::vector<uint32_t> clauses, learnts;
+
+	std::vector<int8_t> value; // per literal: 1 true, -1 false, 0 unassigned
+	std::vector<int> level;
+	std::vector<uint32_t> reason;
+	std::vector<double> activity;
+	std::vector<int8_t> phase;
+	std::vector<int8_t> seen;
+	std::vector<std::vector<Watcher>> watches; // per literal, visited when the literal becomes false
+
+	std::vector<int> heap, heap_index;
+
+	std::vector<int> trail, trail_lim;
+	size_t qhead = 0;
+
+	bool ok = true;
+	double var_inc = 1.0, clause_inc = 1.0;
+	double ema_fast = 0, ema_slow = 0;
+	int64_t conflicts_since_restart = 0, next_reduce = 0;
+	size_t simplified_trail = 0;
+	bool vivify_pending = false;
+	int64_t vivify_props_mark = 0;
+
+	std::vector<int> level_stamp;
+	int stamp_counter = 0;
+	std::vector<int> analyze_stack, analyze_toclear, learnt_buf;
+
+	ezCDCL::Stats stats = {};
+	std::chrono::steady_clock::time_point deadline = {};
+	bool has_deadline = false;
+	const std::atomic<bool> *interrupt = nullptr;
+
+	// A non-zero seed randomizes initial activities and phases, so that
+	// differently seeded instances explore different parts of the search space
+	uint32_t seed = 0;
+
+	uint32_t next_random()
+	{
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		return seed;
+	}
+
+	ezCDCLSolver() { next_reduce = reduce_first; }
+
+	int num_vars() const { return int(level.size()); }
+	int decision_level() const { return int(trail_lim.size()); }
+
+	uint32_t &clause_size(uint32_t cref) { return arena[cref + HDR_SIZE]; }
+	uint32_t &clause_flags(uint32_t cref) { return arena[cref + HDR_FLAGS]; }
+	uint32_t &clause_lbd(uint32_t cref) { return arena[cref + HDR_LBD]; }
+	int *clause_lits(uint32_t cref) { return reinterpret_cast<int*>(&arena[cref + HDR_WORDS]); }
+
+	float clause_activity(uint32_t cref) const {
+		float f;
+		memcpy(&f, &arena[cref + HDR_ACT], sizeof(f));
+		return f;
+	}
+	void set_clause_activity(uint32_t cref, float f) {
+		memcpy(&arena[cref + HDR_ACT], &f, sizeof(f));
+	}
+
+	// ---- variable order heap ----
+
+	void heap_up(int i)
+	{
+		int v = heap[i];
+		while (i > 0) {
+			int p = (i - 1) >> 1;
+			if (!(activity[v] > activity[heap[p]]))
+				break;
+			heap[i] = heap[p];
+			heap_index[heap[i]] = i;
+			i = p;
+		}
+		heap[i] = v;
+		heap_index[v] = i;
+	}
+
+	void heap_down(int i)
+	{
+		int v = heap[i], n = int(heap.size());
+		while (true) {
+			int c = 2 * i + 1;
+			if (c >= n)
+				break;
+			if (c + 1 < n && activity[heap[c + 1]] > activity[heap[c]])
+				c++;
+			if (!(activity[heap[c]] > activity[v]))
+				break;
+			heap[i] = heap[c];
+			heap_index[heap[i]] = i;
+			i = c;
+		}
+		heap[i] = v;
+		heap_index[v] = i;
+	}
+
+	void heap_insert(int v)
+	{
+		if (heap_index[v] >= 0)
+			return;
+		heap_index[v] = int(heap.size());
+		heap.push_back(v);
+		heap_up(heap_index[v]);
+	}
+
+	int heap_pop()
+	{
+		int v = heap[0];
+		heap_index[v] = -1;
+		int last = heap.back();
+		heap.pop_back();
+		if (!heap.empty()) {
+			heap[0] = last;
+			heap_index[last] = 0;
+			heap_down(0);
+		}
+		return v;
+	}
+
+	void bump_var(int v)
+	{
+		if ((activity[v] += var_inc) > 1e100) {
+			for (auto &a : activity)
+				a *= 1e-100;
+			var_inc *= 1e-100;
+		}
+		if (heap_index[v] >= 0)
+			heap_up(heap_index[v]);
+	}
+
+	void bump_clause(uint32_t cref)
+	{
+		float act = clause_activity(cref) + float(clause_inc);
+		set_clause_activity(cref, act);
+		if (act > 1e20f) {
+			for (auto c : learnts)
+				set_clause_activity(c, clause_activity(c) * 1e-20f);
+			clause_inc *= 1e-20;
+		}
+	}
+
+	// ---- assignment ----
+
+	int new_var()
+	{
+		int v = num_vars();
+		value.push_back(0);
+		value.push_back(0);
+		level.push_back(0);
+		reason.push_back(CREF_NONE);
+		activity.push_back(seed ? (next_random() % 1024) * 1e-5 : 0);
+		phase.push_back(seed ? next_random() & 1 : 1);
+		seen.push_back(0);
+		watches.emplace_back();
+		watches.emplace_back();
+		heap_index.push_back(-1);
+		heap_insert(v);
+		return v;
+	}
+
+	void assign(int lit, int lvl, uint32_t from)
+	{
+		int v = lit_var(lit);
+		value[lit] = 1;
+		value[lit ^ 1] = -1;
+		level[v] = lvl;
+		reason[v] = from;
+		trail.push_back(lit);
+	}
+
+	// Backtracks to `target`, keeping literals that were assigned out of
+	// order at a lower level (as a result of chronological backtracking).
+	void backtrack(int target)
+	{
+		if (decision_level() <= target)
+			return;
+		size_t start = trail_lim[target], j = start;
+		for (size_t i = start; i < trail.size(); i++) {
+			int lit = trail[i], v = lit_var(lit);
+			if (level[v] > target) {
+				value[lit] = 0;
+				value[lit ^ 1] = 0;
+				reason[v] = CREF_NONE;
+				phase[v] = lit & 1;
+				heap_insert(v);
+			} else
+				trail[j++] = lit;
+		}
+		trail.resize(j);
+		trail_lim.resize(target);
+		qhead = std::min(qhead, start);
+	}
+
+	bool locked(uint32_t cref)
+	{
+		int lit = clause_lits(cref)[0];
+		return value[lit] == 1 && reason[lit_var(lit)] == cref;
+	}
+
+	// ---- clauses ----
+
+	uint32_t alloc_clause(const std::vector<int> &lits, bool learnt, int lbd)
+	{
+		uint32_t cref = uint32_t(arena.size());
+		arena.push_back(uint32_t(lits.size()));
+		arena.push_back(learnt ? FLAG_LEARNT : 0);
+		arena.push_back(uint32_t(lbd));
+		arena.push_back(0);
+		for (int lit : lits)
+			arena.push_back(uint32_t(lit));
+		return cref;
+	}
+
+	void attach(uint32_t cref)
+	{
+		int *lits = clause_lits(cref);
+		watches[lits[0]].push_back({cref, lits[1]});
+		watches[lits[1]].push_back({cref, lits[0]});
+	}
+
+	void remove_clause(uint32_t cref)
+	{
+		// Watchers are removed lazily during propagation.
+		clause_flags(cref) |= FLAG_REMOVED;
+		wasted += HDR_WORDS + clause_size(cref);
+	}
+
+	void unwatch(int lit, uint32_t cref)
+	{
+		auto &ws = watches[lit];
+		for (size_t i = 0; i < ws.size(); i++)
+			if (ws[i].cref == cref) {
+				ws[i] = ws.back();
+				ws.pop_back();
+				return;
+			}
+	}
+
+	bool add_clause(std::vector<int> lits)
+	{
+		if (!ok)
+			return false;
+		assert(decision_level() == 0);
+
+		std::sort(lits.begin(), lits.end());
+		size_t j = 0;
+		for (size_t i = 0; i < lits.size(); i++) {
+			int lit = lits[i];
+			if (value[lit] == 1 || (j > 0 && lits[j-1] == (lit ^ 1)))
+				return true;
+			if (value[lit] == -1 || (j > 0 && lits[j-1] == lit))
+				continue;
+			lits[j++] = lit;
+		}
+		lits.resize(j);
+
+		if (lits.empty())
+			return ok = false;
+
+		if (lits.size() == 1) {
+			assign(lits[0], 0, CREF_NONE);
+			return ok = (propagate() == CREF_NONE);
+		}
+
+		uint32_t cref = alloc_clause(lits, false, 0);
+		attach(cref);
+		clauses.push_back(cref);
+		return true;
+	}
+
+	// ---- propagation ----
+
+	uint32_t propagate()
+	{
+		uint32_t conflict = CREF_NONE;
+
+		while (qhead < trail.size())
+		{
+			int false_lit = trail[qhead++] ^ 1;
+			std::vector<Watcher> &ws = watches[false_lit];
+			size_t i = 0, j = 0, n = ws.size();
+			stats.propagations++;
+
+			while (i < n)
+			{
+				Watcher w = ws[i++];
+				if (value[w.blocker] == 1) {
+					ws[j++] = w;
+					continue;
+				}
+
+				uint32_t cref = w.cref;
+				if (clause_flags(cref) & FLAG_REMOVED)
+					continue;
+
+				int *lits = clause_lits(cref);
+				int size = int(clause_size(cref));
+				if (lits[0] == false_lit)
+					std::swap(lits[0], lits[1]);
+
+				int first = lits[0];
+				if (first != w.blocker && value[first] == 1) {
+					ws[j++] = {cref, first};
+					continue;
+				}
+
+				bool found = false;
+				for (int k = 2; k < size; k++)
+					if (value[lits[k]] != -1) {
+						std::swap(lits[1], lits[k]);
+						watches[lits[1]].push_back({cref, first});
+						found = true;
+						break;
+					}
+				if (found)
+					continue;
+
+				ws[j++] = {cref, first};
+
+				if (value[first] == -1) {
+					conflict = cref;
+					qhead = trail.size();
+					while (i < n)
+						ws[j++] = ws[i++];
+				} else {
+					// With chronological backtracking the implied literal may
+					// belong to a lower level than the current one.
+					int lvl = 0;
+					for (int k = 1; k < size; k++)
+						lvl = std::max(lvl, level[lit_var(lits[k])]);
+					assign(first, lvl, cref);
+				}
+			}
+			ws.resize(j);
+
+			if (conflict != CREF_NONE)
+				break;
+		}
+
+		return conflict;
+	}
+
+	// ---- conflict analysis ----
+
+	int compute_lbd(const int *lits, int size)
+	{
+		stamp_counter++;
+		int lbd = 0;
+		for (int k = 0; k < size; k++) {
+			int lvl = level[lit_var(lits[k])];
+			if (lvl >= int(level_stamp.size()))
+				level_stamp.resize(lvl + 1, 0);
+			if (level_stamp[lvl] != stamp_counter) {
+				level_stamp[lvl] = stamp_counter;
+				lbd++;
+			}
+		}
+		return lbd;
+	}
+
+	uint32_t abstract_level(int v) const { return 1u << (level[v] & 31); }
+
+	bool lit_redundant(int p, uint32_t abstract_levels)
+	{
+		analyze_stack.clear();
+		analyze_stack.push_back(p);
+		size_t top = analyze_toclear.size();
+
+		while (!analyze_stack.empty())
+		{
+			int q = analyze_stack.back();
+			analyze_stack.pop_back();
+			uint32_t cref = reason[lit_var(q)];
+			int *lits = clause_lits(cref);
+			int size = int(clause_size(cref));
+
+			for (int k = 1; k < size; k++) {
+				int l = lits[k], v = lit_var(l);
+				if (seen[v] || level[v] == 0)
+					continue;
+				if (reason[v] != CREF_NONE && (abstract_level(v) & abstract_levels)) {
+					seen[v] = 1;
+					analyze_stack.push_back(l);
+					analyze_toclear.push_back(l);
+				} else {
+					for (size_t t = top; t < analyze_toclear.size(); t++)
+						seen[lit_var(analyze_toclear[t])] = 0;
+					analyze_toclear.resize(top);
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	// Computes the first UIP clause for a conflict at the current decision
+	// level. Returns the clause in `learnt` (asserting literal first, a
+	// literal of the backjump level second) and the backjump level.
+	int analyze(uint32_t conflict, std::vector<int> &learnt)
+	{
+		int dl = decision_level();
+		int path_count = 0, p = -1;
+		int index = int(trail.size()) - 1;
+
+		learnt.clear();
+		learnt.push_back(-1);
+
+		do {
+			int *lits = clause_lits(conflict);
+			int size = int(clause_size(conflict));
+
+			if (clause_flags(conflict) & FLAG_LEARNT) {
+				bump_clause(conflict);
+				clause_flags(conflict) |= FLAG_USED;
+				int lbd = compute_lbd(lits, size);
+				if (lbd + 1 < int(clause_lbd(conflict)))
+					clause_lbd(conflict) = lbd;
+			}
+
+			for (int k = (p == -1 ? 0 : 1); k < size; k++) {
+				int q = lits[k], v = lit_var(q);
+				if (seen[v] || level[v] == 0)
+					continue;
+				bump_var(v);
+				seen[v] = 1;
+				if (level[v] >= dl)
+					path_count++;
+				else
+					learnt.push_back(q);
+			}
+
+			while (!(seen[lit_var(trail[index])] && level[lit_var(trail[index])] >= dl))
+				index--;
+			p = trail[index--];
+			conflict = reason[lit_var(p)];
+			seen[lit_var(p)] = 0;
+			path_count--;
+		} while (path_count > 0);
+
+		learnt[0] = p ^ 1;
+
+		// Recursive clause minimization
+		analyze_toclear = learnt;
+		uint32_t abstract_levels = 0;
+		for (size_t k = 1; k < learnt.size(); k++)
+			abstract_levels |= abstract_level(lit_var(learnt[k]));
+		size_t j = 1;
+		for (size_t k = 1; k < learnt.size(); k++) {
+			int v = lit_var(learnt[k]);
+			if (reason[v] == CREF_NONE || !lit_redundant(learnt[k], abstract_levels))
+				learnt[j++] = learnt[k];
+		}
+		learnt.resize(j);
+		for (int lit : analyze_toclear)
+			seen[lit_var(lit)] = 0;
+
+		if (learnt.size() == 1)
+			return 0;
+
+		size_t max_k = 1;
+		for (size_t k = 2; k < learnt.size(); k++)
+			if (level[lit_var(learnt[k])] > level[lit_var(learnt[max_k])])
+				max_k = k;
+		std::swap(learnt[1], learnt[max_k]);
+		return level[lit_var(learnt[1])];
+	}
+
+	// Handles a conflict, returns false if the formula is unsatisfiable.
+	bool handle_conflict(uint32_t conflict)
+	{
+		stats.conflicts++;
+		conflicts_since_restart++;
+
+		int *lits = clause_lits(conflict);
+		int size = int(clause_size(conflict));
+
+		int conflict_level = 0, count = 0, max_k = 0;
+		for (int k = 0; k < size; k++) {
+			int lvl = level[lit_var(lits[k])];
+			if (lvl > conflict_level)
+				conflict_level = lvl, count = 1, max_k = k;
+			else if (lvl == conflict_level)
+				count++;
+		}
+
+		if (conflict_level == 0)
+			return false;
+
+		if (count == 1)
+		{
+			// A single literal on the highest level: this is an implication
+			// that was missed on a lower level, no learning needed.
+			backtrack(conflict_level - 1);
+			int second_k = max_k == 0 ? 1 : 0;
+			for (int k = 0; k < size; k++)
+				if (k != max_k && level[lit_var(lits[k])] > level[lit_var(lits[second_k])])
+					second_k = k;
+			rewatch(conflict, max_k, second_k);
+			lits = clause_lits(conflict);
+			assign(lits[0], level[lit_var(lits[1])], conflict);
+			return true;
+		}
+
+		backtrack(conflict_level);
+
+		int bt_level = analyze(conflict, learnt_buf);
+		int target = bt_level;
+		if (chrono_threshold >= 0 && decision_level() - bt_level > chrono_threshold) {
+			target = decision_level() - 1;
+			stats.chrono_backtracks++;
+		}
+		backtrack(target);
+
+		int lbd = compute_lbd(learnt_buf.data(), int(learnt_buf.size()));
+		if (learnt_buf.size() == 1) {
+			assign(learnt_buf[0], 0, CREF_NONE);
+		} else {
+			uint32_t cref = alloc_clause(learnt_buf, true, lbd);
+			attach(cref);
+			learnts.push_back(cref);
+			bump_clause(cref);
+			assign(learnt_buf[0], bt_level, cref);
+		}
+
+		var_inc /= var_decay;
+		clause_inc /= clause_decay;
+
+		// Moving averages of the LBD, using the plain mean while warming up
+		ema_fast += (lbd - ema_fast) / std::min<double>(stats.conflicts, 32);
+		ema_slow += (lbd - ema_slow) / std::min<double>(stats.conflicts, 4096);
+		return true;
+	}
+
+	// Moves the literals at positions k0 and k1 to the watched positions 0 and 1.
+	void rewatch(uint32_t cref, int k0, int k1)
+	{
+		int *lits = clause_lits(cref);
+		int old0 = lits[0], old1 = lits[1];
+		int new0 = lits[k0], new1 = lits[k1];
+		std::swap(lits[0], lits[k0]);
+		if (k1 == 0)
+			k1 = k0;
+		std::swap(lits[1], lits[k1]);
+		assert(lits[0] == new0 && lits[1] == new1);
+		if (old0 != new0 && old0 != new1)
+			unwatch(old0, cref);
+		if (old1 != new0 && old1 != new1)
+			unwatch(old1, cref);
+		if (new0 != old0 && new0 != old1)
+			watches[new0].push_back({cref, new1});
+		if (new1 != old0 && new1 != old1)
+			watches[new1].push_back({cref, new0});
+	}
+
+	// ---- clause database management ----
+
+	void reduce_db()
+	{
+		stats.reductions++;
+		next_reduce = stats.conflicts + reduce_first + reduce_inc * stats.reductions;
+
+		std::vector<uint32_t> candidates;
+		for (auto cref : learnts) {
+			uint32_t &flags = clause_flags(cref);
+			if (flags & FLAG_REMOVED)
+				continue;
+			int lbd = int(clause_lbd(cref));
+			if (lbd <= tier1_lbd)
+				continue;
+			if (lbd <= tier2_lbd && (flags & FLAG_USED)) {
+				flags &= ~FLAG_USED;
+				continue;
+			}
+			candidates.push_back(cref);
+		}
+
+		std::sort(candidates.begin(), candidates.end(), [&](uint32_t a, uint32_t b) {
+			if (clause_lbd(a) != clause_lbd(b))
+				return clause_lbd(a) > clause_lbd(b);
+			return clause_activity(a) < clause_activity(b);
+		});
+
+		for (size_t k = 0; k < candidates.size() / 2; k++)
+			if (!locked(candidates[k]))
+				remove_clause(candidates[k]);
+
+		purge_removed(learnts);
+		vivify_pending = true;
+		maybe_collect();
+	}
+
+	void purge_removed(std::vector<uint32_t> &list)
+	{
+		size_t j = 0;
+		for (auto cref : list)
+			if (!(clause_flags(cref) & FLAG_REMOVED))
+				list[j++] = cref;
+		list.resize(j);
+	}
+
+	// Removes clauses satisfied on level 0.
+	void simplify()
+	{
+		assert(decision_level() == 0);
+		if (trail.size() == simplified_trail)
+			return;
+		simplified_trail = trail.size();
+
+		for (int lit : trail)
+			reason[lit_var(lit)] = CREF_NONE;
+
+		for (auto *list : {&clauses, &learnts}) {
+			for (auto cref : *list) {
+				if (clause_flags(cref) & FLAG_REMOVED)
+					continue;
+				int *lits = clause_lits(cref);
+				int size = int(clause_size(cref));
+				for (int k = 0; k < size; k++)
+					if (value[lits[k]] == 1) {
+						remove_clause(cref);
+						break;
+					}
+			}
+			purge_removed(*list);
+		}
+		maybe_collect();
+	}
+
+	void maybe_collect()
+	{
+		if (wasted * 2 <= arena.size())
+			return;
+
+		std::vector<uint32_t> new_arena;
+		new_arena.reserve(arena.size() - wasted);
+
+		for (auto *list : {&clauses, &learnts})
+			for (auto &cref : *list) {
+				uint32_t new_cref = uint32_t(new_arena.size());
+				new_arena.insert(new_arena.end(), arena.begin() + cref, arena.begin() + cref + HDR_WORDS + clause_size(cref));
+				// Leave a forwarding address for the reasons below
+				arena[cref + HDR_LBD] = new_cref;
+				cref = new_cref;
+			}
+
+		for (int lit : trail) {
+			uint32_t &r = reason[lit_var(lit)];
+			if (r != CREF_NONE)
+				r = arena[r + HDR_LBD];
+		}
+
+		arena.swap(new_arena);
+		wasted = 0;
+
+		for (auto &ws : watches)
+			ws.clear();
+		for (auto *list : {&clauses, &learnts})
+			for (auto cref : *list)
+				attach(cref);
+	}
+
+	// Tries to shorten learnt clauses by propagating the negation of their
+	// literals one at a time. Must be called on decision level 0.
+	void vivify()
+	{
+		assert(decision_level() == 0);
+		vivify_pending = false;
+
+		int64_t budget = std::max<int64_t>(20000, (stats.propagations - vivify_props_mark) / 10);
+		int64_t start = stats.propagations;
+		vivify_props_mark = stats.propagations;
+
+		std::vector<uint32_t> candidates;
+		for (auto cref : learnts)
+			if (!(clause_flags(cref) & (FLAG_REMOVED | FLAG_VIVIFIED)) && int(clause_lbd(cref)) <= tier2_lbd && clause_size(cref) > 2)
+				candidates.push_back(cref);
+		std::sort(candidates.begin(), candidates.end(), [&](uint32_t a, uint32_t b) {
+			return clause_lbd(a) < clause_lbd(b);
+		});
+
+		std::vector<int> lits, new_lits;
+		for (auto cref : candidates)
+		{
+			if (stats.propagations - start > budget)
+				break;
+			if ((clause_flags(cref) & FLAG_REMOVED) || locked(cref))
+				continue;
+
+			int size = int(clause_size(cref));
+			int lbd = int(clause_lbd(cref));
+			lits.assign(clause_lits(cref), clause_lits(cref) + size);
+			remove_clause(cref);
+
+			bool satisfied = false;
+			for (int lit : lits)
+				if (value[lit] == 1)
+					satisfied = true;
+			if (satisfied)
+				continue;
+
+			new_lits.clear();
+			for (int lit : lits) {
+				if (value[lit] == 1) {
+					// Implied by the negation of the previous literals
+					new_lits.push_back(lit);
+					break;
+				}
+				if (value[lit] == -1)
+					continue;
+				new_lits.push_back(lit);
+				trail_lim.push_back(int(trail.size()));
+				assign(lit ^ 1, decision_level(), CREF_NONE);
+				if (propagate() != CREF_NONE)
+					break;
+			}
+			backtrack(0);
+
+			stats.vivified_clauses++;
+			stats.vivified_literals += size - int(new_lits.size());
+
+			if (new_lits.empty()) {
+				ok = false;
+				return;
+			}
+			if (new_lits.size() == 1) {
+				if (value[new_lits[0]] == 0)
+					assign(new_lits[0], 0, CREF_NONE);
+				if (propagate() != CREF_NONE) {
+					ok = false;
+					return;
+				}
+				continue;
+			}
+
+			uint32_t new_cref = alloc_clause(new_lits, true, std::min(lbd, int(new_lits.size()) - 1));
+			clause_flags(new_cref) |= FLAG_VIVIFIED;
+			attach(new_cref);
+			learnts.push_back(new_cref);
+		}
+
+		purge_removed(learnts);
+		maybe_collect();
+	}
+
+	// ---- search ----
+
+	int pick_branch_lit()
+	{
+		while (!heap.empty()) {
+			int v = heap_pop();
+			if (value[2 * v] == 0)
+				return 2 * v + phase[v];
+		}
+		return -1;
+	}
+
+	bool interrupted() const
+	{
+		if (interrupt != nullptr && interrupt->load(std::memory_order_relaxed))
+			return true;
+		return has_deadline && std::chrono::steady_clock::now() > deadline;
+	}
+
+	// Returns 1 for SAT, 0 for UNSAT, -1 when interrupted (deadline or flag).
+	int solve(const std::vector<int> &assumptions, std::vector<bool> &model)
+	{
+		model.clear();
+		if (!ok)
+			return 0;
+
+		while (true)
+		{
+			uint32_t conflict = propagate();
+			if (conflict != CREF_NONE) {
+				if (!handle_conflict(conflict)) {
+					ok = false;
+					backtrack(0);
+					return 0;
+				}
+				if ((stats.conflicts & 255) == 0 && interrupted()) {
+					backtrack(0);
+					return -1;
+				}
+				continue;
+			}
+
+			if (conflicts_since_restart >= restart_min_conflicts && ema_fast > restart_margin * ema_slow) {
+				stats.restarts++;
+				conflicts_since_restart = 0;
+				backtrack(0);
+				simplify();
+				if (vivify_pending) {
+					vivify();
+					if (!ok)
+						return 0;
+				}
+				continue;
+			}
+
+			if (stats.conflicts >= next_reduce)
+				reduce_db();
+
+			int next = -1;
+			while (decision_level() < int(assumptions.size())) {
+				int p = assumptions[decision_level()];
+				if (value[p] == 1) {
+					trail_lim.push_back(int(trail.size()));
+				} else if (value[p] == -1) {
+					backtrack(0);
+					return 0;
+				} else {
+					next = p;
+					break;
+				}
+			}
+
+			if (next == -1) {
+				next = pick_branch_lit();
+				if (next == -1) {
+					model.resize(num_vars());
+					for (int v = 0; v < num_vars(); v++)
+						model[v] = value[2 * v] == 1;
+					backtrack(0);
+					return 1;
+				}
+			}
+
+			stats.decisions++;
+			trail_lim.push_back(int(trail.size()));
+			assign(next, decision_level(), CREF_NONE);
+		}
+	}
+};
+
+ezCDCL::ezCDCL() : cdclSolver(NULL)
+{
+	foundContradiction = false;
+}
+
+ezCDCL::~ezCDCL()
+{
+	if (cdclSolver != NULL)
+		delete cdclSolver;
+}
+
+void ezCDCL::clear()
+{
+	if (cdclSolver != NULL) {
+		delete cdclSolver;
+		cdclSolver = NULL;
+	}
+	foundContradiction = false;
+	cdclVars.clear();
+	ezSAT::clear();
+}
+
+ezCDCL::Stats ezCDCL::stats() const
+{
+	if (cdclSolver == NULL)
+		return Stats();
+	return cdclSolver->stats;
+}
+
+bool ezCDCL::solver(const std::vector<int> &modelExpressions, std::vector<bool> &modelValues, const std::vector<int> &assumptions)
+{
+	preSolverCallback();
+
+	solverTimoutStatus = false;
+
+	if (foundContradiction) {
+		consumeCnf();
+		return false;
+	}
+
+	std::vector<int> extraClauses, modelIdx;
+
+	for (auto id : assumptions)
+		extraClauses.push_back(bind(id));
+	for (auto id : modelExpressions)
+		modelIdx.push_back(bind(id));
+
+	if (cdclSolver == NULL)
+	{
+		cdclSolver = new ezCDCLSolver;
+		cdclSolver->seed = solverSeed;
+	}
+
+	std::vector<std::vector<int>> cnf;
+	consumeCnf(cnf);
+
+	while (int(cdclVars.size()) < numCnfVariables())
+		cdclVars.push_back(cdclSolver->new_var());
+
+	auto to_lit = [&](int idx) {
+		return idx > 0 ? 2 * cdclVars.at(idx - 1) : 2 * cdclVars.at(-idx - 1) + 1;
+	};
+
+	for (auto &clause : cnf) {
+		std::vector<int> lits;
+		for (auto idx : clause)
+			lits.push_back(to_lit(idx));
+		if (!cdclSolver->add_clause(lits)) {
+			delete cdclSolver;
+			cdclSolver = NULL;
+			cdclVars.clear();
+			foundContradiction = true;
+			return false;
+		}
+	}
+
+	std::vector<int> assumps;
+	for (auto idx : extraClauses)
+		assumps.push_back(to_lit(idx));
+
+	cdclSolver->has_deadline = solverTimeout > 0;
+	cdclSolver->deadline = std::chrono::steady_clock::now() + std::chrono::seconds(solverTimeout);
+	cdclSolver->interrupt = solverInterrupt;
+
+	std::vector<bool> model;
+	int result = cdclSolver->solve(assumps, model);
+
+	if (result < 0)
+		solverTimoutStatus = true;
+	if (result <= 0)
+		return false;
+
+	modelValues.clear();
+	modelValues.resize(modelIdx.size());
+
+	for (size_t i = 0; i < modelIdx.size(); i++)
+	{
+		int idx = modelIdx[i];
+		bool refvalue = true;
+
+		if (idx < 0)
+			idx = -idx, refvalue = false;
+
+		modelValues[i] = (model.at(cdclVars.at(idx - 1)) == refvalue);
+	}
+
+	return true;
+}
@@ -0,0 +1,51 @@
+/*
+ *  ezSAT -- A simple and easy to use CNF generator for SAT solvers
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef EZCDCL_H
+#define EZCDCL_H
+
+#include "ezsat.h"
+
+// The solver engine itself is private to ezcdcl.cc
+struct ezCDCLSolver;
+
+// A built-in incremental CDCL solver backend. In addition to the classic
+// MiniSat techniques (two watched literals, VSIDS, phase saving, 1UIP
+// learning with recursive minimization) it uses chronological backtracking
+// for long backjumps, LBD-driven (glucose style) restarts, a three-tier
+// learnt clause database and periodic vivification of learnt clauses.
+class ezCDCL : public ezSAT
+{
+private:
+	ezCDCLSolver *cdclSolver;
+	std::vector<int> cdclVars;
+	bool foundContradiction;
+
+public:
+	ezCDCL();
+	virtual ~ezCDCL();
+	virtual void clear();
+	virtual bool solver(const std::vector<int> &modelExpressions, std::vector<bool> &modelValues, const std::vector<int> &assumptions);
+
+	struct Stats {
+		int64_t conflicts, decisions, propagations, restarts;
+		int64_t chrono_backtracks, reductions, vivified_clauses, vivified_literals;
+	};
+	Stats stats() const;
+};
+
+#endif
@@ -30,6 +30,7 @@
 #include <limits.h>
 #include <stdint.h>
 #include <cinttypes>
+#include <chrono>
 
 #if !defined(_WIN32) && !defined(__wasm)
 #  include <csignal>
@@ -129,6 +130,11 @@ contradiction:
 	if (minisatSolver == NULL) {
 		minisatSolver = new Solver;
 		minisatSolver->verbosity = EZMINISAT_VERBOSITY;
+		if (solverSeed != 0) {
+			minisatSolver->random_seed = solverSeed;
+			minisatSolver->rnd_init_act = true;
+			minisatSolver->random_var_freq = 0.01;
+		}
 	}
 
 #if EZMINISAT_INCREMENTAL
@@ -189,7 +195,7 @@ contradiction:
 	struct sigaction old_sig_action;
 	int old_alarm_timeout = 0;
 
-	if (solverTimeout > 0) {
+	if (solverTimeout > 0 && solverInterrupt == nullptr) {
 		sig_action.sa_handler = alarmHandler;
 		sigemptyset(&sig_action.sa_mask);
 		sig_action.sa_flags = SA_RESTART;
@@ -201,10 +207,32 @@ contradiction:
 	}
 #endif
 
-	bool foundSolution = minisatSolver->solve(assumps);
+	bool foundSolution;
+
+	if (solverInterrupt != nullptr) {
+		// Solve in slices of a bounded number of conflicts and poll the
+		// interrupt flag (and the wall clock deadline) in between. This
+		// does not need SIGALRM and is therefore safe to use from threads.
+		using namespace Minisat;
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(solverTimeout);
+		lbool ret;
+		while (true) {
+			minisatSolver->setConfBudget(10000);
+			ret = minisatSolver->solveLimited(assumps);
+			if (ret != l_Undef)
+				break;
+			if (solverInterrupt->load() || (solverTimeout > 0 && std::chrono::steady_clock::now() > deadline)) {
+				solverTimoutStatus = true;
+				break;
+			}
+		}
+		minisatSolver->budgetOff();
+		foundSolution = ret == l_True;
+	} else
+		foundSolution = minisatSolver->solve(assumps);
 
 #if defined(HAS_ALARM)
-	if (solverTimeout > 0) {
+	if (solverTimeout > 0 && solverInterrupt == nullptr) {
 		if (alarmHandlerTimeout == 0)
 			solverTimoutStatus = true;
 		alarm(0);
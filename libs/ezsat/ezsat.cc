@@ -55,6 +55,8 @@ ezSAT::ezSAT()
 
 	solverTimeout = 0;
 	solverTimoutStatus = false;
+	solverInterrupt = nullptr;
+	solverSeed = 0;
 
 	literal("CONST_TRUE");
 	literal("CONST_FALSE");
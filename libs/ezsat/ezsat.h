@@ -20,6 +20,7 @@
 #ifndef EZSAT_H
 #define EZSAT_H
 
+#include <atomic>
 #include <map>
 #include <set>
 #include <stdint.h>
@@ -78,6 +79,14 @@ class ezSAT
 	int solverTimeout;
 	bool solverTimoutStatus;
 
+	// Optional flag that is polled by the solver backends. When another thread
+	// sets it, a running solve() returns false with the timeout status set.
+	const std::atomic<bool> *solverInterrupt;
+
+	// Seed for a randomized solver configuration (0 = default configuration).
+	// Backends that do not support this ignore it.
+	uint32_t solverSeed;
+
 	ezSAT();
 	virtual ~ezSAT();
 
@@ -167,6 +176,10 @@ class ezSAT
 
 	bool getSolverTimoutStatus() { return solverTimoutStatus; }
 
+	void setSolverInterrupt(const std::atomic<bool> *flag) { solverInterrupt = flag; }
+
+	void setSolverSeed(uint32_t seed) { solverSeed = seed; }
+
 	// manage CNF (usually only accessed by SAT solvers)
 
 	virtual void clear();
@@ -19,6 +19,7 @@
 
 #include "kernel/yosys.h"
 #include "backends/rtlil/rtlil_backend.h"
+#include "kernel/threading.h"
 
 #if defined(_WIN32)
 #  include <csignal>
@@ -38,6 +39,12 @@ PRIVATE_NAMESPACE_BEGIN
 
 struct BugpointPass : public Pass {
 	BugpointPass() : Pass("bugpoint", "minimize testcases") { }
+
+	// Suppresses the messages of the individual removals of a chunk
+	bool quiet_steps = false;
+	// Hashes of the testcases known not to crash
+	pool<size_t> tested_cases;
+
 	void help() override
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -87,6 +94,12 @@ struct BugpointPass : public Pass {
 		log("        add suffix to generated file names. useful when running more than one\n");
 		log("        instance of bugpoint in the same directory. limited to 8 characters.\n");
 		log("\n");
+		log("    -j <N>\n");
+		log("        check up to N testcases concurrently, limited by the number of cores.\n");
+		log("        in this mode, chunks of parts are removed at once: starting with half\n");
+		log("        of the candidates, the chunk size is halved whenever no chunk can be\n");
+		log("        removed. the testcases are written to 'bugpoint-case.<n>.il' files.\n");
+		log("\n");
 		log("It is possible to constrain which parts of the design will be considered for\n");
 		log("removal. Unless one or more of the following options are specified, all parts\n");
 		log("will be considered.\n");
@@ -120,21 +133,45 @@ struct BugpointPass : public Pass {
 		log("        try to remove wires. wires with a (* bugpoint_keep *) attribute will be\n");
 		log("        skipped.\n");
 		log("\n");
+		log("Testcases that did not crash are remembered by a hash of their contents and\n");
+		log("are not checked again.\n");
+		log("\n");
 	}
 
-	int run_yosys(RTLIL::Design *design, string runner, string yosys_cmd, string yosys_arg, string suffix, bool catch_err)
+	// Base name of the files of a testcase, `slot` distinguishes the
+	// testcases that are checked concurrently
+	string case_file(string suffix, int slot = -1)
 	{
 		string bugpoint_file = "bugpoint-case";
 		if (suffix.size())
 			bugpoint_file += stringf(".%.8s", suffix);
+		if (slot >= 0)
+			bugpoint_file += stringf(".%d", slot);
+		return bugpoint_file;
+	}
+
+	// Writes the testcase and returns a hash of its contents
+	size_t write_case(RTLIL::Design *design, string bugpoint_file)
+	{
+		std::ostringstream buf;
+		RTLIL_BACKEND::dump_design(buf, design, /*only_selected=*/false, /*flag_m=*/true, /*flag_n=*/false);
+		std::string text = buf.str();
 
 		std::ofstream f(bugpoint_file + ".il");
-		RTLIL_BACKEND::dump_design(f, design, /*only_selected=*/false, /*flag_m=*/true, /*flag_n=*/false);
+		f << text;
 		f.close();
+		return std::hash<std::string>()(text);
+	}
 
+	string case_command(string runner, string yosys_cmd, string yosys_arg, string bugpoint_file, bool catch_err)
+	{
 		string yosys_cmdline = stringf("%s %s -qq -L %s.log %s %s.il", runner, yosys_cmd, bugpoint_file, yosys_arg, bugpoint_file);
 		if (catch_err) yosys_cmdline += stringf(" 2>%s.err", bugpoint_file);
-		auto status = run_command(yosys_cmdline);
+		return yosys_cmdline;
+	}
+
+	static int exit_code(int status)
+	{
 		// we're not processing lines, which means we're getting raw system() returns
 		if(WIFEXITED(status))
 			return WEXITSTATUS(status);
@@ -146,7 +183,14 @@ struct BugpointPass : public Pass {
 			return 0;
 	}
 
-	bool check_logfile(string grep, string suffix, bool err=false)
+	int run_yosys(RTLIL::Design *design, string runner, string yosys_cmd, string yosys_arg, string suffix, bool catch_err)
+	{
+		string bugpoint_file = case_file(suffix);
+		write_case(design, bugpoint_file);
+		return exit_code(run_command(case_command(runner, yosys_cmd, yosys_arg, bugpoint_file, catch_err)));
+	}
+
+	bool check_logfile(string grep, string suffix, bool err=false, int slot=-1)
 	{
 		if (grep.empty())
 			return true;
@@ -154,9 +198,7 @@ struct BugpointPass : public Pass {
 		if (grep.size() > 2 && grep.front() == '"' && grep.back() == '"')
 			grep = grep.substr(1, grep.size() - 2);
 
-		string bugpoint_file = "bugpoint-case";
-		if (suffix.size())
-			bugpoint_file += stringf(".%.8s", suffix);
+		string bugpoint_file = case_file(suffix, slot);
 		bugpoint_file += err ? ".err" : ".log";
 
 		std::ifstream f(bugpoint_file);
@@ -171,9 +213,9 @@ struct BugpointPass : public Pass {
 		return false;
 	}
 
-	bool check_logfiles(string grep, string err_grep, string suffix)
+	bool check_logfiles(string grep, string err_grep, string suffix, int slot=-1)
 	{
-		return check_logfile(grep, suffix) && check_logfile(err_grep, suffix, true);
+		return check_logfile(grep, suffix, false, slot) && check_logfile(err_grep, suffix, true, slot);
 	}
 
 	RTLIL::Design *clean_design(RTLIL::Design *design, bool do_clean = true, bool do_delete = false)
@@ -197,7 +239,32 @@ struct BugpointPass : public Pass {
 		RTLIL::Design *design_copy = new RTLIL::Design;
 		for (auto module : design->modules())
 			design_copy->add(module->clone());
+		if (remove_something(design_copy, seed, stage2, modules, ports, cells, connections, processes, assigns, updates, wires))
+			return design_copy;
+		delete design_copy;
+		return nullptr;
+	}
+
+	// Number of parts of the design that are considered for removal
+	int count_candidates(RTLIL::Design *design, bool stage2, bool modules, bool ports, bool cells, bool connections, bool processes, bool assigns, bool updates, bool wires)
+	{
+		int count = 0;
+		bool removed = remove_something(design, -1, stage2, modules, ports, cells, connections, processes, assigns, updates, wires, &count);
+		log_assert(!removed);
+		return count;
+	}
 
+	template <typename... Args>
+	void log_step(RTLIL::Design *design, FmtString<TypeIdentity<Args>...> fmt, const Args &... args)
+	{
+		if (!quiet_steps)
+			log_header(design, fmt, args...);
+	}
+
+	// Removes the part with index `seed` from the design. Returns false and
+	// sets `count` to the number of candidates if there is no such part.
+	bool remove_something(RTLIL::Design *design_copy, int seed, bool stage2, bool modules, bool ports, bool cells, bool connections, bool processes, bool assigns, bool updates, bool wires, int *count = nullptr)
+	{
 		int index = 0;
 		if (modules)
 		{
@@ -212,14 +279,14 @@ struct BugpointPass : public Pass {
 
 				if (index++ == seed)
 				{
-					log_header(design, "Trying to remove module %s.\n", log_id(module));
+					log_step(design_copy, "Trying to remove module %s.\n", log_id(module));
 					removed_module = module;
 					break;
 				}
 			}
 			if (removed_module) {
 				design_copy->remove(removed_module);
-				return design_copy;
+				return true;
 			}
 		}
 		if (ports)
@@ -242,10 +309,10 @@ struct BugpointPass : public Pass {
 
 					if (index++ == seed)
 					{
-						log_header(design, "Trying to remove module port %s.\n", log_id(wire));
+						log_step(design_copy, "Trying to remove module port %s.\n", log_id(wire));
 						wire->port_input = wire->port_output = false;
 						mod->fixup_ports();
-						return design_copy;
+						return true;
 					}
 				}
 			}
@@ -265,14 +332,14 @@ struct BugpointPass : public Pass {
 
 					if (index++ == seed)
 					{
-						log_header(design, "Trying to remove cell %s.%s.\n", log_id(mod), log_id(cell));
+						log_step(design_copy, "Trying to remove cell %s.%s.\n", log_id(mod), log_id(cell));
 						removed_cell = cell;
 						break;
 					}
 				}
 				if (removed_cell) {
 					mod->remove(removed_cell);
-					return design_copy;
+					return true;
 				}
 			}
 		}
@@ -296,16 +363,16 @@ struct BugpointPass : public Pass {
 
 						if (index++ == seed)
 						{
-							log_header(design, "Trying to remove cell port %s.%s.%s.\n", log_id(mod), log_id(cell), log_id(it.first));
+							log_step(design_copy, "Trying to remove cell port %s.%s.%s.\n", log_id(mod), log_id(cell), log_id(it.first));
 							RTLIL::SigSpec port_x(State::Sx, port.size());
 							cell->unsetPort(it.first);
 							cell->setPort(it.first, port_x);
-							return design_copy;
+							return true;
 						}
 
 						if (!stage2 && (cell->input(it.first) || cell->output(it.first)) && index++ == seed)
 						{
-							log_header(design, "Trying to expose cell port %s.%s.%s as module port.\n", log_id(mod), log_id(cell), log_id(it.first));
+							log_step(design_copy, "Trying to expose cell port %s.%s.%s as module port.\n", log_id(mod), log_id(cell), log_id(it.first));
 							RTLIL::Wire *wire = mod->addWire(NEW_ID, port.size());
 							wire->set_bool_attribute(ID($bugpoint));
 							wire->port_input = cell->input(it.first);
@@ -313,7 +380,7 @@ struct BugpointPass : public Pass {
 							cell->unsetPort(it.first);
 							cell->setPort(it.first, wire);
 							mod->fixup_ports();
-							return design_copy;
+							return true;
 						}
 					}
 				}
@@ -334,14 +401,14 @@ struct BugpointPass : public Pass {
 
 					if (index++ == seed)
 					{
-						log_header(design, "Trying to remove process %s.%s.\n", log_id(mod), log_id(process.first));
+						log_step(design_copy, "Trying to remove process %s.%s.\n", log_id(mod), log_id(process.first));
 						removed_process = process.second;
 						break;
 					}
 				}
 				if (removed_process) {
 					mod->remove(removed_process);
-					return design_copy;
+					return true;
 				}
 			}
 		}
@@ -363,9 +430,9 @@ struct BugpointPass : public Pass {
 						{
 							if (index++ == seed)
 							{
-								log_header(design, "Trying to remove assign %s %s in %s.%s.\n", log_signal(it->first), log_signal(it->second), log_id(mod), log_id(pr.first));
+								log_step(design_copy, "Trying to remove assign %s %s in %s.%s.\n", log_signal(it->first), log_signal(it->second), log_id(mod), log_id(pr.first));
 								cs->actions.erase(it);
-								return design_copy;
+								return true;
 							}
 						}
 						for (auto &sw : cs->switches)
@@ -389,9 +456,9 @@ struct BugpointPass : public Pass {
 						{
 							if (index++ == seed)
 							{
-								log_header(design, "Trying to remove sync %s update %s %s in %s.%s.\n", log_signal(sy->signal), log_signal(it->first), log_signal(it->second), log_id(mod), log_id(pr.first));
+								log_step(design_copy, "Trying to remove sync %s update %s %s in %s.%s.\n", log_signal(sy->signal), log_signal(it->first), log_signal(it->second), log_id(mod), log_id(pr.first));
 								sy->actions.erase(it);
-								return design_copy;
+								return true;
 							}
 						}
 						int i = 0;
@@ -399,7 +466,7 @@ struct BugpointPass : public Pass {
 						{
 							if (index++ == seed)
 							{
-								log_header(design, "Trying to remove sync %s memwr %s %s %s %s in %s.%s.\n", log_signal(sy->signal), log_id(it->memid), log_signal(it->address), log_signal(it->data), log_signal(it->enable), log_id(mod), log_id(pr.first));
+								log_step(design_copy, "Trying to remove sync %s memwr %s %s %s %s in %s.%s.\n", log_signal(sy->signal), log_id(it->memid), log_signal(it->address), log_signal(it->data), log_signal(it->enable), log_id(mod), log_id(pr.first));
 								sy->mem_write_actions.erase(it);
 								// Remove the bit for removed action from other actions' priority masks.
 								for (auto it2 = sy->mem_write_actions.begin(); it2 != sy->mem_write_actions.end(); ++it2) {
@@ -412,7 +479,7 @@ struct BugpointPass : public Pass {
 										mask = new_mask_builder.build();
 									}
 								}
-								return design_copy;
+								return true;
 							}
 						}
 					}
@@ -437,19 +504,20 @@ struct BugpointPass : public Pass {
 
 					if (index++ == seed)
 					{
-						log_header(design, "Trying to remove wire %s.%s.\n", log_id(mod), log_id(wire));
+						log_step(design_copy, "Trying to remove wire %s.%s.\n", log_id(mod), log_id(wire));
 						removed_wire = wire;
 						break;
 					}
 				}
 				if (removed_wire) {
 					mod->remove({removed_wire});
-					return design_copy;
+					return true;
 				}
 			}
 		}
-		delete design_copy;
-		return nullptr;
+		if (count != nullptr)
+			*count = index;
+		return false;
 	}
 
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
@@ -457,6 +525,7 @@ struct BugpointPass : public Pass {
 		string yosys_cmd = "yosys", yosys_arg, grep, err_grep, runner, suffix;
 		bool flag_expect_return = false, has_check = false, check_err = false;
 		int expect_return_value = 0;
+		int jobs = 1;
 		bool fast = false, clean = false;
 		bool modules = false, ports = false, cells = false, connections = false, processes = false, assigns = false, updates = false, wires = false, has_part = false;
 
@@ -502,6 +571,10 @@ struct BugpointPass : public Pass {
 				expect_return_value = atoi(args[argidx].c_str());
 				continue;
 			}
+			if (args[argidx] == "-j" && argidx + 1 < args.size()) {
+				jobs = std::max(1, atoi(args[++argidx].c_str()));
+				continue;
+			}
 			if (args[argidx] == "-fast") {
 				fast = true;
 				continue;
@@ -602,72 +675,214 @@ struct BugpointPass : public Pass {
 		if (!check_logfile(err_grep, suffix, true))
 			log_cmd_error("The provided grep string is not found in stderr log!\n");
 
+		tested_cases.clear();
 		int seed = 0;
 		bool found_something = false, stage2 = false;
-		while (true)
+		if (jobs > 1)
 		{
-			if (RTLIL::Design *simplified = simplify_something(crashing_design, seed, stage2, modules, ports, cells, connections, processes, assigns, updates, wires))
+			struct Candidate {
+				int seed;
+				RTLIL::Design *design;
+				size_t hash;
+				int retval = 0;
+			};
+
+			int chunk = 0;
+			// Whether a chunk was removed in the current sweep over the candidates
+			bool sweep_removed = false;
+			while (true)
 			{
-				simplified = clean_design(simplified, fast, /*do_delete=*/true);
+				int count = count_candidates(crashing_design, stage2, modules, ports, cells, connections, processes, assigns, updates, wires);
+				if (chunk == 0)
+					chunk = std::max(1, count / 2);
 
-				if (clean)
+				if (seed >= count)
 				{
-					RTLIL::Design *testcase = clean_design(simplified);
-					retval = run_yosys(testcase, runner, yosys_cmd, yosys_arg, suffix, check_err);
-					delete testcase;
+					seed = 0;
+					if (chunk > 1) {
+						// Keep the chunk size while chunks of it can still be removed
+						if (!sweep_removed) {
+							chunk /= 2;
+							log("Reducing chunk size to %d.\n", chunk);
+						}
+						sweep_removed = false;
+						continue;
+					}
+					if (found_something)
+						found_something = false;
+					else
+					{
+						if (!stage2)
+						{
+							log("Demoting introduced module ports.\n");
+							stage2 = true;
+							chunk = 0;
+							sweep_removed = false;
+						}
+						else
+						{
+							log("Simplifications exhausted.\n");
+							break;
+						}
+					}
+					continue;
 				}
-				else
+
+				// Testcases removing consecutive chunks of candidates, checked concurrently
+				std::vector<Candidate> batch;
+				int next_seed = seed;
+				while (GetSize(batch) < jobs && next_seed < count)
 				{
-					retval = run_yosys(simplified, runner, yosys_cmd, yosys_arg, suffix, check_err);
+					Candidate candidate;
+					candidate.seed = next_seed;
+					candidate.design = new RTLIL::Design;
+					for (auto module : crashing_design->modules())
+						candidate.design->add(module->clone());
+					next_seed += chunk;
+
+					if (chunk > 1)
+						log_header(crashing_design, "Trying to remove %d parts starting at part %d.\n", std::min(chunk, count - candidate.seed), candidate.seed);
+					quiet_steps = chunk > 1;
+					for (int i = 0; i < chunk; i++)
+						if (!remove_something(candidate.design, candidate.seed, stage2, modules, ports, cells, connections, processes, assigns, updates, wires))
+							break;
+					quiet_steps = false;
+					candidate.design = clean_design(candidate.design, fast, /*do_delete=*/true);
+
+					RTLIL::Design *testcase = clean_design(candidate.design, clean);
+					candidate.hash = write_case(testcase, case_file(suffix, GetSize(batch)));
+					if (testcase != candidate.design)
+						delete testcase;
+
+					bool duplicate = tested_cases.count(candidate.hash) != 0;
+					for (auto &other : batch)
+						duplicate |= other.hash == candidate.hash;
+					if (duplicate) {
+						log("Testcase was already tested.\n");
+						delete candidate.design;
+						continue;
+					}
+					batch.push_back(candidate);
 				}
 
-				bool crashes = false;
-				if (flag_expect_return && retval == expect_return_value && check_logfiles(grep, err_grep, suffix))
+				ConcurrentQueue<int> queue;
+				for (int i = 0; i < GetSize(batch); i++)
+					queue.push_back(i);
+				queue.close();
+				auto run_candidates = [&](int) {
+					while (std::optional<int> i = queue.pop_front())
+						batch[*i].retval = exit_code(run_command(case_command(runner, yosys_cmd, yosys_arg, case_file(suffix, *i), check_err)));
+				};
 				{
-					log("Testcase matches expected crash.\n");
-					crashes = true;
+					ThreadPool thread_pool(ThreadPool::pool_size(1, GetSize(batch) - 1), run_candidates);
+					run_candidates(-1);
 				}
-				else if (!flag_expect_return && retval == 0)
-					log("Testcase does not crash.\n");
-				else if (!flag_expect_return && check_logfiles(grep, err_grep, suffix))
-				{
-					log("Testcase crashes.\n");
-					crashes = true;
+
+				// Of the crashing testcases, the one removing the earliest chunk is kept
+				int found = -1;
+				for (int i = 0; i < GetSize(batch); i++) {
+					int retval = batch[i].retval;
+					bool crashes = flag_expect_return ? retval == expect_return_value : retval != 0;
+					if (crashes && check_logfiles(grep, err_grep, suffix, i)) {
+						if (found < 0)
+							found = i;
+					} else
+						tested_cases.insert(batch[i].hash);
 				}
-				else
-					// flag_expect_return && !(retval == expect_return_value && check_logfiles(grep, err_grep, suffix))
-					// !flag_expect_return && !(retval == 0 && check_logfiles(grep, err_grep, suffix))
-					log("Testcase does not match expected crash.\n");
 
-				if (crashes)
+				if (found >= 0)
 				{
+					log("Testcase crashes after removing part %d%s.\n", batch[found].seed, chunk > 1 ? " and following" : "");
 					if (crashing_design != design)
 						delete crashing_design;
-					crashing_design = simplified;
+					crashing_design = batch[found].design;
+					seed = batch[found].seed;
 					found_something = true;
+					sweep_removed = true;
 				}
 				else
 				{
-					delete simplified;
-					seed++;
+					if (!batch.empty())
+						log("None of the %d testcases crashes.\n", GetSize(batch));
+					seed = next_seed;
 				}
+				for (int i = 0; i < GetSize(batch); i++)
+					if (i != found)
+						delete batch[i].design;
 			}
-			else
+		}
+		else
+		{
+			while (true)
 			{
-				seed = 0;
-				if (found_something)
-					found_something = false;
-				else
+				if (RTLIL::Design *simplified = simplify_something(crashing_design, seed, stage2, modules, ports, cells, connections, processes, assigns, updates, wires))
 				{
-					if (!stage2)
+					simplified = clean_design(simplified, fast, /*do_delete=*/true);
+
+					RTLIL::Design *testcase = clean_design(simplified, clean);
+					string bugpoint_file = case_file(suffix);
+					size_t hash = write_case(testcase, bugpoint_file);
+					if (testcase != simplified)
+						delete testcase;
+
+					bool crashes = false;
+					if (tested_cases.count(hash))
+						log("Testcase was already tested.\n");
+					else
 					{
-						log("Demoting introduced module ports.\n");
-						stage2 = true;
+						retval = exit_code(run_command(case_command(runner, yosys_cmd, yosys_arg, bugpoint_file, check_err)));
+
+						if (flag_expect_return && retval == expect_return_value && check_logfiles(grep, err_grep, suffix))
+						{
+							log("Testcase matches expected crash.\n");
+							crashes = true;
+						}
+						else if (!flag_expect_return && retval == 0)
+							log("Testcase does not crash.\n");
+						else if (!flag_expect_return && check_logfiles(grep, err_grep, suffix))
+						{
+							log("Testcase crashes.\n");
+							crashes = true;
+						}
+						else
+							// flag_expect_return && !(retval == expect_return_value && check_logfiles(grep, err_grep, suffix))
+							// !flag_expect_return && !(retval == 0 && check_logfiles(grep, err_grep, suffix))
+							log("Testcase does not match expected crash.\n");
+
+						if (!crashes)
+							tested_cases.insert(hash);
+					}
+
+					if (crashes)
+					{
+						if (crashing_design != design)
+							delete crashing_design;
+						crashing_design = simplified;
+						found_something = true;
 					}
 					else
 					{
-						log("Simplifications exhausted.\n");
-						break;
+						delete simplified;
+						seed++;
+					}
+				}
+				else
+				{
+					seed = 0;
+					if (found_something)
+						found_something = false;
+					else
+					{
+						if (!stage2)
+						{
+							log("Demoting introduced module ports.\n");
+							stage2 = true;
+						}
+						else
+						{
+							log("Simplifications exhausted.\n");
+							break;
+						}
 					}
 				}
 			}
@@ -21,12 +21,588 @@
 #include "kernel/sigtools.h"
 #include "kernel/celledges.h"
 #include "kernel/celltypes.h"
-#include "kernel/utils.h"
+#include "kernel/topo_scc.h"
+#include "kernel/threading.h"
 #include "kernel/log_help.h"
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
+// Checks of a single module. The module is only read, so that modules can be
+// checked in parallel; the diagnostics are collected in `warnings` and logged
+// by the caller. Bits are kept in a dense index, the messages for drivers are
+// only built for bits with a problem.
+struct CheckWorker
+{
+	struct Options {
+		bool noinit = false;
+		bool initdrv = false;
+		bool mapped = false;
+		bool allow_tbuf = false;
+		bool force_detailed_loop_check = false;
+	};
+
+	struct Driver {
+		enum Kind { CELL_PORT, CASE_ACTION, SYNC_ACTION, MODULE_INPUT };
+		Kind kind;
+		int bit;
+		// Bit of the cell port or module input
+		int offset;
+		RTLIL::Cell *cell;
+		RTLIL::Wire *wire;
+		// Port name or process name
+		RTLIL::IdString name;
+		const RTLIL::SigSig *action;
+	};
+
+	// Port wires of the modules of the design, by module name. The lookups
+	// through the design are not thread-safe, so this is filled before the
+	// workers are started and replaces Cell::input() and Cell::output().
+	typedef dict<RTLIL::IdString, dict<RTLIL::IdString, const RTLIL::Wire*>> ModulePorts;
+
+	RTLIL::Module *module;
+	const Options &opt;
+	const ModulePorts &module_ports;
+	SigMap sigmap;
+
+	// Per bit data, indexed like `bits`
+	dict<RTLIL::SigBit, int> bit_index;
+	std::vector<RTLIL::SigBit> bits;
+	std::vector<int> driver_count;
+	std::vector<RTLIL::Cell*> driver_cell;
+	std::vector<bool> used;
+	std::vector<int> used_order;
+
+	std::vector<Driver> drivers;
+	std::vector<int> driver_start, bit_drivers;
+
+	// Edges of the loop graph, negative nodes ~k are the helper nodes of
+	// `helper_cells[k]`, cells for which all input-output pairs are connected
+	std::vector<std::pair<int, int>> loop_edges;
+	std::vector<RTLIL::Cell*> helper_cells;
+	pool<RTLIL::Cell*> coarsened_cells;
+
+	std::vector<std::string> warnings;
+	bool suggest_detail = false;
+
+	CheckWorker(RTLIL::Module *module, const Options &opt, const ModulePorts &module_ports) :
+			module(module), opt(opt), module_ports(module_ports) {}
+
+	static ModulePorts collect_module_ports(RTLIL::Design *design)
+	{
+		ModulePorts result;
+		for (auto mod : design->modules()) {
+			auto &ports = result[mod->name];
+			for (auto port : mod->ports)
+				ports[port] = mod->wire(port);
+		}
+		return result;
+	}
+
+	const RTLIL::Wire *port_wire(RTLIL::Cell *cell, RTLIL::IdString port) const
+	{
+		auto it = module_ports.find(cell->type);
+		if (it == module_ports.end())
+			return nullptr;
+		auto port_it = it->second.find(port);
+		return port_it != it->second.end() ? port_it->second : nullptr;
+	}
+
+	bool cell_input(RTLIL::Cell *cell, RTLIL::IdString port) const
+	{
+		if (yosys_celltypes.cell_known(cell->type))
+			return yosys_celltypes.cell_input(cell->type, port);
+		const RTLIL::Wire *w = port_wire(cell, port);
+		return w && w->port_input;
+	}
+
+	bool cell_output(RTLIL::Cell *cell, RTLIL::IdString port) const
+	{
+		if (yosys_celltypes.cell_known(cell->type))
+			return yosys_celltypes.cell_output(cell->type, port);
+		const RTLIL::Wire *w = port_wire(cell, port);
+		return w && w->port_output;
+	}
+
+	int bit(RTLIL::SigBit b)
+	{
+		auto it = bit_index.find(b);
+		if (it != bit_index.end())
+			return it->second;
+		int idx = GetSize(bits);
+		bit_index.emplace(b, idx);
+		bits.push_back(b);
+		driver_count.push_back(0);
+		driver_cell.push_back(nullptr);
+		used.push_back(false);
+		return idx;
+	}
+
+	void use(RTLIL::SigBit b)
+	{
+		if (!b.wire)
+			return;
+		int idx = bit(b);
+		if (!used[idx]) {
+			used[idx] = true;
+			used_order.push_back(idx);
+		}
+	}
+
+	void add_driver(Driver::Kind kind, RTLIL::SigBit b, int offset, RTLIL::Cell *cell, RTLIL::Wire *wire, RTLIL::IdString name,
+			const RTLIL::SigSig *action)
+	{
+		drivers.push_back({kind, bit(b), offset, cell, wire, name, action});
+	}
+
+	std::string describe(const Driver &d) const
+	{
+		switch (d.kind) {
+		case Driver::CASE_ACTION:
+		case Driver::SYNC_ACTION:
+			return stringf("action %s <= %s (%s rule) in process %s", log_signal(d.action->first), log_signal(d.action->second),
+					d.kind == Driver::CASE_ACTION ? "case" : "sync", RTLIL::unescape_id(d.name));
+		case Driver::CELL_PORT:
+			return stringf("port %s[%d] of cell %s (%s)", RTLIL::unescape_id(d.name), d.offset,
+					RTLIL::unescape_id(d.cell->name), RTLIL::unescape_id(d.cell->type));
+		case Driver::MODULE_INPUT:
+			return stringf("module input %s[%d]", RTLIL::unescape_id(d.wire->name), d.offset);
+		}
+		log_abort();
+	}
+
+	void warning(std::string message)
+	{
+		warnings.push_back(std::move(message));
+	}
+
+	struct CircuitEdgesDatabase : AbstractCellEdgesDatabase {
+		CheckWorker &worker;
+		bool force_detail;
+
+		CircuitEdgesDatabase(CheckWorker &worker, bool force_detail) : worker(worker), force_detail(force_detail) {}
+
+		void add_edge(RTLIL::Cell *cell, RTLIL::IdString from_port, int from_bit,
+					  RTLIL::IdString to_port, int to_bit, int) override {
+			const SigSpec &from_portsig = cell->getPort(from_port);
+			const SigSpec &to_portsig = cell->getPort(to_port);
+			log_assert(from_bit >= 0 && from_bit < from_portsig.size());
+			log_assert(to_bit >= 0 && to_bit < to_portsig.size());
+			SigBit from = worker.sigmap(from_portsig[from_bit]);
+			SigBit to = worker.sigmap(to_portsig[to_bit]);
+
+			if (from.wire && to.wire)
+				worker.loop_edges.emplace_back(worker.bit(from), worker.bit(to));
+		}
+
+		bool detail_costly(Cell *cell) {
+			// Only those cell types for which the edge data can expode quadratically
+			// in port widths are those for us to check.
+			if (!cell->type.in(
+					ID($add), ID($sub),
+					ID($shl), ID($shr), ID($sshl), ID($sshr), ID($shift), ID($shiftx),
+					ID($pmux), ID($bmux)))
+				return false;
+
+			int in_widths = 0, out_widths = 0;
+
+			if (cell->type.in(ID($pmux), ID($bmux))) {
+				// We're skipping inputs A and B, since each of their bits contributes only one edge
+				in_widths = GetSize(cell->getPort(ID::S));
+				out_widths = GetSize(cell->getPort(ID::Y));
+			} else {
+				for (auto &conn : cell->connections()) {
+					if (worker.cell_input(cell, conn.first))
+						in_widths += conn.second.size();
+					if (worker.cell_output(cell, conn.first))
+						out_widths += conn.second.size();
+				}
+			}
+
+			const int threshold = 1024;
+
+			// if the multiplication may overflow we will catch it here 
+			if (in_widths + out_widths >= threshold)
+				return true;
+
+			if (in_widths * out_widths >= threshold)
+				return true;
+
+			return false;
+		}
+
+		bool add_edges_from_cell(Cell *cell) {
+			if (force_detail || !detail_costly(cell)) {
+				if (AbstractCellEdgesDatabase::add_edges_from_cell(cell))
+					return true;
+			}
+
+			// We don't have accurate cell edges, do the fallback of all input-output pairs
+			int helper = ~GetSize(worker.helper_cells);
+			worker.helper_cells.push_back(cell);
+			for (auto &conn : cell->connections()) {
+				if (worker.cell_input(cell, conn.first))
+				for (auto bit : worker.sigmap(conn.second))
+				if (bit.wire)
+					worker.loop_edges.emplace_back(worker.bit(bit), helper);
+
+				if (worker.cell_output(cell, conn.first))
+				for (auto bit : worker.sigmap(conn.second))
+				if (bit.wire)
+					worker.loop_edges.emplace_back(helper, worker.bit(bit));
+			}
+
+			// Return false to signify the fallback
+			return false;
+		}
+	};
+
+	void collect_processes()
+	{
+		for (auto &proc_it : module->processes)
+		{
+			std::vector<RTLIL::CaseRule*> all_cases = {&proc_it.second->root_case};
+			for (size_t i = 0; i < all_cases.size(); i++) {
+				for (auto &action : all_cases[i]->actions) {
+					for (auto b : sigmap(action.first))
+						add_driver(Driver::CASE_ACTION, b, 0, nullptr, nullptr, proc_it.first, &action);
+					for (auto b : sigmap(action.second))
+						use(b);
+				}
+				for (auto switch_ : all_cases[i]->switches) {
+					for (auto case_ : switch_->cases) {
+						all_cases.push_back(case_);
+						for (auto compare : case_->compare)
+							for (auto b : sigmap(compare))
+								use(b);
+					}
+				}
+			}
+			for (auto &sync : proc_it.second->syncs) {
+				for (auto b : sigmap(sync->signal))
+					use(b);
+				for (auto &action : sync->actions) {
+					for (auto b : sigmap(action.first))
+						add_driver(Driver::SYNC_ACTION, b, 0, nullptr, nullptr, proc_it.first, &action);
+					for (auto b : sigmap(action.second))
+						use(b);
+				}
+				for (auto &memwr : sync->mem_write_actions) {
+					for (auto b : sigmap(memwr.address))
+						use(b);
+					for (auto b : sigmap(memwr.data))
+						use(b);
+					for (auto b : sigmap(memwr.enable))
+						use(b);
+				}
+			}
+		}
+	}
+
+	void collect_cells()
+	{
+		CircuitEdgesDatabase edges_db(*this, opt.force_detailed_loop_check);
+
+		for (auto cell : module->cells())
+		{
+			if (opt.mapped && cell->type.begins_with("$") && !module_ports.count(cell->type)) {
+				if (!opt.allow_tbuf || cell->type != ID($_TBUF_))
+					warning(stringf("Cell %s.%s is an unmapped internal cell of type %s.\n", RTLIL::unescape_id(module->name),
+							RTLIL::unescape_id(cell->name), RTLIL::unescape_id(cell->type)));
+			}
+
+			for (auto &conn : cell->connections()) {
+				bool input = cell_input(cell, conn.first);
+				bool output = cell_output(cell, conn.first);
+
+				SigSpec sig = sigmap(conn.second);
+				for (int i = 0; i < sig.size(); i++) {
+					SigBit b = sig[i];
+
+					if (input && b.wire)
+						use(b);
+					if (output && !input && b.wire)
+						driver_count[bit(b)]++;
+					if (output && (b.wire || !input))
+						add_driver(Driver::CELL_PORT, b, i, cell, nullptr, conn.first, nullptr);
+					if (output)
+						driver_cell[bit(b)] = cell;
+				}
+			}
+
+			if (yosys_celltypes.cell_evaluable(cell->type) || cell->type.in(ID($mem_v2), ID($memrd), ID($memrd_v2)) \
+					|| cell->is_builtin_ff()) {
+				if (!edges_db.add_edges_from_cell(cell))
+					coarsened_cells.insert(cell);
+			}
+		}
+	}
+
+	void collect_wires(pool<SigBit> &init_bits)
+	{
+		for (auto wire : module->wires()) {
+			if (wire->port_input) {
+				SigSpec sig = sigmap(wire);
+				for (int i = 0; i < GetSize(sig); i++)
+					if (sig[i].wire || !wire->port_output)
+						add_driver(Driver::MODULE_INPUT, sig[i], i, nullptr, wire, RTLIL::IdString(), nullptr);
+			}
+			if (wire->port_output)
+				for (auto b : sigmap(wire))
+					use(b);
+			if (wire->port_input && !wire->port_output)
+				for (auto b : sigmap(wire))
+					if (b.wire) driver_count[bit(b)]++;
+			if (wire->attributes.count(ID::init)) {
+				Const initval = wire->attributes.at(ID::init);
+				for (int i = 0; i < GetSize(initval) && i < GetSize(wire); i++)
+					if (initval[i] == State::S0 || initval[i] == State::S1)
+						init_bits.insert(sigmap(SigBit(wire, i)));
+				if (opt.noinit)
+					warning(stringf("Wire %s.%s has an unprocessed 'init' attribute.\n", RTLIL::unescape_id(module->name),
+							RTLIL::unescape_id(wire->name)));
+			}
+		}
+	}
+
+	// Sorts the drivers by bit (CSR), keeping the order of the drivers of each bit
+	void index_drivers()
+	{
+		driver_start.assign(GetSize(bits) + 1, 0);
+		for (auto &d : drivers)
+			driver_start[d.bit + 1]++;
+		for (int i = 0; i < GetSize(bits); i++)
+			driver_start[i + 1] += driver_start[i];
+		std::vector<int> fill(driver_start.begin(), driver_start.end() - 1);
+		bit_drivers.resize(GetSize(drivers));
+		for (int i = 0; i < GetSize(drivers); i++)
+			bit_drivers[fill[drivers[i].bit]++] = i;
+	}
+
+	bool has_drivers(int b) const { return driver_start[b] != driver_start[b + 1]; }
+
+	std::string driver_list(int b) const
+	{
+		std::string message;
+		for (int i = driver_start[b]; i < driver_start[b + 1]; i++)
+			message += stringf("    %s\n", describe(drivers[bit_drivers[i]]));
+		return message;
+	}
+
+	void check_drivers()
+	{
+		for (auto state : {State::S0, State::S1, State::Sx}) {
+			auto it = bit_index.find(state);
+			if (it != bit_index.end() && has_drivers(it->second))
+				warning(stringf("Drivers conflicting with a constant %s driver:\n", log_signal(state)) + driver_list(it->second));
+		}
+
+		// Bits in the order they first got a driver, reported last to first
+		std::vector<int> driven_order;
+		std::vector<bool> seen(GetSize(bits));
+		for (auto &d : drivers)
+			if (!seen[d.bit]) {
+				seen[d.bit] = true;
+				driven_order.push_back(d.bit);
+			}
+		for (int i = GetSize(driven_order) - 1; i >= 0; i--) {
+			int b = driven_order[i];
+			if (driver_count[b] > 1)
+				warning(stringf("multiple conflicting drivers for %s.%s:\n", RTLIL::unescape_id(module->name), log_signal(bits[b])) +
+						driver_list(b));
+		}
+
+		for (int i = GetSize(used_order) - 1; i >= 0; i--) {
+			int b = used_order[i];
+			if (!has_drivers(b))
+				warning(stringf("Wire %s.%s is used but has no driver.\n", RTLIL::unescape_id(module->name), log_signal(bits[b])));
+		}
+	}
+
+	// Finds the strongly connected components of the loop graph and reports
+	// one cycle through each of them
+	void check_loops()
+	{
+		if (loop_edges.empty())
+			return;
+
+		int num_bits = GetSize(bits);
+		auto node = [&](int n) { return n < 0 ? num_bits + ~n : n; };
+		IntGraph graph;
+		for (auto &edge : loop_edges)
+			graph.add_edge(node(edge.first), node(edge.second));
+
+		std::vector<std::vector<int>> components;
+		TopoSortedSccs(graph, [&](int *begin, int *end) {
+			if (end - begin == 1) {
+				bool self_loop = false;
+				for (auto succ = graph.enumerate_successors(*begin); !succ.finished();)
+					if (succ.next() == *begin)
+						self_loop = true;
+				if (!self_loop)
+					return;
+			}
+			components.emplace_back(begin, end);
+		}).process_all();
+
+		int num_nodes = num_bits + GetSize(helper_cells);
+		std::vector<int> component_of(num_nodes, -1), parent(num_nodes, -1);
+		for (int c = 0; c < GetSize(components); c++)
+			for (int n : components[c])
+				component_of[n] = c;
+
+		for (int c = 0; c < GetSize(components); c++)
+		{
+			// Shortest cycle through the first bit of the component
+			int start = -1;
+			for (int n : components[c])
+				if (n < num_bits && (start < 0 || n < start))
+					start = n;
+			log_assert(start >= 0);
+
+			std::vector<int> queue = {start};
+			int last = -1;
+			for (int i = 0; i < GetSize(queue) && last < 0; i++) {
+				for (auto succ = graph.enumerate_successors(queue[i]); !succ.finished();) {
+					int n = succ.next();
+					if (n == start) {
+						last = queue[i];
+						break;
+					}
+					if (component_of[n] == c && parent[n] < 0) {
+						parent[n] = queue[i];
+						queue.push_back(n);
+					}
+				}
+			}
+			log_assert(last >= 0);
+
+			std::vector<int> loop;
+			for (int n = last; n != start; n = parent[n])
+				loop.push_back(n);
+			loop.push_back(start);
+			std::reverse(loop.begin(), loop.end());
+			for (int n : queue)
+				parent[n] = -1;
+
+			report_loop(loop, num_bits);
+		}
+	}
+
+	void report_loop(const std::vector<int> &loop, int num_bits)
+	{
+		string message = stringf("found logic loop in module %s:\n", RTLIL::unescape_id(module->name));
+
+		// `loop` only contains wire bits, or an occasional special helper node for cells for
+		// which we have done the edges fallback. The cell and its ports that led to an edge are
+		// a piece of information we need to recover now. For that we need to have the previous
+		// wire bit of the loop at hand.
+		SigBit prev;
+		for (auto it = loop.rbegin(); it != loop.rend(); it++)
+		if (*it < num_bits) { // skip the fallback helper nodes
+			prev = bits[*it];
+			break;
+		}
+		log_assert(prev != SigBit());
+
+		for (int n : loop) {
+			if (n >= num_bits)
+				continue; // helper node for edges fallback, we can ignore it
+
+			struct MatchingEdgePrinter : AbstractCellEdgesDatabase {
+				std::string &message;
+				SigMap &sigmap;
+				SigBit from, to;
+				int nhits;
+				const int HITS_LIMIT = 3;
+
+				MatchingEdgePrinter(std::string &message, SigMap &sigmap, SigBit from, SigBit to)
+					: message(message), sigmap(sigmap), from(from), to(to), nhits(0) {}
+
+				void add_edge(RTLIL::Cell *cell, RTLIL::IdString from_port, int from_bit,
+							  RTLIL::IdString to_port, int to_bit, int) override {
+					SigBit edge_from = sigmap(cell->getPort(from_port))[from_bit];
+					SigBit edge_to = sigmap(cell->getPort(to_port))[to_bit];
+
+					if (edge_from == from && edge_to == to && nhits++ < HITS_LIMIT)
+						message += stringf("      %s[%d] --> %s[%d]\n", RTLIL::unescape_id(from_port), from_bit,
+										   RTLIL::unescape_id(to_port), to_bit);
+					if (nhits == HITS_LIMIT)
+						message += "      ...\n";
+				}
+			};
+
+			SigBit bit = bits[n];
+			Cell *driver = driver_cell[n];
+			log_assert(driver);
+
+			std::string driver_src;
+			if (driver->has_attribute(ID::src)) {
+				std::string src_attr = driver->get_src_attribute();
+				driver_src = stringf(" source: %s", src_attr);
+			}
+
+			message += stringf("    cell %s (%s)%s\n", RTLIL::unescape_id(driver->name), RTLIL::unescape_id(driver->type), driver_src);
+
+			if (!coarsened_cells.count(driver)) {
+				MatchingEdgePrinter printer(message, sigmap, prev, bit);
+				printer.add_edges_from_cell(driver);
+			} else {
+				message += "      (cell's internal connectivity overapproximated; loop may be a false positive)\n";
+				suggest_detail = true;
+			}
+
+			Wire *wire = bit.wire;
+			if (wire->name.isPublic()) {
+				std::string wire_src;
+				if (wire->has_attribute(ID::src)) {
+					std::string src_attr = wire->get_src_attribute();
+					wire_src = stringf(" source: %s", src_attr);
+				}
+				message += stringf("    wire %s%s\n", log_signal(bit), wire_src);
+			}
+
+			prev = bit;
+		}
+		warning(message);
+	}
+
+	void check_initdrv(pool<SigBit> &init_bits)
+	{
+		for (auto cell : module->cells())
+		{
+			if (cell->is_builtin_ff() == 0)
+				continue;
+
+			for (auto b : sigmap(cell->getPort(ID::Q)))
+				init_bits.erase(b);
+		}
+
+		SigSpec init_sig(init_bits);
+		init_sig.sort_and_unify();
+
+		for (auto chunk : init_sig.chunks())
+			warning(stringf("Wire %s.%s has 'init' attribute and is not driven by an FF cell.\n", RTLIL::unescape_id(module->name),
+					log_signal(chunk)));
+	}
+
+	void run()
+	{
+		sigmap.set(module);
+		pool<SigBit> init_bits;
+
+		collect_processes();
+		collect_cells();
+		collect_wires(init_bits);
+		index_drivers();
+
+		check_drivers();
+		check_loops();
+		if (opt.initdrv)
+			check_initdrv(init_bits);
+	}
+};
+
 struct CheckPass : public Pass {
 	CheckPass() : Pass("check", "check for obvious problems in the design") { }
 	bool formatted_help() override {
@@ -75,30 +651,26 @@ struct CheckPass : public Pass {
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
 	{
 		int counter = 0;
-		bool noinit = false;
-		bool initdrv = false;
-		bool mapped = false;
-		bool allow_tbuf = false;
+		CheckWorker::Options opt;
 		bool assert_mode = false;
-		bool force_detailed_loop_check = false;
 		bool suggest_detail = false;
 
 		size_t argidx;
 		for (argidx = 1; argidx < args.size(); argidx++) {
 			if (args[argidx] == "-noinit") {
-				noinit = true;
+				opt.noinit = true;
 				continue;
 			}
 			if (args[argidx] == "-initdrv") {
-				initdrv = true;
+				opt.initdrv = true;
 				continue;
 			}
 			if (args[argidx] == "-mapped") {
-				mapped = true;
+				opt.mapped = true;
 				continue;
 			}
 			if (args[argidx] == "-allow-tbuf") {
-				allow_tbuf = true;
+				opt.allow_tbuf = true;
 				continue;
 			}
 			if (args[argidx] == "-assert") {
@@ -106,7 +678,7 @@ struct CheckPass : public Pass {
 				continue;
 			}
 			if (args[argidx] == "-force-detailed-loop-check") {
-				force_detailed_loop_check = true;
+				opt.force_detailed_loop_check = true;
 				continue;
 			}
 			break;
@@ -115,332 +687,35 @@ struct CheckPass : public Pass {
 
 		log_header(design, "Executing CHECK pass (checking for obvious problems).\n");
 
-		for (auto module : design->selected_whole_modules_warn())
-		{
-			log("Checking module %s...\n", log_id(module));
-
-			SigMap sigmap(module);
-			dict<SigBit, vector<string>> wire_drivers;
-			dict<SigBit, Cell *> driver_cells;
-			dict<SigBit, int> wire_drivers_count;
-			pool<SigBit> used_wires;
-			TopoSort<std::pair<RTLIL::IdString, int>> topo;
-			for (auto &proc_it : module->processes)
-			{
-				std::vector<RTLIL::CaseRule*> all_cases = {&proc_it.second->root_case};
-				for (size_t i = 0; i < all_cases.size(); i++) {
-					for (auto action : all_cases[i]->actions) {
-						for (auto bit : sigmap(action.first))
-							wire_drivers[bit].push_back(
-								stringf("action %s <= %s (case rule) in process %s",
-										log_signal(action.first), log_signal(action.second), log_id(proc_it.first)));
-
-						for (auto bit : sigmap(action.second))
-							if (bit.wire) used_wires.insert(bit);
-					}
-					for (auto switch_ : all_cases[i]->switches) {
-						for (auto case_ : switch_->cases) {
-							all_cases.push_back(case_);
-							for (auto compare : case_->compare)
-								for (auto bit : sigmap(compare))
-									if (bit.wire) used_wires.insert(bit);
-						}
-					}
-				}
-				for (auto &sync : proc_it.second->syncs) {
-					for (auto bit : sigmap(sync->signal))
-						if (bit.wire) used_wires.insert(bit);
-					for (auto action : sync->actions) {
-						for (auto bit : sigmap(action.first))
-							wire_drivers[bit].push_back(
-								stringf("action %s <= %s (sync rule) in process %s",
-										log_signal(action.first), log_signal(action.second), log_id(proc_it.first)));
-						for (auto bit : sigmap(action.second))
-							if (bit.wire) used_wires.insert(bit);
-					}
-					for (auto memwr : sync->mem_write_actions) {
-						for (auto bit : sigmap(memwr.address))
-							if (bit.wire) used_wires.insert(bit);
-						for (auto bit : sigmap(memwr.data))
-							if (bit.wire) used_wires.insert(bit);
-						for (auto bit : sigmap(memwr.enable))
-							if (bit.wire) used_wires.insert(bit);
-					}
-				}
-			}
-
-			struct CircuitEdgesDatabase : AbstractCellEdgesDatabase {
-				TopoSort<std::pair<RTLIL::IdString, int>> &topo;
-				SigMap sigmap;
-				bool force_detail;
+		std::vector<RTLIL::Module*> modules = design->selected_whole_modules_warn();
+		CheckWorker::ModulePorts module_ports = CheckWorker::collect_module_ports(design);
+		std::vector<CheckWorker> workers;
+		workers.reserve(modules.size());
+		for (auto module : modules)
+			workers.emplace_back(module, opt, module_ports);
 
-				CircuitEdgesDatabase(TopoSort<std::pair<RTLIL::IdString, int>> &topo, SigMap &sigmap, bool force_detail)
-					: topo(topo), sigmap(sigmap), force_detail(force_detail) {}
-
-				void add_edge(RTLIL::Cell *cell, RTLIL::IdString from_port, int from_bit,
-							  RTLIL::IdString to_port, int to_bit, int) override {
-					SigSpec from_portsig = cell->getPort(from_port);
-					SigSpec to_portsig = cell->getPort(to_port);
-					log_assert(from_bit >= 0 && from_bit < from_portsig.size());
-					log_assert(to_bit >= 0 && to_bit < to_portsig.size());
-					SigBit from = sigmap(from_portsig[from_bit]);
-					SigBit to = sigmap(to_portsig[to_bit]);
-
-					if (from.wire && to.wire)
-						topo.edge(std::make_pair(from.wire->name, from.offset), std::make_pair(to.wire->name, to.offset));
-				}
-
-				bool detail_costly(Cell *cell) {
-					// Only those cell types for which the edge data can expode quadratically
-					// in port widths are those for us to check.
-					if (!cell->type.in(
-							ID($add), ID($sub),
-							ID($shl), ID($shr), ID($sshl), ID($sshr), ID($shift), ID($shiftx),
-							ID($pmux), ID($bmux)))
-						return false;
-
-					int in_widths = 0, out_widths = 0;
-
-					if (cell->type.in(ID($pmux), ID($bmux))) {
-						// We're skipping inputs A and B, since each of their bits contributes only one edge
-						in_widths = GetSize(cell->getPort(ID::S));
-						out_widths = GetSize(cell->getPort(ID::Y));
-					} else {
-						for (auto &conn : cell->connections()) {
-							if (cell->input(conn.first))
-								in_widths += conn.second.size();
-							if (cell->output(conn.first))
-								out_widths += conn.second.size();
-						}
-					}
-
-					const int threshold = 1024;
-
-					// if the multiplication may overflow we will catch it here 
-					if (in_widths + out_widths >= threshold)
-						return true;
-
-					if (in_widths * out_widths >= threshold)
-						return true;
-
-					return false;
-				}
-
-				bool add_edges_from_cell(Cell *cell) {
-					if (force_detail || !detail_costly(cell)) {
-						if (AbstractCellEdgesDatabase::add_edges_from_cell(cell))
-							return true;
-					}
-
-					// We don't have accurate cell edges, do the fallback of all input-output pairs
-					for (auto &conn : cell->connections()) {
-						if (cell->input(conn.first))
-						for (auto bit : sigmap(conn.second))
-						if (bit.wire)
-							topo.edge(std::make_pair(bit.wire->name, bit.offset),
-									  std::make_pair(cell->name, -1));
-
-						if (cell->output(conn.first))
-						for (auto bit : sigmap(conn.second))
-						if (bit.wire)
-							topo.edge(std::make_pair(cell->name, -1),
-									  std::make_pair(bit.wire->name, bit.offset));
-					}
-
-					// Return false to signify the fallback
-					return false;
-				}
-			};
-
-			CircuitEdgesDatabase edges_db(topo, sigmap, force_detailed_loop_check);
-
-			pool<Cell *> coarsened_cells;
-			for (auto cell : module->cells())
-			{
-				if (mapped && cell->type.begins_with("$") && design->module(cell->type) == nullptr) {
-					if (allow_tbuf && cell->type == ID($_TBUF_)) goto cell_allowed;
-					log_warning("Cell %s.%s is an unmapped internal cell of type %s.\n", log_id(module), log_id(cell), log_id(cell->type));
-					counter++;
-				cell_allowed:;
-				}
-
-				for (auto &conn : cell->connections()) {
-					bool input = cell->input(conn.first);
-					bool output = cell->output(conn.first);
-
-					SigSpec sig = sigmap(conn.second);
-					for (int i = 0; i < sig.size(); i++) {
-						SigBit bit = sig[i];
-
-						if (input && bit.wire)
-							used_wires.insert(bit);
-						if (output && !input && bit.wire)
-							wire_drivers_count[bit]++;
-						if (output && (bit.wire || !input))
-							wire_drivers[bit].push_back(stringf("port %s[%d] of cell %s (%s)", log_id(conn.first), i,
-																log_id(cell), log_id(cell->type)));
-						if (output)
-							driver_cells[bit] = cell;
-					}
-				}
-
-				if (yosys_celltypes.cell_evaluable(cell->type) || cell->type.in(ID($mem_v2), ID($memrd), ID($memrd_v2)) \
-						|| cell->is_builtin_ff()) {
-					if (!edges_db.add_edges_from_cell(cell))
-						coarsened_cells.insert(cell);
-				}
-			}
-
-			pool<SigBit> init_bits;
-
-			for (auto wire : module->wires()) {
-				if (wire->port_input) {
-					SigSpec sig = sigmap(wire);
-					for (int i = 0; i < GetSize(sig); i++)
-						if (sig[i].wire || !wire->port_output)
-							wire_drivers[sig[i]].push_back(stringf("module input %s[%d]", log_id(wire), i));
-				}
-				if (wire->port_output)
-					for (auto bit : sigmap(wire))
-						if (bit.wire) used_wires.insert(bit);
-				if (wire->port_input && !wire->port_output)
-					for (auto bit : sigmap(wire))
-						if (bit.wire) wire_drivers_count[bit]++;
-				if (wire->attributes.count(ID::init)) {
-					Const initval = wire->attributes.at(ID::init);
-					for (int i = 0; i < GetSize(initval) && i < GetSize(wire); i++)
-						if (initval[i] == State::S0 || initval[i] == State::S1)
-							init_bits.insert(sigmap(SigBit(wire, i)));
-					if (noinit) {
-						log_warning("Wire %s.%s has an unprocessed 'init' attribute.\n", log_id(module), log_id(wire));
-						counter++;
-					}
-				}
-			}
-
-			for (auto state : {State::S0, State::S1, State::Sx})
-				if (wire_drivers.count(state)) {
-					string message = stringf("Drivers conflicting with a constant %s driver:\n", log_signal(state));
-					for (auto str : wire_drivers[state])
-						message += stringf("    %s\n", str);
-					log_warning("%s", message);
-					counter++;
-				}
-
-			for (auto it : wire_drivers)
-				if (wire_drivers_count[it.first] > 1) {
-					string message = stringf("multiple conflicting drivers for %s.%s:\n", log_id(module), log_signal(it.first));
-					for (auto str : it.second)
-						message += stringf("    %s\n", str);
-					log_warning("%s", message);
-					counter++;
-				}
-
-			for (auto bit : used_wires)
-				if (!wire_drivers.count(bit)) {
-					log_warning("Wire %s.%s is used but has no driver.\n", log_id(module), log_signal(bit));
-					counter++;
-				}
-
-			topo.sort();
-			for (auto &loop : topo.loops) {
-				string message = stringf("found logic loop in module %s:\n", log_id(module));
-
-				// `loop` only contains wire bits, or an occasional special helper node for cells for
-				// which we have done the edges fallback. The cell and its ports that led to an edge are
-				// a piece of information we need to recover now. For that we need to have the previous
-				// wire bit of the loop at hand.
-				SigBit prev;
-				for (auto it = loop.rbegin(); it != loop.rend(); it++)
-				if (it->second != -1) { // skip the fallback helper nodes
-					prev = SigBit(module->wire(it->first), it->second);
-					break;
-				}
-				log_assert(prev != SigBit());
-
-				for (auto &pair : loop) {
-					if (pair.second == -1)
-						continue; // helper node for edges fallback, we can ignore it
-
-					struct MatchingEdgePrinter : AbstractCellEdgesDatabase {
-						std::string &message;
-						SigMap &sigmap;
-						SigBit from, to;
-						int nhits;
-						const int HITS_LIMIT = 3;
-
-						MatchingEdgePrinter(std::string &message, SigMap &sigmap, SigBit from, SigBit to)
-							: message(message), sigmap(sigmap), from(from), to(to), nhits(0) {}
-
-						void add_edge(RTLIL::Cell *cell, RTLIL::IdString from_port, int from_bit,
-									  RTLIL::IdString to_port, int to_bit, int) override {
-							SigBit edge_from = sigmap(cell->getPort(from_port))[from_bit];
-							SigBit edge_to = sigmap(cell->getPort(to_port))[to_bit];
-
-							if (edge_from == from && edge_to == to && nhits++ < HITS_LIMIT)
-								message += stringf("      %s[%d] --> %s[%d]\n", log_id(from_port), from_bit,
-												   log_id(to_port), to_bit);
-							if (nhits == HITS_LIMIT)
-								message += "      ...\n";
-						}
-					};
-
-					Wire *wire = module->wire(pair.first);
-					log_assert(wire);
-					SigBit bit(module->wire(pair.first), pair.second);
-					log_assert(driver_cells.count(bit));
-					Cell *driver = driver_cells.at(bit);
-
-					std::string driver_src;
-					if (driver->has_attribute(ID::src)) {
-						std::string src_attr = driver->get_src_attribute();
-						driver_src = stringf(" source: %s", src_attr);
-					}
-
-					message += stringf("    cell %s (%s)%s\n", log_id(driver), log_id(driver->type), driver_src);
-
-					if (!coarsened_cells.count(driver)) {						
-						MatchingEdgePrinter printer(message, sigmap, prev, bit);
-						printer.add_edges_from_cell(driver);
-					} else {
-						message += "      (cell's internal connectivity overapproximated; loop may be a false positive)\n";
-						suggest_detail = true;
-					}
-
-					if (wire->name.isPublic()) {
-						std::string wire_src;
-						if (wire->has_attribute(ID::src)) {
-							std::string src_attr = wire->get_src_attribute();
-							wire_src = stringf(" source: %s", src_attr);
-						}
-						message += stringf("    wire %s%s\n", log_signal(SigBit(wire, pair.second)), wire_src);						
-					}
+		int num_workers = GetSize(modules) > 1 ? ThreadPool::pool_size(1, GetSize(modules) - 1) : 0;
+		ConcurrentQueue<int> jobs;
+		{
+			ThreadPool pool(num_workers, [&](int) {
+					while (std::optional<int> i = jobs.pop_front())
+						workers[*i].run();
+				});
+			for (int i = 0; i < GetSize(workers); i++)
+				jobs.push_back(i);
+			jobs.close();
+			// With no worker threads this does all of the work
+			while (std::optional<int> i = jobs.pop_front())
+				workers[*i].run();
+		}
 
-					prev = bit;
-				}
+		for (auto &worker : workers) {
+			log("Checking module %s...\n", log_id(worker.module));
+			for (auto &message : worker.warnings) {
 				log_warning("%s", message);
 				counter++;
 			}
-
-			if (initdrv)
-			{
-				for (auto cell : module->cells())
-				{
-					if (cell->is_builtin_ff() == 0)
-						continue;
-
-					for (auto bit : sigmap(cell->getPort(ID::Q)))
-						init_bits.erase(bit);
-				}
-
-				SigSpec init_sig(init_bits);
-				init_sig.sort_and_unify();
-
-				for (auto chunk : init_sig.chunks()) {
-					log_warning("Wire %s.%s has 'init' attribute and is not driven by an FF cell.\n", log_id(module), log_signal(chunk));
-					counter++;
-				}
-			}
+			suggest_detail |= worker.suggest_detail;
 		}
 
 		log("Found and reported %d problems.\n", counter);
@@ -130,6 +130,7 @@ struct ConnwrappersWorker
 						old_sig = conn.second;
 
 					conn.second.replace(i+1, extend_sig.extract(0, extend_width));
+					module->invalidate_content_hash();
 					i += extend_width;
 				}
 
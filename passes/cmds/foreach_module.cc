@@ -0,0 +1,274 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/yosys.h"
+#include "kernel/log_help.h"
+#include "kernel/forkjobs.h"
+
+#include <fstream>
+#include <thread>
+
+#ifndef _WIN32
+#  include <sys/wait.h>
+#endif
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+#ifndef _WIN32
+
+struct ForeachModuleWorker
+{
+	struct Task
+	{
+		RTLIL::IdString module;
+		bool ok = false;
+		std::string status;
+	};
+
+	RTLIL::Design *design;
+	ForkJobs fork_jobs{"foreach"};
+	std::string script;
+	std::vector<Task> tasks;
+
+	std::string path(int index, const char *suffix)
+	{
+		return fork_jobs.path(index, suffix);
+	}
+
+	// Runs in the forked process: executes the script with only the module of
+	// the task selected, then writes that module and any modules the script
+	// added to the temporary directory. Modules the script created under the
+	// name of an existing module are written as well, so that the parent can
+	// reject them.
+	int run_child(int index)
+	{
+		Task &task = tasks[index];
+		dict<RTLIL::IdString, Hasher::hash_t> other_modules;
+		for (auto mod : design->modules())
+			if (mod->name != task.module)
+				other_modules[mod->name] = mod->hashidx_;
+
+		design->selection_stack.clear();
+		design->selection_vars.clear();
+		design->selected_active_module.clear();
+		design->push_empty_selection();
+		design->select(design->module(task.module));
+
+		try {
+			Pass::call(design, script);
+			for (auto mod : design->modules().to_vector()) {
+				auto it = other_modules.find(mod->name);
+				if (it != other_modules.end() && it->second == mod->hashidx_)
+					design->remove(mod);
+			}
+			design->selection_stack.clear();
+			design->push_complete_selection();
+			Pass::call(design, "write_rtlil " + path(index, "il"));
+		} catch (log_cmd_error_exception) {
+			std::ofstream out(path(index, "err"));
+			out << log_last_error;
+			return 1;
+		}
+		return 0;
+	}
+
+	void collect(int index, int status)
+	{
+		Task &task = tasks[index];
+
+		if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+			task.ok = true;
+			return;
+		}
+
+		std::string error = fork_jobs.read_file(index, "err");
+		while (!error.empty() && error.back() == '\n')
+			error.pop_back();
+		task.status = error.empty() ? ForkJobs::status_text(status) : error;
+	}
+
+	void run_all(int jobs)
+	{
+		fork_jobs.run(GetSize(tasks), jobs,
+				[this](int index) { return run_child(index); },
+				[this](int index, int status) { collect(index, status); });
+	}
+
+	void replay_log(int index)
+	{
+		log("\n-- Output for module %s --\n", log_id(tasks[index].module));
+		log("%s", fork_jobs.read_file(index, "log"));
+	}
+
+	// Reads all results before changing the design, so that the design is
+	// left unchanged if they can't be merged
+	void merge_all()
+	{
+		pool<RTLIL::IdString> task_modules;
+		for (auto &task : tasks)
+			task_modules.insert(task.module);
+
+		std::vector<std::unique_ptr<RTLIL::Design>> results;
+		dict<RTLIL::IdString, int> added_by;
+		for (int i = 0; i < GetSize(tasks); i++) {
+			results.push_back(std::make_unique<RTLIL::Design>());
+			Frontend::frontend_call(results.back().get(), nullptr, path(i, "il"), "rtlil");
+			for (auto mod : results.back()->modules()) {
+				if (mod->name == tasks[i].module)
+					continue;
+				if (task_modules.count(mod->name) || design->module(mod->name) != nullptr)
+					log_cmd_error("Module %s added by the commands for %s already exists, the design is unchanged.\n",
+							log_id(mod->name), log_id(tasks[i].module));
+				auto it = added_by.find(mod->name);
+				if (it != added_by.end())
+					log_cmd_error("Module %s was added by the commands for both %s and %s, the design is unchanged.\n",
+							log_id(mod->name), log_id(tasks[it->second].module), log_id(tasks[i].module));
+				added_by[mod->name] = i;
+			}
+		}
+
+		for (int i = 0; i < GetSize(tasks); i++) {
+			RTLIL::Module *old_mod = design->module(tasks[i].module);
+			if (old_mod != nullptr)
+				design->remove(old_mod);
+			for (auto mod : results[i]->modules().to_vector()) {
+				results[i]->modules_.erase(mod->name);
+				design->add(mod);
+			}
+		}
+	}
+};
+
+#endif
+
+struct ForeachModulePass : public Pass {
+	ForeachModulePass() : Pass("foreach_module", "run a script on each module in parallel") { }
+	bool formatted_help() override {
+		auto *help = PrettyHelp::get_current();
+		help->set_group("passes/cmds");
+		return false;
+	}
+	void help() override
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    foreach_module [options] -run <commands> [selection]\n");
+		log("\n");
+		log("Run the given commands once for each selected module, with only that module\n");
+		log("selected. Commands are separated with semicolons, as with 'yosys -p'. The\n");
+		log("modules are processed in parallel, each in a forked process that works on its\n");
+		log("own copy of the design, and the results are merged back into the design.\n");
+		log("\n");
+		log("The commands should only change the selected module. Only this module and any\n");
+		log("modules added by the commands are merged back, changes to the other modules\n");
+		log("are discarded. Commands that need the whole hierarchy, such as 'flatten' or\n");
+		log("'hierarchy -top', are not suitable for this command. It is an error if the\n");
+		log("commands for two modules add modules with the same name.\n");
+		log("\n");
+		log("The modules are passed back as RTLIL, so modules read by a frontend lose the\n");
+		log("frontend data kept with them. In particular, the AST that read_verilog keeps\n");
+		log("for a module is lost, and a parametric module can't be derived for other\n");
+		log("parameter values afterwards. Run 'hierarchy' before this command. Modules with\n");
+		log("cells that 'hierarchy' has not processed yet are rejected.\n");
+		log("\n");
+		log("The log output of each module is copied to the log in module order. If the\n");
+		log("commands fail for any module, the design is left unchanged.\n");
+		log("\n");
+		log("    -run <commands>\n");
+		log("        the commands to run for each module\n");
+		log("\n");
+		log("    -j <N>\n");
+		log("        process at most N modules at the same time (default: the number of\n");
+		log("        hardware threads)\n");
+		log("\n");
+		log("Example:\n");
+		log("\n");
+		log("    foreach_module -j 8 -run \"opt; wreduce; alumacc; opt -full\" A:keep_hierarchy\n");
+		log("\n");
+	}
+	void execute(std::vector<std::string> args, RTLIL::Design *design) override
+	{
+		log_header(design, "Executing FOREACH_MODULE pass (run a script on each module in parallel).\n");
+
+		std::string script;
+		int jobs = std::max(1, int(std::thread::hardware_concurrency()));
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++) {
+			if (args[argidx] == "-run" && argidx+1 < args.size()) {
+				script = args[++argidx];
+				continue;
+			}
+			if (args[argidx] == "-j" && argidx+1 < args.size()) {
+				jobs = std::max(1, atoi(args[++argidx].c_str()));
+				continue;
+			}
+			break;
+		}
+		extra_args(args, argidx, design);
+
+		if (script.empty())
+			log_cmd_error("No commands given, use -run.\n");
+
+#ifdef _WIN32
+		(void)jobs;
+		log_cmd_error("The foreach_module command is not supported on Windows.\n");
+#else
+		ForeachModuleWorker worker;
+		worker.design = design;
+		worker.script = script;
+		for (auto mod : design->selected_unboxed_whole_modules_warn()) {
+			// The results are read back from RTLIL, which can't represent the
+			// frontend data (e.g. the AST kept by read_verilog) that is still
+			// needed to process the cells of these modules
+			if (typeid(*mod) != typeid(RTLIL::Module) && mod->get_bool_attribute(ID::cells_not_processed))
+				log_cmd_error("The cells of module %s have not been processed by 'hierarchy' yet.\n", log_id(mod));
+			worker.tasks.emplace_back();
+			worker.tasks.back().module = mod->name;
+		}
+
+		if (worker.tasks.empty()) {
+			log("No modules selected.\n");
+			return;
+		}
+
+		log("Processing %d modules, %d at a time.\n", GetSize(worker.tasks), std::min(jobs, GetSize(worker.tasks)));
+		worker.run_all(jobs);
+
+		std::vector<int> failed;
+		for (int i = 0; i < GetSize(worker.tasks); i++) {
+			worker.replay_log(i);
+			if (!worker.tasks[i].ok)
+				failed.push_back(i);
+		}
+		log("\n");
+
+		if (!failed.empty()) {
+			for (int i : failed)
+				log("Module %s failed: %s\n", log_id(worker.tasks[i].module), worker.tasks[i].status);
+			log_cmd_error("Commands failed for %d of %d modules, the design is unchanged.\n",
+					GetSize(failed), GetSize(worker.tasks));
+		}
+
+		worker.merge_all();
+		log("Merged %d modules.\n", GetSize(worker.tasks));
+#endif
+	}
+} ForeachModulePass;
+
+PRIVATE_NAMESPACE_END
@@ -0,0 +1,318 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/yosys.h"
+#include "kernel/log_help.h"
+#include "kernel/forkjobs.h"
+#include "libs/json11/json11.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+using json11::Json;
+
+#ifndef _WIN32
+
+struct ForkExploreWorker
+{
+	struct Alternative
+	{
+		std::string script;
+		bool ok = false;
+		std::string status;
+		double time = 0;
+		dict<std::string, std::string> scratchpad;
+	};
+
+	RTLIL::Design *design;
+	ForkJobs fork_jobs{"fork"};
+	std::vector<Alternative> alternatives;
+	std::string report = "stat";
+	std::vector<std::string> metrics;
+	bool write_designs = true;
+
+	std::string path(int index, const char *suffix)
+	{
+		return fork_jobs.path(index, suffix);
+	}
+
+	// Runs in the forked process: executes the alternative on the inherited
+	// copy of the design and writes the results to the temporary directory.
+	int run_child(int index)
+	{
+		// Values inherited from the parent would hide a failing report
+		for (auto &metric : metrics)
+			design->scratchpad_unset(metric);
+
+		Alternative &alt = alternatives[index];
+		Json::object result;
+		auto start = std::chrono::steady_clock::now();
+		try {
+			Pass::call(design, alt.script);
+			design->check();
+			if (!report.empty())
+				Pass::call(design, report);
+			if (write_designs)
+				Pass::call(design, "write_rtlil " + path(index, "il"));
+			result["status"] = "ok";
+		} catch (log_cmd_error_exception) {
+			std::string error = log_last_error;
+			while (!error.empty() && error.back() == '\n')
+				error.pop_back();
+			result["status"] = "error: " + error;
+		}
+		result["time"] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		Json::object scratchpad;
+		for (auto &it : design->scratchpad)
+			scratchpad[it.first] = it.second;
+		result["scratchpad"] = scratchpad;
+
+		std::ofstream out(path(index, "json"));
+		out << Json(result).dump() << "\n";
+		out.close();
+		return 0;
+	}
+
+	void collect(int index, int status)
+	{
+		Alternative &alt = alternatives[index];
+
+		std::string error;
+		Json result = Json::parse(fork_jobs.read_file(index, "json"), error);
+
+		if (!result.is_object()) {
+			alt.status = ForkJobs::status_text(status);
+			return;
+		}
+
+		alt.status = result["status"].string_value();
+		alt.ok = alt.status == "ok";
+		alt.time = result["time"].number_value();
+		for (auto &it : result["scratchpad"].object_items())
+			alt.scratchpad[it.first] = it.second.string_value();
+	}
+
+	void run_all(int jobs)
+	{
+		fork_jobs.run(GetSize(alternatives), jobs,
+				[this](int index) { return run_child(index); },
+				[this](int index, int status) { collect(index, status); });
+	}
+
+	void report_table()
+	{
+		std::vector<std::vector<std::string>> rows;
+		std::vector<std::string> header = {"#", "status", "time"};
+		for (auto &metric : metrics)
+			header.push_back(metric);
+		header.push_back("script");
+		rows.push_back(header);
+
+		for (int i = 0; i < GetSize(alternatives); i++) {
+			auto &alt = alternatives[i];
+			std::vector<std::string> row = {std::to_string(i), alt.status, stringf("%.2f", alt.time)};
+			for (auto &metric : metrics)
+				row.push_back(alt.scratchpad.count(metric) ? alt.scratchpad.at(metric) : "-");
+			row.push_back(alt.script);
+			rows.push_back(row);
+		}
+
+		std::vector<int> widths(header.size());
+		for (auto &row : rows)
+			for (int i = 0; i < GetSize(row) - 1; i++)
+				widths[i] = std::max(widths[i], GetSize(row[i]));
+
+		log("\n");
+		for (auto &row : rows) {
+			std::string line = " ";
+			for (int i = 0; i < GetSize(row); i++) {
+				line += " " + row[i];
+				if (i + 1 < GetSize(row))
+					line += std::string(widths[i] - GetSize(row[i]), ' ');
+			}
+			log("%s\n", line);
+		}
+		log("\n");
+	}
+
+	// Index of the best alternative by the first metric, or -1
+	int pick_best(bool maximize)
+	{
+		int best = -1;
+		double best_value = 0;
+		for (int i = 0; i < GetSize(alternatives); i++) {
+			auto &alt = alternatives[i];
+			if (!alt.ok || !alt.scratchpad.count(metrics.front()))
+				continue;
+			double value = atof(alt.scratchpad.at(metrics.front()).c_str());
+			if (best < 0 || (maximize ? value > best_value : value < best_value))
+				best = i, best_value = value;
+		}
+		return best;
+	}
+
+	void load_result(int index)
+	{
+		for (auto mod : design->modules().to_vector())
+			design->remove(mod);
+		design->selection_stack.clear();
+		design->selection_vars.clear();
+		design->selected_active_module.clear();
+		design->push_full_selection();
+
+		Frontend::frontend_call(design, nullptr, path(index, "il"), "rtlil");
+		for (auto &it : alternatives[index].scratchpad)
+			design->scratchpad[it.first] = it.second;
+	}
+};
+
+#endif
+
+struct ForkExplorePass : public Pass {
+	ForkExplorePass() : Pass("fork_explore", "run alternative scripts in forked processes") { }
+	bool formatted_help() override {
+		auto *help = PrettyHelp::get_current();
+		help->set_group("passes/cmds");
+		return false;
+	}
+	void help() override
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    fork_explore [options] -run <commands> [-run <commands> ...]\n");
+		log("\n");
+		log("Run each of the given alternative scripts on a copy of the current design and\n");
+		log("compare the results. Each alternative runs in a forked process, so that the\n");
+		log("copy of the design shares its memory with this process until it is modified.\n");
+		log("Commands of an alternative are separated with semicolons, as with 'yosys -p'.\n");
+		log("\n");
+		log("After an alternative, the report commands are run and the given scratchpad\n");
+		log("variables (see 'help scratchpad') are collected. The results are printed as a\n");
+		log("table, and the design of the best alternative (by the first metric) is loaded\n");
+		log("back into this process, together with its scratchpad variables.\n");
+		log("\n");
+		log("    -run <commands>\n");
+		log("        an alternative script, this option can be used multiple times\n");
+		log("\n");
+		log("    -report <commands>\n");
+		log("        commands run after each alternative to compute the metrics. The\n");
+		log("        default is 'stat', which sets stat.* variables if the design has a\n");
+		log("        top module. 'sta' sets sta.latest_arrival and sta.worst_slack.\n");
+		log("\n");
+		log("    -metric <variable>\n");
+		log("        scratchpad variable to collect, this option can be used multiple\n");
+		log("        times. The first one selects the best alternative.\n");
+		log("        (default: stat.num_cells)\n");
+		log("\n");
+		log("    -max\n");
+		log("        the best alternative has the largest instead of the smallest value\n");
+		log("\n");
+		log("    -j <N>\n");
+		log("        run at most N alternatives at the same time (default: the number of\n");
+		log("        hardware threads)\n");
+		log("\n");
+		log("    -nopick\n");
+		log("        only report the results, keep the current design unchanged\n");
+		log("\n");
+	}
+	void execute(std::vector<std::string> args, RTLIL::Design *design) override
+	{
+		log_header(design, "Executing FORK_EXPLORE pass (run alternative scripts in forked processes).\n");
+
+		std::vector<std::string> scripts;
+		std::vector<std::string> metrics;
+		std::string report = "stat";
+		bool maximize = false;
+		bool nopick = false;
+		int jobs = std::max(1, int(std::thread::hardware_concurrency()));
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++) {
+			if (args[argidx] == "-run" && argidx+1 < args.size()) {
+				scripts.push_back(args[++argidx]);
+				continue;
+			}
+			if (args[argidx] == "-report" && argidx+1 < args.size()) {
+				report = args[++argidx];
+				continue;
+			}
+			if (args[argidx] == "-metric" && argidx+1 < args.size()) {
+				metrics.push_back(args[++argidx]);
+				continue;
+			}
+			if (args[argidx] == "-max") {
+				maximize = true;
+				continue;
+			}
+			if (args[argidx] == "-j" && argidx+1 < args.size()) {
+				jobs = std::max(1, atoi(args[++argidx].c_str()));
+				continue;
+			}
+			if (args[argidx] == "-nopick") {
+				nopick = true;
+				continue;
+			}
+			break;
+		}
+		extra_args(args, argidx, design, false);
+
+		if (scripts.empty())
+			log_cmd_error("No alternatives given, use -run.\n");
+		if (metrics.empty())
+			metrics.push_back("stat.num_cells");
+
+#ifdef _WIN32
+		(void)report;
+		(void)maximize;
+		(void)nopick;
+		(void)jobs;
+		log_cmd_error("The fork_explore command is not supported on Windows.\n");
+#else
+		ForkExploreWorker worker;
+		worker.design = design;
+		worker.report = report;
+		worker.metrics = metrics;
+		worker.write_designs = !nopick;
+		for (auto &script : scripts) {
+			worker.alternatives.emplace_back();
+			worker.alternatives.back().script = script;
+		}
+
+		log("Running %d alternatives, %d at a time.\n", GetSize(scripts), std::min(jobs, GetSize(scripts)));
+		worker.run_all(jobs);
+
+		worker.report_table();
+
+		int best = worker.pick_best(maximize);
+		if (best < 0)
+			log_warning("No alternative finished with a value for %s.\n", metrics.front());
+		else if (nopick)
+			log("Best alternative is #%d.\n", best);
+		else {
+			log("Loading the result of alternative #%d.\n", best);
+			worker.load_result(best);
+		}
+#endif
+	}
+} ForkExplorePass;
+
+PRIVATE_NAMESPACE_END
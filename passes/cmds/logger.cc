@@ -110,6 +110,7 @@ struct LoggerPass : public Pass {
 				try {
 					log("Added regex '%s' for warnings to warn list.\n", pattern);
 					log_warn_regexes.push_back(YS_REGEX_COMPILE(pattern));
+					log_outputs_changed();
 				}
 				catch (const std::regex_error& e) {
 					log_cmd_error("Error in regex expression '%s' !\n", pattern);
@@ -186,6 +187,7 @@ struct LoggerPass : public Pass {
 					else if (type == "prefix-log")
 						log_expect_prefix_log[pattern] = LogExpectedItem(YS_REGEX_COMPILE(pattern), count);
 					else log_abort();
+					log_outputs_changed();
 				}
 				catch (const std::regex_error& e) {
 					log_cmd_error("Error in regex expression '%s' !\n", pattern);
@@ -19,7 +19,7 @@
 
 #include "kernel/yosys.h"
 #include "kernel/celltypes.h"
-#include "kernel/sigtools.h"
+#include "kernel/cellgraph.h"
 #include "kernel/log_help.h"
 
 USING_YOSYS_NAMESPACE
@@ -29,17 +29,22 @@ struct LtpWorker
 {
 	RTLIL::Design *design;
 	RTLIL::Module *module;
-	SigMap sigmap;
+	bool noff;
 
+	// Level, predecessor bit and cell of each bit of the selected wires
 	dict<SigBit, tuple<int, SigBit, Cell*>> bits;
-	dict<SigBit, dict<SigBit, Cell*>> bit2bits;
 	dict<SigBit, tuple<SigBit, Cell*>> bit2ff;
 
 	int maxlvl;
 	SigBit maxbit;
-	pool<SigBit> busy;
 
-	LtpWorker(RTLIL::Module *module, bool noff) : design(module->design), module(module), sigmap(module)
+	LtpWorker(RTLIL::Module *module, bool noff) : design(module->design), module(module), noff(noff)
+	{
+		maxlvl = -1;
+		maxbit = State::Sx;
+	}
+
+	void run()
 	{
 		CellTypes ff_celltypes;
 
@@ -48,86 +53,68 @@ struct LtpWorker
 			ff_celltypes.setup_stdcells_mem();
 		}
 
-		for (auto wire : module->selected_wires())
-			for (auto bit : sigmap(wire))
-				bits[bit] = tuple<int, SigBit, Cell*>(-1, State::Sx, nullptr);
+		CellGraph &graph = CellGraph::get(module, noff ? "ltp -noff" : "ltp",
+				[ff_celltypes](Cell *cell) { return !ff_celltypes.cell_known(cell->type); },
+				[](Cell *cell, IdString port) {
+					return (cell->input(port) ? CellGraph::PORT_INPUT : 0) | (cell->output(port) ? CellGraph::PORT_OUTPUT : 0);
+				});
 
-		for (auto cell : module->selected_cells())
-		{
-			pool<SigBit> src_bits, dst_bits;
-
-			for (auto &conn : cell->connections())
-				for (auto bit : sigmap(conn.second)) {
-					if (cell->input(conn.first))
-						src_bits.insert(bit);
-					if (cell->output(conn.first))
-						dst_bits.insert(bit);
-				}
-
-			if (noff && ff_celltypes.cell_known(cell->type)) {
-				for (auto s : src_bits)
-					for (auto d : dst_bits) {
-						bit2ff[s] = tuple<SigBit, Cell*>(d, cell);
-						break;
+		for (auto wire : module->selected_wires())
+			for (auto bit : graph.sigmap(wire))
+				bits[bit] = tuple<int, SigBit, Cell*>(0, State::Sx, nullptr);
+
+		if (noff)
+			for (auto cell : module->selected_cells())
+			{
+				if (!ff_celltypes.cell_known(cell->type))
+					continue;
+
+				pool<SigBit> src_bits, dst_bits;
+				for (auto &conn : cell->connections())
+					for (auto bit : graph.sigmap(conn.second)) {
+						if (cell->input(conn.first))
+							src_bits.insert(bit);
+						if (cell->output(conn.first))
+							dst_bits.insert(bit);
 					}
-				continue;
+				if (!dst_bits.empty())
+					for (auto s : src_bits)
+						bit2ff[s] = tuple<SigBit, Cell*>(*dst_bits.begin(), cell);
 			}
 
-			for (auto s : src_bits)
-				for (auto d : dst_bits)
-					bit2bits[s][d] = cell;
-		}
-
-		maxlvl = -1;
-		maxbit = State::Sx;
-	}
-
-	void runner(SigBit bit, int level, SigBit from, Cell *via)
-	{
-		auto &bitinfo = bits.at(bit);
-
-		if (get<0>(bitinfo) >= level)
-			return;
-
-		if (busy.count(bit) > 0) {
-			log_warning("Detected loop at %s in %s\n", log_signal(bit), log_id(module));
-			return;
-		}
-
-		busy.insert(bit);
-		get<0>(bitinfo) = level;
-		get<1>(bitinfo) = from;
-		get<2>(bitinfo) = via;
-
-		if (level > maxlvl) {
-			maxlvl = level;
-			maxbit = bit;
-		}
-
-		if (bit2bits.count(bit)) {
-			for (auto &it : bit2bits.at(bit))
-				runner(it.first, level+1, bit, it.second);
-		}
+		std::vector<bool> mask(graph.size());
+		for (int n = 0; n < graph.size(); n++)
+			mask[n] = design->selected(module, graph.cells[n]);
 
-		busy.erase(bit);
-	}
+		// Levels are final once all cells of the drivers are done, cells of a
+		// loop are processed once in arbitrary order
+		for (auto &component : graph.sccs(&mask))
+		{
+			if (GetSize(component) > 1 || graph.has_self_loop(component.front())) {
+				auto &outputs = graph.outputs(component.front());
+				if (!outputs.empty())
+					log_warning("Detected loop at %s in %s\n", log_signal(graph.bits[outputs.front()]), log_id(module));
+			}
 
-	void printpath(SigBit bit)
-	{
-		auto &bitinfo = bits.at(bit);
-		if (get<2>(bitinfo)) {
-			printpath(get<1>(bitinfo));
-			log("%5d: %s (via %s)\n", get<0>(bitinfo), log_signal(bit), log_id(get<2>(bitinfo)));
-		} else {
-			log("%5d: %s\n", get<0>(bitinfo), log_signal(bit));
+			for (int n : component)
+			for (int s : graph.inputs(n)) {
+				auto src = bits.find(graph.bits[s]);
+				if (src == bits.end())
+					continue;
+				for (int d : graph.outputs(n)) {
+					auto dst = bits.find(graph.bits[d]);
+					if (dst == bits.end() || get<0>(dst->second) > get<0>(src->second))
+						continue;
+					dst->second = tuple<int, SigBit, Cell*>(get<0>(src->second) + 1, src->first, graph.cells[n]);
+				}
+			}
 		}
-	}
 
-	void run()
-	{
 		for (auto &it : bits)
-			if (get<0>(it.second) < 0)
-				runner(it.first, 0, State::Sx, nullptr);
+			if (get<0>(it.second) > maxlvl) {
+				maxlvl = get<0>(it.second);
+				maxbit = it.first;
+			}
 
 		log("\n");
 		log("Longest topological path in %s (length=%d):\n", log_id(module), maxlvl);
@@ -138,6 +125,24 @@ struct LtpWorker
 		if (bit2ff.count(maxbit))
 			log("%5s: %s (via %s)\n", "ff", log_signal(get<0>(bit2ff.at(maxbit))), log_id(get<1>(bit2ff.at(maxbit))));
 	}
+
+	void printpath(SigBit bit)
+	{
+		pool<SigBit> seen;
+		std::vector<SigBit> path;
+		for (; seen.insert(bit).second; bit = get<1>(bits.at(bit))) {
+			path.push_back(bit);
+			if (get<2>(bits.at(bit)) == nullptr)
+				break;
+		}
+		for (int i = GetSize(path) - 1; i >= 0; i--) {
+			auto &bitinfo = bits.at(path[i]);
+			if (get<2>(bitinfo))
+				log("%5d: %s (via %s)\n", get<0>(bitinfo), log_signal(path[i]), log_id(get<2>(bitinfo)));
+			else
+				log("%5d: %s\n", get<0>(bitinfo), log_signal(path[i]));
+		}
+	}
 };
 
 struct LtpPass : public Pass {
@@ -24,6 +24,7 @@
 #include "kernel/yosys.h"
 #include "kernel/celltypes.h"
 #include "kernel/sigtools.h"
+#include "kernel/cellgraph.h"
 #include "kernel/log_help.h"
 
 USING_YOSYS_NAMESPACE
@@ -33,72 +34,77 @@ struct SccWorker
 {
 	RTLIL::Design *design;
 	RTLIL::Module *module;
-	SigMap sigmap;
 	CellTypes ct, specifyCells;
 
-	pool<RTLIL::Cell*> workQueue;
-	dict<RTLIL::Cell*, pool<RTLIL::Cell*>> cellToNextCell;
-	dict<RTLIL::Cell*, RTLIL::SigSpec> cellToPrevSig, cellToNextSig;
+	std::unique_ptr<CellGraph> local_graph;
+	CellGraph *graph = nullptr;
 
-	dict<RTLIL::Cell*, std::pair<int, int>> cellLabels;
-	dict<RTLIL::Cell*, int> cellDepth;
-	pool<RTLIL::Cell*> cellsOnStack;
-	std::vector<RTLIL::Cell*> cellStack;
+	// State of the depth limited search (-max_depth)
+	std::vector<std::pair<int, int>> cellLabels;
+	std::vector<int> cellDepth;
+	std::vector<bool> cellsOnStack, visited;
+	std::vector<int> cellStack;
 	int labelCounter;
 
-	dict<RTLIL::Cell*, int> cell2scc;
 	std::vector<pool<RTLIL::Cell*>> sccList;
 
-	void run(RTLIL::Cell *cell, int depth, int maxDepth)
+	void found_scc(const std::vector<int> &nodes)
 	{
-		log_assert(workQueue.count(cell) > 0);
+		log("Found an SCC:");
+		pool<RTLIL::Cell*> scc;
+		for (int n : nodes) {
+			log(" %s", RTLIL::id2cstr(graph->cells[n]->name));
+			scc.insert(graph->cells[n]);
+		}
+		sccList.push_back(scc);
+		log("\n");
+	}
 
-		workQueue.erase(cell);
-		cellLabels[cell] = std::pair<int, int>(labelCounter, labelCounter);
+	void run(int node, int depth, int maxDepth)
+	{
+		visited[node] = true;
+		cellLabels[node] = std::pair<int, int>(labelCounter, labelCounter);
 		labelCounter++;
 
-		cellsOnStack.insert(cell);
-		cellStack.push_back(cell);
-
-		if (maxDepth >= 0)
-			cellDepth[cell] = depth;
+		cellsOnStack[node] = true;
+		cellStack.push_back(node);
+		cellDepth[node] = depth;
 
-		for (auto nextCell : cellToNextCell[cell])
-			if (cellLabels.count(nextCell) == 0) {
-				run(nextCell, depth+1, maxDepth);
-				cellLabels[cell].second = min(cellLabels[cell].second, cellLabels[nextCell].second);
+		auto successors = graph->successors(node);
+		for (auto it = successors.first; it != successors.second; ++it) {
+			int next = *it;
+			if (!visited[next]) {
+				run(next, depth+1, maxDepth);
+				cellLabels[node].second = min(cellLabels[node].second, cellLabels[next].second);
 			} else
-			if (cellsOnStack.count(nextCell) > 0 && (maxDepth < 0 || cellDepth[nextCell] + maxDepth > depth)) {
-					cellLabels[cell].second = min(cellLabels[cell].second, cellLabels[nextCell].second);
+			if (cellsOnStack[next] && cellDepth[next] + maxDepth > depth) {
+				cellLabels[node].second = min(cellLabels[node].second, cellLabels[next].second);
 			}
+		}
 
-		if (cellLabels[cell].first == cellLabels[cell].second)
+		if (cellLabels[node].first == cellLabels[node].second)
 		{
-			if (cellStack.back() == cell)
+			if (cellStack.back() == node)
 			{
 				cellStack.pop_back();
-				cellsOnStack.erase(cell);
+				cellsOnStack[node] = false;
 			}
 			else
 			{
-				log("Found an SCC:");
-				pool<RTLIL::Cell*> scc;
-				while (cellsOnStack.count(cell) > 0) {
-					RTLIL::Cell *c = cellStack.back();
+				std::vector<int> scc;
+				while (cellsOnStack[node]) {
+					int n = cellStack.back();
 					cellStack.pop_back();
-					cellsOnStack.erase(c);
-					log(" %s", RTLIL::id2cstr(c->name));
-					cell2scc[c] = sccList.size();
-					scc.insert(c);
+					cellsOnStack[n] = false;
+					scc.push_back(n);
 				}
-				sccList.push_back(scc);
-				log("\n");
+				found_scc(scc);
 			}
 		}
 	}
 
 	SccWorker(RTLIL::Design *design, RTLIL::Module *module, bool nofeedbackMode, bool allCellTypes, bool specifyMode, int maxDepth) :
-			design(design), module(module), sigmap(module)
+			design(design), module(module)
 	{
 		if (module->processes.size() > 0) {
 			log("Skipping module %s as it contains processes (run 'proc' pass first).\n", module->name);
@@ -113,6 +119,7 @@ struct SccWorker
 		}
 
 		// Discover boxes with specify rules in them, for special handling.
+		dict<RTLIL::IdString, pool<RTLIL::IdString>> specifySrcPorts, specifyDstPorts;
 		if (specifyMode) {
 			for (auto mod : design->modules())
 				if (mod->get_blackbox_attribute(false))
@@ -122,103 +129,76 @@ struct SccWorker
 							specifyCells.setup_module(mod);
 							break;
 						}
-		}
-
-		SigPool selectedSignals;
-		SigSet<RTLIL::Cell*> sigToNextCells;
-
-		for (auto &it : module->wires_)
-			if (design->selected(module, it.second))
-				selectedSignals.add(sigmap(RTLIL::SigSpec(it.second)));
-
-		for (auto &it : module->cells_)
-		{
-			RTLIL::Cell *cell = it.second;
-
-			if (!design->selected(module, cell))
-				continue;
-
-			if (!allCellTypes && !ct.cell_known(cell->type) && !specifyCells.cell_known(cell->type))
-				continue;
-
-			workQueue.insert(cell);
-
-			RTLIL::SigSpec inputSignals, outputSignals;
-
-			if (specifyCells.cell_known(cell->type)) {
-				// Use specify rules of the type `(X => Y) = NN` to look for asynchronous paths in boxes.
-				for (auto subcell : design->module(cell->type)->cells())
+			for (auto &it : specifyCells.cell_types)
+				for (auto subcell : design->module(it.first)->cells())
 				{
 					if (subcell->type != ID($specify2))
 						continue;
-
+					// Use specify rules of the type `(X => Y) = NN` to look for asynchronous paths in boxes.
 					for (auto bit : subcell->getPort(ID::SRC))
-					{
-						if (!bit.wire || !cell->hasPort(bit.wire->name))
-							continue;
-						inputSignals.append(sigmap(cell->getPort(bit.wire->name)));
-					}
-
+						if (bit.wire)
+							specifySrcPorts[it.first].insert(bit.wire->name);
 					for (auto bit : subcell->getPort(ID::DST))
-					{
-						if (!bit.wire || !cell->hasPort(bit.wire->name))
-							continue;
-						outputSignals.append(sigmap(cell->getPort(bit.wire->name)));
-					}
-				}
-			} else {
-				for (auto &conn : cell->connections())
-				{
-					bool isInput = true, isOutput = true;
-
-					if (ct.cell_known(cell->type)) {
-						isInput = ct.cell_input(cell->type, conn.first);
-						isOutput = ct.cell_output(cell->type, conn.first);
-					}
-
-					RTLIL::SigSpec sig = selectedSignals.extract(sigmap(conn.second));
-					sig.sort_and_unify();
-
-					if (isInput)
-						inputSignals.append(sig);
-					if (isOutput)
-						outputSignals.append(sig);
+						if (bit.wire)
+							specifyDstPorts[it.first].insert(bit.wire->name);
 				}
-			}
-
-			inputSignals.sort_and_unify();
-			outputSignals.sort_and_unify();
-
-			cellToPrevSig[cell] = inputSignals;
-			cellToNextSig[cell] = outputSignals;
-			sigToNextCells.insert(inputSignals, cell);
 		}
 
-		for (auto cell : workQueue)
-		{
-			sigToNextCells.find(cellToNextSig[cell], cellToNextCell[cell]);
-
-			if (!nofeedbackMode && cellToNextCell[cell].count(cell)) {
-				log("Found an SCC:");
-				pool<RTLIL::Cell*> scc;
-				log(" %s", RTLIL::id2cstr(cell->name));
-				cell2scc[cell] = sccList.size();
-				scc.insert(cell);
-				sccList.push_back(scc);
-				log("\n");
+		auto port_classifier = [ct = ct, specifySrcPorts, specifyDstPorts](RTLIL::Cell *cell, RTLIL::IdString port) {
+			if (specifySrcPorts.count(cell->type) || specifyDstPorts.count(cell->type)) {
+				int dir = 0;
+				if (specifySrcPorts.count(cell->type) && specifySrcPorts.at(cell->type).count(port))
+					dir |= CellGraph::PORT_INPUT;
+				if (specifyDstPorts.count(cell->type) && specifyDstPorts.at(cell->type).count(port))
+					dir |= CellGraph::PORT_OUTPUT;
+				return dir;
 			}
+			if (!ct.cell_known(cell->type))
+				return int(CellGraph::PORT_INOUT);
+			return (ct.cell_input(cell->type, port) ? CellGraph::PORT_INPUT : 0) |
+					(ct.cell_output(cell->type, port) ? CellGraph::PORT_OUTPUT : 0);
+		};
+
+		if (design->selected_whole_module(module->name) && !allCellTypes && !specifyMode) {
+			// The cell types do not depend on the design, the graph can be cached
+			graph = &CellGraph::get(module, "scc", [ct = ct](RTLIL::Cell *cell) { return ct.cell_known(cell->type); }, port_classifier);
+		} else {
+			SigPool selectedSignals;
+			SigMap sigmap(module);
+			for (auto wire : module->selected_wires())
+				selectedSignals.add(sigmap(wire));
+
+			local_graph = std::make_unique<CellGraph>(module,
+					[this, allCellTypes](RTLIL::Cell *cell) {
+						return this->design->selected(this->module, cell) &&
+								(allCellTypes || ct.cell_known(cell->type) || specifyCells.cell_known(cell->type));
+					},
+					port_classifier,
+					[selectedSignals](RTLIL::SigBit bit) { return selectedSignals.check(bit); });
+			graph = local_graph.get();
 		}
 
-		labelCounter = 0;
-		cellLabels.clear();
+		if (!nofeedbackMode)
+			for (int n = 0; n < graph->size(); n++)
+				if (graph->has_self_loop(n))
+					found_scc({n});
 
-		while (!workQueue.empty())
-		{
-			RTLIL::Cell *cell = *workQueue.begin();
-			log_assert(cellStack.size() == 0);
-			cellDepth.clear();
-
-			run(cell, 0, maxDepth);
+		if (maxDepth < 0) {
+			for (auto &component : graph->sccs())
+				if (GetSize(component) > 1)
+					found_scc(component);
+		} else {
+			labelCounter = 0;
+			cellLabels.assign(graph->size(), {0, 0});
+			cellDepth.assign(graph->size(), 0);
+			cellsOnStack.assign(graph->size(), false);
+			visited.assign(graph->size(), false);
+
+			for (int n = 0; n < graph->size(); n++)
+				if (!visited[n]) {
+					log_assert(cellStack.size() == 0);
+					run(n, 0, maxDepth);
+				}
 		}
 
 		log("Found %d SCCs in module %s.\n", int(sccList.size()), RTLIL::id2cstr(module->name));
@@ -229,21 +209,18 @@ struct SccWorker
 		for (int i = 0; i < int(sccList.size()); i++)
 		{
 			pool<RTLIL::Cell*> &cells = sccList[i];
-			RTLIL::SigSpec prevsig, nextsig, sig;
+			pool<int> prevbits, nextbits;
 
 			for (auto cell : cells) {
 				sel.selected_members[module->name].insert(cell->name);
-				prevsig.append(cellToPrevSig[cell]);
-				nextsig.append(cellToNextSig[cell]);
+				int n = graph->node(cell);
+				prevbits.insert(graph->inputs(n).begin(), graph->inputs(n).end());
+				nextbits.insert(graph->outputs(n).begin(), graph->outputs(n).end());
 			}
 
-			prevsig.sort_and_unify();
-			nextsig.sort_and_unify();
-			sig = prevsig.extract(nextsig);
-
-			for (auto &chunk : sig.chunks())
-				if (chunk.wire != NULL)
-					sel.selected_members[module->name].insert(chunk.wire->name);
+			for (int b : prevbits)
+				if (nextbits.count(b))
+					sel.selected_members[module->name].insert(graph->bits[b].wire->name);
 		}
 	}
 };
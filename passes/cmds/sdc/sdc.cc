@@ -6,6 +6,9 @@
 #include <tcl.h>
 #include <list>
 #include <optional>
+#include <regex>
+#include <algorithm>
+#include <climits>
 #include <iostream>
 
 #if TCL_MAJOR_VERSION < 9
@@ -88,6 +91,171 @@ struct BitSelection {
 	}
 };
 
+// TODO vectors
+// TODO cell arrays?
+struct MatchConfig {
+	enum MatchMode {
+		WILDCARD,
+		REGEX,
+	} match;
+	bool match_case;
+	enum HierMode {
+		FLAT,
+		TREE,
+	} hier;
+	MatchConfig(bool regexp_flag, bool nocase_flag, bool hierarchical_flag) :
+		match(regexp_flag ? REGEX : WILDCARD),
+		match_case(!nocase_flag),
+		hier(hierarchical_flag ? FLAT : TREE) { }
+	std::string cache_key(const std::string& pat_base) const {
+		std::string key;
+		key += match == REGEX ? 'r' : 'w';
+		key += match_case ? 'c' : 'i';
+		key += hier == FLAT ? 'f' : 't';
+		return key + pat_base;
+	}
+};
+
+// Splits a trailing bit selector off a pattern, "foo[3]" selects bit 3 of foo.
+// Brackets are part of the syntax of regular expressions, so for those only
+// a trailing "[<digits>]" is taken as a bit selector.
+static std::pair<std::string, BitSelection> split_bit_selector(const std::string& pat, bool regex) {
+	BitSelection bits = {};
+	size_t pos = pat.rfind('[');
+	bool is_selector = pos != std::string::npos;
+	if (is_selector && regex)
+		is_selector = pat.back() == ']' && pos + 2 < pat.size() &&
+				std::all_of(pat.begin() + pos + 1, pat.end() - 1, [](char c) { return std::isdigit(c); });
+	if (!is_selector) {
+		bits.set_all();
+		return std::make_pair(pat, bits);
+	}
+	std::string bit_selector = pat.substr(pos + 1, pat.rfind(']') - pos - 1);
+	for (auto c : bit_selector)
+		if (!std::isdigit(c))
+			log_error("Unsupported bit selector %s in SDC pattern %s\n",
+						bit_selector.c_str(), pat.c_str());
+	bits.set(std::stoi(bit_selector));
+	return std::make_pair(pat.substr(0, pos), bits);
+}
+
+// Glob match with '*' and '?'. Unless cross_sep is set, wildcards don't
+// match the hierarchy separator, so "u1/*" only matches objects in u1.
+static bool glob_match(const char* pat, const char* str, bool cross_sep, bool match_case) {
+	for (; *pat; pat++, str++) {
+		if (*pat == '*') {
+			while (*pat == '*')
+				pat++;
+			for (;; str++) {
+				if (glob_match(pat, str, cross_sep, match_case))
+					return true;
+				if (!*str || (!cross_sep && *str == '/'))
+					return false;
+			}
+		}
+		if (!*str)
+			return false;
+		if (*pat == '?') {
+			if (!cross_sep && *str == '/')
+				return false;
+			continue;
+		}
+		if (match_case ? *pat != *str : std::tolower(*pat) != std::tolower(*str))
+			return false;
+	}
+	return !*str;
+}
+
+// Index over the hierarchical names of one kind of design objects. Names are
+// kept sorted, so a pattern only has to be tested against the names sharing
+// its literal prefix. With -hierarchical, patterns are matched against the
+// leaf names at any level of hierarchy, which have an index of their own.
+// Results are cached per pattern, SDC files tend to repeat the same queries.
+template <typename T>
+struct SdcNameIndex {
+	const std::vector<std::pair<std::string, T>>* objects = nullptr;
+	// Number of trailing path components forming the leaf name: pins are
+	// named by their cell and pin, "cell/pin"
+	int leaf_depth = 1;
+	std::vector<std::pair<std::string, int>> by_name;
+	std::vector<std::pair<std::string, int>> by_leaf;
+	dict<std::string, std::vector<int>> cache;
+
+	SdcNameIndex(const std::vector<std::pair<std::string, T>>* objects, int leaf_depth) :
+		objects(objects), leaf_depth(leaf_depth) { }
+
+	void build() {
+		if (!by_name.empty() || objects->empty())
+			return;
+		by_name.reserve(objects->size());
+		by_leaf.reserve(objects->size());
+		for (int i = 0; i < GetSize(*objects); i++) {
+			const std::string& name = (*objects)[i].first;
+			size_t start = name.size();
+			for (int depth = 0; depth < leaf_depth; depth++) {
+				size_t pos = start > 0 ? name.rfind('/', start - 1) : std::string::npos;
+				if (pos == std::string::npos) {
+					start = 0;
+					break;
+				}
+				start = pos;
+			}
+			by_name.emplace_back(name, i);
+			by_leaf.emplace_back(start == 0 ? name : name.substr(start + 1), i);
+		}
+		std::sort(by_name.begin(), by_name.end());
+		std::sort(by_leaf.begin(), by_leaf.end());
+	}
+
+	void scan_prefix(const std::vector<std::pair<std::string, int>>& sorted, const std::string& pat_base, std::vector<int>& result) {
+		std::string prefix = pat_base.substr(0, pat_base.find_first_of("*?"));
+		auto it = std::lower_bound(sorted.begin(), sorted.end(), std::make_pair(prefix, INT_MIN));
+		for (; it != sorted.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+			if (prefix.size() == pat_base.size()) {
+				if (it->first.size() != prefix.size())
+					break;
+			} else if (!glob_match(pat_base.c_str() + prefix.size(), it->first.c_str() + prefix.size(), false, true))
+				continue;
+			result.push_back(it->second);
+		}
+	}
+
+	const std::vector<int>& lookup(const std::string& pat_base, const MatchConfig& config) {
+		std::string key = config.cache_key(pat_base);
+		auto cached = cache.find(key);
+		if (cached != cache.end())
+			return cached->second;
+
+		build();
+		const auto& sorted = config.hier == MatchConfig::FLAT ? by_leaf : by_name;
+		std::vector<int> result;
+		if (config.match == MatchConfig::REGEX) {
+			auto flags = std::regex_constants::ECMAScript;
+			if (!config.match_case)
+				flags |= std::regex_constants::icase;
+			std::regex re;
+			try {
+				re.assign(pat_base, flags);
+			} catch (const std::regex_error& e) {
+				log_error("Invalid regular expression %s in SDC pattern: %s\n", pat_base.c_str(), e.what());
+			}
+			for (auto& [name, idx] : sorted)
+				if (std::regex_match(name, re))
+					result.push_back(idx);
+		} else if (!config.match_case) {
+			for (auto& [name, idx] : sorted)
+				if (glob_match(pat_base.c_str(), name.c_str(), false, false))
+					result.push_back(idx);
+		} else {
+			scan_prefix(sorted, pat_base, result);
+		}
+		// Report matches in design order
+		std::sort(result.begin(), result.end());
+		result.erase(std::unique(result.begin(), result.end()), result.end());
+		return cache[key] = std::move(result);
+	}
+};
+
 struct SdcObjects {
 	enum CollectMode {
 		// getter-side object tracking with minimal features
@@ -115,6 +283,11 @@ struct SdcObjects {
 	dict<std::pair<std::string, CellPin>, BitSelection> constrained_pins;
 	dict<std::pair<std::string, Wire*>, BitSelection> constrained_nets;
 
+	SdcNameIndex<Wire*> port_index{&design_ports, 1};
+	SdcNameIndex<Cell*> cell_index{&design_cells, 1};
+	SdcNameIndex<CellPin> pin_index{&design_pins, 2};
+	SdcNameIndex<Wire*> net_index{&design_nets, 1};
+
 	void sniff_module(std::list<std::string>& hierarchy, Module* mod) {
 		std::string prefix;
 		for (auto mod_name : hierarchy) {
@@ -299,56 +472,6 @@ struct SdcObjects {
 	}
 };
 
-// TODO vectors
-// TODO cell arrays?
-struct MatchConfig {
-	enum MatchMode {
-		WILDCARD,
-		REGEX,
-	} match;
-	bool match_case;
-	enum HierMode {
-		FLAT,
-		TREE,
-	} hier;
-	MatchConfig(bool regexp_flag, bool nocase_flag, bool hierarchical_flag) :
-		match(regexp_flag ? REGEX : WILDCARD),
-		match_case(!nocase_flag),
-		hier(hierarchical_flag ? FLAT : TREE) { }
-};
-
-static std::pair<bool, BitSelection> matches(std::string name, const std::string& pat, const MatchConfig& config) {
-	(void)config;
-	bool got_bit_index = false;;
-	int bit_idx;
-	std::string pat_base = pat;
-	size_t pos = pat.rfind('[');
-	if (pos != std::string::npos) {
-		got_bit_index = true;
-		pat_base = pat.substr(0, pos);
-		std::string bit_selector = pat.substr(pos + 1, pat.rfind(']') - pos - 1);
-		for (auto c : bit_selector)
-			if (!std::isdigit(c))
-				log_error("Unsupported bit selector %s in SDC pattern %s\n",
-							bit_selector.c_str(), pat.c_str());
-		bit_idx = std::stoi(bit_selector);
-
-	}
-	BitSelection bits = {};
-	if (name == pat_base) {
-		if (got_bit_index) {
-			bits.set(bit_idx);
-			return std::make_pair(true, bits);
-		} else {
-			bits.set_all();
-			return std::make_pair(true, bits);
-
-		}
-	} else {
-		return std::make_pair(false, bits);
-	}
-}
-
 static int getter_graph_node(TclCall call) {
 	// Insert -getter-validated as first argument for passing to unknown
 	// to distinguish resolved and unknown getters.
@@ -526,22 +649,19 @@ void inspect_globals(Tcl_Interp* interp, bool dump_mode) {
 }
 
 // patterns -> (pattern-object-bit)s
-template <typename T, typename U>
+template <typename T>
 std::vector<std::tuple<std::string, T, BitSelection>>
-find_matching(U objects, const MatchConfig& config, const std::vector<std::string> &patterns, const char* obj_type)
+find_matching(SdcNameIndex<T>& index, const MatchConfig& config, const std::vector<std::string> &patterns, const char* obj_type)
 {
 	std::vector<std::tuple<std::string, T, BitSelection>> resolved;
 	for (auto pat : patterns) {
-		bool found = false;
-		for (auto [name, obj] : objects) {
-			auto [does_match, matching_bits] = matches(name, pat, config);
-			if (does_match) {
-				found = true;
-				resolved.push_back(std::make_tuple(name, obj, matching_bits));
-				// TODO add a continue statement, conditional on config
-			}
+		auto [pat_base, matching_bits] = split_bit_selector(pat, config.match == MatchConfig::REGEX);
+		const std::vector<int>& matched = index.lookup(pat_base, config);
+		for (int idx : matched) {
+			auto& [name, obj] = (*index.objects)[idx];
+			resolved.push_back(std::make_tuple(name, obj, matching_bits));
 		}
-		if (!found)
+		if (matched.empty())
 			log_warning("No matches in design for %s %s\n", obj_type, pat.c_str());
 	}
 	return resolved;
@@ -635,8 +755,7 @@ static int sdc_get_pins_cmd(ClientData data, Tcl_Interp *interp, int objc, Tcl_O
 
 	MatchConfig config(opts.regexp_flag, opts.nocase_flag, opts.hierarchical_flag);
 	std::vector<std::tuple<std::string, SdcObjects::CellPin, BitSelection>> resolved;
-	const auto& pins = objects->design_pins;
-	resolved = find_matching<SdcObjects::CellPin, decltype(pins)>(pins, config, opts.patterns, "pin");
+	resolved = find_matching(objects->pin_index, config, opts.patterns, "pin");
 
 	return getter_graph_node(TclCall{interp, objc, objv});
 }
@@ -651,8 +770,7 @@ static int sdc_get_ports_cmd(ClientData data, Tcl_Interp *interp, int objc, Tcl_
 
 	MatchConfig config(opts.regexp_flag, opts.nocase_flag, false);
 	std::vector<std::tuple<std::string, Wire*, BitSelection>> resolved;
-	const auto& ports = objects->design_ports;
-	resolved = find_matching<Wire*, decltype(ports)>(ports, config, opts.patterns, "port");
+	resolved = find_matching(objects->port_index, config, opts.patterns, "port");
 
 	for (auto [name, wire, matching_bits] : resolved) {
 		if (objects->collect_mode != SdcObjects::CollectMode::FullConstraint)
@@ -670,10 +788,9 @@ static int sdc_get_nets_cmd(ClientData data, Tcl_Interp *interp, int objc, Tcl_O
 	if (objects->collect_mode == SdcObjects::CollectMode::SimpleGetter)
 		opts.check_simple();
 
-	MatchConfig config(opts.regexp_flag, opts.nocase_flag, false);
+	MatchConfig config(opts.regexp_flag, opts.nocase_flag, opts.hierarchical_flag);
 	std::vector<std::tuple<std::string, Wire*, BitSelection>> resolved;
-	const auto& ports = objects->design_nets;
-	resolved = find_matching<Wire*, decltype(ports)>(ports, config, opts.patterns, "net");
+	resolved = find_matching(objects->net_index, config, opts.patterns, "net");
 
 	for (auto [name, wire, matching_bits] : resolved) {
 		if (objects->collect_mode != SdcObjects::CollectMode::FullConstraint)
@@ -683,6 +800,28 @@ static int sdc_get_nets_cmd(ClientData data, Tcl_Interp *interp, int objc, Tcl_O
 	return getter_graph_node(TclCall{interp, objc, objv});
 }
 
+static int sdc_get_cells_cmd(ClientData data, Tcl_Interp *interp, int objc, Tcl_Obj* const objv[])
+{
+	auto* objects = (SdcObjects*)data;
+	GetterOpts opts("get_cells", {"hierarchical", "hier", "regexp", "nocase", "hsc", "of_objects"});
+	opts.parse(objc, objv);
+	if (objects->collect_mode == SdcObjects::CollectMode::SimpleGetter)
+		opts.check_simple();
+	opts.check_simple_sep();
+
+	MatchConfig config(opts.regexp_flag, opts.nocase_flag, opts.hierarchical_flag);
+	std::vector<std::tuple<std::string, Cell*, BitSelection>> resolved;
+	resolved = find_matching(objects->cell_index, config, opts.patterns, "cell");
+
+	for (auto [name, cell, matching_bits] : resolved) {
+		(void)matching_bits;
+		if (objects->collect_mode != SdcObjects::CollectMode::FullConstraint)
+			objects->constrained_cells.insert(std::make_pair(name, cell));
+	}
+
+	return getter_graph_node(TclCall{interp, objc, objv});
+}
+
 class SDCInterpreter
 {
 private:
@@ -707,6 +846,7 @@ public:
 
 		objects = std::make_unique<SdcObjects>(design);
 		objects->collect_mode = SdcObjects::CollectMode::SimpleGetter;
+		Tcl_CreateObjCommand(interp, "get_cells", sdc_get_cells_cmd, (ClientData) objects.get(), NULL);
 		Tcl_CreateObjCommand(interp, "get_pins", sdc_get_pins_cmd, (ClientData) objects.get(), NULL);
 		Tcl_CreateObjCommand(interp, "get_nets", sdc_get_nets_cmd, (ClientData) objects.get(), NULL);
 		Tcl_CreateObjCommand(interp, "get_ports", sdc_get_ports_cmd, (ClientData) objects.get(), NULL);
@@ -724,6 +864,11 @@ struct SdcPass : public Pass {
 		log("\n");
 		log("Read the SDC file for the current design.\n");
 		log("\n");
+		log("The object getters (get_cells, get_nets, get_pins, get_ports) match glob\n");
+		log("patterns against hierarchical names. Wildcards don't match the '/' hierarchy\n");
+		log("separator. The names are indexed once per SDC file and query results are\n");
+		log("cached, so repeated queries are cheap.\n");
+		log("\n");
 		log("    -dump\n");
 		log("        Dump the referenced design objects.\n");
 		log("\n");
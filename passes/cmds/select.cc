@@ -140,6 +140,187 @@ static bool match_attr(const dict<RTLIL::IdString, RTLIL::Const> &attributes, co
 	return match_attr(attributes, match_expr, std::string(), 0);
 }
 
+// Per-module indexes for select patterns, built on first use. Members are
+// looked up by the literal prefix of a pattern (or the `$` suffix of
+// autogenerated names) and by cell type, attribute and parameter name,
+// instead of matching each pattern against every object. The indexes are
+// only valid as long as the design is not modified and are dropped at the
+// start of each select command.
+struct SelectIndex
+{
+	struct Names
+	{
+		std::vector<std::pair<std::string, RTLIL::IdString>> sorted;
+		dict<std::string, std::vector<RTLIL::IdString>> dollar_suffix;
+
+		void add(RTLIL::IdString id)
+		{
+			sorted.push_back({id.str(), id});
+			if (id[0] == '$')
+				dollar_suffix[strrchr(id.c_str(), '$')].push_back(id);
+		}
+
+		void sort()
+		{
+			std::sort(sorted.begin(), sorted.end());
+		}
+
+		// Calls `f` for all names with match_ids(name, pattern)
+		template<typename F>
+		void match(const std::string &pattern, F f) const
+		{
+			std::string prefix = pattern.substr(0, pattern.find_first_of("\\?*["));
+			auto scan = [&](const std::string &p) {
+				auto it = std::lower_bound(sorted.begin(), sorted.end(), std::make_pair(p, RTLIL::IdString()));
+				for (; it != sorted.end() && it->first.compare(0, p.size(), p) == 0; ++it)
+					if (match_ids(it->second, pattern))
+						f(it->second);
+			};
+			scan(prefix);
+			if (!prefix.empty())
+				scan("\\" + prefix);
+			if (!pattern.empty() && pattern[0] == '$') {
+				auto it = dollar_suffix.find(pattern);
+				if (it != dollar_suffix.end())
+					for (auto id : it->second)
+						if (id.str().compare(0, prefix.size(), prefix) != 0)
+							f(id);
+			}
+		}
+	};
+
+	typedef const dict<RTLIL::IdString, RTLIL::Const> *attrs_t;
+
+	struct ModuleIndex
+	{
+		bool names_built = false, attrs_built = false, conns_built = false;
+		Names wires, memories, cells, processes, types;
+		dict<RTLIL::IdString, std::vector<RTLIL::IdString>> cells_by_type;
+		// members having an attribute (parameter) of the given name
+		dict<RTLIL::IdString, std::vector<std::pair<RTLIL::IdString, attrs_t>>> attr_members, param_cells;
+		// cell ports connected to a wire, and wires connected to a wire by
+		// module connections (true if the other wire is on the lhs)
+		dict<RTLIL::Wire*, std::vector<std::pair<RTLIL::Cell*, RTLIL::IdString>>> wire_ports;
+		dict<RTLIL::Wire*, std::vector<std::pair<RTLIL::Wire*, bool>>> wire_conns;
+	};
+
+	dict<RTLIL::IdString, ModuleIndex> modules;
+
+	ModuleIndex &names(RTLIL::Module *mod)
+	{
+		ModuleIndex &idx = modules[mod->name];
+		if (idx.names_built)
+			return idx;
+		idx.names_built = true;
+		for (auto wire : mod->wires())
+			idx.wires.add(wire->name);
+		for (auto &it : mod->memories)
+			idx.memories.add(it.first);
+		for (auto cell : mod->cells()) {
+			idx.cells.add(cell->name);
+			auto &list = idx.cells_by_type[cell->type];
+			if (list.empty())
+				idx.types.add(cell->type);
+			list.push_back(cell->name);
+		}
+		for (auto &it : mod->processes)
+			idx.processes.add(it.first);
+		for (auto names : {&idx.wires, &idx.memories, &idx.cells, &idx.processes, &idx.types})
+			names->sort();
+		return idx;
+	}
+
+	ModuleIndex &attrs(RTLIL::Module *mod)
+	{
+		ModuleIndex &idx = modules[mod->name];
+		if (idx.attrs_built)
+			return idx;
+		idx.attrs_built = true;
+		for (auto wire : mod->wires())
+			for (auto &it : wire->attributes)
+				idx.attr_members[it.first].push_back({wire->name, &wire->attributes});
+		for (auto &mem : mod->memories)
+			for (auto &it : mem.second->attributes)
+				idx.attr_members[it.first].push_back({mem.first, &mem.second->attributes});
+		for (auto cell : mod->cells()) {
+			for (auto &it : cell->attributes)
+				idx.attr_members[it.first].push_back({cell->name, &cell->attributes});
+			for (auto &it : cell->parameters)
+				idx.param_cells[it.first].push_back({cell->name, &cell->parameters});
+		}
+		for (auto &proc : mod->processes)
+			for (auto &it : proc.second->attributes)
+				idx.attr_members[it.first].push_back({proc.first, &proc.second->attributes});
+		return idx;
+	}
+
+	ModuleIndex &conns(RTLIL::Module *mod)
+	{
+		ModuleIndex &idx = modules[mod->name];
+		if (idx.conns_built)
+			return idx;
+		idx.conns_built = true;
+		for (auto &conn : mod->connections())
+			for (int i = 0; i < GetSize(conn.first); i++) {
+				RTLIL::Wire *lhs = conn.first[i].wire, *rhs = conn.second[i].wire;
+				if (lhs == nullptr || rhs == nullptr)
+					continue;
+				idx.wire_conns[rhs].push_back({lhs, true});
+				idx.wire_conns[lhs].push_back({rhs, false});
+			}
+		for (auto cell : mod->cells())
+			for (auto &conn : cell->connections()) {
+				pool<RTLIL::Wire*> seen;
+				for (auto &chunk : conn.second.chunks())
+					if (chunk.wire != nullptr && seen.insert(chunk.wire).second)
+						idx.wire_ports[chunk.wire].push_back({cell, conn.first});
+			}
+		return idx;
+	}
+
+	// Calls `f` for the attributes (or parameters) of all members that
+	// may match the attribute expression, f(name, attributes)
+	template<typename F>
+	void match_attr_candidates(RTLIL::Module *mod, const std::string &match_expr, bool params, F f)
+	{
+		std::string name_pat = match_expr.substr(0, match_expr.find_first_of("<!=>"));
+		if (name_pat.find_first_of("*?[") == std::string::npos) {
+			ModuleIndex &idx = attrs(mod);
+			auto &index = params ? idx.param_cells : idx.attr_members;
+			std::vector<RTLIL::IdString> attr_names = {RTLIL::IdString("\\" + name_pat)};
+			if (!name_pat.empty() && (name_pat[0] == '\\' || name_pat[0] == '$'))
+				attr_names.push_back(name_pat);
+			for (auto &attr_name : attr_names) {
+				auto it = index.find(attr_name);
+				if (it != index.end())
+					for (auto &member : it->second)
+						f(member.first, member.second);
+			}
+			return;
+		}
+		if (params) {
+			for (auto cell : mod->cells())
+				f(cell->name, &cell->parameters);
+			return;
+		}
+		for (auto wire : mod->wires())
+			f(wire->name, &wire->attributes);
+		for (auto &it : mod->memories)
+			f(it.first, &it.second->attributes);
+		for (auto cell : mod->cells())
+			f(cell->name, &cell->attributes);
+		for (auto &it : mod->processes)
+			f(it.first, &it.second->attributes);
+	}
+
+	void clear()
+	{
+		modules.clear();
+	}
+};
+
+static SelectIndex select_index;
+
 static void select_all(RTLIL::Design *design, RTLIL::Selection &lhs)
 {
 	if (!lhs.selects_all())
@@ -452,9 +633,11 @@ static void select_op_intersect(RTLIL::Design *design, RTLIL::Selection &lhs, co
 			del_list.push_back(it.first);
 			continue;
 		}
+		// not selected as a whole, so rhs has a member set for this module
+		const pool<RTLIL::IdString> &rhs_members = rhs.selected_members.at(it.first);
 		std::vector<RTLIL::IdString> del_list2;
 		for (auto &it2 : it.second)
-			if (!rhs.selected_member(it.first, it2))
+			if (!rhs_members.count(it2))
 				del_list2.push_back(it2);
 		for (auto &it2 : del_list2)
 			it.second.erase(it2);
@@ -488,72 +671,91 @@ static int parse_comma_list(std::set<RTLIL::IdString> &tokens, const std::string
 	}
 }
 
-static int select_op_expand(RTLIL::Design *design, RTLIL::Selection &lhs, std::vector<expand_rule_t> &rules, std::set<RTLIL::IdString> &limits, int max_objects, char mode, CellTypes &ct, bool eval_only)
+// One level of expansion. Objects that were selected before the previous
+// level have already been expanded, so only the objects added in the
+// previous level (the frontier) are visited.
+static int select_op_expand(RTLIL::Design *design, RTLIL::Selection &lhs, dict<RTLIL::IdString, std::vector<RTLIL::IdString>> &frontier,
+		std::vector<expand_rule_t> &rules, std::set<RTLIL::IdString> &limits, int max_objects, char mode, CellTypes &ct, bool eval_only)
 {
 	int sel_objects = 0;
-	bool is_input, is_output;
+	dict<RTLIL::IdString, std::vector<RTLIL::IdString>> next_frontier;
+
 	for (auto mod : design->modules())
 	{
 		if (lhs.selected_whole_module(mod->name) || !lhs.selected_module(mod->name))
 			continue;
 
-		std::set<RTLIL::Wire*> selected_wires;
-		auto selected_members = lhs.selected_members[mod->name];
-
-		for (auto wire : mod->wires())
-			if (lhs.selected_member(mod->name, wire->name) && limits.count(wire->name) == 0)
-				selected_wires.insert(wire);
+		auto frontier_it = frontier.find(mod->name);
+		if (frontier_it == frontier.end())
+			continue;
 
-		for (auto &conn : mod->connections())
-		{
-			std::vector<RTLIL::SigBit> conn_lhs = conn.first.to_sigbit_vector();
-			std::vector<RTLIL::SigBit> conn_rhs = conn.second.to_sigbit_vector();
+		SelectIndex::ModuleIndex &idx = select_index.conns(mod);
+		auto &selected_members = lhs.selected_members[mod->name];
+		auto &added = next_frontier[mod->name];
 
-			for (size_t i = 0; i < conn_lhs.size(); i++) {
-				if (conn_lhs[i].wire == nullptr || conn_rhs[i].wire == nullptr)
-					continue;
-				if (mode != 'i' && selected_wires.count(conn_rhs[i].wire) && selected_members.count(conn_lhs[i].wire->name) == 0)
-					lhs.selected_members[mod->name].insert(conn_lhs[i].wire->name), sel_objects++, max_objects--;
-				if (mode != 'o' && selected_wires.count(conn_lhs[i].wire) && selected_members.count(conn_rhs[i].wire->name) == 0)
-					lhs.selected_members[mod->name].insert(conn_rhs[i].wire->name), sel_objects++, max_objects--;
+		auto select_member = [&](RTLIL::IdString name) {
+			if (selected_members.insert(name).second) {
+				added.push_back(name);
+				sel_objects++, max_objects--;
 			}
-		}
+		};
 
-		for (auto cell : mod->cells())
-		for (auto &conn : cell->connections())
-		{
-			char last_mode = '-';
+		auto port_matches = [&](RTLIL::Cell *cell, RTLIL::IdString port) {
 			if (eval_only && !yosys_celltypes.cell_evaluable(cell->type))
-				goto exclude_match;
+				return false;
+			char last_mode = '-';
 			for (auto &rule : rules) {
 				last_mode = rule.mode;
 				if (rule.cell_types.size() > 0 && rule.cell_types.count(cell->type) == 0)
 					continue;
-				if (rule.port_names.size() > 0 && rule.port_names.count(conn.first) == 0)
+				if (rule.port_names.size() > 0 && rule.port_names.count(port) == 0)
 					continue;
-				if (rule.mode == '+')
-					goto include_match;
-				else
-					goto exclude_match;
+				return rule.mode == '+';
 			}
-			if (last_mode == '+')
-				goto exclude_match;
-		include_match:
-			is_input = mode == 'x' || ct.cell_input(cell->type, conn.first);
-			is_output = mode == 'x' || ct.cell_output(cell->type, conn.first);
-			for (auto &chunk : conn.second.chunks())
-				if (chunk.wire != nullptr) {
-					if (max_objects != 0 && selected_wires.count(chunk.wire) > 0 && selected_members.count(cell->name) == 0)
-						if (mode == 'x' || (mode == 'i' && is_output) || (mode == 'o' && is_input))
-							lhs.selected_members[mod->name].insert(cell->name), sel_objects++, max_objects--;
-					if (max_objects != 0 && selected_members.count(cell->name) > 0 && limits.count(cell->name) == 0 && selected_members.count(chunk.wire->name) == 0)
-						if (mode == 'x' || (mode == 'i' && is_input) || (mode == 'o' && is_output))
-							lhs.selected_members[mod->name].insert(chunk.wire->name), sel_objects++, max_objects--;
+			return last_mode != '+';
+		};
+
+		for (auto name : frontier_it->second)
+		{
+			if (limits.count(name) != 0)
+				continue;
+
+			if (RTLIL::Wire *wire = mod->wire(name)) {
+				auto conns_it = idx.wire_conns.find(wire);
+				if (conns_it != idx.wire_conns.end())
+					for (auto &other : conns_it->second)
+						if (other.second ? mode != 'i' : mode != 'o')
+							select_member(other.first->name);
+
+				auto ports_it = idx.wire_ports.find(wire);
+				if (ports_it != idx.wire_ports.end())
+					for (auto &port : ports_it->second) {
+						RTLIL::Cell *cell = port.first;
+						if (max_objects == 0 || !port_matches(cell, port.second))
+							continue;
+						if (mode == 'x' || (mode == 'i' && ct.cell_output(cell->type, port.second)) || (mode == 'o' && ct.cell_input(cell->type, port.second)))
+							select_member(cell->name);
+					}
+				continue;
+			}
+
+			if (RTLIL::Cell *cell = mod->cell(name)) {
+				for (auto &conn : cell->connections()) {
+					if (!port_matches(cell, conn.first))
+						continue;
+					if (mode == 'i' && !ct.cell_input(cell->type, conn.first))
+						continue;
+					if (mode == 'o' && !ct.cell_output(cell->type, conn.first))
+						continue;
+					for (auto &chunk : conn.second.chunks())
+						if (chunk.wire != nullptr && max_objects != 0)
+							select_member(chunk.wire->name);
 				}
-		exclude_match:;
+			}
 		}
 	}
 
+	frontier.swap(next_frontier);
 	return sel_objects;
 }
 
@@ -650,8 +852,12 @@ static void select_op_expand(RTLIL::Design *design, const std::string &arg, char
 	}
 #endif
 
+	dict<RTLIL::IdString, std::vector<RTLIL::IdString>> frontier;
+	for (auto &it : work_stack.back().selected_members)
+		frontier[it.first].assign(it.second.begin(), it.second.end());
+
 	while (levels-- > 0 && rem_objects != 0) {
-		int num_objects = select_op_expand(design, work_stack.back(), rules, limits, rem_objects, mode, ct, eval_only);
+		int num_objects = select_op_expand(design, work_stack.back(), frontier, rules, limits, rem_objects, mode, ct, eval_only);
 		if (num_objects == 0)
 			break;
 		rem_objects -= num_objects;
@@ -884,24 +1090,17 @@ static void select_stmt(RTLIL::Design *design, std::string arg, bool disable_emp
 		}
 
 		if (arg_memb.compare(0, 2, "w:") == 0) {
-			for (auto wire : mod->wires())
-				if (match_ids(wire->name, arg_memb.substr(2)))
-					sel.selected_members[mod->name].insert(wire->name);
+			select_index.names(mod).wires.match(arg_memb.substr(2), [&](RTLIL::IdString name) {
+				sel.selected_members[mod->name].insert(name);
+			});
 		} else
-		if (arg_memb.compare(0, 2, "i:") == 0) {
-			for (auto wire : mod->wires())
-				if (wire->port_input && match_ids(wire->name, arg_memb.substr(2)))
-					sel.selected_members[mod->name].insert(wire->name);
-		} else
-		if (arg_memb.compare(0, 2, "o:") == 0) {
-			for (auto wire : mod->wires())
-				if (wire->port_output && match_ids(wire->name, arg_memb.substr(2)))
-					sel.selected_members[mod->name].insert(wire->name);
-		} else
-		if (arg_memb.compare(0, 2, "x:") == 0) {
-			for (auto wire : mod->wires())
-				if ((wire->port_input || wire->port_output) && match_ids(wire->name, arg_memb.substr(2)))
-					sel.selected_members[mod->name].insert(wire->name);
+		if (arg_memb.compare(0, 2, "i:") == 0 || arg_memb.compare(0, 2, "o:") == 0 || arg_memb.compare(0, 2, "x:") == 0) {
+			char kind = arg_memb[0];
+			select_index.names(mod).wires.match(arg_memb.substr(2), [&](RTLIL::IdString name) {
+				RTLIL::Wire *wire = mod->wire(name);
+				if ((kind != 'o' && wire->port_input) || (kind != 'i' && wire->port_output))
+					sel.selected_members[mod->name].insert(name);
+			});
 		} else
 		if (arg_memb.compare(0, 2, "s:") == 0) {
 			size_t delim = arg_memb.substr(2).find(':');
@@ -921,14 +1120,14 @@ static void select_stmt(RTLIL::Design *design, std::string arg, bool disable_emp
 			}
 		} else
 		if (arg_memb.compare(0, 2, "m:") == 0) {
-			for (auto &it : mod->memories)
-				if (match_ids(it.first, arg_memb.substr(2)))
-					sel.selected_members[mod->name].insert(it.first);
+			select_index.names(mod).memories.match(arg_memb.substr(2), [&](RTLIL::IdString name) {
+				sel.selected_members[mod->name].insert(name);
+			});
 		} else
 		if (arg_memb.compare(0, 2, "c:") == 0) {
-			for (auto cell : mod->cells())
-				if (match_ids(cell->name, arg_memb.substr(2)))
-					sel.selected_members[mod->name].insert(cell->name);
+			select_index.names(mod).cells.match(arg_memb.substr(2), [&](RTLIL::IdString name) {
+				sel.selected_members[mod->name].insert(name);
+			});
 		} else
 		if (arg_memb.compare(0, 2, "t:") == 0) {
 			if (arg_memb.compare(2, 1, "@") == 0) {
@@ -941,58 +1140,34 @@ static void select_stmt(RTLIL::Design *design, std::string arg, bool disable_emp
 					if (muster.selected_modules.count(cell->type))
 						sel.selected_members[mod->name].insert(cell->name);
 			} else {
-				for (auto cell : mod->cells())
-					if (match_ids(cell->type, arg_memb.substr(2)))
-						sel.selected_members[mod->name].insert(cell->name);
+				SelectIndex::ModuleIndex &idx = select_index.names(mod);
+				idx.types.match(arg_memb.substr(2), [&](RTLIL::IdString type) {
+					for (auto name : idx.cells_by_type.at(type))
+						sel.selected_members[mod->name].insert(name);
+				});
 			}
 		} else
 		if (arg_memb.compare(0, 2, "p:") == 0) {
-			for (auto &it : mod->processes)
-				if (match_ids(it.first, arg_memb.substr(2)))
-					sel.selected_members[mod->name].insert(it.first);
-		} else
-		if (arg_memb.compare(0, 2, "a:") == 0) {
-			for (auto wire : mod->wires())
-				if (match_attr(wire->attributes, arg_memb.substr(2)))
-					sel.selected_members[mod->name].insert(wire->name);
-			for (auto &it : mod->memories)
-				if (match_attr(it.second->attributes, arg_memb.substr(2)))
-					sel.selected_members[mod->name].insert(it.first);
-			for (auto cell : mod->cells())
-				if (match_attr(cell->attributes, arg_memb.substr(2)))
-					sel.selected_members[mod->name].insert(cell->name);
-			for (auto &it : mod->processes)
-				if (match_attr(it.second->attributes, arg_memb.substr(2)))
-					sel.selected_members[mod->name].insert(it.first);
+			select_index.names(mod).processes.match(arg_memb.substr(2), [&](RTLIL::IdString name) {
+				sel.selected_members[mod->name].insert(name);
+			});
 		} else
-		if (arg_memb.compare(0, 2, "r:") == 0) {
-			for (auto cell : mod->cells())
-				if (match_attr(cell->parameters, arg_memb.substr(2)))
-					sel.selected_members[mod->name].insert(cell->name);
+		if (arg_memb.compare(0, 2, "a:") == 0 || arg_memb.compare(0, 2, "r:") == 0) {
+			std::string match_expr = arg_memb.substr(2);
+			select_index.match_attr_candidates(mod, match_expr, arg_memb[0] == 'r', [&](RTLIL::IdString name, SelectIndex::attrs_t attributes) {
+				if (match_attr(*attributes, match_expr))
+					sel.selected_members[mod->name].insert(name);
+			});
 		} else {
 			std::string orig_arg_memb = arg_memb;
 			if (arg_memb.compare(0, 2, "n:") == 0)
 				arg_memb = arg_memb.substr(2);
-			for (auto wire : mod->wires())
-				if (match_ids(wire->name, arg_memb)) {
-					sel.selected_members[mod->name].insert(wire->name);
+			SelectIndex::ModuleIndex &idx = select_index.names(mod);
+			for (auto names : {&idx.wires, &idx.memories, &idx.cells, &idx.processes})
+				names->match(arg_memb, [&](RTLIL::IdString name) {
+					sel.selected_members[mod->name].insert(name);
 					arg_memb_found[orig_arg_memb] = true;
-				}
-			for (auto &it : mod->memories)
-				if (match_ids(it.first, arg_memb)) {
-					sel.selected_members[mod->name].insert(it.first);
-					arg_memb_found[orig_arg_memb] = true;
-				}
-			for (auto cell : mod->cells())
-				if (match_ids(cell->name, arg_memb)) {
-					sel.selected_members[mod->name].insert(cell->name);
-					arg_memb_found[orig_arg_memb] = true;
-				}
-			for (auto &it : mod->processes)
-				if (match_ids(it.first, arg_memb)) {
-					sel.selected_members[mod->name].insert(it.first);
-					arg_memb_found[orig_arg_memb] = true;
-				}
+				});
 		}
 	}
 
@@ -1037,6 +1212,7 @@ YOSYS_NAMESPACE_BEGIN
 void handle_extra_select_args(Pass *pass, const vector<string> &args, size_t argidx, size_t args_size, RTLIL::Design *design)
 {
 	work_stack.clear();
+	select_index.clear();
 	for (; argidx < args_size; argidx++) {
 		if (args[argidx].compare(0, 1, "-") == 0) {
 			if (pass != nullptr)
@@ -1060,6 +1236,7 @@ void handle_extra_select_args(Pass *pass, const vector<string> &args, size_t arg
 RTLIL::Selection eval_select_args(const vector<string> &args, RTLIL::Design *design)
 {
 	work_stack.clear();
+	select_index.clear();
 	for (auto &arg : args)
 		select_stmt(design, arg);
 	while (work_stack.size() > 1) {
@@ -1075,6 +1252,7 @@ RTLIL::Selection eval_select_args(const vector<string> &args, RTLIL::Design *des
 void eval_select_op(vector<RTLIL::Selection> &work, const string &op, RTLIL::Design *design)
 {
 	work_stack.swap(work);
+	select_index.clear();
 	select_stmt(design, op);
 	work_stack.swap(work);
 }
@@ -1345,6 +1523,7 @@ struct SelectPass : public Pass {
 		std::string set_name, unset_name, sel_str;
 
 		work_stack.clear();
+		select_index.clear();
 
 		size_t argidx;
 		for (argidx = 1; argidx < args.size(); argidx++)
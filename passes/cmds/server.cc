@@ -0,0 +1,445 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/yosys.h"
+#include "kernel/log_help.h"
+#include "kernel/cellaigs.h"
+#include "passes/techmap/libparse.h"
+#include "libs/json11/json11.hpp"
+
+#include <chrono>
+#include <sstream>
+
+#ifndef _WIN32
+#  include <sys/socket.h>
+#  include <sys/stat.h>
+#  include <sys/un.h>
+#  include <unistd.h>
+#  ifndef MSG_NOSIGNAL
+#    define MSG_NOSIGNAL 0
+#  endif
+#endif
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+using json11::Json;
+
+#ifndef _WIN32
+
+// Redirects the log to a buffer and selects the design of a request. The
+// previous state is restored when the guard goes out of scope, so that it is
+// also restored if a command throws something other than a command error.
+struct RequestStateGuard
+{
+	std::vector<FILE*> backup_log_files = log_files;
+	std::vector<std::ostream*> backup_log_streams = log_streams;
+	RTLIL::Design *backup_design = yosys_design;
+	bool backup_cmd_error_throw = log_cmd_error_throw;
+
+	RequestStateGuard(RTLIL::Design *design, std::ostream *buffer, bool quiet)
+	{
+		if (quiet) {
+			log_files.clear();
+			log_streams.clear();
+		}
+		log_streams.push_back(buffer);
+		log_outputs_changed();
+		yosys_design = design;
+		log_cmd_error_throw = true;
+	}
+
+	~RequestStateGuard()
+	{
+		yosys_design = backup_design;
+		log_cmd_error_throw = backup_cmd_error_throw;
+		log_files = backup_log_files;
+		log_streams = backup_log_streams;
+		log_outputs_changed();
+	}
+};
+
+// Requests and responses are JSON objects, one per line, like the protocol of
+// connect_rpc. Clients are served one at a time.
+struct ServerWorker
+{
+	RTLIL::Design *default_design;
+	std::map<std::string, RTLIL::Design*> designs;
+	bool quiet = false;
+	bool shutdown = false;
+	int request_count = 0;
+
+	ServerWorker(RTLIL::Design *default_design) : default_design(default_design) { }
+
+	~ServerWorker()
+	{
+		for (auto &it : designs)
+			delete it.second;
+	}
+
+	RTLIL::Design *get_design(const std::string &name)
+	{
+		if (name.empty())
+			return default_design;
+		auto &design = designs[name];
+		if (design == nullptr)
+			design = new RTLIL::Design;
+		return design;
+	}
+
+	static void run_script(RTLIL::Design *design, const std::string &script)
+	{
+		std::string buffer = script;
+		FILE *f = fmemopen(buffer.data(), buffer.size(), "r");
+		if (f == nullptr)
+			log_cmd_error("fmemopen failed: %s\n", strerror(errno));
+
+		FILE *backup_script_file = Frontend::current_script_file;
+		Frontend::current_script_file = f;
+
+		try {
+			std::string command;
+			while (fgetline(f, command)) {
+				while (!command.empty() && command.back() == '\\') {
+					std::string next_line;
+					if (!fgetline(f, next_line))
+						break;
+					command.pop_back();
+					command += next_line;
+				}
+				Pass::call(design, command);
+				design->check();
+			}
+			if (!command.empty()) {
+				Pass::call(design, command);
+				design->check();
+			}
+		} catch (...) {
+			Frontend::current_script_file = backup_script_file;
+			fclose(f);
+			throw;
+		}
+
+		Frontend::current_script_file = backup_script_file;
+		fclose(f);
+	}
+
+	Json run(const Json &request)
+	{
+		std::string design_name = request["design"].string_value();
+		RTLIL::Design *design = get_design(design_name);
+
+		std::map<std::string, int64_t> runtime_before;
+		for (auto &it : pass_register)
+			runtime_before[it.first] = it.second->runtime_ns;
+
+		std::ostringstream buffer;
+		std::string error;
+		double elapsed;
+		{
+			RequestStateGuard guard(design, &buffer, quiet);
+			auto start = std::chrono::steady_clock::now();
+			try {
+				if (!request["script"].string_value().empty())
+					run_script(design, request["script"].string_value());
+				for (auto &command : request["commands"].array_items()) {
+					Pass::call(design, command.string_value());
+					design->check();
+				}
+			} catch (log_cmd_error_exception) {
+				while (design->selection_stack.size() > 1)
+					design->pop_selection();
+				log_reset_stack();
+				error = log_last_error;
+				while (!error.empty() && error.back() == '\n')
+					error.pop_back();
+			}
+			elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		Json::object passes;
+		for (auto &it : pass_register) {
+			int64_t delta = it.second->runtime_ns - runtime_before[it.first];
+			if (delta > 0)
+				passes[it.first] = delta * 1e-9;
+		}
+
+		Json::object response = {
+			{ "design", design_name },
+			{ "log", buffer.str() },
+			{ "time", elapsed },
+			{ "passes", passes },
+		};
+		if (!error.empty())
+			response["error"] = error;
+		log("Request %d on design `%s' finished in %.3f seconds%s.\n", request_count, design_name.empty() ? "<default>" : design_name,
+				elapsed, error.empty() ? "" : " with an error");
+		return response;
+	}
+
+	Json handle(const Json &request)
+	{
+		request_count++;
+		std::string method = request["method"].string_value();
+
+		if (method == "run")
+			return run(request);
+
+		if (method == "designs") {
+			Json::array names;
+			for (auto &it : designs)
+				names.push_back(it.first);
+			return Json::object { { "designs", names } };
+		}
+
+		if (method == "drop") {
+			std::string name = request["design"].string_value();
+			auto it = designs.find(name);
+			if (it == designs.end())
+				return Json::object { { "error", stringf("No design named `%s'.", name) } };
+			delete it->second;
+			designs.erase(it);
+			return Json::object { };
+		}
+
+		if (method == "purge") {
+			LibertyAstCache::instance.cached.clear();
+			LibertyAstCache::instance.cached_stamps.clear();
+			techmap_cache_purge();
+			Aig::clear_cache();
+			return Json::object { };
+		}
+
+		if (method == "shutdown") {
+			shutdown = true;
+			return Json::object { };
+		}
+
+		return Json::object { { "error", stringf("Unknown method `%s'.", method) } };
+	}
+
+	static bool write_line(int fd, const std::string &data)
+	{
+		size_t offset = 0;
+		while (offset < data.size()) {
+			ssize_t result = ::send(fd, data.data() + offset, data.size() - offset, MSG_NOSIGNAL);
+			if (result == -1) {
+				if (errno == EINTR)
+					continue;
+				return false;
+			}
+			offset += result;
+		}
+		return true;
+	}
+
+	void serve_client(int fd)
+	{
+		std::string pending;
+		char block[4096];
+		while (!shutdown) {
+			size_t term_pos = pending.find('\n');
+			if (term_pos == std::string::npos) {
+				ssize_t result = ::read(fd, block, sizeof(block));
+				if (result == -1 && errno == EINTR)
+					continue;
+				if (result <= 0)
+					break;
+				pending.append(block, result);
+				continue;
+			}
+
+			std::string line = pending.substr(0, term_pos);
+			pending.erase(0, term_pos + 1);
+			if (line.find_first_not_of(" \t\r") == std::string::npos)
+				continue;
+
+			std::string parse_error;
+			Json request = Json::parse(line, parse_error);
+			Json response = request.is_object() ? handle(request) :
+					Json::object { { "error", stringf("Malformed request: %s", parse_error.empty() ? "not an object" : parse_error) } };
+
+			std::string data;
+			response.dump(data);
+			data += "\n";
+			if (!write_line(fd, data))
+				break;
+		}
+	}
+
+	void serve(const std::string &path)
+	{
+		struct sockaddr_un addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		if (path.size() >= sizeof(addr.sun_path))
+			log_cmd_error("Socket path `%s' is too long.\n", path);
+		strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+		int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (fd == -1)
+			log_cmd_error("socket failed: %s\n", strerror(errno));
+
+		// Only replace a stale socket, never another kind of file
+		struct stat st;
+		if (lstat(path.c_str(), &st) == 0) {
+			if (!S_ISSOCK(st.st_mode)) {
+				close(fd);
+				log_cmd_error("Refusing to replace `%s', which is not a socket.\n", path);
+			}
+			unlink(path.c_str());
+		}
+
+		// The socket accepts arbitrary commands, so only the owner may connect
+		mode_t old_umask = umask(077);
+		int result = bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+		umask(old_umask);
+		if (result != 0 || listen(fd, 4) != 0) {
+			int err = errno;
+			close(fd);
+			log_cmd_error("Can't listen on `%s': %s\n", path, strerror(err));
+		}
+
+		log("Listening on `%s'.\n", path);
+		log_flush();
+
+		while (!shutdown) {
+			int client = accept(fd, nullptr, nullptr);
+			if (client == -1) {
+				if (errno == EINTR)
+					continue;
+				log_warning("accept failed: %s\n", strerror(errno));
+				break;
+			}
+			serve_client(client);
+			close(client);
+		}
+
+		close(fd);
+		unlink(path.c_str());
+		log("Served %d requests.\n", request_count);
+	}
+};
+
+#endif
+
+struct ServerPass : public Pass {
+	ServerPass() : Pass("server", "serve commands over a Unix domain socket") { }
+	bool formatted_help() override {
+		auto *help = PrettyHelp::get_current();
+		help->set_group("passes/cmds");
+		return false;
+	}
+	void help() override
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    server [options] <path>\n");
+		log("\n");
+		log("Listen on the Unix domain socket <path> and execute the scripts sent by clients,\n");
+		log("until a client requests a shutdown. Designs, parsed Liberty files and techmap\n");
+		log("libraries stay in memory between requests, so that incremental flows don't pay\n");
+		log("for starting yosys and parsing the libraries again. This command is also run by\n");
+		log("'yosys --server <path>'.\n");
+		log("\n");
+		log("The socket is only accessible to the current user. An existing socket at <path>\n");
+		log("is replaced, other kinds of files are not.\n");
+		log("\n");
+		log("Requests and responses are JSON objects, one per line (as for connect_rpc).\n");
+		log("Clients are served one at a time. Each request has a \"method\" field:\n");
+		log("\n");
+		log("    {\"method\": \"run\", \"design\": <name>, \"script\": <text>, \"commands\": [...]}\n");
+		log("        Execute the script text and/or the list of commands on the named\n");
+		log("        design, which is created empty on first use. Without a name the\n");
+		log("        current design is used. The response contains the log output\n");
+		log("        (\"log\"), the wall clock time in seconds (\"time\") and the time spent\n");
+		log("        in each pass (\"passes\"). If a command fails, the remaining commands\n");
+		log("        are skipped and the error message is returned in \"error\".\n");
+		log("\n");
+		log("    {\"method\": \"designs\"}\n");
+		log("        List the names of the designs kept by the server.\n");
+		log("\n");
+		log("    {\"method\": \"drop\", \"design\": <name>}\n");
+		log("        Delete a named design.\n");
+		log("\n");
+		log("    {\"method\": \"purge\"}\n");
+		log("        Drop the cached Liberty files, techmap libraries and cell AIG models.\n");
+		log("\n");
+		log("    {\"method\": \"shutdown\"}\n");
+		log("        Stop the server after responding.\n");
+		log("\n");
+		log("Errors that are not command errors (see 'help shell') still terminate the\n");
+		log("server.\n");
+		log("\n");
+		log("    -q\n");
+		log("        do not print the output of requests to the console and log files\n");
+		log("\n");
+		log("    -nocache\n");
+		log("        do not enable caching of Liberty files (see 'help libcache') and of\n");
+		log("        techmap libraries (which are parsed again if the files change)\n");
+		log("\n");
+	}
+	void execute(std::vector<std::string> args, RTLIL::Design *design) override
+	{
+		bool quiet = false;
+		bool nocache = false;
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++) {
+			if (args[argidx] == "-q") {
+				quiet = true;
+				continue;
+			}
+			if (args[argidx] == "-nocache") {
+				nocache = true;
+				continue;
+			}
+			break;
+		}
+		if (argidx + 1 != args.size())
+			cmd_error(args, argidx, "Expected a single socket path.");
+		std::string path = args[argidx];
+
+#ifdef _WIN32
+		(void)design;
+		(void)quiet;
+		(void)nocache;
+		(void)path;
+		log_cmd_error("The server command is not supported on Windows.\n");
+#else
+		log_header(design, "Executing SERVER command.\n");
+
+		bool backup_cache_by_default = LibertyAstCache::instance.cache_by_default;
+		bool backup_techmap_cache = techmap_cache_enabled;
+		if (!nocache) {
+			LibertyAstCache::instance.cache_by_default = true;
+			techmap_cache_enabled = true;
+		}
+
+		ServerWorker worker(design);
+		worker.quiet = quiet;
+		worker.serve(path);
+
+		LibertyAstCache::instance.cache_by_default = backup_cache_by_default;
+		techmap_cache_enabled = backup_techmap_cache;
+		if (!nocache)
+			techmap_cache_purge();
+#endif
+	}
+} ServerPass;
+
+PRIVATE_NAMESPACE_END
@@ -19,7 +19,10 @@
 
 #include "kernel/yosys.h"
 #include "kernel/celltypes.h"
+#include "kernel/sigtools.h"
+#include "kernel/cellgraph.h"
 #include "kernel/log_help.h"
+#include "libs/json11/json11.hpp"
 
 #ifndef _WIN32
 #  include <dirent.h>
@@ -660,6 +663,338 @@ struct ShowWorker
 	}
 };
 
+// Condensed graph of a module for large designs: cells are collapsed into
+// clusters, edges between clusters are annotated with the number of bits they
+// carry. The graph of each module is built in memory and then written, either
+// as DOT or as JSON Lines (one object per line, modules first, then their
+// nodes and edges) that a viewer can process line by line.
+struct ShowClusterWorker
+{
+	enum ClusterMode {
+		CLUSTER_NONE,
+		CLUSTER_PREFIX,
+		CLUSTER_SCC,
+		CLUSTER_BUS
+	};
+
+	struct Node {
+		std::string name;
+		// Module port represented by the node, nullptr for cell nodes
+		RTLIL::Wire *port = nullptr;
+		// Node of a single cell that was not clustered
+		RTLIL::Cell *cell = nullptr;
+		int num_cells = 0;
+		dict<RTLIL::IdString, int> types;
+	};
+
+	CellTypes ct;
+	FILE *f;
+	RTLIL::Design *design;
+	RTLIL::Module *module;
+	ClusterMode mode;
+	int depth;
+	bool json;
+	int page_counter;
+
+	std::vector<Node> nodes;
+	dict<std::string, int> cluster_index;
+
+	static std::string escape_dot(const std::string &str)
+	{
+		std::string ret;
+		for (char ch : str) {
+			if (ch == '"' || ch == '\\')
+				ret += '\\';
+			ret += ch;
+		}
+		return ret;
+	}
+
+	// Hierarchical prefix of a (flattened) cell name, up to `depth` levels
+	std::string prefix_key(RTLIL::Cell *cell)
+	{
+		std::string name = cell->name.str();
+		if (name.compare(0, 9, "$flatten\\") == 0)
+			name = name.substr(8);
+		// The part of the name starting with '$' is an internal name
+		size_t end = name.find('$');
+		if (end == std::string::npos)
+			end = name.size();
+
+		std::string key;
+		size_t pos = 0;
+		for (int level = 0; level < depth; level++) {
+			size_t sep = name.find_first_of("./", pos);
+			if (sep == std::string::npos || sep >= end)
+				break;
+			key = name.substr(0, sep);
+			pos = sep + 1;
+		}
+		key.erase(std::remove(key.begin(), key.end(), '\\'), key.end());
+		return key;
+	}
+
+	// Name of the first public wire driven by the cell
+	std::string bus_key(RTLIL::Cell *cell, const SigMap &sigmap)
+	{
+		for (auto &conn : cell->connections()) {
+			if (!ct.cell_output(cell->type, conn.first))
+				continue;
+			for (auto &chunk : conn.second.chunks())
+				if (chunk.wire && chunk.wire->name.isPublic())
+					return RTLIL::unescape_id(chunk.wire->name);
+			for (auto bit : sigmap(conn.second))
+				if (bit.wire && bit.wire->name.isPublic())
+					return RTLIL::unescape_id(bit.wire->name);
+		}
+		return std::string();
+	}
+
+	int add_node(const std::string &name)
+	{
+		nodes.emplace_back();
+		nodes.back().name = name;
+		return GetSize(nodes) - 1;
+	}
+
+	int cluster_node(const std::string &key)
+	{
+		auto it = cluster_index.find(key);
+		if (it != cluster_index.end())
+			return it->second;
+		return cluster_index[key] = add_node(key.empty() ? "(top)" : key);
+	}
+
+	void add_cell(int node, RTLIL::Cell *cell)
+	{
+		nodes[node].num_cells++;
+		nodes[node].types[cell->type]++;
+	}
+
+	void cluster_cells(const std::vector<RTLIL::Cell*> &cells, const SigMap &sigmap, std::vector<int> &cell_node)
+	{
+		cell_node.assign(GetSize(cells), -1);
+
+		if (mode == CLUSTER_SCC) {
+			// Loops through flip-flops and memories are not combinational
+			auto combinational = [this](RTLIL::Cell *cell) {
+				return design->selected(module, cell) && !cell->is_builtin_ff() && !cell->is_mem_cell();
+			};
+			CellGraph graph(module, combinational,
+					[this](RTLIL::Cell *cell, RTLIL::IdString port) {
+						return ct.cell_output(cell->type, port) ? CellGraph::PORT_OUTPUT : CellGraph::PORT_INPUT;
+					});
+			dict<RTLIL::IdString, int> scc_node;
+			int scc_count = 0;
+			for (auto &component : graph.sccs()) {
+				if (GetSize(component) < 2)
+					continue;
+				int node = add_node(stringf("scc%d", scc_count++));
+				for (int n : component)
+					scc_node[graph.cells[n]->name] = node;
+			}
+			for (int i = 0; i < GetSize(cells); i++) {
+				auto it = scc_node.find(cells[i]->name);
+				if (it != scc_node.end())
+					cell_node[i] = it->second;
+			}
+		}
+
+		for (int i = 0; i < GetSize(cells); i++) {
+			RTLIL::Cell *cell = cells[i];
+			if (cell_node[i] < 0 && mode == CLUSTER_PREFIX)
+				cell_node[i] = cluster_node(prefix_key(cell));
+			if (cell_node[i] < 0 && mode == CLUSTER_BUS) {
+				std::string key = bus_key(cell, sigmap);
+				if (!key.empty())
+					cell_node[i] = cluster_node(key);
+			}
+			if (cell_node[i] < 0) {
+				cell_node[i] = add_node(RTLIL::unescape_id(cell->name));
+				nodes[cell_node[i]].cell = cell;
+			}
+			add_cell(cell_node[i], cell);
+		}
+	}
+
+	// The most frequent cell types of a cluster, at most `count` of them
+	std::vector<std::pair<RTLIL::IdString, int>> top_types(const Node &node, int count)
+	{
+		std::vector<std::pair<RTLIL::IdString, int>> types(node.types.begin(), node.types.end());
+		std::sort(types.begin(), types.end(), [](const std::pair<RTLIL::IdString, int> &a, const std::pair<RTLIL::IdString, int> &b) {
+			return a.second != b.second ? a.second > b.second : a.first.str() < b.first.str();
+		});
+		if (count >= 0 && GetSize(types) > count)
+			types.resize(count);
+		return types;
+	}
+
+	void write_dot(const std::vector<std::tuple<int, int, int>> &edges)
+	{
+		fprintf(f, "digraph \"%s\" {\n", escape_dot(RTLIL::unescape_id(module->name)).c_str());
+		fprintf(f, "label=\"%s\";\n", escape_dot(RTLIL::unescape_id(module->name)).c_str());
+		fprintf(f, "rankdir=\"LR\";\n");
+		fprintf(f, "remincross=true;\n");
+
+		for (int i = 0; i < GetSize(nodes); i++) {
+			const Node &node = nodes[i];
+			if (node.port) {
+				fprintf(f, "n%d [ shape=octagon, label=\"%s\" ];\n", i, escape_dot(node.name).c_str());
+			} else if (node.cell) {
+				fprintf(f, "n%d [ shape=box, label=\"%s\\n%s\" ];\n", i, escape_dot(node.name).c_str(),
+						escape_dot(RTLIL::unescape_id(node.cell->type)).c_str());
+			} else {
+				std::string label = stringf("%s\\n%d cells", escape_dot(node.name), node.num_cells);
+				for (auto &it : top_types(node, 4))
+					label += stringf("\\n%s x%d", escape_dot(RTLIL::unescape_id(it.first)), it.second);
+				if (GetSize(node.types) > 4)
+					label += "\\n...";
+				fprintf(f, "n%d [ shape=box3d, label=\"%s\" ];\n", i, label.c_str());
+			}
+		}
+
+		for (auto &[from, to, bits] : edges) {
+			if (bits > 1)
+				fprintf(f, "n%d:e -> n%d:w [ style=\"setlinewidth(3)\", label=\"<%d>\" ];\n", from, to, bits);
+			else
+				fprintf(f, "n%d:e -> n%d:w;\n", from, to);
+		}
+
+		fprintf(f, "}\n");
+	}
+
+	void write_json_record(const json11::Json::object &record)
+	{
+		std::string line = json11::Json(record).dump();
+		fprintf(f, "%s\n", line.c_str());
+	}
+
+	void write_json(const std::vector<std::tuple<int, int, int>> &edges)
+	{
+		write_json_record({
+			{"kind", "module"},
+			{"name", RTLIL::unescape_id(module->name)},
+			{"nodes", GetSize(nodes)},
+			{"edges", GetSize(edges)},
+		});
+
+		for (int i = 0; i < GetSize(nodes); i++) {
+			const Node &node = nodes[i];
+			json11::Json::object record = {
+				{"id", i},
+				{"name", node.name},
+			};
+			if (node.port) {
+				record["kind"] = "port";
+				record["direction"] = node.port->port_input ? (node.port->port_output ? "inout" : "input") : "output";
+				record["width"] = node.port->width;
+			} else {
+				record["kind"] = node.cell ? "cell" : "cluster";
+				record["cells"] = node.num_cells;
+				json11::Json::object types;
+				for (auto &it : top_types(node, -1))
+					types[RTLIL::unescape_id(it.first)] = it.second;
+				record["types"] = types;
+			}
+			write_json_record(record);
+		}
+
+		for (auto &[from, to, bits] : edges)
+			write_json_record({
+				{"kind", "edge"},
+				{"from", from},
+				{"to", to},
+				{"bits", bits},
+			});
+	}
+
+	void handle_module()
+	{
+		SigMap sigmap(module);
+		nodes.clear();
+		cluster_index.clear();
+
+		std::vector<RTLIL::Cell*> cells = module->selected_cells();
+		std::vector<int> cell_node;
+		cluster_cells(cells, sigmap, cell_node);
+
+		std::vector<int> port_nodes;
+		for (auto wire : module->selected_wires())
+			if (wire->port_id) {
+				port_nodes.push_back(add_node(RTLIL::unescape_id(wire->name)));
+				nodes.back().port = wire;
+			}
+
+		dict<RTLIL::SigBit, int> driver;
+		for (int n : port_nodes)
+			if (nodes[n].port->port_input)
+				for (auto bit : sigmap(nodes[n].port))
+					driver[bit] = n;
+		for (int i = 0; i < GetSize(cells); i++)
+			for (auto &conn : cells[i]->connections())
+				if (ct.cell_output(cells[i]->type, conn.first))
+					for (auto bit : sigmap(conn.second))
+						if (bit.wire)
+							driver[bit] = cell_node[i];
+
+		dict<std::pair<int, int>, int> edge_bits;
+		auto add_sink = [&](const RTLIL::SigSpec &sig, int sink) {
+			for (auto bit : sigmap(sig)) {
+				auto it = driver.find(bit);
+				if (bit.wire && it != driver.end() && it->second != sink)
+					edge_bits[{it->second, sink}]++;
+			}
+		};
+		for (int i = 0; i < GetSize(cells); i++)
+			for (auto &conn : cells[i]->connections())
+				if (!ct.cell_output(cells[i]->type, conn.first))
+					add_sink(conn.second, cell_node[i]);
+		for (int n : port_nodes)
+			if (nodes[n].port->port_output)
+				add_sink(nodes[n].port, n);
+
+		std::vector<std::tuple<int, int, int>> edges;
+		for (auto &it : edge_bits)
+			edges.emplace_back(it.first.first, it.first.second, it.second);
+		std::sort(edges.begin(), edges.end());
+
+		log("Dumping %d cells of module %s as %d nodes and %d edges to page %d.\n",
+				GetSize(cells), log_id(module), GetSize(nodes), GetSize(edges), ++page_counter);
+		if (json)
+			write_json(edges);
+		else
+			write_dot(edges);
+	}
+
+	ShowClusterWorker(FILE *f, RTLIL::Design *design, std::vector<RTLIL::Design*> &libs, ClusterMode mode, int depth, bool json) :
+			f(f), design(design), mode(mode), depth(depth), json(json)
+	{
+		ct.setup_internals();
+		ct.setup_internals_mem();
+		ct.setup_internals_anyinit();
+		ct.setup_stdcells();
+		ct.setup_stdcells_mem();
+		ct.setup_design(design);
+
+		for (auto lib : libs)
+			ct.setup_design(lib);
+
+		design->optimize();
+		page_counter = 0;
+		for (auto mod : design->selected_modules())
+		{
+			module = mod;
+			if (module->get_blackbox_attribute())
+				continue;
+			if (module->cells().size() == 0 && module->connections().empty()) {
+				log("Skipping empty module %s.\n", log_id(module->name));
+				continue;
+			}
+			handle_module();
+		}
+	}
+};
+
 struct ShowPass : public Pass {
 	ShowPass() : Pass("show", "generate schematics using graphviz") { }
 	bool formatted_help() override {
@@ -685,6 +1020,7 @@ struct ShowPass : public Pass {
 		log("        Generate a graphics file in the specified format. Use 'dot' to just\n");
 		log("        generate a .dot file, or other <format> strings such as 'svg' or 'ps'\n");
 		log("        to generate files in other formats (this calls the 'dot' command).\n");
+		log("        Use 'jsonl' to write the graph as JSON Lines (see -cluster below).\n");
 		log("\n");
 		log("    -lib <verilog_or_rtlil_file>\n");
 		log("        Use the specified library file for determining whether cell ports are\n");
@@ -751,6 +1087,31 @@ struct ShowPass : public Pass {
 		log("        adds href attribute to all items representing cells and wires, using\n");
 		log("        src attribute of origin\n");
 		log("\n");
+		log("    -cluster <mode>\n");
+		log("        draw a condensed graph for large designs, in which cells are collapsed\n");
+		log("        into clusters shown with their cell count and most frequent cell types.\n");
+		log("        Edges between clusters are labeled with the number of bits they carry.\n");
+		log("        The following modes are supported:\n");
+		log("          prefix - cells with the same hierarchical name prefix (of flattened\n");
+		log("                   designs), see -cluster_depth\n");
+		log("          scc    - cells of the same combinational loop (flip-flops and\n");
+		log("                   memories are never part of a loop)\n");
+		log("          bus    - cells driving the same public wire\n");
+		log("          none   - no clustering, one node per cell\n");
+		log("        Cells that don't belong to a cluster are shown as single nodes.\n");
+		log("        Processes are not shown. The graph of each module is built without the\n");
+		log("        per-port details of the normal schematic, and then written out.\n");
+		log("\n");
+		log("    -cluster_depth <n>\n");
+		log("        number of hierarchy levels in the name prefixes of '-cluster prefix'\n");
+		log("        (default: 1)\n");
+		log("\n");
+		log("With '-format jsonl' the condensed graph (by default with '-cluster none') is\n");
+		log("written to '<prefix>.jsonl' with one JSON object per line, so that a viewer\n");
+		log("can process it line by line. For each module there is an object with \"kind\"\n");
+		log("\"module\", followed by its nodes (\"port\", \"cell\" or \"cluster\") and\n");
+		log("\"edge\" objects referring to the node ids.\n");
+		log("\n");
 		log("When no <format> is specified, 'dot' is used. When no <format> and <viewer> is\n");
 		log("specified, 'xdot' is used to display the schematic (POSIX systems only).\n");
 		log("\n");
@@ -791,6 +1152,8 @@ struct ShowPass : public Pass {
 		bool flag_notitle = false;
 		bool flag_href = false;
 		bool custom_prefix = false;
+		std::string cluster_mode;
+		int cluster_depth = 1;
 		std::string background = "&";
 		RTLIL::IdString colorattr;
 
@@ -885,11 +1248,34 @@ struct ShowPass : public Pass {
 				flag_href = true;
 				continue;
 			}
+			if (arg == "-cluster" && argidx+1 < args.size()) {
+				cluster_mode = args[++argidx];
+				continue;
+			}
+			if (arg == "-cluster_depth" && argidx+1 < args.size()) {
+				cluster_depth = atoi(args[++argidx].c_str());
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
 
-		if (format != "ps" && format != "dot") {
+		ShowClusterWorker::ClusterMode mode = ShowClusterWorker::CLUSTER_NONE;
+		if (cluster_mode == "prefix")
+			mode = ShowClusterWorker::CLUSTER_PREFIX;
+		else if (cluster_mode == "scc")
+			mode = ShowClusterWorker::CLUSTER_SCC;
+		else if (cluster_mode == "bus")
+			mode = ShowClusterWorker::CLUSTER_BUS;
+		else if (!cluster_mode.empty() && cluster_mode != "none")
+			log_cmd_error("Unknown cluster mode `%s'.\n", cluster_mode);
+		if (cluster_depth < 1)
+			log_cmd_error("Cluster depth must be at least 1.\n");
+
+		bool json = format == "jsonl";
+		bool condensed = json || !cluster_mode.empty();
+
+		if (format != "ps" && format != "dot" && !json) {
 			int modcount = 0;
 			for (auto module : design->selected_modules()) {
 				if (module->get_blackbox_attribute())
@@ -917,10 +1303,13 @@ struct ShowPass : public Pass {
 		if (libs.size() > 0)
 			log_header(design, "Continuing show pass.\n");
 
-		std::string dot_file = stringf("%s.dot", prefix);
+		std::string dot_file = stringf("%s.%s", prefix, json ? "jsonl" : "dot");
 		std::string out_file = stringf("%s.%s", prefix, format.empty() ? "svg" : format);
 
-		log("Writing dot description to `%s'.\n", dot_file);
+		if (json)
+			log("Writing JSON graph to `%s'.\n", dot_file);
+		else
+			log("Writing dot description to `%s'.\n", dot_file);
 		FILE *f = fopen(dot_file.c_str(), "w");
 		if (custom_prefix)
 			yosys_output_files.insert(dot_file);
@@ -929,16 +1318,23 @@ struct ShowPass : public Pass {
 				delete lib;
 			log_cmd_error("Can't open dot file `%s' for writing.\n", dot_file);
 		}
-		ShowWorker worker(f, design, libs, colorSeed, flag_width, flag_wireshape, flag_signed, flag_stretch, flag_enum, flag_abbreviate, flag_notitle, flag_href, color_selections, label_selections, colorattr);
+		int page_counter;
+		if (condensed) {
+			ShowClusterWorker worker(f, design, libs, mode, cluster_depth, json);
+			page_counter = worker.page_counter;
+		} else {
+			ShowWorker worker(f, design, libs, colorSeed, flag_width, flag_wireshape, flag_signed, flag_stretch, flag_enum, flag_abbreviate, flag_notitle, flag_href, color_selections, label_selections, colorattr);
+			page_counter = worker.page_counter;
+		}
 		fclose(f);
 
 		for (auto lib : libs)
 			delete lib;
 
-		if (worker.page_counter == 0)
+		if (page_counter == 0)
 			log_cmd_error("Nothing there to show.\n");
 
-		if (format != "dot" && !format.empty()) {
+		if (format != "dot" && !format.empty() && !json) {
 			#ifdef _WIN32
 				// system()/cmd.exe does not understand single quotes on Windows.
 				#define DOT_CMD "dot -T%s \"%s\" > \"%s.new\" && move \"%s.new\" \"%s\""
@@ -19,232 +19,127 @@
  */
 
 #include "kernel/yosys.h"
-#include "kernel/sigtools.h"
-#include "kernel/timinginfo.h"
+#include "kernel/timinggraph.h"
 #include "kernel/log_help.h"
-#include <deque>
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
 struct StaWorker
 {
-	Design *design;
 	Module *module;
-	SigMap sigmap;
+	TimingGraph graph;
+	double latest_arrival = 0;
 
-	struct t_data {
-		Cell* driver;
-		IdString dst_port, src_port;
-		vector<tuple<SigBit,int,IdString>> fanouts;
-		SigBit backtrack;
-		t_data() : driver(nullptr) {}
-	};
-	dict<SigBit, t_data> data;
-	std::deque<SigBit> queue;
-	struct t_endpoint {
-		Cell *sink;
-		IdString port;
-		int required;
-		t_endpoint() : sink(nullptr), required(0) {}
-	};
-	dict<SigBit, t_endpoint> endpoints;
-
-	int maxarrival;
-	SigBit maxbit;
-
-	pool<SigBit> driven;
-
-	StaWorker(RTLIL::Module *module) : design(module->design), module(module), sigmap(module), maxarrival(0)
+	StaWorker(RTLIL::Module *module, const LibertyTiming *liberty, double period) : module(module), graph(module, liberty)
 	{
-		TimingInfo timing;
-
-		pool<IdString> unrecognised_cells;
-
-		for (auto cell : module->cells())
-		{
-			Module *inst_module = design->module(cell->type);
-			if (!inst_module) {
-				if (unrecognised_cells.insert(cell->type).second)
-					log_warning("Cell type '%s' not recognised! Ignoring.\n", log_id(cell->type));
-				continue;
-			}
-
-			if (!inst_module->get_blackbox_attribute()) {
-				log_warning("Cell type '%s' is not a black- nor white-box! Ignoring.\n", log_id(cell->type));
-				continue;
-			}
-
-			IdString derived_type = inst_module->derive(design, cell->parameters);
-			inst_module = design->module(derived_type);
-			log_assert(inst_module);
-
-			if (!timing.count(derived_type)) {
-				auto &t = timing.setup_module(inst_module);
-				if (t.has_inputs && t.comb.empty() && t.arrival.empty() && t.required.empty())
-					log_warning("Module '%s' has no timing arcs!\n", log_id(cell->type));
-			}
-
-			auto &t = timing.at(derived_type);
-			if (t.comb.empty() && t.arrival.empty() && t.required.empty())
-				continue;
-
-			pool<std::pair<SigBit,TimingInfo::NameBit>> src_bits, dst_bits;
-
-			for (auto &conn : cell->connections()) {
-				auto rhs = sigmap(conn.second);
-				for (auto i = 0; i < GetSize(rhs); i++) {
-					const auto &bit = rhs[i];
-					if (!bit.wire)
-						continue;
-					TimingInfo::NameBit namebit(conn.first,i);
-					if (cell->input(conn.first)) {
-						src_bits.insert(std::make_pair(bit,namebit));
-
-						auto it = t.required.find(namebit);
-						if (it == t.required.end())
-							continue;
-						auto r = endpoints.insert(bit);
-						if (r.second || r.first->second.required < it->second.first) {
-							r.first->second.sink = cell;
-							r.first->second.port = conn.first;
-							r.first->second.required = it->second.first;
-						}
-					}
-					if (cell->output(conn.first)) {
-						dst_bits.insert(std::make_pair(bit,namebit));
-						auto &d = data[bit];
-						d.driver = cell;
-						d.dst_port = conn.first;
-						driven.insert(bit);
+		graph.period = period;
+		graph.update();
+	}
 
-						auto it = t.arrival.find(namebit);
-						if (it == t.arrival.end())
-							continue;
-						const auto &s = it->second.second;
-						if (cell->hasPort(s.name)) {
-							auto s_bit = sigmap(cell->getPort(s.name)[s.offset]);
-							if (s_bit.wire)
-								data[s_bit].fanouts.emplace_back(bit,it->second.first,s.name);
-						}
-					}
-				}
-			}
+	static int rounded(double t)
+	{
+		return int(std::lround(t));
+	}
 
-			for (const auto &s : src_bits)
-				for (const auto &d : dst_bits) {
-					auto it = t.comb.find(TimingInfo::BitBit(s.second,d.second));
-					if (it == t.comb.end())
-						continue;
-					data[s.first].fanouts.emplace_back(d.first,it->second,s.second.name);
-				}
+	void log_path(const TimingGraph::Path &path, int endpoint_time, SigBit endpoint_bit)
+	{
+		if (path.sink)
+			log("  %6d %s (%s.%s)\n", endpoint_time, log_id(path.sink), log_id(path.sink->type), log_id(path.sink_port));
+		else {
+			log("  %6d (%s)\n", endpoint_time, endpoint_bit.wire->port_output ? "<primary output>" : "<unknown>");
+			if (!endpoint_bit.wire->port_output)
+				log_warning("Critical-path does not terminate in a recognised endpoint.\n");
+		}
+		for (int i = GetSize(path.points) - 1; i >= 0; i--) {
+			const auto &p = path.points[i];
+			if (p.cell) {
+				log("           %s\n", log_signal(p.bit));
+				log("  %6d %s (%s.%s->%s)\n", rounded(p.arrival), log_id(p.cell), log_id(p.cell->type), log_id(p.from_port), log_id(p.to_port));
+			} else
+				log("  %6d   %s (%s)\n", rounded(p.arrival), log_signal(p.bit), p.bit.wire->port_input ? "<primary input>" : "<unknown>");
 		}
+	}
 
-		for (auto port_name : module->ports) {
-			auto wire = module->wire(port_name);
-			if (wire->port_input) {
-				for (const auto &b : sigmap(wire)) {
-					queue.emplace_back(b);
-					driven.insert(b);
-				}
-				// All primary inputs to arrive at time zero
-				wire->set_intvec_attribute(ID::sta_arrival, std::vector<int>(GetSize(wire), 0));
+	void annotate()
+	{
+		SigMap &sigmap = graph.sigmap;
+		for (auto wire : module->wires()) {
+			std::vector<int> arrivals(GetSize(wire), -1);
+			bool reached = false;
+			for (int i = 0; i < GetSize(wire); i++) {
+				auto it = graph.bit_index.find(sigmap(SigBit(wire, i)));
+				if (it == graph.bit_index.end() || !graph.reached(it->second))
+					continue;
+				arrivals[i] = rounded(graph.arrival[it->second]);
+				reached = true;
 			}
-			if (wire->port_output)
-				for (const auto &b : sigmap(wire))
-					if (b.wire)
-						endpoints.insert(b);
+			if (reached)
+				wire->set_intvec_attribute(ID::sta_arrival, arrivals);
 		}
 	}
 
-	void run()
+	bool report_latest()
 	{
-		while (!queue.empty()) {
-			auto b = queue.front();
-			queue.pop_front();
-			auto it = data.find(b);
-			if (it == data.end())
+		// The latest arriving bit driven through a timing arc, including
+		// the setup time of endpoints
+		int maxnode = -1;
+		double maxarrival = 0;
+		for (int n = 0; n < GetSize(graph.bits); n++) {
+			if (!graph.reached(n) || graph.arrival_edge[n] < 0)
 				continue;
-			const auto& src_arrivals = b.wire->get_intvec_attribute(ID::sta_arrival);
-			log_assert(GetSize(src_arrivals) == GetSize(b.wire));
-			auto src_arrival = src_arrivals[b.offset];
-			for (const auto &d : it->second.fanouts) {
-				const auto &dst_bit = std::get<0>(d);
-				auto dst_arrivals = dst_bit.wire->get_intvec_attribute(ID::sta_arrival);
-				if (dst_arrivals.empty())
-					dst_arrivals = std::vector<int>(GetSize(dst_bit.wire), -1);
-				else
-					log_assert(GetSize(dst_arrivals) == GetSize(dst_bit.wire));
-				auto &dst_arrival = dst_arrivals[dst_bit.offset];
-				auto new_arrival = src_arrival + std::get<1>(d);
-				if (dst_arrival < new_arrival) {
-					auto dst_wire = dst_bit.wire;
-					dst_arrival = std::max(dst_arrival, new_arrival);
-					dst_wire->set_intvec_attribute(ID::sta_arrival, dst_arrivals);
-					queue.emplace_back(dst_bit);
-
-					data[dst_bit].backtrack = b;
-					data[dst_bit].src_port = std::get<2>(d);
-
-					auto it = endpoints.find(dst_bit);
-					if (it != endpoints.end())
-						new_arrival += it->second.required;
-					if (new_arrival > maxarrival && driven.count(b)) {
-						maxarrival = new_arrival;
-						maxbit = dst_bit;
-					}
-				}
-			}
+			double t = graph.arrival[n] + (graph.endpoint[n] ? graph.setup[n] : 0);
+			if (maxnode < 0 || t > maxarrival)
+				maxnode = n, maxarrival = t;
 		}
 
-		auto b = maxbit;
-		if (b == SigBit()) {
+		if (maxnode < 0) {
 			log("No timing paths found.\n");
-			return;
+			return false;
 		}
 
-		log("Latest arrival time in '%s' is %d:\n", log_id(module), maxarrival);
-		auto it = endpoints.find(maxbit);
-		if (it != endpoints.end() && it->second.sink)
-			log("  %6d %s (%s.%s)\n", maxarrival, log_id(it->second.sink), log_id(it->second.sink->type), log_id(it->second.port));
+		latest_arrival = maxarrival;
+		log("Latest arrival time in '%s' is %d:\n", log_id(module), rounded(maxarrival));
+		log_path(graph.path_to(maxnode), rounded(maxarrival), graph.bits[maxnode]);
+		return true;
+	}
+
+	void report_slack(int num_paths)
+	{
+		double wns = graph.worst_slack(), tns = 0;
+		int violations = 0;
+		for (int n = 0; n < GetSize(graph.bits); n++)
+			if (graph.endpoint[n] && graph.reached(n) && graph.slack(n) < 0)
+				tns += graph.slack(n), violations++;
+
+		log("\n");
+		log("Clock period: %d\n", rounded(graph.effective_period));
+		if (wns >= TimingGraph::INFINITY_TIME)
+			log("No constrained endpoints.\n");
 		else {
-			log("  %6d (%s)\n", maxarrival, b.wire->port_output ? "<primary output>" : "<unknown>");
-			if (!b.wire->port_output)
-				log_warning("Critical-path does not terminate in a recognised endpoint.\n");
+			log("Worst slack: %d\n", rounded(wns));
+			log("Total negative slack: %d (%d violating endpoint(s))\n", rounded(tns), violations);
 		}
-		auto jt = data.find(b);
-		while (jt != data.end()) {
-			int arrival = b.wire->get_intvec_attribute(ID::sta_arrival)[b.offset];
-			if (jt->second.driver) {
-				log("           %s\n", log_signal(b));
-				log("  %6d %s (%s.%s->%s)\n", arrival, log_id(jt->second.driver), log_id(jt->second.driver->type), log_id(jt->second.src_port), log_id(jt->second.dst_port));
-			}
-			else if (b.wire->port_input)
-				log("  %6d   %s (%s)\n", arrival, log_signal(b), "<primary input>");
-			else
-				log_abort();
-			b = jt->second.backtrack;
-			jt = data.find(b);
+
+		int index = 0;
+		for (auto &path : graph.critical_paths(num_paths)) {
+			log("\n");
+			log("Path %d: arrival %d, required %d, slack %d\n", ++index, rounded(path.arrival), rounded(path.required), rounded(path.slack));
+			log_path(path, rounded(path.arrival), path.points.back().bit);
 		}
+	}
 
+	void report_histogram()
+	{
 		std::map<int, unsigned> arrival_histogram;
-		for (const auto &i : endpoints) {
-			const auto &b = i.first;
-			if (!driven.count(b))
-				continue;
-
-			if (!b.wire->attributes.count(ID::sta_arrival)) {
-				log_warning("Endpoint %s.%s has no (* sta_arrival *) value.\n", log_id(module), log_signal(b));
+		for (int n = 0; n < GetSize(graph.bits); n++) {
+			if (!graph.endpoint[n] || !graph.driven[n])
 				continue;
-			}
-
-			auto arrival = b.wire->get_intvec_attribute(ID::sta_arrival)[b.offset];
-			if (arrival < 0) {
-				log_warning("Endpoint %s.%s has no (* sta_arrival *) value.\n", log_id(module), log_signal(b));
+			if (!graph.reached(n)) {
+				log_warning("Endpoint %s.%s has no (* sta_arrival *) value.\n", log_id(module), log_signal(graph.bits[n]));
 				continue;
 			}
-			arrival += i.second.required;
-			arrival_histogram[arrival]++;
+			arrival_histogram[rounded(graph.arrival[n] + graph.setup[n])]++;
 		}
 		// Adapted from https://github.com/YosysHQ/nextpnr/blob/affb12cc27ebf409eade062c4c59bb98569d8147/common/timing.cc#L946-L969
 		if (arrival_histogram.size() > 0) {
@@ -274,6 +169,7 @@ struct StaWorker
 	}
 };
 
+
 struct StaPass : public Pass {
 	StaPass() : Pass("sta", "perform static timing analysis") { }
 	bool formatted_help() override {
@@ -290,30 +186,92 @@ struct StaPass : public Pass {
 		log("This command performs static timing analysis on the design. (Only considers\n");
 		log("paths within a single module, so the design must be flattened.)\n");
 		log("\n");
+		log("Cell delays are taken from the NLDM tables of the given Liberty files, or\n");
+		log("otherwise from the abc9 box timing (specify blocks) of blackbox modules.\n");
+		log("Primary inputs arrive at time 0. Endpoints are primary outputs and cell pins\n");
+		log("with a setup constraint. The computed arrival times are stored in the\n");
+		log("(* sta_arrival *) attribute of the wires. The latest arrival time and the\n");
+		log("worst slack over all modules are stored in the scratchpad variables\n");
+		log("sta.latest_arrival and sta.worst_slack.\n");
+		log("\n");
+		log("    -liberty <file>\n");
+		log("        read cell timing from the given Liberty file. This option can be\n");
+		log("        used multiple times. Times are reported in picoseconds.\n");
+		log("\n");
+		log("    -period <time>\n");
+		log("        clock period used for the required times of all endpoints. Without\n");
+		log("        this option the latest endpoint arrival time is used.\n");
+		log("\n");
+		log("    -input_transition <time>\n");
+		log("        transition time at the primary inputs (default: 0)\n");
+		log("\n");
+		log("    -paths <N>\n");
+		log("        report slack and the N paths with the least slack\n");
+		log("\n");
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
 	{
 		log_header(design, "Executing STA pass (static timing analysis).\n");
 
-		/*
+		LibertyTiming liberty;
+		std::vector<std::string> liberty_files;
+		double period = 0;
+		int num_paths = -1;
+
 		size_t argidx;
 		for (argidx = 1; argidx < args.size(); argidx++) {
-			if (args[argidx] == "-TODO") {
+			if (args[argidx] == "-liberty" && argidx+1 < args.size()) {
+				liberty_files.push_back(args[++argidx]);
+				continue;
+			}
+			if (args[argidx] == "-period" && argidx+1 < args.size()) {
+				period = atof(args[++argidx].c_str());
+				continue;
+			}
+			if (args[argidx] == "-input_transition" && argidx+1 < args.size()) {
+				liberty.input_transition = atof(args[++argidx].c_str());
+				continue;
+			}
+			if (args[argidx] == "-paths" && argidx+1 < args.size()) {
+				num_paths = atoi(args[++argidx].c_str());
 				continue;
 			}
 			break;
 		}
-		*/
+		extra_args(args, argidx, design);
+
+		for (auto &file : liberty_files) {
+			rewrite_filename(file);
+			liberty.load(file);
+		}
 
-		extra_args(args, 1, design);
+		double latest_arrival = 0, worst_slack = TimingGraph::INFINITY_TIME;
+		bool found_paths = false;
 
 		for (Module *module : design->selected_modules())
 		{
 			if (module->has_processes_warn())
 				continue;
 
-			StaWorker worker(module);
-			worker.run();
+			StaWorker worker(module, liberty_files.empty() ? nullptr : &liberty, period);
+			if (worker.graph.has_loops)
+				log_warning("Module '%s' contains combinational loops, paths through them are cut.\n", log_id(module));
+			worker.annotate();
+			if (!worker.report_latest())
+				continue;
+			if (num_paths >= 0 || period > 0)
+				worker.report_slack(std::max(num_paths, 0));
+			worker.report_histogram();
+
+			latest_arrival = std::max(latest_arrival, worker.latest_arrival);
+			worst_slack = std::min(worst_slack, worker.graph.worst_slack());
+			found_paths = true;
+		}
+
+		if (found_paths) {
+			design->scratchpad_set_int("sta.latest_arrival", StaWorker::rounded(latest_arrival));
+			if (worst_slack < TimingGraph::INFINITY_TIME)
+				design->scratchpad_set_int("sta.worst_slack", StaWorker::rounded(worst_slack));
 		}
 	}
 } StaPass;
@@ -23,10 +23,12 @@
 #include "kernel/cost.h"
 #include "kernel/gzip.h"
 #include "kernel/log_help.h"
+#include "kernel/threading.h"
 #include "kernel/yosys.h"
 #include "libs/json11/json11.hpp"
 #include "passes/techmap/libparse.h"
 #include <charconv>
+#include <utility>
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
@@ -211,7 +213,7 @@ struct statdata_t {
 			if (!cell_area.empty()) {
 				// check if cell_area provides a area calculator
 				if (cell_area.count(cell->type)) {
-					cell_area_t cell_data = cell_area.at(cell->type);
+					cell_area_t cell_data = std::as_const(cell_area).at(cell->type);
 					if (cell_data.single_parameter_area.size() > 0) {
 						// assume that we just take the max of the A,B,Y ports
 
@@ -292,7 +294,7 @@ struct statdata_t {
 				}
 
 				if (cell_area.count(cell_type)) {
-					cell_area_t cell_data = cell_area.at(cell_type);
+					cell_area_t cell_data = std::as_const(cell_area).at(cell_type);
 					if (cell_data.is_sequential) {
 						sequential_area += cell_data.area;
 						local_sequential_area += cell_data.area;
@@ -744,19 +746,164 @@ statdata_t hierarchy_worker(std::map<RTLIL::IdString, statdata_t> &mod_stat, RTL
 	return mod_data;
 }
 
+// Local statistics of modules, kept across calls of the pass. An entry is
+// valid as long as the fingerprint of the module (content hash, cell types
+// and parameters, wire widths, memories, processes and the stat options) is
+// unchanged. Only wholly selected modules are cached.
+struct StatCache
+{
+	struct Entry {
+		uint64_t fingerprint;
+		statdata_t data;
+	};
+
+	dict<RTLIL::IdString, Entry> entries;
+
+	static uint64_t fingerprint(RTLIL::Module *mod, Hasher::hash_t options)
+	{
+		Hasher h;
+		h.eat(mod->get_content_hash());
+		h.eat(options);
+		// Cell types and parameters, wire widths, memories and processes are
+		// not covered by the content hash, and can be changed without
+		// invalidating it (e.g. by setparam)
+		for (auto cell : mod->cells()) {
+			h.eat(cell->type);
+			for (auto &it : cell->parameters) {
+				h.eat(it.first);
+				h.eat(it.second);
+			}
+		}
+		for (auto wire : mod->wires())
+			h.eat(wire->width);
+		for (auto &it : mod->memories) {
+			h.eat(it.first);
+			h.eat(it.second->width);
+			h.eat(it.second->size);
+		}
+		for (auto &it : mod->processes)
+			h.eat(it.first);
+		return (uint64_t(h.yield()) << 32) | mod->get_content_hash();
+	}
+
+	static Hasher::hash_t options_hash(bool width_mode, const dict<IdString, cell_area_t> &cell_area, const string &techname)
+	{
+		Hasher h;
+		h.eat(width_mode);
+		h.eat(techname);
+		for (auto &it : cell_area) {
+			h.eat(it.first);
+			uint64_t bits;
+			memcpy(&bits, &it.second.area, sizeof(bits));
+			h.eat(bits);
+			h.eat(it.second.is_sequential);
+			h.eat(GetSize(it.second.single_parameter_area));
+			h.eat(GetSize(it.second.double_parameter_area));
+			h.eat(GetSize(it.second.parameter_names));
+		}
+		return h.yield();
+	}
+};
+
+static StatCache stat_cache;
+
+// Computes the local statistics of `mods`, taking them from the cache where
+// possible. Uncached modules are processed in parallel, unless the options
+// require creating new IdStrings or updating `cell_area` (-width and
+// parameterised liberty areas).
+void compute_local_stats(RTLIL::Design *design, const std::vector<RTLIL::Module*> &mods, dict<RTLIL::IdString, statdata_t> &local_stat,
+			 bool width_mode, dict<IdString, cell_area_t> &cell_area, string techname)
+{
+	bool parallel_safe = !width_mode;
+	for (auto &it : cell_area)
+		if (!it.second.single_parameter_area.empty() || !it.second.double_parameter_area.empty() ||
+		    !it.second.parameter_names.empty())
+			parallel_safe = false;
+
+	Hasher::hash_t options = StatCache::options_hash(width_mode, cell_area, techname);
+	std::vector<RTLIL::Module*> pending;
+	std::vector<std::optional<uint64_t>> pending_fingerprint;
+	int hits = 0;
+
+	for (auto mod : mods) {
+		if (!design->selected_whole_module(mod->name)) {
+			pending.push_back(mod);
+			pending_fingerprint.push_back(std::nullopt);
+			continue;
+		}
+		uint64_t fp = StatCache::fingerprint(mod, options);
+		auto it = stat_cache.entries.find(mod->name);
+		if (it != stat_cache.entries.end() && it->second.fingerprint == fp) {
+			local_stat[mod->name] = it->second.data;
+			hits++;
+			continue;
+		}
+		pending.push_back(mod);
+		pending_fingerprint.push_back(fp);
+	}
+
+	std::vector<statdata_t> results(GetSize(pending));
+	int num_workers = parallel_safe && GetSize(pending) > 1 ? ThreadPool::pool_size(1, GetSize(pending) - 1) : 0;
+	ConcurrentQueue<int> jobs;
+	auto compute = [&](int i) { results[i] = statdata_t(design, pending[i], width_mode, cell_area, techname); };
+	{
+		ThreadPool pool(num_workers, [&](int) {
+				while (std::optional<int> i = jobs.pop_front())
+					compute(*i);
+			});
+		if (num_workers == 0) {
+			for (int i = 0; i < GetSize(pending); i++)
+				compute(i);
+		} else {
+			for (int i = 0; i < GetSize(pending); i++)
+				jobs.push_back(i);
+			jobs.close();
+			while (std::optional<int> i = jobs.pop_front())
+				compute(*i);
+		}
+	}
+
+	for (int i = 0; i < GetSize(pending); i++) {
+		if (pending_fingerprint[i])
+			stat_cache.entries[pending[i]->name] = {*pending_fingerprint[i], results[i]};
+		local_stat[pending[i]->name] = std::move(results[i]);
+	}
+
+	log_debug("Computed statistics of %d module(s) using %d worker thread(s), %d cached.\n", GetSize(pending), num_workers, hits);
+}
+
+// Adds the modules in the hierarchy below `mod` that hierarchy_builder()
+// needs statistics for.
+void collect_hierarchy(RTLIL::Design *design, RTLIL::Module *mod, const dict<IdString, cell_area_t> &cell_area,
+		       pool<RTLIL::Module*> &seen, std::vector<RTLIL::Module*> &mods)
+{
+	if (!seen.insert(mod).second)
+		return;
+	mods.push_back(mod);
+	for (auto cell : mod->selected_cells()) {
+		if (cell_area.count(cell->type) != 0)
+			continue;
+		RTLIL::Module *sub = design->module(cell->type);
+		if (sub != nullptr && !sub->attributes.count(ID::blackbox))
+			collect_hierarchy(design, sub, cell_area, seen, mods);
+	}
+}
+
 statdata_t hierarchy_builder(const RTLIL::Design *design, const RTLIL::Module *top_mod, std::map<RTLIL::IdString, statdata_t> &mod_stat,
-			     bool width_mode, dict<IdString, cell_area_t> &cell_area, string techname)
+			     const dict<RTLIL::IdString, statdata_t> &local_stat, const dict<IdString, cell_area_t> &cell_area)
 {
 	if (top_mod == nullptr)
 		top_mod = design->top_module();
-	statdata_t mod_data(design, top_mod, width_mode, cell_area, techname);
+	statdata_t mod_data = local_stat.at(top_mod->name);
 	for (auto cell : top_mod->selected_cells()) {
 		if (cell_area.count(cell->type) == 0) {
 			if (design->has(cell->type)) {
 				if (!(design->module(cell->type)->attributes.count(ID::blackbox))) {
-					// deal with modules
-					mod_data.add(
-					  hierarchy_builder(design, design->module(cell->type), mod_stat, width_mode, cell_area, techname));
+					// deal with modules, each submodule is only rolled up once
+					if (mod_stat.count(cell->type))
+						mod_data.add(mod_stat.at(cell->type));
+					else
+						mod_data.add(hierarchy_builder(design, design->module(cell->type), mod_stat, local_stat, cell_area));
 					mod_data.num_submodules_by_type[cell->type]++;
 					mod_data.submodules_area_by_type[cell->type] += mod_stat.at(cell->type).area;
 					mod_data.submodule_area += mod_stat.at(cell->type).area;
@@ -898,6 +1045,10 @@ struct StatPass : public Pass {
 		log("design.\n");
 		log("Extracts the area of cells from a liberty file, if provided.\n");
 		log("\n");
+		log("The statistics of wholly selected modules are cached between calls and are\n");
+		log("only recomputed for modules that changed. Modules are processed in parallel\n");
+		log("unless -width or parameterised liberty areas are used.\n");
+		log("\n");
 		log("    -top <module>\n");
 		log("        print design hierarchy with this module as top. if the design is fully\n");
 		log("        selected and a module has the 'top' attribute set, this module is used\n");
@@ -980,12 +1131,23 @@ struct StatPass : public Pass {
 			log("   \"modules\": {\n");
 		}
 
+		std::vector<RTLIL::Module*> stat_mods;
+		pool<RTLIL::Module*> seen_mods;
+		if (top_mod != nullptr)
+			collect_hierarchy(design, top_mod, cell_area, seen_mods, stat_mods);
+		else
+			for (auto mod : design->selected_modules())
+				collect_hierarchy(design, mod, cell_area, seen_mods, stat_mods);
+
+		dict<RTLIL::IdString, statdata_t> local_stat;
+		compute_local_stats(design, stat_mods, local_stat, width_mode, cell_area, techname);
+
 		if (top_mod != nullptr) {
-			hierarchy_builder(design, top_mod, mod_stat, width_mode, cell_area, techname);
+			hierarchy_builder(design, top_mod, mod_stat, local_stat, cell_area);
 		} else {
 			for (auto mod : design->selected_modules()) {
 				if (mod_stat.count(mod->name) == 0) {
-					hierarchy_builder(design, mod, mod_stat, width_mode, cell_area, techname);
+					hierarchy_builder(design, mod, mod_stat, local_stat, cell_area);
 				}
 			}
 		}
@@ -101,6 +101,7 @@ struct TeePass : public Pass {
 			}
 			break;
 		}
+		log_outputs_changed();
 
 		try {
 			std::vector<std::string> new_args(args.begin() + argidx, args.end());
@@ -111,6 +112,7 @@ struct TeePass : public Pass {
 			log_files = backup_log_files;
 			log_streams = backup_log_streams;
 			log_scratchpads = backup_log_scratchpads;
+			log_outputs_changed();
 			throw;
 		}
 
@@ -121,6 +123,7 @@ struct TeePass : public Pass {
 		log_files = backup_log_files;
 		log_streams = backup_log_streams;
 		log_scratchpads = backup_log_scratchpads;
+		log_outputs_changed();
 	}
 } TeePass;
 
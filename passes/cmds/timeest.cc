@@ -23,33 +23,91 @@
 #include "kernel/utils.h"
 #include "kernel/ff.h"
 #include "kernel/mem.h"
+#include "kernel/threading.h"
 
 #include <assert.h>
 #include <limits>
 
 USING_YOSYS_NAMESPACE
-template<> struct Yosys::hashlib::hash_ops<AigNode *> : Yosys::hashlib::hash_ptr_ops {};
-
 PRIVATE_NAMESPACE_BEGIN
 
 typedef long int arrivalint;
 const arrivalint INF_PAST = std::numeric_limits<arrivalint>::min();
 
+// levels with fewer nodes are processed on the main thread
+const int PARALLEL_CHUNK = 4096;
+
+// timing of a submodule as seen from its ports, computed once per module
+// and reused for all of its instances
+struct ModuleSummary {
+	std::vector<std::pair<IdString, int>> inputs, outputs;
+	// per input bit: longest path to an internal sample point
+	std::vector<arrivalint> sample;
+	// per output bit: longest path from any input in `support`, and
+	// the arrival of paths launched inside the module
+	std::vector<arrivalint> depth, launch;
+	std::vector<std::vector<int>> support;
+	// longest path between internal launch and sample points
+	arrivalint internal = INF_PAST;
+};
+
+struct EstimateSta;
+
+// shared between all modules analyzed by one timeest invocation
+struct TimeestCache {
+	dict<IdString, ModuleSummary> summaries;
+	pool<IdString> summaries_in_progress;
+
+	const Aig *aig(Cell *cell)
+	{
+		// find or build AIG model of combinational cell
+		const Aig &aig = Aig::cached(cell);
+		if (aig.name.empty())
+			log_error("Unsupported cell '%s' in module '%s'", log_id(cell->type), log_id(cell->module));
+		return &aig;
+	}
+
+	const ModuleSummary &summary(Module *m);
+};
+
 // each clock domain must have its own EstimateSta structure
 struct EstimateSta {
+	TimeestCache &cache;
 	SigMap sigmap;
 	Module *m;
 	std::optional<SigBit> clk;
 	bool top_port_endpoints = false;
+	// when computing a ModuleSummary, storage elements of all clock domains
+	// launch and sample
+	bool summary_mode = false;
 
-	dict<std::pair<RTLIL::IdString, dict<RTLIL::IdString, RTLIL::Const>>, Aig> aigs;
-	dict<Cell *, Aig *> cell_aigs;
+	dict<Cell *, const Aig *> cell_aigs;
 
 	std::vector<std::pair<Cell *, SigBit>> launchers;
 	std::vector<std::pair<Cell *, SigBit>> samplers;
 	bool all_paths = false;
 	bool select = false;
 
+	// the timing graph: nodes are signal bits, AIG nodes of combinational
+	// cells and port arcs of submodule instances
+	struct Node {
+		SigBit bit;
+		Cell *cell = nullptr;
+		const AigNode *aig_node = nullptr;
+	};
+	std::vector<Node> nodes;
+	dict<SigBit, int> bit_nodes;
+	std::vector<std::tuple<int, int, arrivalint>> edges;
+	std::vector<arrivalint> launch_time;
+	std::vector<int> sample_nodes;
+
+	// CSR adjacency and the nodes in topological order, grouped by level
+	std::vector<int> fanin_start, fanin_edges, fanout_start, fanout_edges;
+	std::vector<int> level_order, level_start;
+
+	// `levels` records the time after a clock edge after which a signal is stable
+	std::vector<arrivalint> levels;
+
 	void add_seq(Cell *cell, SigSpec launch, SigSpec sample)
 	{
 		sigmap.apply(launch);
@@ -74,21 +132,48 @@ struct EstimateSta {
 	}
 
 	// TODO: ignores clock polarity
-	EstimateSta(Module *m, std::optional<SigBit> clk, bool top_port_endpoints)
-		: sigmap(m), m(m), clk(clk), top_port_endpoints(top_port_endpoints)
+	EstimateSta(TimeestCache &cache, Module *m, std::optional<SigBit> clk, bool top_port_endpoints)
+		: cache(cache), sigmap(m), m(m), clk(clk), top_port_endpoints(top_port_endpoints)
 	{
 		if (clk.has_value())
 			sigmap.apply(*clk);
 	}
 
-	void run()
+	bool in_domain(SigBit bit)
 	{
-		log("\nModule %s\n", log_id(m));
-		if (clk.has_value())
-			log("Domain %s\n", log_signal(*clk));
+		return summary_mode || sigmap(bit) == clk;
+	}
+
+	int add_node(Cell *cell, const AigNode *aig_node)
+	{
+		nodes.emplace_back();
+		nodes.back().cell = cell;
+		nodes.back().aig_node = aig_node;
+		launch_time.push_back(INF_PAST);
+		return GetSize(nodes) - 1;
+	}
 
-		// first, we collect launch and sample points and convert the combinational logic to AIG
-		std::vector<Cell *> combinational;
+	int bit_node(SigBit bit)
+	{
+		bit = sigmap(bit);
+		auto it = bit_nodes.find(bit);
+		if (it != bit_nodes.end())
+			return it->second;
+		int n = add_node(nullptr, nullptr);
+		nodes[n].bit = bit;
+		bit_nodes[bit] = n;
+		return n;
+	}
+
+	void edge(int from, int to, arrivalint delay)
+	{
+		edges.emplace_back(from, to, delay);
+	}
+
+	// first, we collect launch and sample points and convert the logic to a graph
+	void build_graph()
+	{
+		std::vector<Cell *> combinational, instances;
 
 		for (auto cell : m->cells()) {
 			SigSpec launch, sample;
@@ -100,7 +185,7 @@ struct EstimateSta {
 								log_id(cell), log_id(cell->type));
 					continue;
 				}
-				if (ff.sig_clk != clk)
+				if (!in_domain(ff.sig_clk))
 					continue;
 				launch.append(ff.sig_q);
 				sample.append(ff.sig_d);
@@ -114,29 +199,14 @@ struct EstimateSta {
 				continue;
 			} else if (cell->type == ID($scopeinfo)) {
 				continue;
+			} else if (m->design->module(cell->type) && !m->design->module(cell->type)->get_blackbox_attribute()) {
+				instances.push_back(cell);
 			} else {
-				// find or build AIG model of combinational cell
-				auto fingerprint = std::make_pair(cell->type, cell->parameters);
-				if (!aigs.count(fingerprint)) {
-					aigs.emplace(fingerprint, Aig(cell));
-					if (aigs.at(fingerprint).name.empty()) {
-						log_error("Unsupported cell '%s' in module '%s'",
-								  log_id(cell->type), log_id(m));
-					}					
-				}
-
+				cell_aigs.emplace(cell, cache.aig(cell));
 				combinational.push_back(cell);
-				continue;
 			}
 		}
 
-		// since we're now taking reference into `aigs`, we can no longer modify it
-		// and thus have to fill `cell_aigs` in a separate loop
-		for (auto cell : combinational) {
-			auto fingerprint = std::make_pair(cell->type, cell->parameters);
-			cell_aigs.emplace(cell, &aigs.at(fingerprint));
-		}
-
 		// collect launch and sample points for memory cells
 		for (auto &mem : Mem::get_all_memories(m)) {
 			for (auto &rd : mem.rd_ports) {
@@ -144,12 +214,12 @@ struct EstimateSta {
 					log_error("Unsupported async memory port '%s'\n", log_id(rd.cell));
 					continue;
 				}
-				if (sigmap(rd.clk) != clk)
+				if (!in_domain(rd.clk))
 					continue;
 				add_seq(rd.cell, rd.data, {rd.addr, rd.srst, rd.en});
 			}
 			for (auto &wr : mem.wr_ports) {
-				if (sigmap(wr.clk) != clk)
+				if (!in_domain(wr.clk))
 					continue;
 				add_seq(wr.cell, {}, {wr.en, wr.addr, wr.data});
 			}
@@ -171,95 +241,271 @@ struct EstimateSta {
 			add_seq(nullptr, all_inputs, all_outputs);
 		}
 
-		// now we toposort the combinational logic
-
-		// each toposort node is either a SigBit or a pair of Cell * / AigNode *
-		TopoSort<std::tuple<SigBit, Cell *, AigNode *>> topo;
-
-		auto desc_aig = [&](Cell *cell, AigNode &node) {
-			return std::make_tuple(RTLIL::S0, cell, &node);
-		};
-		auto desc_sig = [&](SigBit bit) {
-			return std::make_tuple(sigmap(bit), (Cell *) NULL, (AigNode *) NULL);
-		};
+		for (auto &pair : launchers)
+			launch_time[bit_node(pair.second)] = 0;
+		for (auto &pair : samplers)
+			sample_nodes.push_back(bit_node(pair.second));
 
 		// collect edges of the AIG graph
 		for (auto cell : combinational) {
-			assert(cell_aigs.count(cell));
-			Aig &aig = *cell_aigs.at(cell);
-			for (auto &node : aig.nodes) {
+			const Aig &aig = *cell_aigs.at(cell);
+			int base = GetSize(nodes);
+			for (auto &node : aig.nodes)
+				add_node(cell, &node);
+			for (int i = 0; i < GetSize(aig.nodes); i++) {
+				auto &node = aig.nodes[i];
 				if (!node.portname.empty()) {
-					topo.edge(
-						desc_sig(cell->getPort(node.portname)[node.portbit]),
-						desc_aig(cell, node)
-					);
+					edge(bit_node(cell->getPort(node.portname)[node.portbit]), base + i, 0);
 				} else if (node.left_parent < 0 && node.right_parent < 0) {
 					// constant, nothing to do
 				} else {
-					topo.edge(
-						desc_aig(cell, aig.nodes[node.left_parent]),
-						desc_aig(cell, node)
-					);
-					topo.edge(
-						desc_aig(cell, aig.nodes[node.right_parent]),
-						desc_aig(cell, node)
-					);
+					// each AIG node adds a cell-specific delay
+					edge(base + node.left_parent, base + i, cell_type_factor(cell->type));
+					edge(base + node.right_parent, base + i, cell_type_factor(cell->type));
 				}
+				for (auto &oport : node.outports)
+					edge(base + i, bit_node(cell->getPort(oport.first)[oport.second]), 0);
+			}
+		}
 
-				for (auto &oport : node.outports) {
-					topo.edge(
-						desc_aig(cell, node),
-						desc_sig(cell->getPort(oport.first)[oport.second])
-					);
-				}
+		// submodule instances are represented by their summary
+		for (auto cell : instances) {
+			const ModuleSummary &summary = cache.summary(m->design->module(cell->type));
+			auto port_bit = [&](const std::pair<IdString, int> &port) {
+				if (!cell->hasPort(port.first) || port.second >= GetSize(cell->getPort(port.first)))
+					return -1;
+				return bit_node(cell->getPort(port.first)[port.second]);
+			};
+			std::vector<int> input_nodes;
+			for (auto &port : summary.inputs)
+				input_nodes.push_back(port_bit(port));
+			for (int i = 0; i < GetSize(summary.inputs); i++) {
+				if (summary.sample[i] == INF_PAST || input_nodes[i] < 0)
+					continue;
+				int n = add_node(cell, nullptr);
+				edge(input_nodes[i], n, summary.sample[i]);
+				sample_nodes.push_back(n);
+			}
+			for (int i = 0; i < GetSize(summary.outputs); i++) {
+				int out = port_bit(summary.outputs[i]);
+				if (out < 0 || (summary.launch[i] == INF_PAST && summary.support[i].empty()))
+					continue;
+				int n = add_node(cell, nullptr);
+				launch_time[n] = summary.launch[i];
+				for (int j : summary.support[i])
+					if (input_nodes[j] >= 0)
+						edge(input_nodes[j], n, summary.depth[i]);
+				edge(n, out, 0);
+			}
+			if (summary.internal != INF_PAST) {
+				int n = add_node(cell, nullptr);
+				launch_time[n] = summary.internal;
+				sample_nodes.push_back(n);
 			}
 		}
+	}
 
-		if (!topo.sort())
+	// now we levelize the graph
+	void levelize()
+	{
+		int num_nodes = GetSize(nodes);
+		auto make_csr = [&](std::vector<int> &start, std::vector<int> &list, bool by_from) {
+			start.assign(num_nodes + 1, 0);
+			for (auto &e : edges)
+				start[(by_from ? std::get<0>(e) : std::get<1>(e)) + 1]++;
+			for (int n = 0; n < num_nodes; n++)
+				start[n + 1] += start[n];
+			list.resize(GetSize(edges));
+			std::vector<int> fill(start.begin(), start.end() - 1);
+			for (int i = 0; i < GetSize(edges); i++)
+				list[fill[by_from ? std::get<0>(edges[i]) : std::get<1>(edges[i])]++] = i;
+		};
+		make_csr(fanin_start, fanin_edges, false);
+		make_csr(fanout_start, fanout_edges, true);
+
+		std::vector<int> pending(num_nodes), node_level(num_nodes, 0);
+		std::vector<int> queue;
+		for (int n = 0; n < num_nodes; n++) {
+			pending[n] = fanin_start[n + 1] - fanin_start[n];
+			if (pending[n] == 0)
+				queue.push_back(n);
+		}
+		int max_level = 0;
+		for (int q = 0; q < GetSize(queue); q++) {
+			int n = queue[q];
+			max_level = std::max(max_level, node_level[n]);
+			for (int i = fanout_start[n]; i < fanout_start[n + 1]; i++) {
+				int to = std::get<1>(edges[fanout_edges[i]]);
+				node_level[to] = std::max(node_level[to], node_level[n] + 1);
+				if (--pending[to] == 0)
+					queue.push_back(to);
+			}
+		}
+		if (GetSize(queue) != num_nodes)
 			log_error("Module '%s' contains combinational loops", log_id(m));
-		
-		// now we determine how long it takes for signals to stabilize
-		
-		// `levels` records the time after a clock edge after which a signal is stable
-		dict<std::tuple<SigBit, Cell *, AigNode *>, arrivalint> levels;
-
-		for (auto node : topo.sorted)
-			levels[node] = INF_PAST;
-
-		// launch points are at 0 by definition
-		for (auto pair : launchers)
-			levels[desc_sig(pair.second)] = 0;
-
-		for (auto node : topo.sorted) {
-			AigNode *aig_node = std::get<2>(node);
-			if (aig_node) {
-				Cell *cell = std::get<1>(node);
-				Aig &aig = *cell_aigs.at(cell);
-				if (!aig_node->portname.empty()) {
-					// for a cell port, copy `levels` value from port bit
-					SigBit bit = cell->getPort(aig_node->portname)[aig_node->portbit];
-					levels[node] = levels[desc_sig(bit)];
-				} else if (aig_node->left_parent < 0 && aig_node->right_parent < 0) {
-					// constant, nothing to do
-				} else {
-					// for each AIG node, find maximum of parents and add a cell-specific delay
-					int left = levels[desc_aig(cell, aig.nodes[aig_node->left_parent])];
-					int right = levels[desc_aig(cell, aig.nodes[aig_node->right_parent])];
-					levels[node] = (std::max(left, right) + cell_type_factor(cell->type));
+
+		level_start.assign(max_level + 2, 0);
+		for (int n = 0; n < num_nodes; n++)
+			level_start[node_level[n] + 1]++;
+		for (int l = 0; l <= max_level; l++)
+			level_start[l + 1] += level_start[l];
+		level_order.resize(num_nodes);
+		std::vector<int> fill(level_start.begin(), level_start.end() - 1);
+		for (int n : queue)
+			level_order[fill[node_level[n]]++] = n;
+	}
+
+	// Calls `fn` for all nodes, level by level (in reverse for `backward`).
+	// Nodes of one level only depend on earlier levels, large levels are
+	// split between worker threads.
+	template<typename F>
+	void for_each_level(bool backward, F fn)
+	{
+		int num_levels = GetSize(level_start) - 1;
+		int num_workers = GetSize(nodes) >= 2 * PARALLEL_CHUNK ? ThreadPool::pool_size(1, INT_MAX) : 0;
+		ConcurrentQueue<std::pair<int, int>> jobs;
+		ConcurrentQueue<int> finished;
+		ThreadPool pool(num_workers, [&](int) {
+				while (std::optional<std::pair<int, int>> job = jobs.pop_front()) {
+					for (int i = job->first; i < job->second; i++)
+						fn(level_order[i]);
+					finished.push_back(job->second - job->first);
+				}
+			});
+
+		for (int k = 0; k < num_levels; k++) {
+			int l = backward ? num_levels - 1 - k : k;
+			int begin = level_start[l], end = level_start[l + 1];
+			if (num_workers == 0 || end - begin < 2 * PARALLEL_CHUNK) {
+				for (int i = begin; i < end; i++)
+					fn(level_order[i]);
+				continue;
+			}
+			int chunk = std::max(PARALLEL_CHUNK, (end - begin) / (4 * num_workers) + 1);
+			for (int i = begin; i < end; i += chunk)
+				jobs.push_back({i, std::min(i + chunk, end)});
+			for (int done = 0; done < end - begin;)
+				done += *finished.pop_front();
+		}
+		jobs.close();
+	}
+
+	// arrival times given the launch time of each node
+	std::vector<arrivalint> propagate(const std::vector<arrivalint> &launch)
+	{
+		std::vector<arrivalint> arrival(GetSize(nodes), INF_PAST);
+		for_each_level(false, [&](int n) {
+			arrivalint t = launch[n];
+			for (int i = fanin_start[n]; i < fanin_start[n + 1]; i++) {
+				auto &e = edges[fanin_edges[i]];
+				if (arrival[std::get<0>(e)] != INF_PAST)
+					t = std::max(t, arrival[std::get<0>(e)] + std::get<2>(e));
+			}
+			arrival[n] = t;
+		});
+		return arrival;
+	}
+
+	ModuleSummary summarize()
+	{
+		summary_mode = true;
+		build_graph();
+
+		ModuleSummary summary;
+		dict<int, int> input_index;
+		std::vector<int> output_nodes;
+		for (auto port_id : m->ports) {
+			Wire *port = m->wire(port_id);
+			for (int i = 0; i < GetSize(port); i++) {
+				if (port->port_input && !port->port_output) {
+					input_index.emplace(bit_node(SigBit(port, i)), GetSize(summary.inputs));
+					summary.inputs.push_back({port_id, i});
+				}
+				if (port->port_output && !port->port_input) {
+					output_nodes.push_back(bit_node(SigBit(port, i)));
+					summary.outputs.push_back({port_id, i});
 				}
+			}
+		}
 
-				// copy `levels` value to any output ports
-				for (auto &oport : aig_node->outports) {
-					levels[desc_sig(cell->getPort(oport.first)[oport.second])] = levels[node];
+		levelize();
+
+		// paths within the module
+		levels = propagate(launch_time);
+		for (int n : sample_nodes)
+			summary.internal = std::max(summary.internal, levels[n]);
+
+		// paths from the inputs to the outputs
+		std::vector<arrivalint> input_launch(GetSize(nodes), INF_PAST);
+		for (auto &it : input_index)
+			input_launch[it.first] = 0;
+		std::vector<arrivalint> from_inputs = propagate(input_launch);
+
+		// paths from the inputs to internal sample points
+		std::vector<bool> sampled(GetSize(nodes), false);
+		for (int n : sample_nodes)
+			sampled[n] = true;
+		std::vector<arrivalint> to_sample(GetSize(nodes), INF_PAST);
+		for_each_level(true, [&](int n) {
+			arrivalint t = sampled[n] ? 0 : INF_PAST;
+			for (int i = fanout_start[n]; i < fanout_start[n + 1]; i++) {
+				auto &e = edges[fanout_edges[i]];
+				if (to_sample[std::get<1>(e)] != INF_PAST)
+					t = std::max(t, to_sample[std::get<1>(e)] + std::get<2>(e));
+			}
+			to_sample[n] = t;
+		});
+		summary.sample.resize(GetSize(summary.inputs), INF_PAST);
+		for (auto &it : input_index)
+			summary.sample[it.second] = std::max(summary.sample[it.second], to_sample[it.first]);
+
+		std::vector<int> visited(GetSize(nodes), -1);
+		for (int k = 0; k < GetSize(output_nodes); k++) {
+			int out = output_nodes[k];
+			summary.depth.push_back(from_inputs[out]);
+			summary.launch.push_back(levels[out]);
+			summary.support.emplace_back();
+			if (from_inputs[out] == INF_PAST)
+				continue;
+			// inputs in the fanin cone of the output
+			std::vector<int> stack = {out};
+			visited[out] = k;
+			while (!stack.empty()) {
+				int n = stack.back();
+				stack.pop_back();
+				auto it = input_index.find(n);
+				if (it != input_index.end())
+					summary.support.back().push_back(it->second);
+				for (int i = fanin_start[n]; i < fanin_start[n + 1]; i++) {
+					int from = std::get<0>(edges[fanin_edges[i]]);
+					if (visited[from] != k) {
+						visited[from] = k;
+						stack.push_back(from);
+					}
 				}
 			}
+			std::sort(summary.support.back().begin(), summary.support.back().end());
 		}
+		return summary;
+	}
+
+	void run()
+	{
+		log("\nModule %s\n", log_id(m));
+		if (clk.has_value())
+			log("Domain %s\n", log_signal(*clk));
+
+		build_graph();
+		levelize();
+
+		// now we determine how long it takes for signals to stabilize
+		levels = propagate(launch_time);
 
 		// now find the length of the critical path (slowest path in the design)
 		arrivalint crit = INF_PAST;
-		for (auto pair : samplers)
-			if (levels[desc_sig(pair.second)] > crit)
-				crit = levels[desc_sig(pair.second)];
+		for (int n : sample_nodes)
+			if (levels[n] > crit)
+				crit = levels[n];
 
 		if (crit < 0) {
 			log("No paths found\n");
@@ -268,59 +514,30 @@ struct EstimateSta {
 
 		log("Critical path is %ld nodes long:\n\n", crit);
 
-		// we use dict instead of pool because dict gives us
-		// some compile-time errors related to hashing
-		dict<std::tuple<SigBit, Cell *, AigNode *>, bool> critical;
+		std::vector<bool> critical(GetSize(nodes), false);
 
 		// actually find one critical path, or all such paths if requested
-		for (auto pair : samplers) {
-			if (levels[desc_sig(pair.second)] == crit) {
-				critical[desc_sig(pair.second)] = true;
+		for (int n : sample_nodes) {
+			if (levels[n] == crit) {
+				critical[n] = true;
 				if (!all_paths)
 					break;
 			}
 		}
 
-		// walk backwards through toposorted nodes and set critical flag on nodes in critical path
-		for (auto it = topo.sorted.rbegin(); it != topo.sorted.rend(); it++) {
-			auto node = *it;
-			AigNode *aig_node = std::get<2>(node);
-			if (aig_node) {
-				Cell *cell = std::get<1>(node);
-				Aig &aig = *cell_aigs.at(cell);
-
-				for (auto &oport : aig_node->outports) {
-					if (critical.count(desc_sig(cell->getPort(oport.first)[oport.second])))
-						critical[node] = true;
-				}
-
-				if (!aig_node->portname.empty()) {
-					SigBit bit = cell->getPort(aig_node->portname)[aig_node->portbit];
-					if (critical.count(node))
-						critical[desc_sig(bit)] = true;
-				} else if (aig_node->left_parent < 0 && aig_node->right_parent < 0) {
-					// constant, nothing to do
-				} else {
-					// figure out which parent is on the critical path
-					auto left = desc_aig(cell, aig.nodes[aig_node->left_parent]);
-					auto right = desc_aig(cell, aig.nodes[aig_node->right_parent]);
-					int crit_input_lvl = levels[node] - cell_type_factor(cell->type);
-					if (critical.count(node)) {
-						bool left_critical = (levels[left] == crit_input_lvl);
-						bool right_critical = (levels[right] == crit_input_lvl);
-						if (all_paths) {
-							if (left_critical)
-								critical[left] = true;
-							if (right_critical)
-								critical[right] = true;
-						} else {
-							if (left_critical)
-								critical[left] = true;
-							else if (right_critical)
-								critical[right] = true;
-						}
-					}
-				}
+		// walk backwards through the levels and set critical flag on nodes in critical path
+		for (int k = GetSize(level_order) - 1; k >= 0; k--) {
+			int n = level_order[k];
+			if (!critical[n])
+				continue;
+			for (int i = fanin_start[n]; i < fanin_start[n + 1]; i++) {
+				auto &e = edges[fanin_edges[i]];
+				int from = std::get<0>(e);
+				if (levels[from] == INF_PAST || levels[from] + std::get<2>(e) != levels[n])
+					continue;
+				critical[from] = true;
+				if (!all_paths)
+					break;
 			}
 		}
 
@@ -329,12 +546,12 @@ struct EstimateSta {
 		pool<IdString> to_select;
 
 		pool<Cell *> printed;
-		for (auto node : topo.sorted) {
-			if (!critical.count(node))
+		for (int n : level_order) {
+			if (!critical[n])
 				continue;
-			AigNode *aig_node = std::get<2>(node);
-			if (aig_node) {
-				Cell *cell = std::get<1>(node);
+			const Node &node = nodes[n];
+			if (node.cell) {
+				Cell *cell = node.cell;
 				if (!printed.count(cell)) {
 					to_select.insert(cell->name);
 					std::string cell_src;
@@ -346,14 +563,14 @@ struct EstimateSta {
 					printed.insert(cell);
 				}
 			} else {
-				SigBit bit = std::get<0>(node);
+				SigBit bit = node.bit;
 				bits_to_select.add(bit);
 				std::string wire_src;
 				if (bit.wire && bit.wire->has_attribute(ID::src)) {
 					std::string src_attr = bit.wire->get_src_attribute();
 					wire_src = stringf(" source: %s", src_attr);
 				}
-				log("    wire %s%s (level %ld)\n", log_signal(bit), wire_src, levels[node]);
+				log("    wire %s%s (level %ld)\n", log_signal(bit), wire_src, levels[n]);
 			}
 		}
 
@@ -372,6 +589,19 @@ struct EstimateSta {
 	}
 };
 
+const ModuleSummary &TimeestCache::summary(Module *m)
+{
+	auto it = summaries.find(m->name);
+	if (it != summaries.end())
+		return it->second;
+	if (!summaries_in_progress.insert(m->name).second)
+		log_error("Module '%s' instantiates itself", log_id(m));
+	EstimateSta sta(*this, m, std::nullopt, false);
+	ModuleSummary summary = sta.summarize();
+	summaries_in_progress.erase(m->name);
+	return summaries[m->name] = std::move(summary);
+}
+
 struct TimeestPass : Pass {
 	TimeestPass() : Pass("timeest", "estimate timing") {}
 	void help() override
@@ -382,6 +612,10 @@ struct TimeestPass : Pass {
 		log("\n");
 		log("Estimate the critical path by counting AIG nodes.\n");
 		log("\n");
+		log("Instances of non-blackbox submodules are represented by a summary of their\n");
+		log("port-to-port and port-to-register paths, computed once per module. Within\n");
+		log("a submodule, storage elements of all clock domains are considered.\n");
+		log("\n");
 		log("    -all_paths\n");
 		log("        Print or select nodes from all critical paths instead of focusing on\n");
 		log("        a single illustratory path.\n");
@@ -420,6 +654,8 @@ struct TimeestPass : Pass {
 		if (select && d->selected_modules().size() > 1)
 			log_cmd_error("The -select option operates on a single selected module\n");
 
+		TimeestCache cache;
+
 		for (auto m : d->selected_modules()) {
 			std::optional<SigBit> clk;
 
@@ -432,7 +668,7 @@ struct TimeestPass : Pass {
 				clk = SigBit(m->wire(RTLIL::escape_id(clk_name)), 0);
 			}
 
-			EstimateSta sta(m, clk, /*top_port_endpoints=*/ !clk_domain_specified);
+			EstimateSta sta(cache, m, clk, /*top_port_endpoints=*/ !clk_domain_specified);
 			sta.all_paths = all_paths;
 			sta.select = select;
 			sta.run();
@@ -19,8 +19,7 @@
 
 #include "kernel/yosys.h"
 #include "kernel/celltypes.h"
-#include "kernel/sigtools.h"
-#include "kernel/utils.h"
+#include "kernel/cellgraph.h"
 #include "kernel/log_help.h"
 
 USING_YOSYS_NAMESPACE
@@ -72,56 +71,50 @@ struct TorderPass : public Pass {
 		}
 		extra_args(args, argidx, design);
 
+		// The classifier must not capture references, the graph is cached
+		std::string key = stringf("torder%s", noautostop ? " -noautostop" : "");
+		for (auto &it : stop_db)
+			for (auto &port : it.second)
+				key += stringf(" -stop %s %s", it.first, port);
+
+		auto port_classifier = [stop_db, noautostop](Cell *cell, IdString port) {
+			if (stop_db.count(cell->type) && stop_db.at(cell->type).count(port))
+				return 0;
+
+			if (!noautostop && yosys_celltypes.cell_known(cell->type)) {
+				if (port.in(ID::Q, ID::CTRL_OUT, ID::RD_DATA))
+					return 0;
+				if (cell->type.in(ID($memrd), ID($memrd_v2)) && port == ID::DATA)
+					return 0;
+			}
+
+			return (cell->input(port) ? CellGraph::PORT_INPUT : 0) | (cell->output(port) ? CellGraph::PORT_OUTPUT : 0);
+		};
+
 		for (auto module : design->selected_modules())
 		{
 			log("module %s\n", log_id(module));
 
-			SigMap sigmap(module);
-			dict<SigBit, pool<IdString>> bit_drivers, bit_users;
-			TopoSort<IdString, RTLIL::sort_by_id_str> toposort;
-
-			for (auto cell : module->selected_cells())
-			for (auto conn : cell->connections())
-			{
-				if (stop_db.count(cell->type) && stop_db.at(cell->type).count(conn.first))
-					continue;
-
-				if (!noautostop && yosys_celltypes.cell_known(cell->type)) {
-					if (conn.first.in(ID::Q, ID::CTRL_OUT, ID::RD_DATA))
-						continue;
-					if (cell->type.in(ID($memrd), ID($memrd_v2)) && conn.first == ID::DATA)
-						continue;
-				}
+			CellGraph &graph = CellGraph::get(module, key, [](Cell *) { return true; }, port_classifier);
 
-				if (cell->input(conn.first))
-					for (auto bit : sigmap(conn.second))
-						bit_users[bit].insert(cell->name);
+			std::vector<bool> mask(graph.size());
+			for (int n = 0; n < graph.size(); n++)
+				mask[n] = design->selected(module, graph.cells[n]);
 
-				if (cell->output(conn.first))
-					for (auto bit : sigmap(conn.second))
-						bit_drivers[bit].insert(cell->name);
+			auto components = graph.sccs(&mask);
 
-				toposort.node(cell->name);
-			}
-
-			for (auto &it : bit_users)
-				if (bit_drivers.count(it.first))
-					for (auto driver_cell : bit_drivers.at(it.first))
-					for (auto user_cell : it.second)
-						toposort.edge(driver_cell, user_cell);
-
-			toposort.analyze_loops = true;
-			toposort.sort();
-
-			for (auto &it : toposort.loops) {
+			for (auto &component : components) {
+				if (GetSize(component) == 1 && !graph.has_self_loop(component.front()))
+					continue;
 				log("  loop");
-				for (auto cell : it)
-					log(" %s", log_id(cell));
+				for (int n : component)
+					log(" %s", log_id(graph.cells[n]));
 				log("\n");
 			}
 
-			for (auto cell : toposort.sorted)
-					log("  cell %s\n", log_id(cell));
+			for (auto &component : components)
+				for (int n : component)
+					log("  cell %s\n", log_id(graph.cells[n]));
 		}
 	}
 } TorderPass;
@@ -294,6 +294,7 @@ struct WrapcellPass : Pass {
 
 				cell->type = name;
 				cell->connections_ = new_connections;
+				module->invalidate_content_hash();
 			}
 		}
 	}
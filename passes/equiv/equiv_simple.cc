@@ -19,6 +19,7 @@
 
 #include "kernel/yosys.h"
 #include "kernel/satgen.h"
+#include "kernel/simsig.h"
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
@@ -40,6 +41,7 @@ struct EquivSimpleWorker
 	struct DesignModel {
 		const SigMap &sigmap;
 		dict<SigBit, Cell*> &bit2driver;
+		const SimSignatures *sim;
 	};
 	DesignModel model;
 
@@ -53,10 +55,12 @@ struct EquivSimpleWorker
 		bool nogroup = false;
 		bool set_assumes = false;
 		int max_seq = 1;
+		int sim_words = 4;
 	};
 	Config cfg;
 
 	pool<pair<Cell*, int>> imported_cells_cache;
+	int sim_disproved = 0;
 
 	EquivSimpleWorker(const vector<Cell*> &equiv_cells, const vector<Cell*> &assume_cells, DesignModel model, Config cfg) :
 			module(equiv_cells.front()->module), equiv_cells(equiv_cells), assume_cells(assume_cells),
@@ -280,6 +284,20 @@ struct EquivSimpleWorker
 	{
 		SigBit bit_a = model.sigmap(cell->getPort(ID::A)).as_bit();
 		SigBit bit_b = model.sigmap(cell->getPort(ID::B)).as_bit();
+
+		// A simulated trace over max_seq+1 time steps is a solution of every
+		// SAT problem constructed below, so a mismatch means the proof fails.
+		if (model.sim != nullptr && !model.sim->may_equal(bit_a, bit_b)) {
+			if (cfg.verbose) {
+				log("  Trying to prove $equiv cell %s:\n", log_id(cell));
+				log("    A = %s, B = %s, Y = %s\n", log_signal(bit_a), log_signal(bit_b), log_signal(cell->getPort(ID::Y)));
+				log("    Disproved equivalence by simulation.\n");
+			} else
+				log("  Trying to prove $equiv for %s: failed (simulation).\n", log_signal(cell->getPort(ID::Y)));
+			sim_disproved++;
+			return false;
+		}
+
 		int ez_context = ez->frozen_literal();
 
 		prepare_ezsat(ez_context, bit_a, bit_b);
@@ -433,11 +451,17 @@ struct EquivSimplePass : public Pass {
 		log("    -set-assumes\n");
 		log("        set all assumptions provided via $assume cells\n");
 		log("\n");
+		log("    -sim <N>\n");
+		log("        use <N> words of 64 random simulation patterns to rule out $equiv\n");
+		log("        cells that can't be proven before calling the SAT solver. Ignored\n");
+		log("        with -set-assumes. (default = 4, 0 disables simulation)\n");
+		log("\n");
 	}
 	void execute(std::vector<std::string> args, Design *design) override
 	{
 		EquivSimpleWorker::Config cfg = {};
 		int success_counter = 0;
+		int sim_disproved_counter = 0;
 
 		log_header(design, "Executing EQUIV_SIMPLE pass.\n");
 
@@ -467,6 +491,10 @@ struct EquivSimplePass : public Pass {
 				cfg.set_assumes = true;
 				continue;
 			}
+			if (args[argidx] == "-sim" && argidx+1 < args.size()) {
+				cfg.sim_words = atoi(args[++argidx].c_str());
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
@@ -513,6 +541,12 @@ struct EquivSimplePass : public Pass {
 							bit2driver[bit] = cell;
 			}
 
+			std::unique_ptr<SimSignatures> sim;
+			if (cfg.sim_words > 0 && !cfg.set_assumes) {
+				sim = std::make_unique<SimSignatures>(module, sigmap, cfg.max_seq + 1);
+				sim->add_random_words(cfg.sim_words);
+			}
+
 			unproven_equiv_cells.sort();
 			for (auto [_, d] : unproven_equiv_cells)
 			{
@@ -522,12 +556,15 @@ struct EquivSimplePass : public Pass {
 				for (auto [_, cell] : d)
 					cells.push_back(cell);
 
-				EquivSimpleWorker::DesignModel model {sigmap, bit2driver};
+				EquivSimpleWorker::DesignModel model {sigmap, bit2driver, sim.get()};
 				EquivSimpleWorker worker(cells, assumes, model, cfg);
 				success_counter += worker.run();
+				sim_disproved_counter += worker.sim_disproved;
 			}
 		}
 
+		if (sim_disproved_counter > 0)
+			log("Simulation ruled out %d $equiv cells without calling the SAT solver.\n", sim_disproved_counter);
 		log("Proved %d previously unproven $equiv cells.\n", success_counter);
 	}
 } EquivSimplePass;
@@ -189,6 +189,7 @@ struct FsmOpt
 				}
 
 				ctrl_in.remove(j--, 1);
+				module->invalidate_content_hash();
 				fsm_data.num_inputs--;
 
 				fsm_data.transition_table.swap(new_transition_table);
@@ -222,6 +223,7 @@ struct FsmOpt
 				}
 
 				ctrl_in.remove(i--, 1);
+				module->invalidate_content_hash();
 				fsm_data.num_inputs--;
 
 				fsm_data.transition_table.swap(new_transition_table);
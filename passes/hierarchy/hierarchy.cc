@@ -357,6 +357,8 @@ struct IFExpander
 		for(unsigned int i=0;i<connections_to_remove.size();i++) {
 			cell.connections_.erase(connections_to_remove[i]);
 		}
+		// The connections are changed without setPort()
+		cell.module->invalidate_content_hash();
 	}
 };
 
@@ -1257,6 +1259,7 @@ struct HierarchyPass : public Pass {
 						new_connections[conn.first] = conn.second;
 				}
 				cell->connections_ = new_connections;
+				module->invalidate_content_hash();
 			}
 		}
 
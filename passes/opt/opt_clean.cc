@@ -348,8 +348,10 @@ bool rmunused_module_signals(RTLIL::Module *module, bool purge_mode, bool verbos
 		}
 	}
 
-	// we are removing all connections
+	// we are removing all connections, and the cell connections are
+	// rewritten in place below without notifying monitors
 	module->connections_.clear();
+	module->invalidate_content_hash();
 
 	// used signals sigmapped
 	SigPool used_signals;
@@ -369,6 +371,7 @@ bool rmunused_module_signals(RTLIL::Module *module, bool purge_mode, bool verbos
 				used_signals_nodrivers.add(it2.second);
 		}
 	}
+	module->invalidate_content_hash();
 
 	// gather the usage information for ports, wires with `keep`,
 	// also gather init bits
@@ -506,6 +506,7 @@ struct ExposePass : public Pass {
 
 				for (auto &conn : module->connections_)
 					conn.first = out_to_in_map(conn.first);
+				module->invalidate_content_hash();
 			}
 
 			if (flag_cut)
@@ -527,6 +528,7 @@ struct ExposePass : public Pass {
 
 				for (auto &conn : module->connections_)
 					conn.second = out_to_in_map(sigmap(conn.second));
+				module->invalidate_content_hash();
 			}
 
 			std::set<RTLIL::SigBit> set_q_bits;
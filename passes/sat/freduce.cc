@@ -21,6 +21,7 @@
 #include "kernel/consteval.h"
 #include "kernel/sigtools.h"
 #include "kernel/satgen.h"
+#include "kernel/simsig.h"
 #include "kernel/yosys.h"
 #include "kernel/log_help.h"
 
@@ -28,7 +29,7 @@ USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
 bool inv_mode;
-int verbose_level, reduce_counter, reduce_stop_at;
+int verbose_level, reduce_counter, reduce_stop_at, sim_words;
 typedef std::map<RTLIL::SigBit, std::pair<RTLIL::Cell*, std::set<RTLIL::SigBit>>> drivers_t;
 std::string dump_prefix;
 
@@ -225,6 +226,7 @@ struct PerformReduction
 	SigMap &sigmap;
 	drivers_t &drivers;
 	std::set<std::pair<RTLIL::SigBit, RTLIL::SigBit>> &inv_pairs;
+	SimSignatures *sim;
 	pool<SigBit> recursion_guard;
 
 	ezSatPtr ez;
@@ -274,8 +276,8 @@ struct PerformReduction
 		return sigdepth.at(out);
 	}
 
-	PerformReduction(SigMap &sigmap, drivers_t &drivers, std::set<std::pair<RTLIL::SigBit, RTLIL::SigBit>> &inv_pairs, std::vector<RTLIL::SigBit> &bits, int cone_size) :
-			sigmap(sigmap), drivers(drivers), inv_pairs(inv_pairs), satgen(ez.get(), &sigmap), out_bits(bits), cone_size(cone_size)
+	PerformReduction(SigMap &sigmap, drivers_t &drivers, std::set<std::pair<RTLIL::SigBit, RTLIL::SigBit>> &inv_pairs, SimSignatures *sim, std::vector<RTLIL::SigBit> &bits, int cone_size) :
+			sigmap(sigmap), drivers(drivers), inv_pairs(inv_pairs), sim(sim), satgen(ez.get(), &sigmap), out_bits(bits), cone_size(cone_size)
 	{
 		satgen.model_undef = true;
 
@@ -342,6 +344,16 @@ struct PerformReduction
 		results[result_idx].push_back(bit);
 	}
 
+	// Feeds the primary input values of a model that distinguished signals
+	// back into the simulation, so later buckets are split without SAT calls.
+	void add_counterexample(const std::vector<bool> &model)
+	{
+		if (sim == nullptr)
+			return;
+		std::vector<bool> values(model.begin() + 2*sat_out.size(), model.end());
+		sim->add_pattern(pi_bits, values);
+	}
+
 	void analyze(std::vector<std::set<int>> &results, std::map<int, int> &results_map, std::vector<int> &bucket, std::string indent1, std::string indent2)
 	{
 		std::string indent = indent1 + indent2;
@@ -370,12 +382,13 @@ struct PerformReduction
 		std::vector<bool> model;
 
 		modelVars.insert(modelVars.end(), sat_def.begin(), sat_def.end());
-		if (verbose_level >= 2)
+		if (verbose_level >= 2 || sim != nullptr)
 			modelVars.insert(modelVars.end(), sat_pi.begin(), sat_pi.end());
 
 		if (ez->solve(modelVars, model, ez->expression(ezSAT::OpOr, sat_set_list), ez->expression(ezSAT::OpOr, sat_clr_list)))
 		{
 			int iter_count = 1;
+			add_counterexample(model);
 
 			while (1)
 			{
@@ -394,6 +407,7 @@ struct PerformReduction
 
 				if (!ez->solve(modelVars, model, ez->expression(ezSAT::OpOr, sat_set_list), ez->expression(ezSAT::OpOr, sat_clr_list), ez->expression(ezSAT::OpAnd, sat_def_list)))
 					break;
+				add_counterexample(model);
 				iter_count++;
 			}
 
@@ -564,10 +578,49 @@ struct FreduceWorker
 	drivers_t drivers;
 	std::set<std::pair<RTLIL::SigBit, RTLIL::SigBit>> inv_pairs;
 
+	std::unique_ptr<SimSignatures> sim;
+	int sim_split_buckets = 0, sim_removed_bits = 0, sim_avoided_sat = 0;
+
 	FreduceWorker(RTLIL::Design *design, RTLIL::Module *module) : design(design), module(module), sigmap(module)
 	{
 	}
 
+	// Splits a bucket into classes of signals with equal simulation signatures
+	// (modulo inversion in -inv mode). Signals in different classes are known
+	// to be different, so only classes with more than one signal need SAT.
+	std::vector<std::vector<RTLIL::SigBit>> split_bucket(const std::vector<RTLIL::SigBit> &bucket)
+	{
+		if (sim == nullptr)
+			return {bucket};
+
+		for (auto &bit : bucket)
+			if (!sim->known(bit))
+				return {bucket};
+
+		dict<SimSignatures::signature_t, int> class_index;
+		std::vector<std::vector<RTLIL::SigBit>> classes;
+		for (auto &bit : bucket) {
+			auto sig = sim->signature(bit, inv_mode);
+			auto it = class_index.find(sig);
+			if (it == class_index.end()) {
+				class_index[sig] = GetSize(classes);
+				classes.push_back({bit});
+			} else
+				classes[it->second].push_back(bit);
+		}
+
+		if (GetSize(classes) > 1) {
+			sim_split_buckets++;
+			sim_avoided_sat += GetSize(classes) - 1;
+			for (auto &cls : classes)
+				if (GetSize(cls) == 1)
+					sim_removed_bits++;
+			if (verbose_level >= 1)
+				log("  Simulation split bucket %s into %d classes.\n", log_signal(bucket), GetSize(classes));
+		}
+		return classes;
+	}
+
 	bool find_bit_in_cone(std::set<RTLIL::Cell*> &celldone, RTLIL::SigBit needle, RTLIL::SigBit haystack)
 	{
 		if (needle == haystack)
@@ -661,6 +714,12 @@ struct FreduceWorker
 		}
 		log("  Sorted %d signal bits into %d buckets.\n", bits_count, int(buckets.size()));
 
+		if (sim_words > 0) {
+			sim = std::make_unique<SimSignatures>(module, sigmap);
+			sim->add_random_words(sim_words);
+			log("  Simulated %d random patterns (%d signal bits without signature).\n", sim->num_patterns(), sim->num_opaque_bits());
+		}
+
 		int bucket_count = 0;
 		std::vector<std::vector<equiv_bit_t>> equiv;
 		for (auto &bucket : buckets)
@@ -672,16 +731,24 @@ struct FreduceWorker
 
 			if (bucket.first.size() == 0) {
 				log("  Finding const values for bucket %s%c\n", log_signal(bucket.second), verbose_level ? ':' : '.');
-				PerformReduction worker(sigmap, drivers, inv_pairs, bucket.second, bucket.first.size());
+				PerformReduction worker(sigmap, drivers, inv_pairs, nullptr, bucket.second, bucket.first.size());
 				for (size_t idx = 0; idx < bucket.second.size(); idx++)
 					worker.analyze_const(equiv, idx);
 			} else {
-				log("  Trying to shatter bucket %s%c\n", log_signal(bucket.second), verbose_level ? ':' : '.');
-				PerformReduction worker(sigmap, drivers, inv_pairs, bucket.second, bucket.first.size());
-				worker.analyze(equiv, 100 * bucket_count / (buckets.size() + 1));
+				for (auto &cls : split_bucket(bucket.second)) {
+					if (cls.size() == 1)
+						continue;
+					log("  Trying to shatter bucket %s%c\n", log_signal(cls), verbose_level ? ':' : '.');
+					PerformReduction worker(sigmap, drivers, inv_pairs, sim.get(), cls, bucket.first.size());
+					worker.analyze(equiv, 100 * bucket_count / (buckets.size() + 1));
+				}
 			}
 		}
 
+		if (sim != nullptr)
+			log("  Simulation (%d patterns) split %d buckets and removed %d candidate bits, avoiding at least %d SAT calls.\n",
+					sim->num_patterns(), sim_split_buckets, sim_removed_bits, sim_avoided_sat);
+
 		std::map<RTLIL::SigBit, int> bitusage;
 		CountBitUsage bitusage_worker(sigmap, bitusage);
 		module->rewrite_sigspecs(bitusage_worker);
@@ -781,6 +848,12 @@ struct FreducePass : public Pass {
 		log("        stop after <n> reduction operations. this is mostly used for\n");
 		log("        debugging the freduce command itself.\n");
 		log("\n");
+		log("    -sim <n>\n");
+		log("        use <n> words of 64 random simulation patterns to split candidate\n");
+		log("        groups before proving them with SAT. Counterexamples found by the\n");
+		log("        SAT solver are fed back into the simulation. (default: 4, 0 disables\n");
+		log("        simulation)\n");
+		log("\n");
 		log("    -dump <prefix>\n");
 		log("        dump the design to <prefix>_<module>_<num>.il after each reduction\n");
 		log("        operation. this is mostly used for debugging the freduce command.\n");
@@ -798,6 +871,7 @@ struct FreducePass : public Pass {
 		reduce_stop_at = 0;
 		verbose_level = 0;
 		inv_mode = false;
+		sim_words = 4;
 		dump_prefix = std::string();
 
 		log_header(design, "Executing FREDUCE pass (perform functional reduction).\n");
@@ -820,6 +894,10 @@ struct FreducePass : public Pass {
 				reduce_stop_at = atoi(args[++argidx].c_str());
 				continue;
 			}
+			if (args[argidx] == "-sim" && argidx+1 < args.size()) {
+				sim_words = atoi(args[++argidx].c_str());
+				continue;
+			}
 			if (args[argidx] == "-dump" && argidx+1 < args.size()) {
 				dump_prefix = args[++argidx];
 				continue;
@@ -27,6 +27,8 @@
 #include "kernel/satgen.h"
 #include "kernel/yosys.h"
 #include "kernel/log_help.h"
+#include "kernel/threading.h"
+#include <atomic>
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
@@ -60,8 +62,8 @@ struct SatHelper
 	int max_timestep, timeout;
 	bool gotTimeout;
 
-	SatHelper(RTLIL::Design *design, RTLIL::Module *module, bool enable_undef, bool set_def_formal) :
-		design(design), module(module), sigmap(module), ct(design), satgen(ez.get(), &sigmap)
+	SatHelper(RTLIL::Design *design, RTLIL::Module *module, bool enable_undef, bool set_def_formal, SatSolver *solver) :
+		design(design), module(module), sigmap(module), ct(design), ez(solver), satgen(ez.get(), &sigmap)
 	{
 		this->enable_undef = enable_undef;
 		satgen.model_undef = enable_undef;
@@ -75,6 +77,34 @@ struct SatHelper
 		gotTimeout = false;
 	}
 
+	// Creates a helper with the same constraints and options as `other`, but
+	// with an empty SAT problem on a separate solver instance.
+	SatHelper(const SatHelper &other, SatSolver *solver) :
+		SatHelper(other.design, other.module, other.enable_undef, other.satgen.def_formal, solver)
+	{
+		sets = other.sets;
+		prove = other.prove;
+		prove_x = other.prove_x;
+		sets_init = other.sets_init;
+		sets_at = other.sets_at;
+		unsets_at = other.unsets_at;
+		prove_asserts = other.prove_asserts;
+		set_assumes = other.set_assumes;
+		set_init_def = other.set_init_def;
+		set_init_undef = other.set_init_undef;
+		set_init_zero = other.set_init_zero;
+		ignore_unknown_cells = other.ignore_unknown_cells;
+		sets_def = other.sets_def;
+		sets_any_undef = other.sets_any_undef;
+		sets_all_undef = other.sets_all_undef;
+		sets_def_at = other.sets_def_at;
+		sets_any_undef_at = other.sets_any_undef_at;
+		sets_all_undef_at = other.sets_all_undef_at;
+		shows = other.shows;
+		timeout = other.timeout;
+		satgen.ignore_div_by_zero = other.satgen.ignore_div_by_zero;
+	}
+
 	void check_undef_enabled(const RTLIL::SigSpec &sig)
 	{
 		if (enable_undef)
@@ -902,6 +932,350 @@ void print_qed()
 	log("\n");
 }
 
+// Portfolio mode for temporal induction proofs (sat -tempinduct -portfolio).
+//
+// Instead of growing one incremental base case and one incremental induction
+// step, every base case and induction step of a given length is set up as an
+// independent SAT problem. Setting up problems touches the design and is done
+// on the main thread, solving is done by a pool of worker threads. Each problem
+// can be raced on several solver configurations, the first one to return a
+// definite answer wins and the others are interrupted. Results are evaluated
+// in order of increasing length, so the outcome is the same as that of the
+// sequential loop.
+struct TempinductPortfolio
+{
+	enum Result { RESULT_SUCCESS, RESULT_FAIL, RESULT_TIMEOUT };
+	enum Status { PENDING, SKIPPED, PROVEN, FAILED, TIMED_OUT };
+
+	struct Job
+	{
+		bool induction;
+		int length, config;
+		std::unique_ptr<SatHelper> helper;
+		int assumption;
+		std::atomic<bool> cancel{false};
+		bool success = false, timeout = false;
+
+		// Only the solver of the job may be touched here, this runs on a worker thread
+		void solve()
+		{
+			if (cancel.load())
+				return;
+			success = helper->solve(assumption);
+			timeout = helper->gotTimeout;
+		}
+	};
+
+	struct Problem
+	{
+		Status status = PENDING;
+		int pending_jobs = 0;
+		std::unique_ptr<SatHelper> model;
+	};
+
+	const SatHelper &basecase_template, &inductstep_template;
+	std::vector<std::pair<SatSolver*, uint32_t>> configs;
+
+	int seq_len = 0, maxsteps = 0, initsteps = 0, stepsize = 1, tempinduct_skip = 0;
+	bool tempinduct_baseonly = false, tempinduct_inductonly = false, tempinduct_def = false;
+	std::string vcd_file_name, json_file_name, cnf_file_name;
+
+	std::vector<Problem> basecases, inductsteps;
+	// Model of the longest failed induction step, which is the last one the
+	// sequential loop solves when it reaches -maxsteps
+	std::unique_ptr<SatHelper> induct_model;
+	int induct_model_length = 0;
+	pool<Job*> in_flight;
+	int horizon = INT_MAX;
+
+	TempinductPortfolio(const SatHelper &basecase_template, const SatHelper &inductstep_template) :
+			basecase_template(basecase_template), inductstep_template(inductstep_template) { }
+
+	void add_configs(SatSolver *solver, bool solver_given, int num_configs)
+	{
+		std::vector<SatSolver*> solvers = {solver};
+		if (!solver_given)
+			for (auto s = yosys_satsolver_list; s != nullptr; s = s->next)
+				if (s != solver)
+					solvers.push_back(s);
+		for (int i = 0; i < num_configs; i++)
+			configs.push_back({solvers[i % GetSize(solvers)], i / GetSize(solvers)});
+	}
+
+	Problem &problem(bool induction, int length)
+	{
+		return induction ? inductsteps.at(length) : basecases.at(length);
+	}
+
+	std::string job_name(const Job *job)
+	{
+		auto &config = configs.at(job->config);
+		return stringf("[%s %d, %s/%u]", job->induction ? "induction step" : "base case",
+				job->length, config.first->name, config.second);
+	}
+
+	int setup_basecase(SatHelper &helper, int length)
+	{
+		for (int timestep = 1; timestep <= seq_len; timestep++)
+			helper.setup(timestep, timestep == 1);
+
+		int property = 0;
+		for (int len = 1; len <= length; len++) {
+			if (property != 0)
+				helper.ez->assume(property);
+			helper.setup(seq_len + len, seq_len + len == 1);
+			property = helper.setup_proof(seq_len + len);
+			if (len > 1)
+				helper.force_unique_state(seq_len + 1, seq_len + len);
+		}
+
+		helper.generate_model();
+		return helper.ez->NOT(property);
+	}
+
+	int setup_inductstep(SatHelper &helper, int length)
+	{
+		helper.setup(1);
+		helper.ez->assume(helper.setup_proof(1));
+
+		if (tempinduct_def) {
+			std::vector<int> undef_state = helper.satgen.importUndefSigSpec(helper.satgen.initial_state.export_all(), 1);
+			helper.ez->assume(helper.ez->NOT(helper.ez->expression(ezSAT::OpOr, undef_state)));
+		}
+
+		int property = 0;
+		for (int len = 1; len <= length; len++) {
+			if (property != 0)
+				helper.ez->assume(property);
+			helper.setup(len + 1);
+			property = helper.setup_proof(len + 1);
+			if (len > 1)
+				helper.force_unique_state(1, len + 1);
+		}
+
+		helper.generate_model();
+		return helper.ez->NOT(property);
+	}
+
+	// Sets up all jobs for one length and hands them to `submit`
+	void schedule(int length, std::function<void(std::unique_ptr<Job>)> submit)
+	{
+		basecases.resize(length + 1);
+		inductsteps.resize(length + 1);
+
+		for (bool induction : {false, true})
+		{
+			Problem &p = problem(induction, length);
+			if (induction ? tempinduct_baseonly || length <= tempinduct_skip || length <= initsteps || length % stepsize != 0 :
+					tempinduct_inductonly || length <= tempinduct_skip) {
+				p.status = SKIPPED;
+				continue;
+			}
+
+			for (int config = 0; config < GetSize(configs); config++)
+			{
+				auto job = std::make_unique<Job>();
+				job->induction = induction;
+				job->length = length;
+				job->config = config;
+				job->helper = std::make_unique<SatHelper>(induction ? inductstep_template : basecase_template, configs[config].first);
+				job->helper->ez->setSolverSeed(configs[config].second);
+				job->helper->ez->setSolverInterrupt(&job->cancel);
+
+				{
+					LogMakeDebugHdl mkdebug(true);
+					job->assumption = induction ? setup_inductstep(*job->helper, length) : setup_basecase(*job->helper, length);
+				}
+
+				if (induction && !cnf_file_name.empty())
+				{
+					rewrite_filename(cnf_file_name);
+					FILE *f = fopen(cnf_file_name.c_str(), "w");
+					if (!f)
+						log_cmd_error("Can't open output file `%s' for writing: %s\n", cnf_file_name, strerror(errno));
+
+					log("Dumping CNF to file `%s'.\n", cnf_file_name);
+					cnf_file_name.clear();
+
+					job->helper->ez->printDIMACS(f, false);
+					fclose(f);
+				}
+
+				log("%s Solving problem with %d variables and %d clauses..\n", job_name(job.get()),
+						job->helper->ez->numCnfVariables(), job->helper->ez->numCnfClauses());
+
+				p.pending_jobs++;
+				in_flight.insert(job.get());
+				submit(std::move(job));
+			}
+		}
+		log_flush();
+	}
+
+	void cancel_jobs(std::function<bool(Job*)> filter)
+	{
+		for (auto job : in_flight)
+			if (filter(job))
+				job->cancel.store(true);
+	}
+
+	void handle_result(std::unique_ptr<Job> job)
+	{
+		in_flight.erase(job.get());
+		Problem &p = problem(job->induction, job->length);
+		p.pending_jobs--;
+
+		if (p.status != PENDING || job->cancel.load())
+			return;
+
+		if (job->timeout) {
+			log("%s Interrupted SAT solver.\n", job_name(job.get()));
+			if (p.pending_jobs == 0)
+				p.status = TIMED_OUT;
+			return;
+		}
+
+		p.status = job->success ? FAILED : PROVEN;
+		log("%s %s.\n", job_name(job.get()), job->success ? "Model found" : "Proven");
+
+		bool induction = job->induction;
+		int length = job->length;
+		cancel_jobs([&](Job *other) { return other->induction == induction && other->length == length; });
+
+		// A failing base case or a successful induction step makes all longer problems irrelevant
+		if ((!induction && p.status == FAILED) || (induction && p.status == PROVEN)) {
+			horizon = std::min(horizon, length);
+			cancel_jobs([&](Job *other) { return other->length > horizon; });
+		}
+
+		if (p.status == FAILED && !induction)
+			p.model = std::move(job->helper);
+		if (p.status == FAILED && induction && length > induct_model_length) {
+			induct_model = std::move(job->helper);
+			induct_model_length = length;
+		}
+	}
+
+	// Evaluates the results in the same order as the sequential loop, returns false while undecided
+	bool decide(Result &result)
+	{
+		for (int length = 1;; length++)
+		{
+			if (maxsteps > 0 && length > maxsteps) {
+				if (tempinduct_baseonly) {
+					log("\nReached maximum number of time steps -> proved base case for %d steps: SUCCESS!\n", maxsteps);
+					result = RESULT_SUCCESS;
+					return true;
+				}
+				log("\nReached maximum number of time steps -> proof failed.\n");
+				// No induction step was solved if all of them were skipped
+				if (induct_model != nullptr && !vcd_file_name.empty())
+					induct_model->dump_model_to_vcd(vcd_file_name);
+				if (induct_model != nullptr && !json_file_name.empty())
+					induct_model->dump_model_to_json(json_file_name);
+				print_proof_failed();
+				result = RESULT_FAIL;
+				return true;
+			}
+
+			if (length >= GetSize(basecases))
+				return false;
+
+			Problem &base = basecases[length];
+			if (base.status == PENDING)
+				return false;
+			if (base.status == TIMED_OUT) {
+				result = RESULT_TIMEOUT;
+				return true;
+			}
+			if (base.status == FAILED) {
+				log("SAT temporal induction proof finished - model found for base case: FAIL!\n");
+				print_proof_failed();
+				base.model->print_model();
+				if (!vcd_file_name.empty())
+					base.model->dump_model_to_vcd(vcd_file_name);
+				if (!json_file_name.empty())
+					base.model->dump_model_to_json(json_file_name);
+				result = RESULT_FAIL;
+				return true;
+			}
+
+			Problem &induct = inductsteps[length];
+			if (induct.status == PENDING)
+				return false;
+			if (induct.status == TIMED_OUT) {
+				result = RESULT_TIMEOUT;
+				return true;
+			}
+			if (induct.status == PROVEN) {
+				log("Induction step proven: SUCCESS!\n");
+				print_qed();
+				result = RESULT_SUCCESS;
+				return true;
+			}
+		}
+	}
+
+	Result run(int max_threads)
+	{
+		int num_worker_threads = ThreadPool::pool_size(1, max_threads);
+		log("\nRunning temporal induction portfolio with %d worker threads and %d solver configurations.\n",
+				num_worker_threads, GetSize(configs));
+
+		ConcurrentQueue<std::unique_ptr<Job>> work_queue;
+		ConcurrentQueue<std::unique_ptr<Job>> work_finished_queue;
+		std::deque<std::unique_ptr<Job>> main_thread_queue;
+
+		ThreadPool worker_threads(num_worker_threads, [&](int) {
+				while (std::optional<std::unique_ptr<Job>> job = work_queue.pop_front()) {
+					(*job)->solve();
+					work_finished_queue.push_back(std::move(*job));
+				}
+			});
+
+		auto submit = [&](std::unique_ptr<Job> job) {
+			if (num_worker_threads > 0)
+				work_queue.push_back(std::move(job));
+			else
+				main_thread_queue.push_back(std::move(job));
+		};
+
+		Result result;
+		int next_length = 1;
+		while (!decide(result))
+		{
+			// Keep one length worth of problems queued beyond what the workers are solving
+			while (GetSize(in_flight) <= num_worker_threads && next_length <= horizon && (maxsteps == 0 || next_length <= maxsteps))
+				schedule(next_length++, submit);
+			log_assert(!in_flight.empty());
+
+			if (num_worker_threads > 0) {
+				handle_result(*work_finished_queue.pop_front());
+			} else {
+				std::unique_ptr<Job> job = std::move(main_thread_queue.front());
+				main_thread_queue.pop_front();
+				job->solve();
+				handle_result(std::move(job));
+			}
+		}
+
+		// Interrupt the remaining solvers and collect their jobs, they must be destroyed on the main thread
+		cancel_jobs([](Job*) { return true; });
+		work_queue.close();
+		if (num_worker_threads > 0) {
+			while (!in_flight.empty()) {
+				std::unique_ptr<Job> job = *work_finished_queue.pop_front();
+				in_flight.erase(job.get());
+			}
+		} else {
+			main_thread_queue.clear();
+			in_flight.clear();
+		}
+
+		return result;
+	}
+};
+
 struct SatPass : public Pass {
 	SatPass() : Pass("sat", "solve a SAT problem in the circuit") { }
 	bool formatted_help() override {
@@ -1029,6 +1403,19 @@ struct SatPass : public Pass {
 		log("    -tempinduct-inductonly\n");
 		log("        Run only the induction half of temporal induction\n");
 		log("\n");
+		log("    -portfolio <N>\n");
+		log("        Run the temporal induction proof in portfolio mode with up to <N>\n");
+		log("        worker threads. Base cases and induction steps of increasing length\n");
+		log("        are solved concurrently as independent SAT problems, and the proof\n");
+		log("        stops as soon as the shortest counterexample or the shortest\n");
+		log("        successful induction is found.\n");
+		log("\n");
+		log("    -portfolio-configs <N>\n");
+		log("        Race each problem of the portfolio on <N> solver configurations\n");
+		log("        (default: 1). Configurations alternate between the available solver\n");
+		log("        backends (or only the one given with -solver) and use a different\n");
+		log("        random seed for each round.\n");
+		log("\n");
 		log("    -tempinduct-skip <N>\n");
 		log("        Skip the first <N> steps of the induction proof.\n");
 		log("\n");
@@ -1066,6 +1453,15 @@ struct SatPass : public Pass {
 		log("    -timeout <N>\n");
 		log("        Maximum number of seconds a single SAT instance may take.\n");
 		log("\n");
+		log("    -solver <name>\n");
+		log("        Use the given SAT solver backend. The following solvers are available:\n");
+		for (auto solver = yosys_satsolver_list; solver != nullptr; solver = solver->next)
+			log("            %s%s\n", solver->name, solver == yosys_satsolver ? " (default)" : "");
+		log("        'minisat' is the bundled MiniSat. 'cdcl' is a built-in solver with\n");
+		log("        chronological backtracking, LBD-based restarts and learnt clause\n");
+		log("        vivification, which often performs better on hard BMC and induction\n");
+		log("        problems.\n");
+		log("\n");
 		log("    -verify\n");
 		log("        Return an error and stop the synthesis script if the proof fails.\n");
 		log("\n");
@@ -1092,8 +1488,10 @@ struct SatPass : public Pass {
 		bool show_regs = false, show_public = false, show_all = false;
 		bool ignore_unknown_cells = false, falsify = false, tempinduct_def = false, set_init_def = false;
 		bool tempinduct_baseonly = false, tempinduct_inductonly = false, set_assumes = false;
-		int tempinduct_skip = 0, stepsize = 1;
+		int tempinduct_skip = 0, stepsize = 1, portfolio = 0, portfolio_configs = 1;
 		std::string vcd_file_name, json_file_name, cnf_file_name;
+		SatSolver *solver = yosys_satsolver;
+		bool solver_given = false;
 
 		log_header(design, "Executing SAT pass (solving SAT problems in the circuit).\n");
 
@@ -1125,6 +1523,13 @@ struct SatPass : public Pass {
 				timeout = atoi(args[++argidx].c_str());
 				continue;
 			}
+			if (args[argidx] == "-solver" && argidx+1 < args.size()) {
+				solver = SatSolver::find(args[++argidx]);
+				if (solver == nullptr)
+					log_cmd_error("Unknown SAT solver `%s'.\n", args[argidx]);
+				solver_given = true;
+				continue;
+			}
 			if (args[argidx] == "-max" && argidx+1 < args.size()) {
 				loopcount = atoi(args[++argidx].c_str());
 				continue;
@@ -1209,6 +1614,14 @@ struct SatPass : public Pass {
 				tempinduct_inductonly = true;
 				continue;
 			}
+			if (args[argidx] == "-portfolio" && argidx+1 < args.size()) {
+				portfolio = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (args[argidx] == "-portfolio-configs" && argidx+1 < args.size()) {
+				portfolio_configs = std::max(1, atoi(args[++argidx].c_str()));
+				continue;
+			}
 			if (args[argidx] == "-tempinduct-skip" && argidx+1 < args.size()) {
 				tempinduct_skip = atoi(args[++argidx].c_str());
 				continue;
@@ -1348,6 +1761,9 @@ struct SatPass : public Pass {
 		if (!prove.size() && !prove_x.size() && !prove_asserts && tempinduct)
 			log_cmd_error("Got -tempinduct but nothing to prove!\n");
 
+		if (portfolio > 0 && !tempinduct)
+			log_cmd_error("Option -portfolio is only supported for temporal induction proofs!\n");
+
 		if (prove_skip && tempinduct)
 			log_cmd_error("Options -prove-skip and -tempinduct don't work with each other. Use -seq instead of -prove-skip.\n");
 
@@ -1403,8 +1819,8 @@ struct SatPass : public Pass {
 			if (loopcount > 0 || max_undef)
 				log_cmd_error("The options -max, -all, and -max_undef are not supported for temporal induction proofs!\n");
 
-			SatHelper basecase(design, module, enable_undef, set_def_formal);
-			SatHelper inductstep(design, module, enable_undef, set_def_formal);
+			SatHelper basecase(design, module, enable_undef, set_def_formal, solver);
+			SatHelper inductstep(design, module, enable_undef, set_def_formal, solver);
 
 			basecase.sets = sets;
 			basecase.set_assumes = set_assumes;
@@ -1428,10 +1844,6 @@ struct SatPass : public Pass {
 			basecase.satgen.ignore_div_by_zero = ignore_div_by_zero;
 			basecase.ignore_unknown_cells = ignore_unknown_cells;
 
-			for (int timestep = 1; timestep <= seq_len; timestep++)
-				if (!tempinduct_inductonly)
-					basecase.setup(timestep, timestep == 1);
-
 			inductstep.sets = sets;
 			inductstep.set_assumes = set_assumes;
 			inductstep.prove = prove;
@@ -1445,6 +1857,36 @@ struct SatPass : public Pass {
 			inductstep.satgen.ignore_div_by_zero = ignore_div_by_zero;
 			inductstep.ignore_unknown_cells = ignore_unknown_cells;
 
+			if (portfolio > 0)
+			{
+				TempinductPortfolio tip(basecase, inductstep);
+				tip.add_configs(solver, solver_given, portfolio_configs);
+				tip.seq_len = seq_len;
+				tip.maxsteps = maxsteps;
+				tip.initsteps = initsteps;
+				tip.stepsize = stepsize;
+				tip.tempinduct_skip = tempinduct_skip;
+				tip.tempinduct_baseonly = tempinduct_baseonly;
+				tip.tempinduct_inductonly = tempinduct_inductonly;
+				tip.tempinduct_def = tempinduct_def;
+				tip.vcd_file_name = vcd_file_name;
+				tip.json_file_name = json_file_name;
+				tip.cnf_file_name = cnf_file_name;
+
+				switch (tip.run(portfolio)) {
+				case TempinductPortfolio::RESULT_SUCCESS:
+					goto tip_success;
+				case TempinductPortfolio::RESULT_FAIL:
+					goto tip_failed;
+				case TempinductPortfolio::RESULT_TIMEOUT:
+					goto timeout;
+				}
+			}
+
+			for (int timestep = 1; timestep <= seq_len; timestep++)
+				if (!tempinduct_inductonly)
+					basecase.setup(timestep, timestep == 1);
+
 			if (!tempinduct_baseonly) {
 				inductstep.setup(1);
 				inductstep.ez->assume(inductstep.setup_proof(1));
@@ -1593,7 +2035,7 @@ struct SatPass : public Pass {
 			if (maxsteps > 0)
 				log_cmd_error("The options -maxsteps is only supported for temporal induction proofs!\n");
 
-			SatHelper sathelper(design, module, enable_undef, set_def_formal);
+			SatHelper sathelper(design, module, enable_undef, set_def_formal, solver);
 
 			sathelper.sets = sets;
 			sathelper.set_assumes = set_assumes;
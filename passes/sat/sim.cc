@@ -187,7 +187,8 @@ struct SimInstance
 		Const past_args;
 
 		Cell *cell;
-		Fmt fmt;
+		CompiledFmt fmt;
+		std::string rendered;
 
 		std::tuple<bool, SigSpec, Const, int, Cell*> _sort_label() const
 		{
@@ -343,7 +344,9 @@ struct SimInstance
 				print_database.emplace_back();
 				auto &print = print_database.back();
 				print.cell = cell;
-				print.fmt.parse_rtlil(cell);
+				Fmt fmt;
+				fmt.parse_rtlil(cell);
+				print.fmt = CompiledFmt(fmt);
 				print.past_trg = Const(State::Sx, cell->getPort(ID::TRG).size());
 				print.past_args = Const(State::Sx, cell->getPort(ID::ARGS).size());
 				print.past_en = State::Sx;
@@ -883,15 +886,10 @@ struct SimInstance
 				}
 
 				if (triggered) {
-					int pos = 0;
-					for (auto &part : print.fmt.parts) {
-						part.sig = (sampled ? print.past_args : args).extract(pos, part.sig.size());
-						pos += part.sig.size();
-					}
-
-					std::string rendered = print.fmt.render();
-					log("%s", rendered);
-					shared->display_output.emplace_back(shared->step, this, cell, rendered);
+					print.rendered.clear();
+					print.fmt.render(sampled ? print.past_args : args, print.rendered);
+					log("%s", print.rendered);
+					shared->display_output.emplace_back(shared->step, this, cell, print.rendered);
 				}
 			}
 
@@ -1846,6 +1844,10 @@ struct SimWorker : SimShared
 
 	struct YwHierarchy {
 		dict<IdPath, FoundYWPath> paths;
+		// resolved path of each signal and clock of the witness, by index,
+		// or nullptr when the path is not found in the design
+		std::vector<const FoundYWPath *> signal_paths;
+		std::vector<const FoundYWPath *> clock_paths;
 	};
 
 	YwHierarchy prepare_yw_hierarchy(const ReadWitness &yw)
@@ -1932,17 +1934,31 @@ struct SimWorker : SimShared
 		return hierarchy;
 	}
 
+	// Called once the hierarchy is in its final place, as the bound paths
+	// point into it
+	void bind_yw_paths(const ReadWitness &yw, YwHierarchy &hierarchy)
+	{
+		auto find = [&](const IdPath &path) -> const FoundYWPath * {
+			auto it = hierarchy.paths.find(path);
+			return it == hierarchy.paths.end() ? nullptr : &it->second;
+		};
+		for (auto &signal : yw.signals)
+			hierarchy.signal_paths.push_back(find(signal.path));
+		for (auto &clock : yw.clocks)
+			hierarchy.clock_paths.push_back(find(clock.path));
+	}
+
 	void set_yw_state(const ReadWitness &yw, const YwHierarchy &hierarchy, int t)
 	{
 		log_assert(t >= 0 && t < GetSize(yw.steps));
 
-		for (auto &signal : yw.signals) {
+		for (int i = 0; i < GetSize(yw.signals); i++) {
+			auto &signal = yw.signals[i];
 			if (signal.init_only && t >= 1)
 				continue;
-			auto found_path_it = hierarchy.paths.find(signal.path);
-			if (found_path_it == hierarchy.paths.end())
+			if (hierarchy.signal_paths[i] == nullptr)
 				continue;
-			auto &found_path = found_path_it->second;
+			auto &found_path = *hierarchy.signal_paths[i];
 
 			Const value = yw.get_bits(t, signal.bits_offset, signal.width);
 
@@ -1967,13 +1983,13 @@ struct SimWorker : SimShared
 
 	void set_yw_clocks(const ReadWitness &yw, const YwHierarchy &hierarchy, bool active_edge)
 	{
-		for (auto &clock : yw.clocks) {
+		for (int i = 0; i < GetSize(yw.clocks); i++) {
+			auto &clock = yw.clocks[i];
 			if (clock.is_negedge == clock.is_posedge)
 				continue;
-			auto found_path_it = hierarchy.paths.find(clock.path);
-			if (found_path_it == hierarchy.paths.end())
+			if (hierarchy.clock_paths[i] == nullptr)
 				continue;
-			auto &found_path = found_path_it->second;
+			auto &found_path = *hierarchy.clock_paths[i];
 
 			if (found_path.wire != nullptr) {
 				found_path.instance->set_state(
@@ -1998,6 +2014,7 @@ struct SimWorker : SimShared
 		register_signals();
 
 		YwHierarchy hierarchy = prepare_yw_hierarchy(yw);
+		bind_yw_paths(yw, hierarchy);
 
 		if (yw.steps.empty()) {
 			log_warning("Yosys witness file `%s` contains no time steps\n", yw.filename);
@@ -2493,7 +2510,26 @@ struct AIWWriter : public OutputWriter
 			[this](const char */*name*/, int /*size*/, Wire *wire, int id, bool) { if (wire != nullptr) mapping[wire] = id; }
 		);
 
+		// Bind every witness column to its slot in the simulation state once,
+		// instead of looking up the wire mapping for each bit of each step
 		std::map<int, Yosys::RTLIL::Const> current;
+		auto slot = [&](SigBit bit) { return std::make_pair(&current[mapping[bit.wire]], bit.offset); };
+
+		std::vector<std::pair<const Const *, int>> columns;
+		for (int i = 0; i <= max_input; i++) {
+			if (aiw_inputs.count(i))
+				columns.push_back(slot(aiw_inputs.at(i)));
+			else if (aiw_inits.count(i))
+				columns.push_back(slot(aiw_inits.at(i)));
+			else
+				columns.emplace_back(nullptr, 0);
+		}
+
+		std::vector<std::pair<std::pair<const Const *, int>, State>> clock_columns;
+		for (auto it : clocks)
+			clock_columns.emplace_back(slot(aiw_inputs.at(it.first)), it.second ? State::S1 : State::S0);
+
+		std::string line;
 		bool first = true;
 		for (auto iter = worker->output_data.begin(); iter != std::prev(worker->output_data.end()); ++iter)
 		{
@@ -2516,40 +2552,20 @@ struct AIWWriter : public OutputWriter
 			}
 
 			bool skip = false;
-			for (auto it : clocks)
+			for (auto &it : clock_columns)
 			{
-				auto val = it.second ? State::S1 : State::S0;
-				SigBit bit = aiw_inputs.at(it.first);
-				auto v = current[mapping[bit.wire]].at(bit.offset);
-				if (v == val)
+				if (it.first.first->at(it.first.second) == it.second)
 					skip = true;
 			}
 			if (skip)
 				continue;
-			for (int i = 0; i <= max_input; i++)
-			{
-				if (aiw_inputs.count(i)) {
-					SigBit bit = aiw_inputs.at(i);
-					auto v = current[mapping[bit.wire]].at(bit.offset);
-					if (v == State::S1)
-						aiwfile << '1';
-					else
-						aiwfile << '0';
-					continue;
-				}
-				if (aiw_inits.count(i)) {
-					SigBit bit = aiw_inits.at(i);
-					auto v = current[mapping[bit.wire]].at(bit.offset);
-					if (v == State::S1)
-						aiwfile << '1';
-					else
-						aiwfile << '0';
-					continue;
-				}
-				aiwfile << '0';
-			}
-			aiwfile << '\n';
-		} 
+
+			line.clear();
+			for (auto &column : columns)
+				line += column.first != nullptr && column.first->at(column.second) == State::S1 ? '1' : '0';
+			line += '\n';
+			aiwfile << line;
+		}
 	}
 
 	std::ofstream aiwfile;
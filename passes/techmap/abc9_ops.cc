@@ -1357,6 +1357,7 @@ void reintegrate(RTLIL::Module *module, bool dff_mode)
 			log_assert(jt != mapped_cell->connections_.end());
 			SigSpec outputs = std::move(jt->second);
 			mapped_cell->connections_.erase(jt);
+			module->invalidate_content_hash();
 
 			auto abc9_flop = box_module->get_bool_attribute(ID::abc9_flop);
 			if (abc9_flop) {
@@ -75,15 +75,10 @@ struct AigmapPass : public Pass {
 			pool<IdString> new_sel;
 			for (auto cell : module->selected_cells())
 			{
-				Aig aig(cell);
+				const Aig &aig = Aig::cached(cell);
 
-				if (cell->type.in(ID($_AND_), ID($_NOT_)))
-					aig.name.clear();
-
-				if (nand_mode && cell->type == ID($_NAND_))
-					aig.name.clear();
-
-				if (aig.name.empty()) {
+				if (aig.name.empty() || cell->type.in(ID($_AND_), ID($_NOT_)) ||
+						(nand_mode && cell->type == ID($_NAND_))) {
 					not_replaced_count++;
 					stat_not_replaced[cell->type]++;
 					if (select_mode)
@@ -91,16 +86,21 @@ struct AigmapPass : public Pass {
 					continue;
 				}
 
+				// The cached model is shared by all cells of this shape, so
+				// only the port signals need to be looked up per instance
+				dict<IdString, SigSpec> ports;
+				for (auto &conn : cell->connections())
+					ports[conn.first] = conn.second;
+
 				vector<SigBit> sigs;
-				dict<pair<int, int>, SigBit> and_cache;
+				sigs.reserve(GetSize(aig.nodes));
 
-				for (int node_idx = 0; node_idx < GetSize(aig.nodes); node_idx++)
+				for (auto &node : aig.nodes)
 				{
 					SigBit bit;
-					auto &node = aig.nodes[node_idx];
 
 					if (node.portbit >= 0) {
-						bit = cell->getPort(node.portname)[node.portbit];
+						bit = ports.at(node.portname)[node.portbit];
 					} else if (node.left_parent < 0 && node.right_parent < 0) {
 						bit = node.inverter ? State::S1 : State::S0;
 						goto skip_inverter;
@@ -115,15 +115,10 @@ struct AigmapPass : public Pass {
 
 							goto skip_inverter;
 						} else {
-							pair<int, int> key(node.left_parent, node.right_parent);
-							if (and_cache.count(key))
-								bit = and_cache.at(key);
-							else {
-								bit = module->addWire(NEW_ID);
-								auto gate = module->addAndGate(NEW_ID, A, B, bit);
-								if (select_mode)
-									new_sel.insert(gate->name);
-							}
+							bit = module->addWire(NEW_ID);
+							auto gate = module->addAndGate(NEW_ID, A, B, bit);
+							if (select_mode)
+								new_sel.insert(gate->name);
 						}
 					}
 
@@ -138,7 +133,7 @@ struct AigmapPass : public Pass {
 
 				skip_inverter:
 					for (auto &op : node.outports)
-						module->connect(cell->getPort(op.first)[op.second], bit);
+						module->connect(ports.at(op.first)[op.second], bit);
 
 					sigs.push_back(bit);
 				}
@@ -129,10 +129,12 @@
 		} else if (purge) {
 			if (all) {
 				LibertyAstCache::instance.cached.clear();
+				LibertyAstCache::instance.cached_stamps.clear();
 				LibertyAstCache::instance.cache_path.clear();
 			} else {
 				for (auto const &path : paths) {
 					LibertyAstCache::instance.cached.erase(path);
+					LibertyAstCache::instance.cached_stamps.erase(path);
 					LibertyAstCache::instance.cache_path.erase(path);
 				}
 			}
@@ -54,6 +54,14 @@ std::shared_ptr<const LibertyAst> LibertyAstCache::cached_ast(const std::string
 	auto it = cached.find(fname);
 	if (it == cached.end())
 		return nullptr;
+	auto stamp_it = cached_stamps.find(fname);
+	if (stamp_it == cached_stamps.end() || stamp_it->second != file_content_hash(fname)) {
+		if (verbose)
+			log("Liberty file `%s' has changed, dropping cached data\n", fname);
+		cached.erase(it);
+		cached_stamps.erase(fname);
+		return nullptr;
+	}
 	if (verbose)
 		log("Using cached data for liberty file `%s'\n", fname);
 	return it->second;
@@ -67,7 +75,8 @@ void LibertyAstCache::parsed_ast(const std::string &fname, const std::shared_ptr
 		return;
 	if (verbose)
 		log("Caching data for liberty file `%s'\n", fname);
-	cached.emplace(fname, ast);
+	cached[fname] = ast;
+	cached_stamps[fname] = file_content_hash(fname);
 }
 
 #endif
@@ -148,6 +148,9 @@ namespace Yosys
 		~LibertyAstCache() {};
 	public:
 		dict<std::string, std::shared_ptr<const LibertyAst>> cached;
+		// Content hashes of the cached files when they were parsed, the
+		// cached data is dropped when they change
+		dict<std::string, std::string> cached_stamps;
 
 		bool cache_by_default = false;
 		bool verbose = false;
@@ -26,6 +26,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/stat.h>
 
 #include "simplemap.h"
 
@@ -34,11 +35,74 @@ YOSYS_NAMESPACE_BEGIN
 // see maccmap.cc
 extern void maccmap(RTLIL::Module *module, RTLIL::Cell *cell, bool unmap = false);
 
+bool techmap_cache_enabled = false;
+
 YOSYS_NAMESPACE_END
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
+// Map libraries parsed by earlier techmap calls, used if techmap_cache_enabled
+// is set (e.g. by the "server" command). Entries are keyed by the frontend
+// command (which includes the -D and -I options) and the list of map files.
+// The map files are read into a fresh design, so the defines of the current
+// design don't apply to them. An entry is parsed again when the content of one
+// of the files read for it changes, including files pulled in with `include.
+struct TechmapMapCache
+{
+	struct Entry {
+		// Content hashes of the files read for the entry
+		dict<std::string, std::string> files;
+		RTLIL::Design *design = nullptr;
+	};
+
+	dict<std::string, Entry> entries;
+
+	static void copy_modules(RTLIL::Design *from, RTLIL::Design *to)
+	{
+		for (auto mod : from->modules())
+			if (!to->module(mod->name))
+				to->add(mod->clone());
+	}
+
+	// Returns the cached library or nullptr, in which case the caller parses
+	// the files and hands the result to insert()
+	RTLIL::Design *lookup(const std::string &key)
+	{
+		auto it = entries.find(key);
+		if (it == entries.end())
+			return nullptr;
+		for (auto &file : it->second.files)
+			if (file_content_hash(file.first) != file.second) {
+				delete it->second.design;
+				entries.erase(it);
+				return nullptr;
+			}
+		return it->second.design;
+	}
+
+	// `files` are the files read while parsing `map`
+	void insert(const std::string &key, const std::set<std::string> &files, RTLIL::Design *map)
+	{
+		Entry &entry = entries[key];
+		delete entry.design;
+		entry.files.clear();
+		for (auto &fn : files)
+			entry.files[fn] = file_content_hash(fn);
+		entry.design = new RTLIL::Design;
+		copy_modules(map, entry.design);
+	}
+
+	void purge()
+	{
+		for (auto &it : entries)
+			delete it.second.design;
+		entries.clear();
+	}
+};
+
+TechmapMapCache techmap_map_cache;
+
 void apply_prefix(IdString prefix, IdString &id)
 {
 	if (id[0] == '\\')
@@ -1223,22 +1287,56 @@ struct TechmapPass : public Pass {
 		extra_args(args, argidx, design);
 
 		RTLIL::Design *map = new RTLIL::Design;
-		if (map_files.empty()) {
-			Frontend::frontend_call(map, nullptr, "+/techmap.v", verilog_frontend);
-		} else {
-			for (auto &fn : map_files)
-				if (fn.compare(0, 1, "%") == 0) {
-					if (!saved_designs.count(fn.substr(1))) {
-						delete map;
-						log_cmd_error("Can't open saved design `%s'.\n", fn.c_str()+1);
+		std::vector<std::string> cache_files = map_files.empty() ? std::vector<std::string>{"+/techmap.v"} : map_files;
+		std::string cache_key = verilog_frontend;
+		for (auto &fn : cache_files)
+			cache_key += "\n" + fn;
+		bool use_cache = techmap_cache_enabled;
+		for (auto &fn : map_files)
+			if (fn.compare(0, 1, "%") == 0)
+				use_cache = false;
+		RTLIL::Design *cached_map = use_cache ? techmap_map_cache.lookup(cache_key) : nullptr;
+
+		// Collect the files read by the frontends (including `include files)
+		// for the cache entry
+		bool collect_files = use_cache && cached_map == nullptr;
+		std::set<std::string> backup_input_files;
+		if (collect_files)
+			std::swap(backup_input_files, yosys_input_files);
+		auto restore_input_files = [&]() {
+			if (!collect_files)
+				return;
+			std::swap(backup_input_files, yosys_input_files);
+			yosys_input_files.insert(backup_input_files.begin(), backup_input_files.end());
+		};
+
+		try {
+			if (cached_map != nullptr) {
+				log("Using cached map library.\n");
+				TechmapMapCache::copy_modules(cached_map, map);
+			} else if (map_files.empty()) {
+				Frontend::frontend_call(map, nullptr, "+/techmap.v", verilog_frontend);
+			} else {
+				for (auto &fn : map_files)
+					if (fn.compare(0, 1, "%") == 0) {
+						if (!saved_designs.count(fn.substr(1))) {
+							delete map;
+							log_cmd_error("Can't open saved design `%s'.\n", fn.c_str()+1);
+						}
+						for (auto mod : saved_designs.at(fn.substr(1))->modules())
+							if (!map->module(mod->name))
+								map->add(mod->clone());
+					} else {
+						Frontend::frontend_call(map, nullptr, fn, (fn.size() > 3 && fn.compare(fn.size()-3, std::string::npos, ".il") == 0 ? "rtlil" : verilog_frontend));
 					}
-					for (auto mod : saved_designs.at(fn.substr(1))->modules())
-						if (!map->module(mod->name))
-							map->add(mod->clone());
-				} else {
-					Frontend::frontend_call(map, nullptr, fn, (fn.size() > 3 && fn.compare(fn.size()-3, std::string::npos, ".il") == 0 ? "rtlil" : verilog_frontend));
-				}
+			}
+		} catch (...) {
+			restore_input_files();
+			throw;
 		}
+		if (collect_files)
+			techmap_map_cache.insert(cache_key, yosys_input_files, map);
+		restore_input_files();
 
 		log_header(design, "Continuing TECHMAP pass.\n");
 
@@ -1319,3 +1417,12 @@ struct TechmapPass : public Pass {
 } TechmapPass;
 
 PRIVATE_NAMESPACE_END
+
+YOSYS_NAMESPACE_BEGIN
+
+void techmap_cache_purge()
+{
+	techmap_map_cache.purge();
+}
+
+YOSYS_NAMESPACE_END
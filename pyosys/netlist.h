@@ -0,0 +1,173 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+// Flat array snapshot of a module netlist, for bulk access from Python
+//
+// All references between objects are integer indices, with variable length
+// lists stored in CSR form: the items of entry i of "foo" are at positions
+// foo_offsets[i] to foo_offsets[i+1]-1 of the flat array. The Python bindings
+// export the arrays through the buffer protocol without copying them.
+//
+// Nets are the bits of the module after SigMap. A bit that is connected to a
+// constant is stored as -1-state, e.g. -1 for State::S0 and -2 for State::S1.
+
+#ifndef PYOSYS_NETLIST_H
+#define PYOSYS_NETLIST_H
+
+#include "kernel/yosys.h"
+#include "kernel/sigtools.h"
+
+namespace pyosys {
+
+using namespace Yosys;
+
+struct NetlistArrays
+{
+	enum Direction : int8_t {
+		DIR_NONE = 0,
+		DIR_INPUT = 1,
+		DIR_OUTPUT = 2,
+		DIR_INOUT = 3,
+	};
+
+	RTLIL::Module *module;
+	int num_nets = 0;
+
+	// cell types and port names, referenced by index
+	std::vector<RTLIL::IdString> names;
+
+	std::vector<RTLIL::Wire*> wires;
+	std::vector<int8_t> wire_dirs;
+	std::vector<int32_t> wire_bit_offsets;
+	std::vector<int32_t> wire_bits;
+
+	std::vector<RTLIL::Cell*> cells;
+	std::vector<int32_t> cell_types;
+	std::vector<int32_t> cell_port_offsets;
+
+	// ports of all cells, in cell order
+	std::vector<int32_t> port_names;
+	std::vector<int8_t> port_dirs;
+	std::vector<int32_t> port_bit_offsets;
+	std::vector<int32_t> port_bits;
+
+	// positions in port_bits of the output and input bits of each net
+	std::vector<int32_t> driver_offsets;
+	std::vector<int32_t> drivers;
+	std::vector<int32_t> load_offsets;
+	std::vector<int32_t> loads;
+
+	static int8_t direction(bool input, bool output)
+	{
+		return (input ? DIR_INPUT : DIR_NONE) | (output ? DIR_OUTPUT : DIR_NONE);
+	}
+
+	static void check_size(size_t size)
+	{
+		if (size > size_t(std::numeric_limits<int32_t>::max()))
+			log_error("Module is too large for 32-bit netlist arrays.\n");
+	}
+
+	// Counts per net to offsets, then scatters the port bit positions
+	void build_csr(const std::vector<std::pair<int32_t, int32_t>> &items, std::vector<int32_t> &offsets, std::vector<int32_t> &values)
+	{
+		offsets.assign(num_nets + 1, 0);
+		for (auto &it : items)
+			offsets[it.first + 1]++;
+		for (int i = 0; i < num_nets; i++)
+			offsets[i + 1] += offsets[i];
+
+		values.resize(items.size());
+		std::vector<int32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (auto &it : items)
+			values[fill[it.first]++] = it.second;
+	}
+
+	NetlistArrays(RTLIL::Module *module) : module(module)
+	{
+		SigMap sigmap(module);
+		idict<RTLIL::SigBit> nets;
+		dict<RTLIL::IdString, int> name_ids;
+
+		auto net_id = [&](RTLIL::SigBit bit) -> int32_t {
+			bit = sigmap(bit);
+			if (bit.wire == nullptr)
+				return -1 - int32_t(bit.data);
+			return nets(bit);
+		};
+		auto name_id = [&](RTLIL::IdString name) -> int32_t {
+			auto it = name_ids.find(name);
+			if (it != name_ids.end())
+				return it->second;
+			names.push_back(name);
+			return name_ids[name] = GetSize(names) - 1;
+		};
+
+		wires.reserve(GetSize(module->wires()));
+		wire_dirs.reserve(GetSize(module->wires()));
+		wire_bit_offsets.reserve(GetSize(module->wires()) + 1);
+		wire_bit_offsets.push_back(0);
+		for (auto wire : module->wires()) {
+			wires.push_back(wire);
+			wire_dirs.push_back(direction(wire->port_input, wire->port_output));
+			for (auto bit : RTLIL::SigSpec(wire))
+				wire_bits.push_back(net_id(bit));
+			check_size(wire_bits.size());
+			wire_bit_offsets.push_back(GetSize(wire_bits));
+		}
+
+		std::vector<std::pair<int32_t, int32_t>> driver_items, load_items;
+
+		cells.reserve(GetSize(module->cells()));
+		cell_types.reserve(GetSize(module->cells()));
+		cell_port_offsets.reserve(GetSize(module->cells()) + 1);
+		cell_port_offsets.push_back(0);
+		port_bit_offsets.push_back(0);
+		for (auto cell : module->cells()) {
+			cells.push_back(cell);
+			cell_types.push_back(name_id(cell->type));
+			for (auto &conn : cell->connections()) {
+				bool input = cell->input(conn.first);
+				bool output = cell->output(conn.first);
+				port_names.push_back(name_id(conn.first));
+				port_dirs.push_back(direction(input, output));
+				for (auto bit : conn.second) {
+					int32_t net = net_id(bit);
+					int32_t pos = GetSize(port_bits);
+					port_bits.push_back(net);
+					if (net < 0)
+						continue;
+					if (output)
+						driver_items.emplace_back(net, pos);
+					if (input)
+						load_items.emplace_back(net, pos);
+				}
+				check_size(port_bits.size());
+				port_bit_offsets.push_back(GetSize(port_bits));
+			}
+			cell_port_offsets.push_back(GetSize(port_names));
+		}
+
+		num_nets = GetSize(nets);
+		build_csr(driver_items, driver_offsets, drivers);
+		build_csr(load_items, load_offsets, loads);
+	}
+};
+
+}
+
+#endif
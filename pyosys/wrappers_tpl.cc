@@ -28,6 +28,7 @@
 #include "kernel/yosys_common.h"
 
 #include "pyosys/hashlib.h"
+#include "pyosys/netlist.h"
 
 namespace py = pybind11;
 
@@ -165,6 +166,28 @@ namespace pyosys {
 		}
 	};
 
+	// One array of a NetlistArrays snapshot, keeping the snapshot alive for as
+	// long as Python holds a view of the data
+	struct NetlistArray {
+		std::shared_ptr<NetlistArrays> owner;
+		const void *data;
+		size_t size;
+		size_t itemsize;
+		std::string format;
+
+		template<typename T>
+		static NetlistArray of(std::shared_ptr<NetlistArrays> owner, const std::vector<T> &vec) {
+			return NetlistArray{owner, vec.data(), vec.size(), sizeof(T), py::format_descriptor<T>::format()};
+		}
+	};
+
+	template<typename T>
+	void def_netlist_array(py::class_<NetlistArrays, std::shared_ptr<NetlistArrays>> &cls, const char *name, std::vector<T> NetlistArrays::*member) {
+		cls.def_property_readonly(name, [member](std::shared_ptr<NetlistArrays> self) {
+			return NetlistArray::of(self, (*self).*member);
+		});
+	}
+
 	PYBIND11_MODULE(libyosys, m) {
 		// this code is run on import
 		m.doc() = "python access to libyosys";
@@ -250,6 +273,50 @@ namespace pyosys {
 			.def("notify_blackout", &RTLIL::Monitor::notify_blackout)
 		;
 
+		// Bulk Netlist Access
+		py::class_<NetlistArray>(m, "NetlistArray", py::buffer_protocol())
+			.def_buffer([](NetlistArray &a) {
+				return py::buffer_info(
+					const_cast<void *>(a.data),
+					a.itemsize,
+					a.format,
+					1,
+					{ py::ssize_t(a.size) },
+					{ py::ssize_t(a.itemsize) },
+					true
+				);
+			})
+			.def("__len__", [](NetlistArray &a) { return a.size; })
+		;
+
+		auto netlist_arrays = py::class_<NetlistArrays, std::shared_ptr<NetlistArrays>>(m, "NetlistArrays")
+			.def(py::init([](RTLIL::Module *module) {
+				return std::make_shared<NetlistArrays>(module);
+			}), py::arg("module"), py::keep_alive<1, 2>())
+			.def_readonly("num_nets", &NetlistArrays::num_nets)
+			.def_property_readonly("names", [](NetlistArrays &a) {
+				py::list names;
+				for (auto &name : a.names)
+					names.append(name.str());
+				return names;
+			})
+			.def("wire", [](NetlistArrays &a, int index) { return a.wires.at(index); }, py::return_value_policy::reference)
+			.def("cell", [](NetlistArrays &a, int index) { return a.cells.at(index); }, py::return_value_policy::reference)
+		;
+		def_netlist_array(netlist_arrays, "wire_dirs", &NetlistArrays::wire_dirs);
+		def_netlist_array(netlist_arrays, "wire_bit_offsets", &NetlistArrays::wire_bit_offsets);
+		def_netlist_array(netlist_arrays, "wire_bits", &NetlistArrays::wire_bits);
+		def_netlist_array(netlist_arrays, "cell_types", &NetlistArrays::cell_types);
+		def_netlist_array(netlist_arrays, "cell_port_offsets", &NetlistArrays::cell_port_offsets);
+		def_netlist_array(netlist_arrays, "port_names", &NetlistArrays::port_names);
+		def_netlist_array(netlist_arrays, "port_dirs", &NetlistArrays::port_dirs);
+		def_netlist_array(netlist_arrays, "port_bit_offsets", &NetlistArrays::port_bit_offsets);
+		def_netlist_array(netlist_arrays, "port_bits", &NetlistArrays::port_bits);
+		def_netlist_array(netlist_arrays, "driver_offsets", &NetlistArrays::driver_offsets);
+		def_netlist_array(netlist_arrays, "drivers", &NetlistArrays::drivers);
+		def_netlist_array(netlist_arrays, "load_offsets", &NetlistArrays::load_offsets);
+		def_netlist_array(netlist_arrays, "loads", &NetlistArrays::loads);
+
 		// Bind Opaque Containers
 		bind_autogenerated_opaque_containers(m);
 
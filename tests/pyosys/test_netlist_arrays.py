@@ -0,0 +1,44 @@
+from pyosys import libyosys as ys
+from pathlib import Path
+
+__file_dir__ = Path(__file__).absolute().parent
+
+d = ys.Design()
+
+ys.run_pass(f"read_verilog {__file_dir__ / 'spm.cut.v.gz'}", d)
+ys.run_pass("hierarchy -top spm", d)
+ys.run_pass("synth -flatten", d)
+module = d.top_module()
+
+arrays = ys.NetlistArrays(module)
+names = arrays.names
+cell_types = memoryview(arrays.cell_types)
+cell_port_offsets = memoryview(arrays.cell_port_offsets)
+port_bit_offsets = memoryview(arrays.port_bit_offsets)
+port_bits = memoryview(arrays.port_bits)
+driver_offsets = memoryview(arrays.driver_offsets)
+drivers = memoryview(arrays.drivers)
+
+assert cell_types.readonly
+assert cell_types.format == "i"
+assert len(cell_types) == len(module.cells_)
+assert len(cell_port_offsets) == len(cell_types) + 1
+assert len(port_bit_offsets) == cell_port_offsets[-1] + 1
+assert len(port_bits) == port_bit_offsets[-1]
+assert len(driver_offsets) == arrays.num_nets + 1
+
+# compare against the per-object API
+for i in range(len(cell_types)):
+	cell = arrays.cell(i)
+	assert names[cell_types[i]] == cell.type.str()
+	assert cell_port_offsets[i + 1] - cell_port_offsets[i] == len(cell.connections_)
+
+# after synthesis, every net has at most one driving cell
+for i in range(arrays.num_nets):
+	assert driver_offsets[i + 1] - driver_offsets[i] <= 1
+	for j in range(driver_offsets[i], driver_offsets[i + 1]):
+		assert port_bits[drivers[j]] == i
+
+# views keep the snapshot alive
+view = memoryview(ys.NetlistArrays(module).wire_bits)
+assert len(view) == sum(w.width for w in module.wires_.values())
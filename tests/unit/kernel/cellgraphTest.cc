@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include "kernel/cellgraph.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+namespace RTLIL {
+
+	class KernelCellGraphTest : public testing::Test {
+	protected:
+		Design design;
+		Module *module = nullptr;
+		std::vector<Wire*> nets;
+
+		virtual void SetUp() override {
+			IdString::ensure_prepopulated();
+
+			// n0 -> c1 -> n1 -> c2 -> n2 -> c3 -> n3
+			module = design.addModule(ID(top));
+			for (int i = 0; i < 4; i++)
+				nets.push_back(module->addWire(stringf("\\n%d", i)));
+			for (int i = 1; i < 4; i++)
+				module->addNot(stringf("\\c%d", i), nets[i - 1], nets[i]);
+		}
+
+		CellGraph &graph() {
+			return CellGraph::get(module, "test",
+					[](Cell *) { return true; },
+					[](Cell *, IdString port) { return port == ID::Y ? CellGraph::PORT_OUTPUT : CellGraph::PORT_INPUT; });
+		}
+
+		std::vector<Cell*> successors(CellGraph &g, const char *name) {
+			std::vector<Cell*> result;
+			auto range = g.successors(g.node(module->cell(RTLIL::escape_id(name))));
+			for (auto it = range.first; it != range.second; it++)
+				result.push_back(g.cells[*it]);
+			return result;
+		}
+	};
+
+	TEST_F(KernelCellGraphTest, RewriteSigspecs)
+	{
+		CellGraph &g = graph();
+		g.update();
+		EXPECT_EQ(successors(g, "c1"), std::vector<Cell*>{module->cell(ID(c2))});
+
+		// c3 now reads n1, the change is not reported to the monitor
+		Wire *n1 = nets[1], *n2 = nets[2];
+		auto rewrite = [&](SigSpec &sig) { sig.replace(n2, n1); };
+		module->cell(ID(c3))->rewrite_sigspecs(rewrite);
+
+		CellGraph &cached = graph();
+		EXPECT_EQ(&cached, &g);
+		cached.update();
+		EXPECT_EQ(GetSize(successors(cached, "c1")), 2);
+		EXPECT_TRUE(successors(cached, "c2").empty());
+	}
+
+	TEST_F(KernelCellGraphTest, DirectConnectionWrite)
+	{
+		CellGraph &g = graph();
+		g.update();
+
+		Cell *c3 = module->cell(ID(c3));
+		c3->connections_[ID::A] = nets[0];
+		module->invalidate_content_hash();
+
+		g.update();
+		EXPECT_EQ(GetSize(successors(g, "c1")), 1);
+		EXPECT_TRUE(successors(g, "c2").empty());
+		EXPECT_EQ(g.inputs(g.node(c3)).size(), 1u);
+		EXPECT_EQ(g.bits[g.inputs(g.node(c3))[0]], SigBit(nets[0]));
+	}
+}
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include "kernel/drivertools.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+namespace RTLIL {
+
+	class KernelDriverToolsTest : public testing::Test {
+	protected:
+		Design design;
+		Module *module = nullptr;
+
+		KernelDriverToolsTest() {
+			if (log_files.empty()) log_files.emplace_back(stdout);
+		}
+
+		virtual void SetUp() override {
+			IdString::ensure_prepopulated();
+			module = design.addModule(ID(top));
+		}
+
+		// Builds a map by adding the connections one by one, which doesn't
+		// use the chunked jobs or the cached bit modes of add(Module *)
+		void add_serial(DriverMap &map) {
+			for (auto const &conn : module->connections())
+				map.add(conn.first, conn.second);
+			for (auto cell : module->cells())
+				for (auto const &conn : cell->connections())
+					map.add(conn.second, DriveChunkPort(cell, conn));
+		}
+
+		void expect_same_drivers(DriverMap &map, DriverMap &serial) {
+			for (auto wire : module->wires()) {
+				DriveSpec spec = DriveChunkWire(wire, 0, wire->width);
+				EXPECT_EQ(log_signal(map(spec)), log_signal(serial(spec))) << log_id(wire);
+			}
+			for (auto cell : module->cells())
+				for (auto const &conn : cell->connections()) {
+					DriveSpec spec = DriveChunkPort(cell, conn);
+					EXPECT_EQ(log_signal(map(spec)), log_signal(serial(spec))) << log_id(cell) << " " << log_id(conn.first);
+				}
+		}
+	};
+
+	TEST_F(KernelDriverToolsTest, PartialRangeDrivers)
+	{
+		Wire *a = module->addWire(ID(a), 16);
+		a->port_input = true;
+		Wire *y = module->addWire(ID(y), 16);
+		y->port_output = true;
+		module->fixup_ports();
+
+		// Enough cells for several jobs. Every cell drives a slice of one
+		// wide wire, which is read back in slices by the next cells, so
+		// most ports and wires are only connected to partial ranges.
+		const int num_cells = 3000;
+		Wire *bus = module->addWire(NEW_ID, 4 * num_cells);
+		Wire *named = module->addWire(ID(named), 4 * num_cells);
+		module->connect(SigSpec(named).extract(0, 2 * num_cells), SigSpec(bus).extract(2 * num_cells, 2 * num_cells));
+		for (int i = 0; i < num_cells; i++) {
+			SigSpec in = i == 0 ? SigSpec(a).extract(0, 4) : SigSpec(bus).extract(4 * i - 2, 4);
+			if (i % 7 == 3)
+				in = {SigSpec(named).extract(4 * (i / 2), 2), SigSpec(State::S1), SigSpec(a)[i % 16]};
+			if (i % 2 == 0)
+				module->addNot(NEW_ID, in, SigSpec(bus).extract(4 * i, 4));
+			else
+				module->addAdd(NEW_ID, in, SigSpec(a).extract(i % 13, 3), SigSpec(bus).extract(4 * i, 4));
+		}
+
+		// A second driver for one bit and a direct connection between wires
+		module->addNot(NEW_ID, SigSpec(a)[0], SigSpec(bus)[5]);
+		module->connect(SigSpec(y).extract(0, 8), SigSpec(bus).extract(8, 8));
+		module->connect(SigSpec(y).extract(8, 8), {SigSpec(named).extract(4 * num_cells - 4, 4), Const(5, 3), SigSpec(a)[15]});
+
+		DriverMap map(&design), serial(&design);
+		map.add(module);
+		add_serial(serial);
+		expect_same_drivers(map, serial);
+
+		// Checks a few drivers directly
+		DriveBit first = map(DriveBit(SigBit(bus, 0)));
+		ASSERT_TRUE(first.is_port());
+		EXPECT_EQ(first.port().cell->type, ID($not));
+		EXPECT_EQ(first.port().cell->getPort(ID::A), SigSpec(a).extract(0, 4));
+		EXPECT_EQ(map(DriveBit(SigBit(y, 8))), DriveBit(SigBit(a, 15)));
+		EXPECT_EQ(map(DriveBit(SigBit(y, 9))), DriveBit(State::S1));
+		EXPECT_EQ(map(DriveBit(SigBit(y, 10))), DriveBit(State::S0));
+	}
+
+	TEST_F(KernelDriverToolsTest, AddModuleTwice)
+	{
+		// Ids of the second module are allocated after the bit modes of the
+		// first module are already cached
+		Wire *a = module->addWire(ID(a), 4);
+		a->port_input = true;
+		Wire *y = module->addWire(ID(y), 4);
+		y->port_output = true;
+		module->fixup_ports();
+		Wire *t = module->addWire(NEW_ID, 4);
+		module->addNot(NEW_ID, SigSpec(a).extract(0, 2), SigSpec(t).extract(0, 2));
+		module->addAnd(NEW_ID, SigSpec(a).extract(2, 2), SigSpec(t).extract(0, 2), SigSpec(t).extract(2, 2));
+		module->connect(y, {SigSpec(t).extract(1, 3), SigSpec(State::S0)});
+
+		Module *other = design.addModule(ID(other));
+		Wire *b = other->addWire(ID(b), 2);
+		b->port_input = true;
+		Wire *z = other->addWire(ID(z), 2);
+		z->port_output = true;
+		other->fixup_ports();
+		other->addXor(NEW_ID, b, SigSpec(b).extract(0, 1), z);
+
+		DriverMap map(&design), serial(&design);
+		map.add(module);
+		map.add(other);
+		add_serial(serial);
+		std::swap(module, other);
+		add_serial(serial);
+		expect_same_drivers(map, serial);
+		std::swap(module, other);
+		expect_same_drivers(map, serial);
+	}
+}
+
+YOSYS_NAMESPACE_END
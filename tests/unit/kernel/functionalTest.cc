@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include "kernel/functional.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+namespace Functional {
+
+	class KernelFunctionalTest : public testing::Test {
+	protected:
+		KernelFunctionalTest() {
+			if (log_files.empty()) log_files.emplace_back(stdout);
+		}
+
+		virtual void SetUp() override {
+			IdString::ensure_prepopulated();
+		}
+
+		struct ConstValue : DefaultVisitor<std::optional<RTLIL::Const>> {
+			std::optional<RTLIL::Const> default_handler(Node) override { return {}; }
+			std::optional<RTLIL::Const> constant(Node, RTLIL::Const const &value) override { return value; }
+		};
+
+		static std::optional<RTLIL::Const> const_value(Node n) {
+			return n.visit(ConstValue());
+		}
+	};
+
+	TEST_F(KernelFunctionalTest, FactorySharesNodes)
+	{
+		IR ir;
+		Factory factory = ir.factory();
+		auto &a = factory.add_input(ID(a), ID($input), Sort(4));
+		auto &b = factory.add_input(ID(b), ID($input), Sort(4));
+		Node va = factory.value(a), vb = factory.value(b);
+
+		Node sum = factory.add(va, vb);
+		EXPECT_EQ(factory.value(a).id(), va.id());
+		EXPECT_EQ(factory.add(va, vb).id(), sum.id());
+		EXPECT_NE(factory.add(vb, va).id(), sum.id());
+		EXPECT_EQ(factory.constant(RTLIL::Const(5, 4)).id(), factory.constant(RTLIL::Const(5, 4)).id());
+		EXPECT_NE(factory.constant(RTLIL::Const(5, 4)).id(), factory.constant(RTLIL::Const(5, 3)).id());
+		EXPECT_EQ(ir.statistics.shared, 4);
+		EXPECT_EQ(ir.statistics.folded, 0);
+		EXPECT_EQ(ir.size(), 6);
+	}
+
+	TEST_F(KernelFunctionalTest, FactoryFoldsConstants)
+	{
+		IR ir;
+		Factory factory = ir.factory();
+		auto &a = factory.add_input(ID(a), ID($input), Sort(4));
+		Node va = factory.value(a);
+		Node c3 = factory.constant(RTLIL::Const(3, 4)), c4 = factory.constant(RTLIL::Const(4, 4));
+
+		EXPECT_EQ(const_value(factory.add(c3, c4)), RTLIL::Const(7, 4));
+		EXPECT_EQ(const_value(factory.bitwise_not(c3)), RTLIL::Const(12, 4));
+		EXPECT_EQ(const_value(factory.concat(c3, c4)), RTLIL::Const(0x43, 8));
+		EXPECT_EQ(const_value(factory.extend(c3, 8, false)), RTLIL::Const(3, 8));
+		EXPECT_EQ(const_value(factory.slice(c4, 2, 2)), RTLIL::Const(1, 2));
+		EXPECT_EQ(ir.statistics.folded, 5);
+
+		// Undefined bits are not folded
+		Node cx = factory.constant(RTLIL::Const(RTLIL::State::Sx, 4));
+		EXPECT_EQ(factory.add(cx, c4).fn(), Fn::add);
+		EXPECT_EQ(factory.add(va, c4).fn(), Fn::add);
+		EXPECT_EQ(ir.statistics.folded, 5);
+	}
+
+	TEST_F(KernelFunctionalTest, FactoryFoldsMuxes)
+	{
+		IR ir;
+		Factory factory = ir.factory();
+		Node va = factory.value(factory.add_input(ID(a), ID($input), Sort(4)));
+		Node vb = factory.value(factory.add_input(ID(b), ID($input), Sort(4)));
+		Node s = factory.value(factory.add_input(ID(s), ID($input), Sort(1)));
+
+		EXPECT_EQ(factory.mux(va, vb, factory.constant(RTLIL::Const(0, 1))).id(), va.id());
+		EXPECT_EQ(factory.mux(va, vb, factory.constant(RTLIL::Const(1, 1))).id(), vb.id());
+		EXPECT_EQ(factory.mux(va, va, s).id(), va.id());
+		EXPECT_EQ(ir.statistics.folded, 3);
+
+		Node m = factory.mux(va, vb, s);
+		EXPECT_EQ(m.fn(), Fn::mux);
+		EXPECT_EQ(factory.mux(va, vb, factory.constant(RTLIL::Const(RTLIL::State::Sx, 1))).fn(), Fn::mux);
+		EXPECT_EQ(ir.statistics.folded, 3);
+	}
+
+	TEST_F(KernelFunctionalTest, FromModule)
+	{
+		Design design;
+		Module *module = design.addModule(ID(top));
+		Wire *a = module->addWire(ID(a), 4);
+		a->port_input = true;
+		Wire *b = module->addWire(ID(b), 4);
+		b->port_input = true;
+		std::vector<Wire*> outputs;
+		for (auto name : {ID(y1), ID(y2), ID(y3), ID(y4)}) {
+			outputs.push_back(module->addWire(name, 4));
+			outputs.back()->port_output = true;
+		}
+		module->fixup_ports();
+
+		// Two identical adders, a mux with a constant select and an adder of constants
+		module->addAdd(ID(add1), a, b, outputs[0]);
+		module->addAdd(ID(add2), a, b, outputs[1]);
+		module->addMux(ID(mux), a, b, RTLIL::State::S1, outputs[2]);
+		module->addAdd(ID(add3), RTLIL::Const(3, 4), RTLIL::Const(4, 4), outputs[3]);
+
+		IR ir = IR::from_module(module);
+		Node y1 = ir.output(ID(y1)).value(), y2 = ir.output(ID(y2)).value();
+		Node y3 = ir.output(ID(y3)).value(), y4 = ir.output(ID(y4)).value();
+		EXPECT_EQ(y1.id(), y2.id());
+		EXPECT_EQ(y1.fn(), Fn::add);
+		EXPECT_EQ(y3.fn(), Fn::input);
+		EXPECT_EQ(const_value(y4), RTLIL::Const(7, 4));
+		EXPECT_EQ(ir.statistics.shared, 1);
+		EXPECT_EQ(ir.statistics.folded, 2);
+		EXPECT_EQ(ir.size(), 4);
+
+		int adders = 0;
+		for (auto node : ir)
+			if (node.fn() == Fn::add)
+				adders++;
+		EXPECT_EQ(adders, 1);
+	}
+}
+
+YOSYS_NAMESPACE_END
@@ -3,6 +3,12 @@
 #include "kernel/yosys.h"
 #include "kernel/log.h"
 
+#include <sstream>
+#ifndef _WIN32
+#  include <sys/wait.h>
+#  include <unistd.h>
+#endif
+
 YOSYS_NAMESPACE_BEGIN
 
 TEST(KernelLogTest, logvValidValues)
@@ -11,4 +17,50 @@ TEST(KernelLogTest, logvValidValues)
 	EXPECT_EQ(7, 7);
 }
 
+TEST(KernelLogTest, logDiscardedFollowsOutputs)
+{
+	auto backup_log_files = log_files;
+	auto backup_log_streams = log_streams;
+	log_files.clear();
+	log_streams.clear();
+	log_outputs_changed();
+	EXPECT_TRUE(log_discarded());
+
+	std::ostringstream buf;
+	log_streams.push_back(&buf);
+	log_outputs_changed();
+	EXPECT_FALSE(log_discarded());
+	log("value %d\n", 42);
+	EXPECT_EQ(buf.str(), "value 42\n");
+
+	log_files = backup_log_files;
+	log_streams = backup_log_streams;
+	log_outputs_changed();
+}
+
+#ifndef _WIN32
+TEST(KernelLogTest, logInForkedChild)
+{
+	auto backup_log_streams = log_streams;
+	std::ostringstream buf;
+	log_streams.push_back(&buf);
+	log_outputs_changed();
+	log("parent\n");
+
+	pid_t pid = fork();
+	ASSERT_NE(pid, -1);
+	if (pid == 0) {
+		// Deadlocks if the log lock is still held in the child
+		log("child\n");
+		_exit(buf.str() == "parent\nchild\n" ? 0 : 1);
+	}
+	int status = 0;
+	ASSERT_EQ(waitpid(pid, &status, 0), pid);
+	EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+	log_streams = backup_log_streams;
+	log_outputs_changed();
+}
+#endif
+
 YOSYS_NAMESPACE_END
@@ -0,0 +1,227 @@
+#include <gtest/gtest.h>
+#include "kernel/timinggraph.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+namespace RTLIL {
+
+	class KernelTimingGraphTest : public testing::Test {
+	protected:
+		LibertyTiming liberty;
+		Design design;
+		Module *module = nullptr;
+
+		KernelTimingGraphTest() {
+			if (log_files.empty()) log_files.emplace_back(stdout);
+		}
+
+		static LibertyTiming::Table table(std::vector<double> values) {
+			LibertyTiming::Table t;
+			t.index_1 = {0, 1000};
+			t.index_2 = {0, 1};
+			t.values = values;
+			return t;
+		}
+
+		static LibertyTiming::Arc arc(IdString related_pin, double scale) {
+			LibertyTiming::Arc a;
+			a.related_pin = related_pin;
+			a.delay[0] = table({100 * scale, 300 * scale, 200 * scale, 400 * scale});
+			a.delay[1] = table({100 * scale, 200 * scale, 200 * scale, 300 * scale});
+			a.transition[0] = table({0, 200, 200, 400});
+			a.transition[1] = table({0, 100, 100, 200});
+			return a;
+		}
+
+		static LibertyTiming::Pin input_pin() {
+			LibertyTiming::Pin pin;
+			pin.capacitance = 0.5;
+			return pin;
+		}
+
+		void add_gate(IdString type, double scale) {
+			auto &cell = liberty.cells[type];
+			cell.pins[ID::A] = input_pin();
+			cell.pins[ID::B] = input_pin();
+			cell.pins[ID::Y].output = true;
+			cell.pins[ID::Y].arcs.push_back(arc(ID::A, scale));
+			cell.pins[ID::Y].arcs.push_back(arc(ID::B, 1.5 * scale));
+		}
+
+		virtual void SetUp() override {
+			IdString::ensure_prepopulated();
+
+			liberty.cells[ID(INV)].pins[ID::A] = input_pin();
+			liberty.cells[ID(INV)].pins[ID::Y].output = true;
+			liberty.cells[ID(INV)].pins[ID::Y].arcs.push_back(arc(ID::A, 1));
+			add_gate(ID(NAND2), 1);
+			add_gate(ID(NAND2_SLOW), 2);
+
+			auto &dff = liberty.cells[ID(DFF)];
+			dff.pins[ID::C] = input_pin();
+			dff.pins[ID::D] = input_pin();
+			dff.pins[ID::Q].output = true;
+			dff.pins[ID::Q].arcs.push_back(arc(ID::C, 1));
+			dff.pins[ID::Q].arcs.back().clock_edge = true;
+			LibertyTiming::Arc setup;
+			setup.related_pin = ID::C;
+			setup.delay[0].values = {50};
+			setup.delay[1].values = {60};
+			dff.pins[ID::D].setup.push_back(setup);
+
+			// a -> c0 -> n0 -> ... -> c9 -> n9 -> g (with b) -> m -> f -> q -> o1 -> y
+			// with a side branch n4 -> o2 -> z
+			module = design.addModule(ID(top));
+			for (auto name : {ID(a), ID(b), ID(clk)})
+				module->addWire(name)->port_input = true;
+			for (auto name : {ID(y), ID(z)})
+				module->addWire(name)->port_output = true;
+			module->fixup_ports();
+
+			SigBit prev = module->wire(ID(a));
+			for (int i = 0; i < 10; i++) {
+				Wire *n = module->addWire(stringf("\\n%d", i));
+				add_inv(stringf("\\c%d", i), prev, n);
+				prev = n;
+			}
+			Cell *g = module->addCell(ID(g), ID(NAND2));
+			g->setPort(ID::A, prev);
+			g->setPort(ID::B, module->wire(ID(b)));
+			g->setPort(ID::Y, module->addWire(ID(m)));
+			Cell *f = module->addCell(ID(f), ID(DFF));
+			f->setPort(ID::C, module->wire(ID(clk)));
+			f->setPort(ID::D, module->wire(ID(m)));
+			f->setPort(ID::Q, module->addWire(ID(q)));
+			add_inv(ID(o1), module->wire(ID(q)), module->wire(ID(y)));
+			add_inv(ID(o2), module->wire(ID(n4)), module->wire(ID(z)));
+		}
+
+		Cell *add_inv(IdString name, SigSpec a, SigSpec y) {
+			Cell *cell = module->addCell(name, ID(INV));
+			cell->setPort(ID::A, a);
+			cell->setPort(ID::Y, y);
+			return cell;
+		}
+
+		static int lookup(const TimingGraph &graph, SigBit bit) {
+			auto it = graph.bit_index.find(graph.sigmap(bit));
+			return it == graph.bit_index.end() ? -1 : it->second;
+		}
+
+		// Compares all timing data of the incrementally updated graph
+		// against a graph that is built from scratch
+		void expect_same_as_fresh(TimingGraph &graph) {
+			graph.update();
+			TimingGraph fresh(module, &liberty);
+			fresh.period = graph.period;
+			fresh.update();
+
+			EXPECT_NEAR(graph.effective_period, fresh.effective_period, 1e-6);
+			EXPECT_NEAR(graph.worst_slack(), fresh.worst_slack(), 1e-6);
+
+			for (auto wire : module->wires())
+				for (auto bit : SigSpec(wire)) {
+					int n = lookup(graph, bit), f = lookup(fresh, bit);
+					bool reached = n >= 0 && graph.reached(n);
+					ASSERT_EQ(reached, f >= 0 && fresh.reached(f)) << log_signal(bit);
+					if (!reached)
+						continue;
+					EXPECT_NEAR(graph.arrival[n], fresh.arrival[f], 1e-6) << log_signal(bit);
+					EXPECT_NEAR(graph.transition[n], fresh.transition[f], 1e-6) << log_signal(bit);
+					EXPECT_NEAR(graph.required[n], fresh.required[f], 1e-6) << log_signal(bit);
+
+					auto path = graph.path_to(n), fresh_path = fresh.path_to(f);
+					ASSERT_EQ(GetSize(path.points), GetSize(fresh_path.points)) << log_signal(bit);
+					for (int i = 0; i < GetSize(path.points); i++) {
+						EXPECT_EQ(path.points[i].bit, fresh_path.points[i].bit) << log_signal(bit);
+						EXPECT_EQ(path.points[i].cell, fresh_path.points[i].cell) << log_signal(bit);
+						EXPECT_EQ(path.points[i].from_port, fresh_path.points[i].from_port) << log_signal(bit);
+					}
+				}
+		}
+
+		void check_edits(double period) {
+			TimingGraph graph(module, &liberty);
+			graph.period = period;
+			graph.update();
+			int num_nodes = GetSize(graph.bits);
+
+			// Adds load to n2
+			Cell *extra = add_inv(ID(extra), module->wire(ID(n2)), module->addWire(ID(w)));
+			expect_same_as_fresh(graph);
+			EXPECT_LT(graph.updated_arrivals, num_nodes);
+
+			// Moves the side branch further down the chain
+			module->cell(ID(o2))->setPort(ID::A, module->wire(ID(n7)));
+			expect_same_as_fresh(graph);
+			EXPECT_LT(graph.updated_arrivals, num_nodes);
+
+			module->remove(extra);
+			expect_same_as_fresh(graph);
+
+			// Shortens the chain
+			module->remove(module->cell(ID(c5)));
+			module->cell(ID(c6))->setPort(ID::A, module->wire(ID(n4)));
+			expect_same_as_fresh(graph);
+
+			Cell *g = module->cell(ID(g));
+			g->type = ID(NAND2_SLOW);
+			graph.invalidate(g);
+			expect_same_as_fresh(graph);
+
+			// Removing the flip-flop leaves the chain without endpoint
+			module->remove(module->cell(ID(f)));
+			expect_same_as_fresh(graph);
+		}
+	};
+
+	TEST_F(KernelTimingGraphTest, IncrementalUpdate)
+	{
+		check_edits(0);
+	}
+
+	TEST_F(KernelTimingGraphTest, IncrementalUpdatePeriod)
+	{
+		check_edits(2000);
+	}
+
+	TEST_F(KernelTimingGraphTest, MultiBitPinIgnored)
+	{
+		Wire *wide = module->addWire(ID(wide), 2);
+		module->connect(SigSpec(wide)[0], module->wire(ID(n9)));
+		Cell *cell = add_inv(ID(wide_inv), wide, module->addWire(ID(u), 2));
+
+		TimingGraph graph(module, &liberty);
+		graph.update();
+		for (auto &edge : graph.edges)
+			EXPECT_NE(edge.cell, cell);
+		int n = lookup(graph, SigBit(module->wire(ID(u)), 0));
+		EXPECT_TRUE(n < 0 || !graph.reached(n));
+	}
+
+	TEST_F(KernelTimingGraphTest, UntimedOutputs)
+	{
+		module->addWire(ID(open))->port_output = true;
+		Wire *wide = module->addWire(ID(wide), 2);
+		module->connect(SigSpec(wide)[0], module->wire(ID(n9)));
+		Wire *u = module->addWire(ID(u), 2);
+		u->port_output = true;
+		module->fixup_ports();
+		add_inv(ID(wide_inv), wide, u);
+
+		TimingGraph graph(module, &liberty);
+		graph.update();
+		int num_nodes = GetSize(graph.bits);
+		EXPECT_EQ(GetSize(graph.arrival), num_nodes);
+		EXPECT_EQ(GetSize(graph.endpoint), num_nodes);
+		EXPECT_EQ(GetSize(graph.fanin_start), num_nodes + 1);
+		EXPECT_LT(lookup(graph, SigBit(module->wire(ID(open)), 0)), 0);
+
+		add_inv(ID(extra), module->wire(ID(n2)), module->addWire(ID(w)));
+		expect_same_as_fresh(graph);
+		EXPECT_EQ(GetSize(graph.arrival), GetSize(graph.bits));
+		EXPECT_EQ(GetSize(graph.fanin_start), GetSize(graph.bits) + 1);
+	}
+}
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,27 @@
+#!/usr/bin/env bash
+set -ex
+
+# Log files given with -l are written by a background thread. They must be
+# complete on exit, also when child processes are forked while it runs.
+cat > log_async.v <<EOT
+module sub(input a, b, output y);
+	assign y = a & b;
+endmodule
+module top(input a, b, c, output y);
+	wire t;
+	sub s1(.a(a), .b(b), .y(t));
+	sub s2(.a(t), .b(c), .y(y));
+endmodule
+EOT
+
+../../yosys -q -l log_async.log -p 'read_verilog log_async.v; hierarchy -top top; proc; foreach_module -j 2 -run "opt; stat"; log LOG_ASYNC_DONE'
+grep -F "Executing FOREACH_MODULE pass" log_async.log
+test $(grep -c -- "-- Output for module" log_async.log) -eq 2
+grep -F "LOG_ASYNC_DONE" log_async.log
+grep -F "End of script." log_async.log
+
+# -L files are written synchronously
+../../yosys -q -L log_async.log -p 'read_verilog log_async.v; log LOG_SYNC_DONE'
+grep -F "LOG_SYNC_DONE" log_async.log
+
+rm -f log_async.v log_async.log
@@ -0,0 +1,78 @@
+#!/usr/bin/env bash
+set -ex
+
+rm -f server.sock server_map.v server_inc.vh
+
+# A file that is not a socket is never replaced
+touch server.sock
+if ../../yosys -q -p 'server server.sock'; then
+	exit 1
+fi
+test -f server.sock
+rm -f server.sock
+
+cat > server_inc.vh <<EOT
+\`define MAPPED_CELL BUF_X
+EOT
+cat > server_map.v <<EOT
+\`include "server_inc.vh"
+(* techmap_celltype = "\$_NOT_" *)
+module map_not(input A, output Y);
+	\`MAPPED_CELL _TECHMAP_REPLACE_ (.A(A), .Y(Y));
+endmodule
+EOT
+
+../../yosys -q -p 'server server.sock' &
+server_pid=$!
+trap 'kill $server_pid 2>/dev/null || true' EXIT
+for i in $(seq 100); do
+	test -S server.sock && break
+	sleep 0.1
+done
+
+python3 - server.sock <<'EOT'
+import json, os, socket, stat, sys
+
+path = sys.argv[1]
+assert stat.S_IMODE(os.stat(path).st_mode) == 0o600
+
+sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+sock.connect(path)
+f = sock.makefile("rw")
+
+def request(**req):
+	f.write(json.dumps(req) + "\n")
+	f.flush()
+	return json.loads(f.readline())
+
+def run_map(design, cell):
+	response = request(method="run", design=design,
+		script="read_verilog -noattr <<EOF\nmodule top(input a, output y); assign y = ~a; endmodule\nEOF\n",
+		commands=["techmap", "techmap -map server_map.v", "select -assert-count 1 t:" + cell])
+	assert "error" not in response, response
+	return response["log"]
+
+assert "Using cached map library" not in run_map("a", "BUF_X")
+assert "Using cached map library" in run_map("b", "BUF_X")
+assert sorted(request(method="designs")["designs"]) == ["a", "b"]
+
+# Changing an included file invalidates the cached map library
+with open("server_inc.vh", "w") as inc:
+	inc.write("`define MAPPED_CELL INV_XY\n")
+run_map("c", "INV_XY")
+
+# Also when an edit keeps the size and lands within the same second
+with open("server_inc.vh", "w") as inc:
+	inc.write("`define MAPPED_CELL INV_ZW\n")
+run_map("d", "INV_ZW")
+
+response = request(method="run", commands=["nonexistent_command"])
+assert "error" in response, response
+
+assert request(method="shutdown") == {}
+EOT
+
+wait $server_pid
+trap - EXIT
+test ! -e server.sock
+rm -f server_map.v server_inc.vh
@@ -0,0 +1,41 @@
+#!/usr/bin/env bash
+set -ex
+mkdir -p temp
+
+../../yosys -q -p '
+read_verilog <<EOT
+module loop(input clk, input a, output y, output z);
+	wire t, u;
+	assign t = a ^ u;
+	assign u = t & a;
+	assign y = u;
+	reg q;
+	always @(posedge clk) q <= ~q;
+	assign z = q;
+endmodule
+EOT
+proc
+show -format jsonl -cluster scc -viewer none -prefix temp/show_cluster_jsonl loop
+'
+
+python3 - temp/show_cluster_jsonl.jsonl <<'EOT'
+import json, sys
+
+records = [json.loads(line) for line in open(sys.argv[1])]
+module = records[0]
+assert module["kind"] == "module" and module["name"] == "loop", module
+nodes = [r for r in records if r["kind"] in ("port", "cell", "cluster")]
+edges = [r for r in records if r["kind"] == "edge"]
+assert len(nodes) == module["nodes"] and len(edges) == module["edges"]
+assert [n["id"] for n in nodes] == list(range(len(nodes)))
+
+# The $xor/$and loop is one cluster, the flip-flop and its inverter are not
+clusters = [n for n in nodes if n["kind"] == "cluster"]
+assert len(clusters) == 1, clusters
+assert clusters[0]["cells"] == 2 and clusters[0]["types"] == {"$and": 1, "$xor": 1}, clusters
+assert sorted(n["name"] for n in nodes if n["kind"] == "port") == ["a", "clk", "y", "z"]
+assert sum(1 for n in nodes if n["kind"] == "cell") == 2
+
+for e in edges:
+	assert 0 <= e["from"] < len(nodes) and 0 <= e["to"] < len(nodes) and e["bits"] > 0, e
+EOT
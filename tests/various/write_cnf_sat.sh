@@ -0,0 +1,91 @@
+#!/usr/bin/env bash
+set -ex
+
+# The CNF of a miter is unsatisfiable iff the designs are equivalent
+../../yosys -q -p '
+read_verilog <<EOT
+module gold(input [3:0] a, b, output [3:0] y);
+	assign y = (a & b) ^ (a | b);
+endmodule
+module equiv(input [3:0] a, b, output [3:0] y);
+	assign y = a ^ b;
+endmodule
+module diff(input [3:0] a, b, output [3:0] y);
+	assign y = a | b;
+endmodule
+EOT
+proc
+miter -equiv -flatten gold equiv miter_equiv
+miter -equiv -flatten gold diff miter_diff
+design -save read
+hierarchy -top miter_equiv
+write_cnf write_cnf_sat_equiv.cnf
+write_cnf -strash write_cnf_sat_equiv_strash.cnf
+design -load read
+hierarchy -top miter_diff
+write_cnf write_cnf_sat_diff.cnf
+write_cnf -strash write_cnf_sat_diff_strash.cnf
+'
+
+python3 - <<'EOT'
+import sys
+sys.setrecursionlimit(10000)
+
+def read_cnf(fn):
+	header, clauses, lits = None, [], []
+	for line in open(fn):
+		if line.startswith("c"):
+			continue
+		if line.startswith("p"):
+			header = tuple(int(x) for x in line.split()[2:4])
+			continue
+		for tok in line.split():
+			lit = int(tok)
+			if lit == 0:
+				clauses.append(lits)
+				lits = []
+			else:
+				lits.append(lit)
+	assert header is not None and not lits
+	nvars, nclauses = header
+	assert nclauses == len(clauses), (fn, nclauses, len(clauses))
+	assert all(0 < abs(l) <= nvars for c in clauses for l in c)
+	return clauses
+
+def dpll(clauses, assign):
+	while True:
+		unit, remaining = None, []
+		for c in clauses:
+			if any(assign.get(abs(l)) == (l > 0) for l in c):
+				continue
+			rest = [l for l in c if abs(l) not in assign]
+			if not rest:
+				return None
+			if len(rest) == 1 and unit is None:
+				unit = rest[0]
+			remaining.append(rest)
+		clauses = remaining
+		if unit is None:
+			break
+		assign = dict(assign)
+		assign[abs(unit)] = unit > 0
+	if not clauses:
+		return assign
+	lit = clauses[0][0]
+	for value in (lit > 0, lit < 0):
+		branch = dict(assign)
+		branch[abs(lit)] = value
+		result = dpll(clauses, branch)
+		if result is not None:
+			return result
+	return None
+
+for name, expected in [("equiv", False), ("equiv_strash", False), ("diff", True), ("diff_strash", True)]:
+	clauses = read_cnf(f"write_cnf_sat_{name}.cnf")
+	model = dpll(clauses, {})
+	assert (model is not None) == expected, name
+	if model is not None:
+		assert all(any(model.get(abs(l), False) == (l > 0) for l in c) for c in clauses), name
+EOT
+
+rm -f write_cnf_sat_*.cnf